@@ -7,40 +7,136 @@
 #include "plugin.h"
 #include "vfs.h"
 
+// a VFSFile shared by all STREAMFILEs opened on the same path (one per channel),
+// as opening network files is slow. Channels of a stream are read from one thread.
+typedef struct {
+  VFSFile *vfsFile;
+  int refcount;
+  off_t offset;       // current position of vfsFile
+  size_t filesize;    // cached, as fsize() may need a request
+} VFSSHAREDFILE;
+
 typedef struct _VFSSTREAMFILE {
   STREAMFILE sf;
-  VFSFile *vfsFile;
-  off_t offset;
+  VFSSHAREDFILE *file;
+  off_t offset;       // offset of the buffer
+  size_t validsize;   // current buffer size
+  uint8_t *buffer;
+  size_t buffersize;  // allocated buffer size
+  size_t refill_size; // grows on sequential refills, like stdio
+  size_t bytes_read;
+  int error_count;
   char name[260];
   char realname[260];
 } VFSSTREAMFILE;
 
 static STREAMFILE *open_vfs_by_VFSFILE(VFSFile *file, const char *path);
+static STREAMFILE *open_vfs_by_shared(VFSSHAREDFILE *file, const char *path);
+
+// fills the buffer at offset, reading ahead of the request
+static int refill_vfs(VFSSTREAMFILE *streamfile, off_t offset) {
+  VFSSHAREDFILE *file = streamfile->file;
+
+  // sequential refills read more at once (fewer requests on network VFS)
+  if (offset == streamfile->offset + (off_t)streamfile->validsize) {
+    if (streamfile->refill_size * 2 <= STREAMFILE_STDIO_REFILL_MAX)
+      streamfile->refill_size *= 2;
+  } else {
+    streamfile->refill_size = STREAMFILE_DEFAULT_BUFFER_SIZE;
+  }
+
+  if (streamfile->refill_size > streamfile->buffersize) {
+    uint8_t *buffer = (uint8_t *)realloc(streamfile->buffer, streamfile->refill_size);
+    if (buffer) {
+      streamfile->buffer = buffer;
+      streamfile->buffersize = streamfile->refill_size;
+    } else {
+      streamfile->refill_size = streamfile->buffersize;
+    }
+  }
+
+  streamfile->validsize = 0;
+  streamfile->offset = offset;
+
+  // the shared file may have been moved by another channel
+  if (file->offset != offset) {
+    if (file->vfsFile->fseek(offset, VFS_SEEK_SET) != 0) {
+      file->offset = -1;
+      streamfile->error_count++;
+      return 0;
+    }
+    file->offset = offset;
+  }
+
+  streamfile->validsize = file->vfsFile->fread(streamfile->buffer, 1, streamfile->refill_size);
+  file->offset += streamfile->validsize;
+  streamfile->bytes_read += streamfile->validsize;
+  streamfile->sf.stats.bytes_read += streamfile->validsize;
+  streamfile->sf.stats.refill_size = streamfile->refill_size;
+  return streamfile->validsize > 0;
+}
 
 static size_t read_vfs(VFSSTREAMFILE *streamfile, uint8_t *dest, off_t offset,
                        size_t length) {
-  size_t sz;
-  // if the offsets don't match, then we need to perform a seek
-  if (streamfile->offset != offset) {
-    streamfile->vfsFile->fseek(offset, VFS_SEEK_SET);
-    streamfile->offset = offset;
+  size_t length_read_total = 0;
+
+  if (!streamfile || !dest || length <= 0 || offset < 0)
+    return 0;
+
+  while (length > 0) {
+    size_t length_to_read;
+
+    // request outside the buffer: refill
+    if (!(offset >= streamfile->offset && offset < streamfile->offset + (off_t)streamfile->validsize)) {
+      if (offset >= (off_t)streamfile->file->filesize) {
+        streamfile->offset = streamfile->file->filesize;
+        streamfile->validsize = 0;
+        break;
+      }
+      if (!refill_vfs(streamfile, offset))
+        break;
+    }
+
+    length_to_read = streamfile->validsize - (offset - streamfile->offset);
+    if (length_to_read > length)
+      length_to_read = length;
+    memcpy(dest, streamfile->buffer + (offset - streamfile->offset), length_to_read);
+    length_read_total += length_to_read;
+    length -= length_to_read;
+    dest += length_to_read;
+    offset += length_to_read;
   }
 
-  sz = streamfile->vfsFile->fread(dest, 1, length);
-  // increment our current offset
-  streamfile->offset += sz;
+  if (length > 0)
+    streamfile->error_count++;
+  return length_read_total;
+}
+
+static const uint8_t *peek_vfs(VFSSTREAMFILE *streamfile, off_t offset,
+                               size_t length, size_t *avail) {
+  if (!(offset >= streamfile->offset && offset < streamfile->offset + (off_t)streamfile->validsize)) {
+    if (offset < 0 || offset >= (off_t)streamfile->file->filesize || length > STREAMFILE_DEFAULT_BUFFER_SIZE)
+      return NULL;
+    if (!refill_vfs(streamfile, offset))
+      return NULL;
+  }
 
-  return sz;
+  *avail = streamfile->validsize - (offset - streamfile->offset);
+  return streamfile->buffer + (offset - streamfile->offset);
 }
 
 static void close_vfs(VFSSTREAMFILE *streamfile) {
   debugMessage("close_vfs");
-  free(streamfile->vfsFile);
+  if (--streamfile->file->refcount == 0) {
+    delete streamfile->file->vfsFile;
+    free(streamfile->file);
+  }
+  free(streamfile->buffer);
   free(streamfile);
 }
 
 static size_t get_size_vfs(VFSSTREAMFILE *streamfile) {
-  return streamfile->vfsFile->fsize();
+  return streamfile->file->filesize;
 }
 
 static size_t get_offset_vfs(VFSSTREAMFILE *streamfile) {
@@ -59,16 +155,28 @@ static void get_realname_vfs(VFSSTREAMFILE *streamfile, char *buffer,
   buffer[length - 1] = '\0';
 }
 
+static size_t get_bytes_read_vfs(VFSSTREAMFILE *streamfile) {
+  return streamfile->bytes_read;
+}
+
+static int get_error_count_vfs(VFSSTREAMFILE *streamfile) {
+  return streamfile->error_count;
+}
+
 static STREAMFILE *open_vfs_impl(VFSSTREAMFILE *streamfile,
                                  const char *const filename,
                                  size_t buffersize) {
   if (!filename)
     return NULL;
 
+  // same path (a new channel): share the opened file
+  if (!strcmp(streamfile->name, filename))
+    return open_vfs_by_shared(streamfile->file, filename);
+
   return open_vfs(filename);
 }
 
-STREAMFILE *open_vfs_by_VFSFILE(VFSFile *file, const char *path) {
+static STREAMFILE *open_vfs_by_shared(VFSSHAREDFILE *file, const char *path) {
   VFSSTREAMFILE *streamfile = (VFSSTREAMFILE *)malloc(sizeof(VFSSTREAMFILE));
   if (!streamfile)
     return NULL;
@@ -76,6 +184,14 @@ STREAMFILE *open_vfs_by_VFSFILE(VFSFile *file, const char *path) {
   // success, set our pointers
   memset(streamfile, 0, sizeof(VFSSTREAMFILE));
 
+  streamfile->buffersize = STREAMFILE_DEFAULT_BUFFER_SIZE;
+  streamfile->buffer = (uint8_t *)malloc(streamfile->buffersize);
+  if (!streamfile->buffer) {
+    free(streamfile);
+    return NULL;
+  }
+  streamfile->refill_size = STREAMFILE_DEFAULT_BUFFER_SIZE;
+
   streamfile->sf.read = read_vfs;
   streamfile->sf.get_size = get_size_vfs;
   streamfile->sf.get_offset = get_offset_vfs;
@@ -83,14 +199,18 @@ STREAMFILE *open_vfs_by_VFSFILE(VFSFile *file, const char *path) {
   streamfile->sf.get_realname = get_realname_vfs;
   streamfile->sf.open = open_vfs_impl;
   streamfile->sf.close = close_vfs;
+  streamfile->sf.get_bytes_read = get_bytes_read_vfs;
+  streamfile->sf.get_error_count = get_error_count_vfs;
+  streamfile->sf.peek = peek_vfs;
 
-  streamfile->vfsFile = file;
-  streamfile->offset = 0;
+  streamfile->file = file;
+  file->refcount++;
   strncpy(streamfile->name, path, sizeof(streamfile->name));
   streamfile->name[sizeof(streamfile->name) - 1] = '\0';
   {
+    // non-local URIs (http, sftp...) have no filename
     gchar *realname = g_filename_from_uri(path, NULL, NULL);
-    strncpy(streamfile->realname, realname, sizeof(streamfile->realname));
+    strncpy(streamfile->realname, realname ? realname : path, sizeof(streamfile->realname));
     streamfile->realname[sizeof(streamfile->realname) - 1] = '\0';
     g_free(realname);
   }
@@ -98,12 +218,34 @@ STREAMFILE *open_vfs_by_VFSFILE(VFSFile *file, const char *path) {
   return &streamfile->sf;
 }
 
+STREAMFILE *open_vfs_by_VFSFILE(VFSFile *vfsFile, const char *path) {
+  STREAMFILE *streamfile;
+  VFSSHAREDFILE *file = (VFSSHAREDFILE *)calloc(1, sizeof(VFSSHAREDFILE));
+  if (!file)
+    return NULL;
+
+  file->vfsFile = vfsFile;
+  file->offset = vfsFile->ftell();
+  file->filesize = vfsFile->fsize();
+
+  streamfile = open_vfs_by_shared(file, path);
+  if (!streamfile) {
+    free(file);
+    return NULL;
+  }
+  return streamfile;
+}
+
 STREAMFILE *open_vfs(const char *path) {
+  STREAMFILE *streamfile;
   VFSFile *vfsFile = new VFSFile(path, "rb");
   if (!vfsFile || !*vfsFile) {
     delete vfsFile;
     return NULL;
   }
 
-  return open_vfs_by_VFSFILE(vfsFile, path);
+  streamfile = open_vfs_by_VFSFILE(vfsFile, path);
+  if (!streamfile)
+    delete vfsFile;
+  return streamfile;
 }
@@ -64,13 +64,24 @@ int32_t SASSC_steps[256] =
 };
 
 void decode_SASSC(VGMSTREAMCHANNEL * stream, sample * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do) {
+    uint8_t data_buf[0x100];
     int i;
-    int32_t sample_count;
+    int32_t sample_count = 0;
     int32_t hist = stream->adpcm_history1_32;
 
-    for(i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
-        hist = hist + SASSC_steps[(uint8_t)read_8bit(stream->offset+i,stream->streamfile)];
-        outbuf[sample_count] = clamp16(hist);
+    /* one byte per sample and no frames, so fetch bytes in chunks rather than read_8bit per sample */
+    while (samples_to_do > 0) {
+        int chunk_samples = samples_to_do > (int)sizeof(data_buf) ? (int)sizeof(data_buf) : samples_to_do;
+        const uint8_t * data = read_streamfile_ptr(data_buf, stream->offset+first_sample, chunk_samples, stream->streamfile);
+        if (!data) data = data_buf; /* unreadable bytes are 0xFF, as read_8bit */
+
+        for (i=0; i<chunk_samples; i++,sample_count+=channelspacing) {
+            hist = hist + SASSC_steps[data[i]];
+            outbuf[sample_count] = clamp16(hist);
+        }
+
+        first_sample += chunk_samples;
+        samples_to_do -= chunk_samples;
     }
 
     stream->adpcm_history1_32 = hist;
@@ -19,7 +19,7 @@ void decode_at3plus(VGMSTREAM * vgmstream, sample * outbuf, int channelspacing,
 		if (data->samples_discard) blocks_to_decode = 8;
 		if (blocks_to_decode > max_blocks_to_decode) blocks_to_decode = max_blocks_to_decode;
 		while (blocks_to_decode--) {
-			ch->streamfile->read(ch->streamfile, code_buffer, ch->offset - blocks_to_decode * vgmstream->interleave_block_size, vgmstream->interleave_block_size);
+			read_streamfile(code_buffer, ch->offset - blocks_to_decode * vgmstream->interleave_block_size, vgmstream->interleave_block_size, ch->streamfile);
 			Atrac3plusDecoder_decodeFrame(data->handle, code_buffer, vgmstream->interleave_block_size, &data->channels, (void**)&data->buffer);
 		}
 		data->samples_discard = 0;
@@ -438,15 +438,18 @@ ffmpeg_codec_data * init_ffmpeg_config(STREAMFILE *streamFile, uint8_t * header,
     data->codec = avcodec_find_decoder(data->codecCtx->codec_id);
     if (!data->codec) goto fail;
 
-    if ((errcode = avcodec_open2(data->codecCtx, data->codec, NULL)) < 0) goto fail;
+    /* info only: stream params are already known from the demuxer, so don't open the decoder */
+    if (!streamFile->info_only) {
+        if ((errcode = avcodec_open2(data->codecCtx, data->codec, NULL)) < 0) goto fail;
 
-    data->lastDecodedFrame = av_frame_alloc();
-    if (!data->lastDecodedFrame) goto fail;
-    av_frame_unref(data->lastDecodedFrame);
+        data->lastDecodedFrame = av_frame_alloc();
+        if (!data->lastDecodedFrame) goto fail;
+        av_frame_unref(data->lastDecodedFrame);
 
-    data->lastReadPacket = malloc(sizeof(AVPacket));
-    if (!data->lastReadPacket) goto fail;
-    av_new_packet(data->lastReadPacket, 0);
+        data->lastReadPacket = malloc(sizeof(AVPacket));
+        if (!data->lastReadPacket) goto fail;
+        av_new_packet(data->lastReadPacket, 0);
+    }
 
     data->readNextPacket = 1;
     data->bytesConsumedFromDecodedFrame = INT_MAX;
@@ -487,6 +490,11 @@ ffmpeg_codec_data * init_ffmpeg_config(STREAMFILE *streamFile, uint8_t * header,
             break;
 
         default:
+            /* some demuxers leave the format to the (unopened) decoder */
+            if (streamFile->info_only) {
+                data->bitsPerSample = 16;
+                break;
+            }
             goto fail;
     }
 
@@ -505,16 +513,17 @@ ffmpeg_codec_data * init_ffmpeg_config(STREAMFILE *streamFile, uint8_t * header,
     if(data->frameSize == 0) /* some formats don't set frame_size but can get on request, and vice versa */
         data->frameSize = av_get_audio_frame_duration(data->codecCtx,0);
 
-    /* setup decode buffer */
-    data->sampleBufferBlock = FFMPEG_DEFAULT_BUFFER_SIZE;
-    data->sampleBuffer = av_malloc( data->sampleBufferBlock * (data->bitsPerSample / 8) * data->channels );
-    if (!data->sampleBuffer)
-        goto fail;
-
+    if (!streamFile->info_only) {
+        /* setup decode buffer */
+        data->sampleBufferBlock = FFMPEG_DEFAULT_BUFFER_SIZE;
+        data->sampleBuffer = av_malloc( data->sampleBufferBlock * (data->bitsPerSample / 8) * data->channels );
+        if (!data->sampleBuffer)
+            goto fail;
 
-    /* setup decent seeking for faulty formats */
-    errcode = init_seek(data);
-    if (errcode < 0) goto fail;
+        /* setup decent seeking for faulty formats */
+        errcode = init_seek(data);
+        if (errcode < 0) goto fail;
+    }
 
     /* expose start samples to be skipped (encoder delay, usually added by MDCT-based encoders like AAC/MP3/ATRAC3/XMA/etc)
      * get after init_seek because some demuxers like AAC only fill skip_samples for the first packet */
@@ -39,7 +39,7 @@ void decode_g719(VGMSTREAM * vgmstream, sample * outbuf, int channelspacing, int
     {
         VARDECL(int16_t,code_buffer);
         ALLOC(code_buffer, vgmstream->interleave_block_size / 2, int16_t);
-        vgmstream->ch[channel].streamfile->read(ch->streamfile, (uint8_t*)code_buffer, ch->offset, vgmstream->interleave_block_size);
+        read_streamfile((uint8_t*)code_buffer, ch->offset, vgmstream->interleave_block_size, ch->streamfile);
         g719_decode_frame(ch_data->handle, code_buffer, ch_data->buffer);
     }
 
@@ -38,7 +38,7 @@ void decode_g7221(VGMSTREAM * vgmstream, sample * outbuf, int channelspacing, in
     if (0 == vgmstream->samples_into_block)
     {
         int16_t code_buffer[960/8];
-        vgmstream->ch[channel].streamfile->read(ch->streamfile, (uint8_t*)code_buffer, ch->offset, vgmstream->interleave_block_size);
+        read_streamfile((uint8_t*)code_buffer, ch->offset, vgmstream->interleave_block_size, ch->streamfile);
         g7221_decode_frame(ch_data->handle, code_buffer, ch_data->buffer);
     }
 
@@ -40,12 +40,31 @@ static const int IMA_IndexTable[16] =
     -1, -1, -1, -1, 2, 4, 6, 8 
 };
 
+/* Nibbles are read through a small window of the STREAMFILE (empty when size is 0), refilled when an offset
+ * falls outside it, rather than with read_8bit per nibble. Bytes that can't be read are 0xFF, as read_8bit. */
+typedef struct {
+    off_t offset;
+    size_t size;
+    const uint8_t * data;
+    uint8_t buf[0x100];
+} ima_window;
+
+static inline uint8_t read_window_8bit(ima_window * window, off_t offset, STREAMFILE * streamfile) {
+    if (window->size == 0 || offset < window->offset || offset >= window->offset + (off_t)window->size) {
+        window->data = read_streamfile_ptr(window->buf, offset, sizeof(window->buf), streamfile);
+        if (!window->data) window->data = window->buf;
+        window->offset = offset;
+        window->size = sizeof(window->buf);
+    }
+    return window->data[offset - window->offset];
+}
+
 
 /* Standard IMA (most common) */
-static void std_ima_expand_nibble(VGMSTREAMCHANNEL * stream, off_t byte_offset, int nibble_shift, int32_t * hist1, int32_t * step_index) {
+static void std_ima_expand_nibble(uint8_t byte, int nibble_shift, int32_t * hist1, int32_t * step_index) {
     int sample_nibble, sample_decoded, step, delta;
 
-    sample_nibble = (read_8bit(byte_offset,stream->streamfile) >> nibble_shift)&0xf;
+    sample_nibble = (byte >> nibble_shift)&0xf;
     sample_decoded = *hist1;
     step = ADPCMTable[*step_index];
     delta = step >> 3;
@@ -64,10 +83,10 @@ static void std_ima_expand_nibble(VGMSTREAMCHANNEL * stream, off_t byte_offset,
 }
 
 /* Apple's IMA variation. Exactly the same except it uses 16b history (probably more sensitive to overflow/sign extend) */
-static void std_ima_expand_nibble_16(VGMSTREAMCHANNEL * stream, off_t byte_offset, int nibble_shift, int16_t * hist1, int32_t * step_index) {
+static void std_ima_expand_nibble_16(uint8_t byte, int nibble_shift, int16_t * hist1, int32_t * step_index) {
     int sample_nibble, sample_decoded, step, delta;
 
-    sample_nibble = (read_8bit(byte_offset,stream->streamfile) >> nibble_shift)&0xf;
+    sample_nibble = (byte >> nibble_shift)&0xf;
     sample_decoded = *hist1;
     step = ADPCMTable[*step_index];
     delta = step >> 3;
@@ -86,10 +105,10 @@ static void std_ima_expand_nibble_16(VGMSTREAMCHANNEL * stream, off_t byte_offse
 }
 
 /* 3DS IMA (Mario Golf, Mario Tennis; maybe other Camelot games) */
-static void n3ds_ima_expand_nibble(VGMSTREAMCHANNEL * stream, off_t byte_offset, int nibble_shift, int32_t * hist1, int32_t * step_index) {
+static void n3ds_ima_expand_nibble(uint8_t byte, int nibble_shift, int32_t * hist1, int32_t * step_index) {
     int sample_nibble, sample_decoded, step, delta;
 
-    sample_nibble = (read_8bit(byte_offset,stream->streamfile) >> nibble_shift)&0xf;
+    sample_nibble = (byte >> nibble_shift)&0xf;
     sample_decoded = *hist1;
 
     sample_decoded = sample_decoded << 3;
@@ -108,10 +127,10 @@ static void n3ds_ima_expand_nibble(VGMSTREAMCHANNEL * stream, off_t byte_offset,
 }
 
 /* update step_index before doing current sample */
-static void snds_ima_expand_nibble(VGMSTREAMCHANNEL * stream, off_t byte_offset, int nibble_shift, int32_t * hist1, int32_t * step_index) {
+static void snds_ima_expand_nibble(uint8_t byte, int nibble_shift, int32_t * hist1, int32_t * step_index) {
     int sample_nibble, sample_decoded, step, delta;
 
-    sample_nibble = (read_8bit(byte_offset,stream->streamfile) >> nibble_shift)&0xf;
+    sample_nibble = (byte >> nibble_shift)&0xf;
 
     *step_index += IMA_IndexTable[sample_nibble];
     if (*step_index < 0) *step_index=0;
@@ -127,10 +146,10 @@ static void snds_ima_expand_nibble(VGMSTREAMCHANNEL * stream, off_t byte_offset,
 }
 
 /* algorithm by aluigi, unsure if it's a known IMA variation */
-static void otns_ima_expand_nibble(VGMSTREAMCHANNEL * stream, off_t byte_offset, int nibble_shift, int32_t * hist1, int32_t * step_index) {
+static void otns_ima_expand_nibble(uint8_t byte, int nibble_shift, int32_t * hist1, int32_t * step_index) {
     int sample_nibble, sample_decoded, step, delta;
 
-    sample_nibble = (read_8bit(byte_offset,stream->streamfile) >> nibble_shift)&0xf;
+    sample_nibble = (byte >> nibble_shift)&0xf;
     sample_decoded = *hist1;
     step = ADPCMTable[*step_index];
     delta = 0;
@@ -150,10 +169,10 @@ static void otns_ima_expand_nibble(VGMSTREAMCHANNEL * stream, off_t byte_offset,
 }
 
 /* algorithm by Zench (https://bitbucket.org/Zenchreal/decubisnd) */
-static void ubi_ima_expand_nibble(VGMSTREAMCHANNEL * stream, off_t byte_offset, int nibble_shift, int32_t * hist1, int32_t * step_index) {
+static void ubi_ima_expand_nibble(uint8_t byte, int nibble_shift, int32_t * hist1, int32_t * step_index) {
     int sample_nibble, sample_decoded, step, delta;
 
-    sample_nibble = (read_8bit(byte_offset,stream->streamfile) >> nibble_shift)&0xf;
+    sample_nibble = (byte >> nibble_shift)&0xf;
 
     step = ADPCMTable[*step_index];
     *step_index += IMA_IndexTable[sample_nibble];
@@ -180,6 +199,7 @@ void decode_standard_ima(VGMSTREAMCHANNEL * stream, sample * outbuf, int channel
 
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
+    ima_window window;
 
     /* external interleave */
 
@@ -188,6 +208,7 @@ void decode_standard_ima(VGMSTREAMCHANNEL * stream, sample * outbuf, int channel
     if (step_index > 88) step_index=88;
 
     /* decode nibbles */
+    window.size = 0;
     for (i = first_sample; i < first_sample + samples_to_do; i++, sample_count += channelspacing) {
         off_t byte_offset = is_stereo ?
                 stream->offset + i :    /* stereo: one nibble per channel */
@@ -196,7 +217,7 @@ void decode_standard_ima(VGMSTREAMCHANNEL * stream, sample * outbuf, int channel
                 is_stereo ? (!(channel&1) ? 4:0) : (!(i&1) ? 4:0) : /* even = high, odd = low */
                 is_stereo ? (!(channel&1) ? 0:4) : (!(i&1) ? 0:4);  /* even = low, odd = high */
 
-        std_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        std_ima_expand_nibble(read_window_8bit(&window, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)(hist1);
     }
 
@@ -209,16 +230,18 @@ void decode_3ds_ima(VGMSTREAMCHANNEL * stream, sample * outbuf, int channelspaci
 
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
+    ima_window window;
 
     //external interleave
 
     //no header
 
+    window.size = 0;
     for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
         off_t byte_offset = stream->offset + i/2;
         int nibble_shift = (i&1?4:0); //low nibble order
 
-        n3ds_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        n3ds_ima_expand_nibble(read_window_8bit(&window, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)(hist1);
     }
 
@@ -231,16 +254,18 @@ void decode_snds_ima(VGMSTREAMCHANNEL * stream, sample * outbuf, int channelspac
 
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
+    ima_window window;
 
     //external interleave
 
     //no header
 
+    window.size = 0;
     for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
         off_t byte_offset = stream->offset + i;//one nibble per channel
         int nibble_shift = (channel==0?0:4); //high nibble first, based on channel
 
-        snds_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        snds_ima_expand_nibble(read_window_8bit(&window, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)(hist1);
     }
 
@@ -253,18 +278,20 @@ void decode_otns_ima(VGMSTREAM * vgmstream, VGMSTREAMCHANNEL * stream, sample *
 
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
+    ima_window window;
 
     //internal/byte interleave
 
     //no header
 
+    window.size = 0;
     for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
         off_t byte_offset = stream->offset + (vgmstream->channels==1 ? i/2 : i); //one nibble per channel if stereo
         int nibble_shift = (vgmstream->channels==1) ? //todo simplify
                     (i&1?0:4) : //high nibble first(?)
                     (channel==0?4:0); //low=ch0, high=ch1 (this is correct compared to vids)
 
-        otns_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        otns_ima_expand_nibble(read_window_8bit(&window, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)(hist1);
     }
 
@@ -282,6 +309,7 @@ void decode_ms_ima(VGMSTREAM * vgmstream,VGMSTREAMCHANNEL * stream, sample * out
 
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
+    ima_window window;
 
     //internal interleave (configurable size), mixed channels (4 byte per ch)
     int block_samples = (vgmstream->interleave_block_size - 4*vgmstream->channels) * 2 / vgmstream->channels;
@@ -297,11 +325,12 @@ void decode_ms_ima(VGMSTREAM * vgmstream,VGMSTREAMCHANNEL * stream, sample * out
         if (step_index > 88) step_index=88;
     }
 
+    window.size = 0;
     for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
         off_t byte_offset = stream->offset + 4*channel + 4*vgmstream->channels + i/8*4*vgmstream->channels + (i%8)/2;
         int nibble_shift = (i&1?4:0); //low nibble first
 
-        std_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        std_ima_expand_nibble(read_window_8bit(&window, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)(hist1);
     }
 
@@ -319,6 +348,7 @@ void decode_xbox_ima(VGMSTREAM * vgmstream,VGMSTREAMCHANNEL * stream, sample * o
 
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
+    ima_window window;
 
     off_t offset = stream->offset;
 
@@ -339,6 +369,7 @@ void decode_xbox_ima(VGMSTREAM * vgmstream,VGMSTREAMCHANNEL * stream, sample * o
         if (step_index > 88) step_index=88;
     }
 
+    window.size = 0;
     for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
         int nibble_shift;
 
@@ -347,7 +378,7 @@ void decode_xbox_ima(VGMSTREAM * vgmstream,VGMSTREAMCHANNEL * stream, sample * o
             stream->offset + 4*(channel%2) + 4*2 + i/8*4*2 + (i%8)/2;
         nibble_shift = (i&1?4:0); //low nibble first
 
-        std_ima_expand_nibble(stream, offset,nibble_shift, &hist1, &step_index);
+        std_ima_expand_nibble(read_window_8bit(&window, offset, stream->streamfile), nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)(hist1);
     }
 
@@ -364,23 +395,19 @@ void decode_xbox_ima(VGMSTREAM * vgmstream,VGMSTREAMCHANNEL * stream, sample * o
     stream->adpcm_step_index = step_index;
 }
 
-/* mono XBOX ADPCM for interleave */
-void decode_xbox_ima_int(VGMSTREAMCHANNEL * stream, sample * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int channel) {
-    int i, sample_count = 0, num_frame;
+/* mono XBOX ADPCM for interleave, decodes samples of one 0x24 frame (header + 0x20 bytes of nibbles) */
+void decode_xbox_ima_int_frame(VGMSTREAMCHANNEL * stream, sample * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, const uint8_t * frame) {
+    int i, sample_count = 0;
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
 
     //external interleave
     int block_samples = (0x24 - 0x4) * 2; /* block size - header, 2 samples per byte */
-    num_frame = first_sample / block_samples;
-    first_sample = first_sample % block_samples;
 
     //normal header
     if (first_sample == 0) {
-        off_t header_offset = stream->offset + 0x24*num_frame;
-
-        hist1 = read_16bitLE(header_offset,stream->streamfile);
-        step_index = read_8bit(header_offset+2,stream->streamfile);
+        hist1 = get_16bitLE((uint8_t *)frame+0x00);
+        step_index = (int8_t)frame[0x02];
         if (step_index < 0) step_index=0;
         if (step_index > 88) step_index=88;
 
@@ -392,12 +419,11 @@ void decode_xbox_ima_int(VGMSTREAMCHANNEL * stream, sample * outbuf, int channel
     }
 
     for (i=first_sample; i < first_sample + samples_to_do; i++) { /* first_sample + samples_to_do should be block_samples at most */
-        off_t byte_offset = (stream->offset + 0x24*num_frame + 0x4) + (i-1)/2;
         int nibble_shift = ((i-1)&1?4:0); //low nibble first
 
         //last nibble/sample in block is ignored (next header sample contains it)
         if (i < block_samples) {
-            std_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+            std_ima_expand_nibble(frame[0x4 + (i-1)/2], nibble_shift, &hist1, &step_index);
             outbuf[sample_count] = (short)(hist1);
             sample_count += channelspacing;
         }
@@ -412,6 +438,7 @@ void decode_nds_ima(VGMSTREAMCHANNEL * stream, sample * outbuf, int channelspaci
 
     int32_t hist1 = stream->adpcm_history1_16;//todo unneeded 16?
     int step_index = stream->adpcm_step_index;
+    ima_window window;
 
     //external interleave
 
@@ -425,11 +452,12 @@ void decode_nds_ima(VGMSTREAMCHANNEL * stream, sample * outbuf, int channelspaci
         //todo clip step_index?
     }
 
+    window.size = 0;
     for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
         off_t byte_offset = stream->offset + 4 + i/2;
         int nibble_shift = (i&1?4:0); //low nibble first
 
-        std_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        std_ima_expand_nibble(read_window_8bit(&window, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)(hist1);
     }
 
@@ -442,6 +470,7 @@ void decode_dat4_ima(VGMSTREAMCHANNEL * stream, sample * outbuf, int channelspac
 
     int32_t hist1 = stream->adpcm_history1_16;//todo unneeded 16?
     int step_index = stream->adpcm_step_index;
+    ima_window window;
 
     //external interleave
 
@@ -455,11 +484,12 @@ void decode_dat4_ima(VGMSTREAMCHANNEL * stream, sample * outbuf, int channelspac
         //todo clip step_index?
     }
 
+    window.size = 0;
     for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
         off_t byte_offset = stream->offset + 4 + i/2;
         int nibble_shift = (i&1?0:4); //high nibble first
 
-        std_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        std_ima_expand_nibble(read_window_8bit(&window, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)(hist1);
     }
 
@@ -472,6 +502,7 @@ void decode_rad_ima(VGMSTREAM * vgmstream,VGMSTREAMCHANNEL * stream, sample * ou
 
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
+    ima_window window;
 
     //internal interleave (configurable size), mixed channels (4 byte per ch)
     int block_samples = (vgmstream->interleave_block_size - 4*vgmstream->channels) * 2 / vgmstream->channels;
@@ -487,11 +518,12 @@ void decode_rad_ima(VGMSTREAM * vgmstream,VGMSTREAMCHANNEL * stream, sample * ou
         if (step_index > 88) step_index=88;
     }
 
+    window.size = 0;
     for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
         off_t byte_offset = stream->offset + 4*vgmstream->channels + channel + i/2*vgmstream->channels;
         int nibble_shift = (i&1?4:0); //low nibble first
 
-        std_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        std_ima_expand_nibble(read_window_8bit(&window, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)(hist1);
     }
 
@@ -502,31 +534,27 @@ void decode_rad_ima(VGMSTREAM * vgmstream,VGMSTREAMCHANNEL * stream, sample * ou
     stream->adpcm_step_index = step_index;
 }
 
-void decode_rad_ima_mono(VGMSTREAMCHANNEL * stream, sample * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do) {
+/* decodes samples of one 0x14 frame (inverted header + 0x10 bytes of nibbles) */
+void decode_rad_ima_mono_frame(VGMSTREAMCHANNEL * stream, sample * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, const uint8_t * frame) {
     int i, sample_count;
 
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
 
     //semi-external interleave?
-    int block_samples = 0x14 * 2;
-    first_sample = first_sample % block_samples;
 
     //inverted header
     if (first_sample == 0) {
-        off_t header_offset = stream->offset;
-
-        step_index = read_16bitLE(header_offset,stream->streamfile);
-        hist1 = read_16bitLE(header_offset+2,stream->streamfile);
+        step_index = get_16bitLE((uint8_t *)frame+0x00);
+        hist1 = get_16bitLE((uint8_t *)frame+0x02);
         if (step_index < 0) step_index=0;
         if (step_index > 88) step_index=88;
     }
 
     for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
-        off_t byte_offset = stream->offset + 4 + i/2;
         int nibble_shift = (i&1?4:0); //low nibble first
 
-        std_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        std_ima_expand_nibble(frame[0x4 + i/2], nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)(hist1);
     }
 
@@ -534,31 +562,26 @@ void decode_rad_ima_mono(VGMSTREAMCHANNEL * stream, sample * outbuf, int channel
     stream->adpcm_step_index = step_index;
 }
 
-void decode_apple_ima4(VGMSTREAMCHANNEL * stream, sample * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do) {
-    int i, sample_count, num_frame;
+/* decodes samples of one 0x22 frame (2-byte header + 0x20 bytes of nibbles) */
+void decode_apple_ima4_frame(VGMSTREAMCHANNEL * stream, sample * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, const uint8_t * frame) {
+    int i, sample_count;
     int16_t hist1 = stream->adpcm_history1_16;//todo unneeded 16?
     int step_index = stream->adpcm_step_index;
 
     //external interleave
-    int block_samples = (0x22 - 0x2) * 2;
-    num_frame = first_sample / block_samples;
-    first_sample = first_sample % block_samples;
 
     //2-byte header
     if (first_sample == 0) {
-        off_t header_offset = stream->offset + 0x22*num_frame;
-
-        hist1 = (int16_t)((uint16_t)read_16bitBE(header_offset,stream->streamfile) & 0xff80);
-        step_index = read_8bit(header_offset+1,stream->streamfile) & 0x7f;
+        hist1 = (int16_t)((uint16_t)get_16bitBE((uint8_t *)frame+0x00) & 0xff80);
+        step_index = frame[0x01] & 0x7f;
         if (step_index < 0) step_index=0;
         if (step_index > 88) step_index=88;
     }
 
     for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
-        off_t byte_offset = (stream->offset + 0x22*num_frame + 0x2) + i/2;
         int nibble_shift = (i&1?4:0); //low nibble first
 
-        std_ima_expand_nibble_16(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        std_ima_expand_nibble_16(frame[0x2 + i/2], nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)(hist1);
     }
 
@@ -571,6 +594,7 @@ void decode_fsb_ima(VGMSTREAM * vgmstream, VGMSTREAMCHANNEL * stream, sample * o
 
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
+    ima_window window;
 
     //internal interleave
     int block_samples = (36 - 4) * 2; /* block size - header, 2 samples per byte */
@@ -587,11 +611,12 @@ void decode_fsb_ima(VGMSTREAM * vgmstream, VGMSTREAMCHANNEL * stream, sample * o
         if (step_index > 88) step_index=88;
     }
 
+    window.size = 0;
     for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
         off_t byte_offset = stream->offset + 4*vgmstream->channels + 2*channel + i/4*2*vgmstream->channels + (i%4)/2;//2-byte per channel
         int nibble_shift = (i&1?4:0); //low nibble first
 
-        std_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        std_ima_expand_nibble(read_window_8bit(&window, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)(hist1);
     }
 
@@ -608,6 +633,7 @@ void decode_wwise_ima(VGMSTREAM * vgmstream,VGMSTREAMCHANNEL * stream, sample *
 
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
+    ima_window window;
 
     //internal interleave (configurable size), block-interleave multichannel (ex. if block is 0xD8 in 6ch: 6 blocks of 4+0x20)
     int block_samples = (vgmstream->interleave_block_size - 4*vgmstream->channels) * 2 / vgmstream->channels;
@@ -630,13 +656,14 @@ void decode_wwise_ima(VGMSTREAM * vgmstream,VGMSTREAMCHANNEL * stream, sample *
         samples_to_do -= 1;
     }
 
+    window.size = 0;
     for (i=first_sample; i < first_sample + samples_to_do; i++) { /* first_sample + samples_to_do should be block_samples at most */
         off_t byte_offset = stream->offset + (vgmstream->interleave_block_size / vgmstream->channels)*channel + 4 + (i-1)/2;
         int nibble_shift = ((i-1)&1?4:0); //low nibble first
 
         //last nibble/sample in block is ignored (next header sample contains it)
         if (i < block_samples) {
-            std_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+            std_ima_expand_nibble(read_window_8bit(&window, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
             outbuf[sample_count] = (short)(hist1);
             sample_count+=channelspacing;
             //todo atenuation: apparently from hcs's analysis Wwise IMA decodes nibbles slightly different, reducing dbs
@@ -656,6 +683,7 @@ void decode_ref_ima(VGMSTREAM * vgmstream,VGMSTREAMCHANNEL * stream, sample * ou
 
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
+    ima_window window;
 
     //internal interleave (configurable size), mixed channels (4 byte per ch)
     int block_channel_size = (vgmstream->interleave_block_size - 4*vgmstream->channels) / vgmstream->channels;
@@ -673,11 +701,12 @@ void decode_ref_ima(VGMSTREAM * vgmstream,VGMSTREAMCHANNEL * stream, sample * ou
     }
 
     //layout: all nibbles from one channel, then all nibbles from other
+    window.size = 0;
     for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
         off_t byte_offset = stream->offset + 4*vgmstream->channels + block_channel_size*channel + i/2;
         int nibble_shift = (i&1?4:0); //low nibble first
 
-        std_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        std_ima_expand_nibble(read_window_8bit(&window, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)(hist1);
     }
 
@@ -693,6 +722,7 @@ void decode_awc_ima(VGMSTREAMCHANNEL * stream, sample * outbuf, int channelspaci
 
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
+    ima_window window;
 
     //internal interleave, mono
     int block_samples = (0x800 - 4) * 2;
@@ -708,11 +738,12 @@ void decode_awc_ima(VGMSTREAMCHANNEL * stream, sample * outbuf, int channelspaci
         if (step_index > 88) step_index=88;
     }
 
+    window.size = 0;
     for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
         off_t byte_offset = stream->offset + 4 + i/2;
         int nibble_shift = (i&1?4:0); //low nibble first
 
-        std_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        std_ima_expand_nibble(read_window_8bit(&window, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)(hist1);
     }
 
@@ -730,6 +761,7 @@ void decode_ubi_ima(VGMSTREAMCHANNEL * stream, sample * outbuf, int channelspaci
 
     int32_t hist1 = stream->adpcm_history1_32;
     int step_index = stream->adpcm_step_index;
+    ima_window window;
 
     //internal interleave
 
@@ -767,6 +799,7 @@ void decode_ubi_ima(VGMSTREAMCHANNEL * stream, sample * outbuf, int channelspaci
 
     first_sample -= 10; //todo fix hack (needed to adjust nibble offset below)
 
+    window.size = 0;
     for (i = first_sample; i < first_sample + samples_to_do; i++, sample_count += channelspacing) {
         off_t byte_offset = channelspacing == 1 ?
                 stream->offset + i/2 :  /* mono mode */
@@ -775,7 +808,7 @@ void decode_ubi_ima(VGMSTREAMCHANNEL * stream, sample * outbuf, int channelspaci
                 (!(i%2) ? 4:0) :        /* mono mode (high first) */
                 (channel==0 ? 4:0);     /* stereo mode (high=L,low=R) */
 
-        ubi_ima_expand_nibble(stream, byte_offset,nibble_shift, &hist1, &step_index);
+        ubi_ima_expand_nibble(read_window_8bit(&window, byte_offset, stream->streamfile), nibble_shift, &hist1, &step_index);
         outbuf[sample_count] = (short)(hist1); /* all samples are written */
     }
 
@@ -108,6 +108,12 @@ mpeg_codec_data *init_mpeg_codec_data(STREAMFILE *streamfile, off_t start_offset
         mpg123_open_feed(main_m);
     }
 
+    /* info only: format is known, decoder isn't needed anymore */
+    if (streamfile->info_only) {
+        mpg123_delete(data->m);
+        data->m = NULL;
+    }
+
     return data;
 
 fail:
@@ -152,6 +158,9 @@ mpeg_codec_data *init_mpeg_custom_codec_data(STREAMFILE *streamFile, off_t start
     data->streams = calloc(data->streams_size, sizeof(mpeg_custom_stream*));
     for (i=0; i < data->streams_size; i++) {
         data->streams[i] = calloc(1, sizeof(mpeg_custom_stream));
+        if (streamFile->info_only) /* decoders won't be used */
+            continue;
+
         data->streams[i]->m = init_mpg123_handle(); /* decoder not shared as may need several frames to decode)*/
         if (!data->streams[i]->m) goto fail;
 
@@ -178,21 +187,25 @@ fail:
 }
 
 
+/* mpg123_init isn't thread-safe, so it's called once (see vgm_once) */
+static vgm_once_flag mpg123_library_once = VGM_ONCE_INIT;
+static int mpg123_library_ok = 0;
+static void init_mpg123_library(void) {
+    mpg123_library_ok = (mpg123_init() == MPG123_OK);
+}
+
 static mpg123_handle * init_mpg123_handle() {
     mpg123_handle *m = NULL;
     int rc;
 
+    /* inits the library if needed */
+    vgm_once(&mpg123_library_once, init_mpg123_library);
+    if (!mpg123_library_ok)
+        goto fail;
+
     /* inits a new mpg123 handle */
     m = mpg123_new(NULL,&rc);
-    if (rc == MPG123_NOT_INITIALIZED) {
-        /* inits the library if needed */
-        if (mpg123_init() != MPG123_OK)
-            goto fail;
-        m = mpg123_new(NULL,&rc);
-        if (rc != MPG123_OK) goto fail;
-    } else if (rc != MPG123_OK) {
-        goto fail;
-    }
+    if (rc != MPG123_OK) goto fail;
 
     mpg123_param(m,MPG123_REMOVE_FLAGS,MPG123_GAPLESS,0.0); /* wonky support */
     mpg123_param(m,MPG123_RESYNC_LIMIT, -1, 0x10000); /* should be enough */
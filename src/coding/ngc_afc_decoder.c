@@ -19,13 +19,12 @@ const short afc_coef[16][2] =
 {0xfc00,0},
 {0xf800,0}};
 
-void decode_ngc_afc(VGMSTREAMCHANNEL * stream, sample * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do) {
-    int i=first_sample;
+/* decodes samples of one 0x09 frame (header + 16 nibbles) */
+void decode_ngc_afc_frame(VGMSTREAMCHANNEL * stream, sample * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, const uint8_t * frame) {
+    int i;
     int32_t sample_count;
 
-    int framesin = first_sample/16;
-
-    int8_t header = read_8bit(framesin*9+stream->offset,stream->streamfile);
+    int8_t header = frame[0];
     int32_t scale = 1 << ((header>>4) & 0xf);
     int coef_index = (header & 0xf);
     int32_t hist1 = stream->adpcm_history1_16;
@@ -35,10 +34,8 @@ void decode_ngc_afc(VGMSTREAMCHANNEL * stream, sample * outbuf, int channelspaci
     /*printf("offset: %x\nscale: %d\nindex: %d (%lf,%lf)\nhist: %d %d\n",
             (unsigned)stream->offset,scale,coef_index,coef1/2048.0,coef2/2048.0,hist1,hist2);*/
 
-    first_sample = first_sample%16;
-
     for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
-        int sample_byte = read_8bit(framesin*9+stream->offset+1+i/2,stream->streamfile);
+        int sample_byte = (int8_t)frame[1+i/2];
 
         outbuf[sample_count] = clamp16((
                  (((i&1?
@@ -1,20 +1,17 @@
 #include "coding.h"
 #include "../util.h"
 
-void decode_ngc_dtk(VGMSTREAMCHANNEL * stream, sample * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int channel) {
+/* decodes samples of one 0x20 frame (4 header bytes + 28 bytes of nibbles, low nibble = left, high = right) */
+void decode_ngc_dtk_frame(VGMSTREAMCHANNEL * stream, sample * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, int channel, const uint8_t * frame) {
     int i=first_sample;
     int32_t sample_count;
 
-    int framesin = first_sample/28;
-
-    uint8_t q = read_8bit(framesin*32+stream->offset+channel,stream->streamfile);
+    uint8_t q = frame[channel];
     int32_t hist1 = stream->adpcm_history1_32;
     int32_t hist2 = stream->adpcm_history2_32;
 
-    first_sample = first_sample%28;
-
     for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
-        int sample_byte = read_8bit(framesin*32+stream->offset+4+i,stream->streamfile);
+        int sample_byte = (int8_t)frame[4+i];
 
         int32_t hist=0;
 
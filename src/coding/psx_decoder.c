@@ -42,8 +42,8 @@ static const int8_t VAG_coefs[5][2] = {
  *  0x8+ Not valid
  */
 
-/* default */
-void decode_psx(VGMSTREAMCHANNEL * stream, sample * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do) {
+/* default, decodes samples of one 0x10 frame (header + flag + 28 nibbles) */
+void decode_psx_frame(VGMSTREAMCHANNEL * stream, sample * outbuf, int channelspacing, int32_t first_sample, int32_t samples_to_do, const uint8_t * frame) {
 
 	int predict_nr, shift_factor, sample;
 	int32_t hist1=stream->adpcm_history1_32;
@@ -54,21 +54,17 @@ void decode_psx(VGMSTREAMCHANNEL * stream, sample * outbuf, int channelspacing,
 	int32_t sample_count;
 	uint8_t flag;
 
-	int framesin = first_sample/28;
-
-	predict_nr = read_8bit(stream->offset+framesin*16,stream->streamfile) >> 4;
-	shift_factor = read_8bit(stream->offset+framesin*16,stream->streamfile) & 0xf;
-	flag = read_8bit(stream->offset+framesin*16+1,stream->streamfile); /* only lower nibble needed */
+	predict_nr = (int8_t)frame[0] >> 4;
+	shift_factor = frame[0] & 0xf;
+	flag = frame[1]; /* only lower nibble needed */
 
-	first_sample = first_sample % 28;
-	
 	for (i=first_sample,sample_count=0; i<first_sample+samples_to_do; i++,sample_count+=channelspacing) {
 
 		sample=0;
 
 		if(flag<0x07) {
 		
-			short sample_byte = (short)read_8bit(stream->offset+(framesin*16)+2+i/2,stream->streamfile);
+			short sample_byte = (short)(int8_t)frame[2+i/2];
 
 			scale = ((i&1 ? /* odd/even byte */
 				     sample_byte >> 4 :
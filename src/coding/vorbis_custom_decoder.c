@@ -57,9 +57,11 @@ vorbis_custom_codec_data * init_vorbis_custom_codec_data(STREAMFILE *streamFile,
 
     data->op.b_o_s = 0; /* end of fake headers */
 
-    /* init vorbis global and block state */
-    if (vorbis_synthesis_init(&data->vd,&data->vi) != 0) goto fail;
-    if (vorbis_block_init(&data->vd,&data->vb) != 0) goto fail;
+    /* init vorbis global and block state (not needed if only info is wanted) */
+    if (!streamFile->info_only) {
+        if (vorbis_synthesis_init(&data->vd,&data->vi) != 0) goto fail;
+        if (vorbis_block_init(&data->vd,&data->vb) != 0) goto fail;
+    }
 
 
     /* write output */
@@ -387,6 +387,42 @@ const char ** vgmstream_get_formats(size_t * size) {
     return extension_list;
 }
 
+/* extension_list indexes sorted by name, for lookups */
+static int format_indexes[sizeof(extension_list) / sizeof(char*)];
+static vgm_once_flag format_indexes_once = VGM_ONCE_INIT;
+
+static int compare_format_index(const void * a, const void * b) {
+    return strcmp(extension_list[*(const int *)a], extension_list[*(const int *)b]);
+}
+
+/* builds the sorted index (once, see vgm_once) */
+static void build_format_indexes(void) {
+    size_t i, count = sizeof(extension_list) / sizeof(char*);
+
+    for (i = 0; i < count; i++) {
+        format_indexes[i] = i;
+    }
+    qsort(format_indexes, count, sizeof(int), compare_format_index);
+}
+
+int vgmstream_get_format_index(const char * ext) {
+    int lo = 0, hi = (sizeof(extension_list) / sizeof(char*)) - 1;
+
+    vgm_once(&format_indexes_once, build_format_indexes);
+
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        int cmp = strcmp(ext, extension_list[format_indexes[mid]]);
+        if (cmp == 0)
+            return format_indexes[mid];
+        if (cmp < 0)
+            hi = mid - 1;
+        else
+            lo = mid + 1;
+    }
+    return -1;
+}
+
 
 /* internal description info */
 
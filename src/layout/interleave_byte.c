@@ -34,13 +34,18 @@ void render_vgmstream_interleave_byte(sample * buffer, int32_t sample_count, VGM
         {
             int i,j;
             for (j=0;j<vgmstream->channels;j++) {
-                for (i=0;i<frame_size;i++) {
-                    sample_data[i] = read_8bit(vgmstream->ch[j].offset+
-                            i/vgmstream->interleave_block_size*
-                            vgmstream->interleave_block_size*
-                            vgmstream->channels+
-                            i%vgmstream->interleave_block_size,
-                            vgmstream->ch[j].streamfile);
+                /* gather the channel's frame, a whole interleave at a time */
+                for (i=0;i<frame_size;i+=vgmstream->interleave_block_size) {
+                    size_t chunk_size = vgmstream->interleave_block_size;
+                    size_t chunk_read;
+                    if (chunk_size > frame_size - i)
+                        chunk_size = frame_size - i;
+
+                    chunk_read = read_streamfile(sample_data+i,
+                            vgmstream->ch[j].offset+i*vgmstream->channels,
+                            chunk_size, vgmstream->ch[j].streamfile);
+                    if (chunk_read < chunk_size) /* same as failed read_8bit */
+                        memset(sample_data+i+chunk_read, 0xFF, chunk_size-chunk_read);
                 }
                 decode_vgmstream_mem(vgmstream, samples_written,
                         samples_to_do, buffer, sample_data, j);
@@ -386,7 +386,7 @@ static STREAMFILE *open_aix_impl(AIXSTREAMFILE *streamfile,const char * const fi
 
 static STREAMFILE *open_aix_with_STREAMFILE(STREAMFILE *file,off_t start_offset,int stream_id)
 {
-  AIXSTREAMFILE *streamfile = malloc(sizeof(AIXSTREAMFILE));
+  AIXSTREAMFILE *streamfile = calloc(1,sizeof(AIXSTREAMFILE));
 
   if (!streamfile)
     return NULL;
@@ -400,10 +400,8 @@ static STREAMFILE *open_aix_with_STREAMFILE(STREAMFILE *file,off_t start_offset,
   streamfile->sf.get_realname = (void*)get_name_aix;
   streamfile->sf.open = (void*)open_aix_impl;
   streamfile->sf.close = (void*)close_aix;
-#ifdef PROFILE_STREAMFILE
   streamfile->sf.get_bytes_read = NULL;
   streamfile->sf.get_error_count = NULL;
-#endif
 
   streamfile->real_file = file;
   streamfile->current_physical_offset = 
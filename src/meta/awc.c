@@ -19,9 +19,15 @@ typedef struct {
     off_t stream_offset;
     off_t stream_size;
 
+    int entries;
+    off_t entries_offset;   /* stream ids and tag counts, then each stream's tags */
+
 } awc_header;
 
 static int parse_awc_header(STREAMFILE* streamFile, awc_header* awc);
+static int parse_awc_bank(STREAMFILE* streamFile, awc_header* awc);
+static int parse_awc_stream(STREAMFILE* streamFile, awc_header* awc, off_t tags_offset, int tag_count);
+static VGMSTREAM * build_awc_vgmstream(STREAMFILE *streamFile, awc_header* awc);
 
 
 /* AWC - from RAGE (Rockstar Advanced Game Engine) audio (Red Dead Redemption, Max Payne 3, GTA5) */
@@ -37,33 +43,46 @@ VGMSTREAM * init_vgmstream_awc(STREAMFILE *streamFile) {
     if (!parse_awc_header(streamFile, &awc))
         goto fail;
 
-    if (awc.is_encrypted)
+    vgmstream = build_awc_vgmstream(streamFile, &awc);
+    if (!vgmstream) goto fail;
+
+    return vgmstream;
+
+fail:
+    close_vgmstream(vgmstream);
+    return NULL;
+}
+
+static VGMSTREAM * build_awc_vgmstream(STREAMFILE *streamFile, awc_header* awc) {
+    VGMSTREAM * vgmstream = NULL;
+
+    if (awc->is_encrypted)
         goto fail;
 
 
     /* build the VGMSTREAM */
-    vgmstream = allocate_vgmstream(awc.channel_count, 0);
+    vgmstream = allocate_vgmstream(awc->channel_count, 0);
     if (!vgmstream) goto fail;
 
-    vgmstream->sample_rate = awc.sample_rate;
-    vgmstream->num_samples = awc.num_samples;
-    vgmstream->num_streams = awc.total_streams;
+    vgmstream->sample_rate = awc->sample_rate;
+    vgmstream->num_samples = awc->num_samples;
+    vgmstream->num_streams = awc->total_streams;
     vgmstream->meta_type = meta_AWC;
 
 
-    switch(awc.codec) {
+    switch(awc->codec) {
         case 0x01:      /* PCM (PC/PS3) [sfx, rarely] */
-            if (awc.is_music) goto fail; /* blocked_awc needs to be prepared */
-            vgmstream->coding_type = awc.big_endian ? coding_PCM16BE : coding_PCM16LE;
+            if (awc->is_music) goto fail; /* blocked_awc needs to be prepared */
+            vgmstream->coding_type = awc->big_endian ? coding_PCM16BE : coding_PCM16LE;
             vgmstream->layout_type = layout_interleave;
             vgmstream->interleave_block_size = 0x02;
             break;
 
         case 0x04:      /* IMA (PC) */
             vgmstream->coding_type = coding_AWC_IMA;
-            vgmstream->layout_type = awc.is_music ? layout_blocked_awc : layout_none;
-            vgmstream->full_block_size = awc.block_chunk;
-            vgmstream->codec_endian = awc.big_endian;
+            vgmstream->layout_type = awc->is_music ? layout_blocked_awc : layout_none;
+            vgmstream->full_block_size = awc->block_chunk;
+            vgmstream->codec_endian = awc->big_endian;
             break;
 
 #ifdef VGM_USE_MPEG
@@ -71,10 +90,10 @@ VGMSTREAM * init_vgmstream_awc(STREAMFILE *streamFile) {
             mpeg_custom_config cfg;
             memset(&cfg, 0, sizeof(mpeg_custom_config));
 
-            cfg.chunk_size = awc.block_chunk;
-            cfg.big_endian = awc.big_endian;
+            cfg.chunk_size = awc->block_chunk;
+            cfg.big_endian = awc->big_endian;
 
-            vgmstream->codec_data = init_mpeg_custom_codec_data(streamFile, awc.stream_offset, &vgmstream->coding_type, vgmstream->channels, MPEG_AWC, &cfg);
+            vgmstream->codec_data = init_mpeg_custom_codec_data(streamFile, awc->stream_offset, &vgmstream->coding_type, vgmstream->channels, MPEG_AWC, &cfg);
             if (!vgmstream->codec_data) goto fail;
             vgmstream->layout_type = layout_none;
 
@@ -84,17 +103,17 @@ VGMSTREAM * init_vgmstream_awc(STREAMFILE *streamFile) {
 
         case 0x05:      /* XMA2 (X360) */
         default:
-            VGM_LOG("AWC: unknown codec 0x%02x\n", awc.codec);
+            VGM_LOG("AWC: unknown codec 0x%02x\n", awc->codec);
             goto fail;
     }
 
 
     /* open files; channel offsets are updated below */
-    if (!vgmstream_open_stream(vgmstream,streamFile,awc.stream_offset))
+    if (!vgmstream_open_stream(vgmstream,streamFile,awc->stream_offset))
         goto fail;
 
     if (vgmstream->layout_type == layout_blocked_awc)
-        block_update_awc(awc.stream_offset, vgmstream);
+        block_update_awc(awc->stream_offset, vgmstream);
 
     return vgmstream;
 
@@ -107,13 +126,47 @@ fail:
 /* Parse Rockstar's AWC header (much info from LibertyV: https://github.com/koolkdev/libertyv).
  * Made of entries for N streams, each with a number of tags pointing to chunks (header, data, events, etc). */
 static int parse_awc_header(STREAMFILE* streamFile, awc_header* awc) {
-    int64_t (*read_64bit)(off_t,STREAMFILE*) = NULL;
     int32_t (*read_32bit)(off_t,STREAMFILE*) = NULL;
-    int16_t (*read_16bit)(off_t,STREAMFILE*) = NULL;
-    int i, ch, entries;
-    uint32_t flags, info_header, tag_count = 0, tags_skip = 0;
+    int i, target_stream = streamFile->stream_index;
+    uint32_t info_header, tag_count = 0, tags_skip = 0;
+
+    if (!parse_awc_bank(streamFile, awc))
+        goto fail;
+    read_32bit = awc->big_endian ? read_32bitBE : read_32bitLE;
+
+    if (awc->is_music) {
+        target_stream = 1; /* we only need id 0, though channels may have its own tags/chunks */
+    }
+    else {
+        if (target_stream == 0) target_stream = 1;
+        if (target_stream < 0 || target_stream > awc->total_streams || awc->total_streams < 1) goto fail;
+    }
+
+
+    /* get stream base info */
+    for (i = 0; i < awc->entries; i++) {
+        info_header = read_32bit(awc->entries_offset + 0x04*i, streamFile);
+        tag_count   = (info_header >> 29) & 0x7; /* 3b */
+        //id        = (info_header >>  0) & 0x1FFFFFFF; /* 29b */
+        if (target_stream-1 == i)
+            break;
+        tags_skip += tag_count; /* tags to skip to reach target's tags, in the next header */
+    }
+
+    if (!parse_awc_stream(streamFile, awc, awc->entries_offset + 0x04*awc->entries + 0x08*tags_skip, tag_count))
+        goto fail;
+
+    return 1;
+fail:
+    return 0;
+}
+
+/* bank-wide values, before any stream */
+static int parse_awc_bank(STREAMFILE* streamFile, awc_header* awc) {
+    int32_t (*read_32bit)(off_t,STREAMFILE*) = NULL;
+    int entries;
+    uint32_t flags;
     off_t off;
-    int target_stream = streamFile->stream_index;
 
     memset(awc,0,sizeof(awc_header));
 
@@ -124,15 +177,7 @@ static int parse_awc_header(STREAMFILE* streamFile, awc_header* awc) {
         goto fail;
 
     awc->big_endian = read_32bitBE(0x00,streamFile) == 0x54414441;
-    if (awc->big_endian) {
-        read_64bit = read_64bitBE;
-        read_32bit = read_32bitBE;
-        read_16bit = read_16bitBE;
-    } else {
-        read_64bit = read_64bitLE;
-        read_32bit = read_32bitLE;
-        read_16bit = read_16bitLE;
-    }
+    read_32bit = awc->big_endian ? read_32bitBE : read_32bitLE;
 
 
     flags = read_32bit(0x04,streamFile);
@@ -162,26 +207,36 @@ static int parse_awc_header(STREAMFILE* streamFile, awc_header* awc) {
     awc->is_music = (read_32bit(off + 0x00,streamFile) & 0x1FFFFFFF) == 0x00000000;
     if (awc->is_music) { /* all streams except id 0 is a channel */
         awc->total_streams = 1;
-        target_stream = 1; /* we only need id 0, though channels may have its own tags/chunks */
     }
     else { /* each stream is a single sound */
         awc->total_streams = entries;
-        if (target_stream == 0) target_stream = 1;
-        if (target_stream < 0 || target_stream > awc->total_streams || awc->total_streams < 1) goto fail;
     }
 
+    awc->entries = entries;
+    awc->entries_offset = off;
 
-    /* get stream base info */
-    for (i = 0; i < entries; i++) {
-        info_header = read_32bit(off + 0x04*i, streamFile);
-        tag_count   = (info_header >> 29) & 0x7; /* 3b */
-        //id        = (info_header >>  0) & 0x1FFFFFFF; /* 29b */
-        if (target_stream-1 == i)
-            break;
-        tags_skip += tag_count; /* tags to skip to reach target's tags, in the next header */
+    return 1;
+fail:
+    return 0;
+}
+
+/* a stream's values, from its tags */
+static int parse_awc_stream(STREAMFILE* streamFile, awc_header* awc, off_t tags_offset, int tag_count) {
+    int64_t (*read_64bit)(off_t,STREAMFILE*) = NULL;
+    int32_t (*read_32bit)(off_t,STREAMFILE*) = NULL;
+    int16_t (*read_16bit)(off_t,STREAMFILE*) = NULL;
+    int i, ch;
+    off_t off = tags_offset;
+
+    if (awc->big_endian) {
+        read_64bit = read_64bitBE;
+        read_32bit = read_32bitBE;
+        read_16bit = read_16bitBE;
+    } else {
+        read_64bit = read_64bitLE;
+        read_32bit = read_32bitLE;
+        read_16bit = read_16bitLE;
     }
-    off += 0x04*entries;
-    off += 0x08*tags_skip;
 
     /* get stream tags */
     for (i = 0; i < tag_count; i++) {
@@ -210,7 +265,7 @@ static int parse_awc_header(STREAMFILE* streamFile, awc_header* awc) {
                 awc->block_chunk = read_32bit(offset + 0x04,streamFile);
                 awc->channel_count = read_32bit(offset + 0x08,streamFile);
 
-                if (awc->channel_count != entries - 1) { /* not counting id-0 */
+                if (awc->channel_count != awc->entries - 1) { /* not counting id-0 */
                     VGM_LOG("AWC: number of music channels doesn't match entries\n");
                     goto fail;
                 }
@@ -275,3 +330,103 @@ static int parse_awc_header(STREAMFILE* streamFile, awc_header* awc) {
 fail:
     return 0;
 }
+
+
+/* ****************************************************************************** */
+/* subsong table, with all stream tags parsed in one pass (sfx packs, music is a single subsong) */
+
+typedef struct {
+    awc_header * streams; /* parsed headers, one per subsong */
+} awc_bank_data;
+
+static void free_awc_bank_data(void * bank_data) {
+    awc_bank_data * data = bank_data;
+    if (!data) return;
+    free(data->streams);
+    free(data);
+}
+
+static VGMSTREAM * init_awc_subsong(STREAMFILE *streamFile, vgmstream_subsong_table * table, int subsong) {
+    awc_bank_data * data = table->bank_data;
+    return build_awc_vgmstream(streamFile, &data->streams[subsong-1]);
+}
+
+/* codec as set when building the VGMSTREAM (returns 0 if not supported or not enabled) */
+static int get_awc_coding(STREAMFILE *streamFile, awc_header * awc, coding_t * coding_type) {
+    if (awc->is_encrypted)
+        return 0;
+
+    switch(awc->codec) {
+        case 0x01: *coding_type = awc->big_endian ? coding_PCM16BE : coding_PCM16LE; return 1;
+        case 0x04: *coding_type = coding_AWC_IMA; return 1;
+#ifdef VGM_USE_MPEG
+        case 0x07: /* layer from the first frame header, as the decoder does */
+            switch ((read_32bitBE(awc->stream_offset,streamFile) >> 17) & 0x03) {
+                case 3:  *coding_type = coding_MPEG_layer1; break;
+                case 2:  *coding_type = coding_MPEG_layer2; break;
+                default: *coding_type = coding_MPEG_layer3; break;
+            }
+            return 1;
+#endif
+        default:
+            return 0;
+    }
+}
+
+int init_subsong_table_awc(STREAMFILE * streamFile, vgmstream_subsong_table * table) {
+    int32_t (*read_32bit)(off_t,STREAMFILE*) = NULL;
+    awc_header awc;
+    awc_bank_data * data = NULL;
+    vgmstream_subsong_info * subsongs = NULL;
+    off_t tags_offset;
+    int i;
+
+
+    if (!parse_awc_bank(streamFile, &awc))
+        goto fail;
+    if (awc.is_music || awc.total_streams < 1)
+        goto fail; /* single subsong */
+    read_32bit = awc.big_endian ? read_32bitBE : read_32bitLE;
+
+    data = calloc(1, sizeof(awc_bank_data));
+    if (!data) goto fail;
+    data->streams = calloc(awc.total_streams, sizeof(awc_header));
+    if (!data->streams) goto fail;
+    subsongs = calloc(awc.total_streams, sizeof(vgmstream_subsong_info));
+    if (!subsongs) goto fail;
+
+    /* each stream's tags follow the previous stream's */
+    tags_offset = awc.entries_offset + 0x04*awc.entries;
+    for (i = 0; i < awc.total_streams; i++) {
+        awc_header * stream = &data->streams[i];
+        vgmstream_subsong_info * info = &subsongs[i];
+        uint32_t tag_count = (read_32bit(awc.entries_offset + 0x04*i, streamFile) >> 29) & 0x7; /* 3b */
+        int ok;
+
+        memcpy(stream, &awc, sizeof(awc_header));
+        ok = parse_awc_stream(streamFile, stream, tags_offset, tag_count);
+        tags_offset += 0x08*tag_count;
+        if (!ok)
+            continue;
+
+        info->supported = get_awc_coding(streamFile, stream, &info->coding_type);
+        info->stream_offset = stream->stream_offset;
+        info->stream_size = stream->stream_size;
+        info->channels = stream->channel_count;
+        info->sample_rate = stream->sample_rate;
+        info->num_samples = stream->num_samples;
+    }
+
+    table->meta_type = meta_AWC;
+    table->subsong_count = awc.total_streams;
+    table->subsongs = subsongs;
+    table->bank_data = data;
+    table->init_subsong = init_awc_subsong;
+    table->free_bank_data = free_awc_bank_data;
+    return 1;
+
+fail:
+    free(subsongs);
+    free_awc_bank_data(data);
+    return 0;
+}
@@ -0,0 +1,171 @@
+#include "meta.h"
+#include "../util.h"
+#include "cri_utf.h"
+
+/* guesses an extension for entries without names, for detection */
+static const char * get_archive_entry_ext(STREAMFILE *streamFile, off_t offset) {
+    if ((uint16_t)read_16bitBE(offset,streamFile) == 0x8000) {
+        uint8_t encoding_type = read_8bit(offset+0x04,streamFile);
+        return (encoding_type == 0x10 || encoding_type == 0x11) ? "ahx" : "adx";
+    }
+    if ((read_32bitBE(offset,streamFile) & 0x7F7F7F7F) == 0x48434100) /* "HCA\0" (masked) */
+        return "hca";
+    if (read_32bitBE(offset,streamFile) == 0x52494646) /* "RIFF" */
+        return "wav";
+    if (read_32bitBE(offset,streamFile) == 0x56414770) /* "VAGp" */
+        return "vag";
+    return "bin";
+}
+
+/* AFS - CRI archive (DC/PS2/GC/Xbox games) */
+int init_streamfile_archive_afs(streamfile_archive * archive) {
+    STREAMFILE * streamFile = archive->streamfile;
+    size_t file_size = get_streamfile_size(streamFile);
+    off_t names_offset;
+    size_t names_size;
+    int i, entry_count;
+
+    if (read_32bitBE(0x00,streamFile) != 0x41465300) /* "AFS\0" */
+        goto fail;
+    entry_count = read_32bitLE(0x04,streamFile);
+    if (entry_count <= 0 || 0x08 + entry_count*0x08 + 0x08 > file_size)
+        goto fail;
+
+    /* optional name table, pointed after the entry table or right before the first entry */
+    names_offset = read_32bitLE(0x08 + entry_count*0x08 + 0x00,streamFile);
+    names_size   = read_32bitLE(0x08 + entry_count*0x08 + 0x04,streamFile);
+    if (names_offset == 0 && read_32bitLE(0x08,streamFile) >= 0x08) {
+        off_t first_offset = read_32bitLE(0x08,streamFile);
+        names_offset = read_32bitLE(first_offset - 0x08,streamFile);
+        names_size   = read_32bitLE(first_offset - 0x04,streamFile);
+    }
+    if (names_offset <= 0 || names_size < entry_count*0x30 || names_offset + names_size > file_size)
+        names_offset = 0;
+
+    for (i = 0; i < entry_count; i++) {
+        off_t entry_offset = read_32bitLE(0x08 + i*0x08 + 0x00,streamFile);
+        size_t entry_size  = read_32bitLE(0x08 + i*0x08 + 0x04,streamFile);
+        char name[STREAMFILE_ARCHIVE_NAME_SIZE];
+
+        name[0] = '\0';
+        if (names_offset) {
+            char entry_name[0x20+1];
+            read_streamfile((uint8_t*)entry_name, names_offset + i*0x30, 0x20, streamFile);
+            entry_name[0x20] = '\0';
+            snprintf(name,sizeof(name),"%s",entry_name);
+        }
+        if (name[0] == '\0' || strchr(name, '/') || strchr(name, '\\'))
+            snprintf(name,sizeof(name),"%05i.%s", i, get_archive_entry_ext(streamFile,entry_offset));
+
+        /* names may repeat, but entries are found by name (keeps the extension for detection) */
+        if (find_streamfile_archive_entry(archive, name) >= 0) {
+            char entry_name[STREAMFILE_ARCHIVE_NAME_SIZE];
+            snprintf(entry_name,sizeof(entry_name),"%s",name);
+            snprintf(name,sizeof(name),"%05i_%.*s", i, (int)sizeof(name)-13, entry_name); /* room for any index */
+            if (find_streamfile_archive_entry(archive, name) >= 0)
+                goto fail; /* still repeated after truncation */
+        }
+
+        if (!add_streamfile_archive_entry(archive, name, entry_offset, entry_size))
+            goto fail;
+    }
+
+    return 1;
+fail:
+    return 0;
+}
+
+/* reads an integer column of a CPK table */
+static uint64_t query_cpk_value(STREAMFILE *streamFile, const struct utf_table_info * table, int index, const char * name, int * error) {
+    struct utf_query query;
+    struct utf_query_result result;
+
+    query.index = index;
+    query.name = name;
+    result = utf_query_table(streamFile, table, &query);
+    if (!result.valid || !result.found) {
+        *error = 1;
+        return 0;
+    }
+
+    switch (result.type) {
+        case COLUMN_TYPE_8BYTE:  return result.value.value_u64;
+        case COLUMN_TYPE_4BYTE:  return result.value.value_u32;
+        case COLUMN_TYPE_2BYTE2:
+        case COLUMN_TYPE_2BYTE:  return result.value.value_u16;
+        case COLUMN_TYPE_1BYTE2:
+        case COLUMN_TYPE_1BYTE:  return result.value.value_u8;
+        case COLUMN_TYPE_STRING: return result.value.value_string;
+        default:
+            *error = 1;
+            return 0;
+    }
+}
+
+/* CPK - CRI archive (PS3/X360/Wii/PC/etc games), uncompressed entries listed in the TOC */
+int init_streamfile_archive_cpk(streamfile_archive * archive) {
+    STREAMFILE * streamFile = archive->streamfile;
+    struct utf_table_info header, toc;
+    uint64_t toc_offset, content_offset, base_offset;
+    int i, j, error = 0;
+    int header_open = 0, toc_open = 0;
+
+    if (read_32bitBE(0x00,streamFile) != 0x43504B20) /* "CPK " */
+        goto fail;
+
+    /* header table (unencrypted only) */
+    if (!utf_open_table(streamFile, 0x10, &header))
+        goto fail;
+    header_open = 1;
+    toc_offset = query_cpk_value(streamFile, &header, 0, "TocOffset", &error);
+    content_offset = query_cpk_value(streamFile, &header, 0, "ContentOffset", &error);
+    if (error || toc_offset == 0) goto fail; /* ITOC-only (entries by ID) not supported */
+
+    /* entry offsets are relative to whichever comes first */
+    base_offset = (content_offset && content_offset < toc_offset) ? content_offset : toc_offset;
+
+    if (read_32bitBE(toc_offset,streamFile) != 0x544F4320) /* "TOC " */
+        goto fail;
+    if (!utf_open_table(streamFile, toc_offset + 0x10, &toc))
+        goto fail;
+    toc_open = 1;
+
+    for (i = 0; i < toc.rows; i++) {
+        char name[STREAMFILE_ARCHIVE_NAME_SIZE];
+        const char * dir_name, * file_name;
+        uint64_t file_offset;
+        size_t file_size, extract_size;
+
+        dir_name  = utf_get_string(&toc, query_cpk_value(streamFile, &toc, i, "DirName", &error));
+        file_name = utf_get_string(&toc, query_cpk_value(streamFile, &toc, i, "FileName", &error));
+        file_size    = query_cpk_value(streamFile, &toc, i, "FileSize", &error);
+        extract_size = query_cpk_value(streamFile, &toc, i, "ExtractSize", &error);
+        file_offset  = query_cpk_value(streamFile, &toc, i, "FileOffset", &error);
+        if (error || !file_name) goto fail;
+
+        if (extract_size != file_size)
+            continue; /* compressed (CRILAYLA) */
+
+        if (dir_name && dir_name[0] != '\0')
+            snprintf(name,sizeof(name),"%s/%s", dir_name, file_name);
+        else
+            snprintf(name,sizeof(name),"%s", file_name);
+
+        /* entries are opened as "archive/dir/file" paths, so dirs must use the system's separator */
+        for (j = 0; name[j] != '\0'; j++) {
+            if (name[j] == '/' || name[j] == '\\')
+                name[j] = DIR_SEPARATOR;
+        }
+
+        if (!add_streamfile_archive_entry(archive, name, base_offset + file_offset, file_size))
+            goto fail;
+    }
+
+    utf_close_table(&toc);
+    utf_close_table(&header);
+    return 1;
+fail:
+    if (toc_open) utf_close_table(&toc);
+    if (header_open) utf_close_table(&header);
+    return 0;
+}
@@ -0,0 +1,381 @@
+#include "cri_utf.h"
+
+/* @UTF table reading, abridged */
+int utf_open_table(STREAMFILE *infile, long offset, struct utf_table_info *table_info)
+{
+    unsigned char buf[4];
+    char *string_table = NULL;
+    struct utf_column_info * schema = NULL;
+    uint32_t table_name_string;
+    int string_table_size;
+
+    memset(table_info, 0, sizeof(struct utf_table_info));
+    table_info->table_offset = offset;
+
+    /* check header */
+    {
+        static const char UTF_signature[4] = "@UTF"; /* intentionally unterminated */
+        if (4 != read_streamfile(buf, offset, 4, infile)) goto cleanup_error;
+        if (memcmp(buf, UTF_signature, sizeof(UTF_signature)))
+        {
+            goto cleanup_error;
+        }
+    }
+
+    /* get table size */
+    table_info->table_size = read_32bitBE(offset+4, infile);
+
+    table_info->schema_offset = 0x20;
+    table_info->rows_offset = read_32bitBE(offset+8, infile);
+    table_info->string_table_offset = read_32bitBE(offset+0xc,infile);
+    table_info->data_offset = read_32bitBE(offset+0x10,infile);
+    table_name_string = read_32bitBE(offset+0x14,infile);
+    table_info->columns = read_16bitBE(offset+0x18,infile);
+    table_info->row_width = read_16bitBE(offset+0x1a,infile);
+    table_info->rows = read_32bitBE(offset+0x1c,infile);
+
+    /* allocate for string table */
+    if (table_info->data_offset < table_info->string_table_offset) goto cleanup_error;
+    string_table_size = table_info->data_offset-table_info->string_table_offset;
+    string_table = malloc(string_table_size+1);
+    if (!string_table) goto cleanup_error;
+    table_info->string_table = string_table;
+    table_info->string_table_size = string_table_size;
+    memset(string_table, 0, string_table_size+1);
+
+    /* load schema */
+    schema = malloc(sizeof(struct utf_column_info) * table_info->columns);
+    if (!schema) goto cleanup_error;
+
+    {
+        int i;
+        long schema_current_offset = offset + table_info->schema_offset;
+        for (i = 0; i < table_info->columns; i++)
+        {
+            uint32_t column_name_string;
+
+            schema[i].type = read_8bit(schema_current_offset,infile);
+            schema_current_offset ++;
+            column_name_string = read_32bitBE(schema_current_offset,infile);
+            if (column_name_string >= string_table_size) goto cleanup_error;
+            schema[i].column_name = string_table + column_name_string;
+            schema_current_offset += 4;
+
+            if ((schema[i].type & COLUMN_STORAGE_MASK) == COLUMN_STORAGE_CONSTANT)
+            {
+                schema[i].constant_offset = schema_current_offset;
+                switch (schema[i].type & COLUMN_TYPE_MASK)
+                {
+                    case COLUMN_TYPE_8BYTE:
+                    case COLUMN_TYPE_DATA:
+                        schema_current_offset+=8;
+                        break;
+                    case COLUMN_TYPE_STRING:
+                    case COLUMN_TYPE_FLOAT:
+                    case COLUMN_TYPE_4BYTE:
+                        schema_current_offset+=4;
+                        break;
+                    case COLUMN_TYPE_2BYTE2:
+                    case COLUMN_TYPE_2BYTE:
+                        schema_current_offset+=2;
+                        break;
+                    case COLUMN_TYPE_1BYTE2:
+                    case COLUMN_TYPE_1BYTE:
+                        schema_current_offset++;
+                        break;
+                    default:
+                        goto cleanup_error;
+                }
+            }
+        }
+    }
+
+    table_info->schema = schema;
+
+    /* read string table */
+    read_streamfile((unsigned char *)string_table,
+            table_info->string_table_offset+8+offset,
+            string_table_size, infile);
+    if (table_name_string >= string_table_size) goto cleanup_error;
+    table_info->table_name = table_info->string_table+table_name_string;
+
+    return 1;
+
+cleanup_error:
+    free(string_table);
+    free(schema);
+    memset(table_info, 0, sizeof(struct utf_table_info));
+    return 0;
+}
+
+void utf_close_table(struct utf_table_info *table_info)
+{
+    free((char *)table_info->string_table);
+    free((struct utf_column_info *)table_info->schema);
+    memset(table_info, 0, sizeof(struct utf_table_info));
+}
+
+const char * utf_get_string(const struct utf_table_info *table_info, uint32_t string_offset)
+{
+    if (string_offset >= table_info->string_table_size)
+        return NULL;
+    return table_info->string_table + string_offset;
+}
+
+struct utf_query_result utf_query_table(STREAMFILE *infile, const struct utf_table_info *table_info, const struct utf_query *query)
+{
+    struct utf_query_result result;
+
+    memset(&result, 0, sizeof(result));
+
+    /* fill in the default stuff */
+    result.found = 0;
+    result.rows = table_info->rows;
+    result.name_offset = table_info->table_name - table_info->string_table;
+    result.string_table_offset = table_info->string_table_offset;
+    result.data_offset = table_info->data_offset;
+
+    /* explore the values (rows are fixed width, so only the queried one is read) */
+    if (query && query->index >= 0 && query->index < table_info->rows) {
+        int j;
+        uint32_t row_offset =
+            table_info->table_offset + 8 + table_info->rows_offset +
+            query->index * table_info->row_width;
+        const uint32_t row_start_offset = row_offset;
+
+        for (j = 0; j < table_info->columns; j++)
+        {
+            const struct utf_column_info *schema = table_info->schema;
+            uint8_t type = schema[j].type;
+            long constant_offset = schema[j].constant_offset;
+            int constant = 0;
+
+            int qthis = query->name && !strcmp(schema[j].column_name, query->name);
+
+            if (qthis)
+            {
+                result.found = 1;
+                result.type = schema[j].type & COLUMN_TYPE_MASK;
+            }
+
+            switch (schema[j].type & COLUMN_STORAGE_MASK)
+            {
+                case COLUMN_STORAGE_PERROW:
+                    break;
+                case COLUMN_STORAGE_CONSTANT:
+                    constant = 1;
+                    break;
+                case COLUMN_STORAGE_ZERO:
+                    if (qthis)
+                    {
+                        memset(&result.value, 0,
+                                sizeof(result.value));
+                    }
+                    continue;
+                default:
+                    return result;
+            }
+
+            if (1)
+            {
+                long data_offset;
+                int bytes_read;
+
+                if (constant)
+                {
+                    data_offset = constant_offset;
+                }
+                else
+                {
+                    data_offset = row_offset;
+                }
+
+                switch (type & COLUMN_TYPE_MASK)
+                {
+                    case COLUMN_TYPE_STRING:
+                        {
+                            uint32_t string_offset;
+                            string_offset = read_32bitBE(data_offset, infile);
+                            bytes_read = 4;
+                            if (qthis)
+                            {
+                                result.value.value_string = string_offset;
+                            }
+                        }
+                        break;
+                    case COLUMN_TYPE_DATA:
+                        {
+                            uint32_t vardata_offset, vardata_size;
+
+                            vardata_offset = read_32bitBE(data_offset, infile);
+                            vardata_size = read_32bitBE(data_offset+4, infile);
+                            bytes_read = 8;
+                            if (qthis)
+                            {
+                                result.value.value_data.offset = vardata_offset;
+                                result.value.value_data.size = vardata_size;
+                            }
+                        }
+                        break;
+
+                    case COLUMN_TYPE_8BYTE:
+                        {
+                            uint64_t value =
+                                read_32bitBE(data_offset, infile);
+                            value <<= 32;
+                            value |=
+                                (uint32_t)read_32bitBE(data_offset+4, infile);
+                            if (qthis)
+                            {
+                                result.value.value_u64 = value;
+                            }
+                            bytes_read = 8;
+                            break;
+                        }
+                    case COLUMN_TYPE_4BYTE:
+                        {
+                            uint32_t value =
+                                read_32bitBE(data_offset, infile);
+                            if (qthis)
+                            {
+                                result.value.value_u32 = value;
+                            }
+                            bytes_read = 4;
+                        }
+                        break;
+                    case COLUMN_TYPE_2BYTE2:
+                    case COLUMN_TYPE_2BYTE:
+                        {
+                            uint16_t value =
+                                read_16bitBE(data_offset, infile);
+                            if (qthis)
+                            {
+                                result.value.value_u16 = value;
+                            }
+                            bytes_read = 2;
+                        }
+                        break;
+                    case COLUMN_TYPE_FLOAT:
+                        if (sizeof(float) == 4)
+                        {
+                            union {
+                                float float_value;
+                                uint32_t int_value;
+                            } int_float;
+
+                            int_float.int_value = read_32bitBE(data_offset, infile);
+                            if (qthis)
+                            {
+                                result.value.value_float = int_float.float_value;
+                            }
+                        }
+                        else
+                        {
+                            read_32bitBE(data_offset, infile);
+                            if (qthis)
+                            {
+                                return result;
+                            }
+                        }
+                        bytes_read = 4;
+                        break;
+                    case COLUMN_TYPE_1BYTE2:
+                    case COLUMN_TYPE_1BYTE:
+                        {
+                            uint8_t value =
+                                read_8bit(data_offset, infile);
+                            if (qthis)
+                            {
+                                result.value.value_u8 = value;
+                            }
+                            bytes_read = 1;
+                        }
+                        break;
+                    default:
+                        return result;
+                }
+
+                if (!constant)
+                {
+                    row_offset += bytes_read;
+                }
+            } /* useless if end */
+        } /* column for loop end */
+
+        if (row_offset - row_start_offset != table_info->row_width)
+            return result;
+    } /* explore values block end */
+
+    result.valid = 1;
+    return result;
+}
+
+struct utf_query_result query_utf(STREAMFILE *infile, const long offset, const struct utf_query *query)
+{
+    struct utf_table_info table_info;
+    struct utf_query_result result;
+
+    if (!utf_open_table(infile, offset, &table_info))
+    {
+        memset(&result, 0, sizeof(result));
+        return result;
+    }
+
+    result = utf_query_table(infile, &table_info, query);
+    utf_close_table(&table_info);
+    return result;
+}
+
+struct utf_query_result query_utf_nofail(STREAMFILE *infile, const long offset, const struct utf_query *query, int *error)
+{
+    const struct utf_query_result result = query_utf(infile, offset, query);
+
+    if (error)
+    {
+        *error = 0;
+        if (!result.valid) *error = 1;
+        if (query && !result.found) *error = 1;
+    }
+
+    return result;
+}
+
+struct utf_query_result query_utf_key(STREAMFILE *infile, const long offset, int index, const char *name, int *error)
+{
+    struct utf_query query;
+    query.index = index;
+    query.name = name;
+
+    return query_utf_nofail(infile, offset, &query, error);
+}
+
+uint8_t query_utf_1byte(STREAMFILE *infile, const long offset, int index, const char *name, int *error)
+{
+    struct utf_query_result result = query_utf_key(infile, offset, index, name, error);
+    if (error)
+    {
+        if (result.type != COLUMN_TYPE_1BYTE) *error = 1;
+    }
+    return result.value.value_u8;
+}
+
+uint32_t query_utf_4byte(STREAMFILE *infile, const long offset, int index, const char *name, int *error)
+{
+    struct utf_query_result result = query_utf_key(infile, offset, index, name, error);
+    if (error)
+    {
+        if (result.type != COLUMN_TYPE_4BYTE) *error = 1;
+    }
+    return result.value.value_u32;
+}
+
+struct offset_size_pair query_utf_data(STREAMFILE *infile, const long offset,
+        int index, const char *name, int *error)
+{
+    struct utf_query_result result = query_utf_key(infile, offset, index, name, error);
+    if (error)
+    {
+        if (result.type != COLUMN_TYPE_DATA) *error = 1;
+    }
+    return result.value.value_data;
+}
@@ -0,0 +1,102 @@
+#ifndef _CRI_UTF_H_
+#define _CRI_UTF_H_
+
+#include "../streamfile.h"
+
+/* CRI's @UTF tables (AAX, CPK, etc): a header, a schema of typed columns, fixed-width rows,
+ * a string table and a data area. Values are queried by row and column name. */
+
+#define COLUMN_STORAGE_MASK         0xf0
+#define COLUMN_STORAGE_PERROW       0x50
+#define COLUMN_STORAGE_CONSTANT     0x30
+#define COLUMN_STORAGE_ZERO         0x10
+
+#define COLUMN_TYPE_MASK            0x0f
+#define COLUMN_TYPE_DATA            0x0b
+#define COLUMN_TYPE_STRING          0x0a
+#define COLUMN_TYPE_FLOAT           0x08
+#define COLUMN_TYPE_8BYTE           0x06
+#define COLUMN_TYPE_4BYTE           0x04
+#define COLUMN_TYPE_2BYTE2          0x03
+#define COLUMN_TYPE_2BYTE           0x02
+#define COLUMN_TYPE_1BYTE2          0x01
+#define COLUMN_TYPE_1BYTE           0x00
+
+struct utf_query
+{
+    /* if 0 */
+    const char *name;
+    int index;
+};
+
+struct offset_size_pair
+{
+    uint32_t offset;
+    uint32_t size;
+};
+
+struct utf_query_result
+{
+    int valid;  /* table is valid */
+    int found;
+    int type;   /* one of COLUMN_TYPE_* */
+    union
+    {
+        uint64_t value_u64;
+        uint32_t value_u32;
+        uint16_t value_u16;
+        uint8_t value_u8;
+        float value_float;
+        struct offset_size_pair value_data;
+        uint32_t value_string;
+    } value;
+
+    /* info for the queried table */
+    uint32_t rows;
+    uint32_t name_offset;
+    uint32_t string_table_offset;
+    uint32_t data_offset;
+};
+
+struct utf_column_info
+{
+    uint8_t type;
+    const char *column_name;
+    long constant_offset;
+};
+
+struct utf_table_info
+{
+    long table_offset;
+    uint32_t table_size;
+    uint32_t schema_offset;
+    uint32_t rows_offset;
+    uint32_t string_table_offset;
+    uint32_t data_offset;
+    const char *string_table;
+    uint32_t string_table_size;
+    const char *table_name;
+    uint16_t columns;
+    uint16_t row_width;
+    uint32_t rows;
+
+    const struct utf_column_info *schema;
+};
+
+/* Loads a table's header, schema and strings once, to query many values with utf_query_table
+ * (queries by offset reload the table each time). Returns 0 on error. */
+int utf_open_table(STREAMFILE *infile, long offset, struct utf_table_info *table_info);
+void utf_close_table(struct utf_table_info *table_info);
+struct utf_query_result utf_query_table(STREAMFILE *infile, const struct utf_table_info *table_info, const struct utf_query *query);
+/* string of a COLUMN_TYPE_STRING value (NULL if out of the string table) */
+const char * utf_get_string(const struct utf_table_info *table_info, uint32_t string_offset);
+
+/* queries of the table at offset; with error set if not found or of another type */
+struct utf_query_result query_utf(STREAMFILE *infile, long offset, const struct utf_query *query);
+struct utf_query_result query_utf_nofail(STREAMFILE *infile, const long offset, const struct utf_query *query, int *error);
+struct utf_query_result query_utf_key(STREAMFILE *infile, const long offset, int index, const char *name, int *error);
+uint8_t query_utf_1byte(STREAMFILE *infile, const long offset, int index, const char *name, int *error);
+uint32_t query_utf_4byte(STREAMFILE *infile, const long offset, int index, const char *name, int *error);
+struct offset_size_pair query_utf_data(STREAMFILE *infile, const long offset, int index, const char *name, int *error);
+
+#endif /* _CRI_UTF_H_ */
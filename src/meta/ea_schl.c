@@ -77,6 +77,18 @@ static int get_ea_stream_total_samples(STREAMFILE* streamFile, off_t start_offse
 static off_t get_ea_stream_mpeg_start_offset(STREAMFILE* streamFile, off_t start_offset, const ea_header* ea);
 static VGMSTREAM * init_vgmstream_ea_variable_header(STREAMFILE *streamFile, ea_header *ea, off_t start_offset, int is_bnk, int total_streams);
 
+typedef struct {
+    off_t offset;           /* BNK start (some have garbage before) */
+    off_t table_offset;     /* stream header offsets, relative to each entry */
+    size_t header_size;
+    int bnk_version;
+    int total_streams;
+    int big_endian;
+} ea_bnk_header;
+
+static int parse_ea_bnk_header(STREAMFILE *streamFile, ea_bnk_header * bnk);
+static int parse_ea_bnk_stream(STREAMFILE *streamFile, ea_bnk_header * bnk, int target_stream, ea_header * ea, off_t * start_offset);
+
 
 /* EA SCHl with variable header - from EA games (roughly 1997~2010); generated by EA Canada's sx.exe/Sound eXchange */
 VGMSTREAM * init_vgmstream_ea_schl(STREAMFILE *streamFile) {
@@ -116,13 +128,10 @@ fail:
 
 /* EA BNK with variable header - from EA games SFXs; also created by sx.exe */
 VGMSTREAM * init_vgmstream_ea_bnk(STREAMFILE *streamFile) {
-    off_t start_offset, header_offset, offset, table_offset;
-    size_t header_size;
+    off_t start_offset;
+    ea_bnk_header bnk;
     ea_header ea;
-    int32_t (*read_32bit)(off_t,STREAMFILE*) = NULL;
-    int16_t (*read_16bit)(off_t,STREAMFILE*) = NULL;
-    int i, bnk_version;
-    int total_streams, target_stream = streamFile->stream_index;
+    int target_stream = streamFile->stream_index;
 
 
     /* check extension */
@@ -130,6 +139,30 @@ VGMSTREAM * init_vgmstream_ea_bnk(STREAMFILE *streamFile) {
     if (!check_extensions(streamFile,"bnk,sdt,mus"))
         goto fail;
 
+    if (!parse_ea_bnk_header(streamFile, &bnk))
+        goto fail;
+
+    /* check multi-streams */
+    if (target_stream == 0) target_stream = 1;
+    if (target_stream < 0 || target_stream > bnk.total_streams || bnk.total_streams < 1) goto fail;
+
+    if (!parse_ea_bnk_stream(streamFile, &bnk, target_stream, &ea, &start_offset))
+        goto fail;
+
+    /* rest is common */
+    return init_vgmstream_ea_variable_header(streamFile, &ea, start_offset, bnk.bnk_version, bnk.total_streams);
+
+fail:
+    return NULL;
+}
+
+static int parse_ea_bnk_header(STREAMFILE *streamFile, ea_bnk_header * bnk) {
+    int32_t (*read_32bit)(off_t,STREAMFILE*) = NULL;
+    int16_t (*read_16bit)(off_t,STREAMFILE*) = NULL;
+    off_t offset;
+
+    memset(bnk,0,sizeof(ea_bnk_header));
+
     /* check header (doesn't use EA blocks, otherwise very similar to SCHl) */
     if (read_32bitBE(0x00,streamFile) == 0x424E4B6C ||  /* "BNKl" (common) */
         read_32bitBE(0x00,streamFile) == 0x424E4B62)    /* "BNKb" (FIFA 98 SS) */
@@ -140,7 +173,8 @@ VGMSTREAM * init_vgmstream_ea_bnk(STREAMFILE *streamFile) {
         goto fail;
 
     /* use header size as endianness flag */
-    if ((uint32_t)read_32bitLE(0x08,streamFile) > 0x000F0000) { /* todo not very accurate */
+    bnk->big_endian = (uint32_t)read_32bitLE(0x08,streamFile) > 0x000F0000; /* todo not very accurate */
+    if (bnk->big_endian) {
         read_32bit = read_32bitBE;
         read_16bit = read_16bitBE;
     } else {
@@ -148,61 +182,65 @@ VGMSTREAM * init_vgmstream_ea_bnk(STREAMFILE *streamFile) {
         read_16bit = read_16bitLE;
     }
 
-    bnk_version = read_8bit(offset + 0x04,streamFile);
-    total_streams = read_16bit(offset + 0x06,streamFile);
-    /* check multi-streams */
-    if (target_stream == 0) target_stream = 1;
-    if (target_stream < 0 || target_stream > total_streams || total_streams < 1) goto fail;
+    bnk->offset = offset;
+    bnk->bnk_version = read_8bit(offset + 0x04,streamFile);
+    bnk->total_streams = read_16bit(offset + 0x06,streamFile);
 
-    switch(bnk_version) {
+    switch(bnk->bnk_version) {
         case 0x02: /* early (Need For Speed PC, Fifa 98 SS) */
-            table_offset = 0x0c;
-
-            header_size = read_32bit(offset + 0x08,streamFile); /* full size */
-            header_offset = offset + table_offset + 0x04*(target_stream-1) + read_32bit(offset + table_offset + 0x04*(target_stream-1),streamFile);
+            bnk->table_offset = 0x0c;
+            bnk->header_size = read_32bit(offset + 0x08,streamFile); /* full size */
             break;
 
         case 0x04: /* mid (last used in PSX banks) */
         case 0x05: /* late (generated by sx.exe ~v2+) */
             /* 0x08: header/file size, 0x0C: file size/null, 0x10: always null */
-            table_offset = 0x14;
-            if (read_32bit(offset + table_offset,streamFile) == 0x00)
-                table_offset += 0x4; /* MOH Heroes 2 PSP has an extra empty field, not sure why */
+            bnk->table_offset = 0x14;
+            if (read_32bit(offset + bnk->table_offset,streamFile) == 0x00)
+                bnk->table_offset += 0x4; /* MOH Heroes 2 PSP has an extra empty field, not sure why */
 
-            header_size = get_streamfile_size(streamFile); /* unknown (header is variable and may have be garbage until data) */
-            header_offset = offset + table_offset + 0x04*(target_stream-1) + read_32bit(offset + table_offset + 0x04*(target_stream-1),streamFile);
+            bnk->header_size = get_streamfile_size(streamFile); /* unknown (header is variable and may have be garbage until data) */
             break;
 
         default:
-            VGM_LOG("EA BNK: unknown version %x\n", bnk_version);
+            VGM_LOG("EA BNK: unknown version %x\n", bnk->bnk_version);
             goto fail;
     }
 
-    if (!parse_variable_header(streamFile,&ea, header_offset, header_size - header_offset))
+    return 1;
+fail:
+    return 0;
+}
+
+static int parse_ea_bnk_stream(STREAMFILE *streamFile, ea_bnk_header * bnk, int target_stream, ea_header * ea, off_t * start_offset) {
+    int32_t (*read_32bit)(off_t,STREAMFILE*) = bnk->big_endian ? read_32bitBE : read_32bitLE;
+    off_t header_offset, offset = bnk->offset;
+    int i;
+
+    header_offset = offset + bnk->table_offset + 0x04*(target_stream-1) + read_32bit(offset + bnk->table_offset + 0x04*(target_stream-1),streamFile);
+
+    if (!parse_variable_header(streamFile,ea, header_offset, bnk->header_size - header_offset))
         goto fail;
 
     /* fix absolute offsets so it works in next funcs */
     if (offset) {
-        for (i = 0; i < ea.channels; i++) {
-            ea.coefs[i] += offset;
-            ea.offsets[i] += offset;
+        for (i = 0; i < ea->channels; i++) {
+            ea->coefs[i] += offset;
+            ea->offsets[i] += offset;
         }
     }
 
-    start_offset = ea.offsets[0]; /* first channel, presumably needed for MPEG */
+    *start_offset = ea->offsets[0]; /* first channel, presumably needed for MPEG */
 
     /* special case found in some tests (pcstream had hist, pcbnk no hist, no patch diffs)
      * I think this works but what decides if hist is used or not a secret to everybody */
-    if (ea.codec2 == EA_CODEC2_EAXA && ea.codec1 == EA_CODEC1_NONE && ea.version == EA_VERSION_V1) {
-        ea.codec_version = 0;
+    if (ea->codec2 == EA_CODEC2_EAXA && ea->codec1 == EA_CODEC1_NONE && ea->version == EA_VERSION_V1) {
+        ea->codec_version = 0;
     }
 
-
-    /* rest is common */
-    return init_vgmstream_ea_variable_header(streamFile, &ea, start_offset, bnk_version, total_streams);
-
+    return 1;
 fail:
-    return NULL;
+    return 0;
 }
 
 /* inits VGMSTREAM from a EA header */
@@ -842,3 +880,65 @@ static off_t get_ea_stream_mpeg_start_offset(STREAMFILE* streamFile, off_t start
 fail:
     return 0;
 }
+
+
+/* ****************************************************************************** */
+/* BNK subsong table, with all stream headers parsed in one pass (info from each stream built
+ * from them, as samples may need the data) */
+
+typedef struct {
+    ea_header * streams;    /* parsed headers, one per subsong */
+    off_t * start_offsets;  /* 0 if the header couldn't be parsed */
+    int bnk_version;
+} ea_bnk_bank_data;
+
+static void free_ea_bnk_bank_data(void * bank_data) {
+    ea_bnk_bank_data * data = bank_data;
+    if (!data) return;
+    free(data->streams);
+    free(data->start_offsets);
+    free(data);
+}
+
+static VGMSTREAM * init_ea_bnk_subsong(STREAMFILE *streamFile, vgmstream_subsong_table * table, int subsong) {
+    ea_bnk_bank_data * data = table->bank_data;
+    ea_header ea;
+
+    if (!data->start_offsets[subsong-1])
+        return NULL;
+    memcpy(&ea, &data->streams[subsong-1], sizeof(ea_header)); /* modified when building */
+    return init_vgmstream_ea_variable_header(streamFile, &ea, data->start_offsets[subsong-1], data->bnk_version, table->subsong_count);
+}
+
+int init_subsong_table_ea_bnk(STREAMFILE * streamFile, vgmstream_subsong_table * table) {
+    ea_bnk_header bnk;
+    ea_bnk_bank_data * data = NULL;
+    int i;
+
+    if (!parse_ea_bnk_header(streamFile, &bnk))
+        goto fail;
+    if (bnk.total_streams < 1) goto fail;
+
+    data = calloc(1, sizeof(ea_bnk_bank_data));
+    if (!data) goto fail;
+    data->streams = calloc(bnk.total_streams, sizeof(ea_header));
+    data->start_offsets = calloc(bnk.total_streams, sizeof(off_t));
+    if (!data->streams || !data->start_offsets) goto fail;
+
+    data->bnk_version = bnk.bnk_version;
+    for (i = 0; i < bnk.total_streams; i++) {
+        if (!parse_ea_bnk_stream(streamFile, &bnk, i+1, &data->streams[i], &data->start_offsets[i]))
+            data->start_offsets[i] = 0;
+    }
+
+    table->meta_type = meta_EA_BNK;
+    table->subsong_count = bnk.total_streams;
+    table->bank_data = data;
+    table->init_subsong = init_ea_bnk_subsong;
+    table->free_bank_data = free_ea_bnk_bank_data;
+    return 1;
+
+fail:
+    free_ea_bnk_bank_data(data);
+    return 0;
+}
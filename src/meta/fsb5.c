@@ -2,193 +2,251 @@
 #include "../coding/coding.h"
 #include "../util.h"
 
+typedef struct {
+    /* main header */
+    int total_streams;
+    size_t sample_header_length;
+    size_t name_table_length;
+    size_t sample_data_length;
+    size_t base_header_length;
+    int coding_id;
+
+    /* stream header (some values carry over from previous streams when missing) */
+    off_t stream_offset;
+    size_t stream_size;
+    off_t name_offset;
+    uint32_t num_samples;
+    uint32_t loop_start;
+    uint32_t loop_end;
+    int loop_flag;
+    int channels;
+    int sample_rate;
+    off_t dsp_info_start;
+    uint32_t vorbis_setup_id;
+} fsb5_header;
+
+static int parse_fsb5_bank(STREAMFILE *streamFile, header_reader * hdr, fsb5_header * fsb5);
+static int parse_fsb5_stream(header_reader * hdr, fsb5_header * fsb5, off_t * sample_header_start, int stream_number);
+static VGMSTREAM * build_fsb5_vgmstream(STREAMFILE *streamFile, fsb5_header * fsb5);
+
+
 /* FSB5 - FMOD Studio multiplatform format */
 VGMSTREAM * init_vgmstream_fsb5(STREAMFILE *streamFile) {
-    VGMSTREAM * vgmstream = NULL;
-    off_t StartOffset = 0, NameOffset = 0;
-    off_t SampleHeaderStart = 0, DSPInfoStart = 0;
-    size_t SampleHeaderLength, NameTableLength, SampleDataLength, BaseHeaderLength, StreamSize = 0;
-
-    uint32_t NumSamples = 0, LoopStart = 0, LoopEnd = 0;
-    int LoopFlag = 0, ChannelCount = 0, SampleRate = 0, CodingID;
-    int TotalStreams, TargetStream = streamFile->stream_index;
-    uint32_t VorbisSetupId = 0;
+    fsb5_header fsb5 = {0};
+    off_t SampleHeaderStart;
+    int TargetStream = streamFile->stream_index;
     int i;
+    header_reader hdr;
+
+    if (!parse_fsb5_bank(streamFile, &hdr, &fsb5))
+        goto fail;
+
+    if (TargetStream == 0) TargetStream = 1; /* default to 1 */
+    if (TargetStream > fsb5.total_streams || fsb5.total_streams <= 0) goto fail;
+
+    /* find target stream header and data offset, and read all needed values for later use
+     *  (reads one by one as the size of a single stream header is variable) */
+    SampleHeaderStart = fsb5.base_header_length;
+    for (i = 1; i <= TargetStream; i++) {
+        if (!parse_fsb5_stream(&hdr, &fsb5, &SampleHeaderStart, i))
+            goto fail;
+    }
+
+    return build_fsb5_vgmstream(streamFile, &fsb5);
+
+fail:
+    return NULL;
+}
+
+/* reads main bank info, shared by all streams */
+static int parse_fsb5_bank(STREAMFILE *streamFile, header_reader * hdr, fsb5_header * fsb5) {
 
     /* check extension, case insensitive */
     if (!check_extensions(streamFile,"fsb")) goto fail;
 
-    if (read_32bitBE(0x00,streamFile) != 0x46534235) goto fail; /* "FSB5" */
+    /* base header and sample headers are usually small, so most files are parsed from one read */
+    init_header_reader(hdr, streamFile, 0x00, STREAMFILE_HEADER_READER_SIZE, 0);
+
+    if (read_hdr_32bitBE(0x00,hdr) != 0x46534235) goto fail; /* "FSB5" */
 
     //v0 has extra flags at 0x1c and BaseHeaderLength = 0x40?
-    if (read_32bitLE(0x04,streamFile) != 0x01) goto fail; /* Version ID */
+    if (read_hdr_32bitLE(0x04,hdr) != 0x01) goto fail; /* Version ID */
 
-    TotalStreams       = read_32bitLE(0x08,streamFile);
-    SampleHeaderLength = read_32bitLE(0x0C,streamFile);
-    NameTableLength    = read_32bitLE(0x10,streamFile);
-    SampleDataLength   = read_32bitLE(0x14,streamFile);
-    CodingID = read_32bitLE(0x18,streamFile);
+    fsb5->total_streams        = read_hdr_32bitLE(0x08,hdr);
+    fsb5->sample_header_length = read_hdr_32bitLE(0x0C,hdr);
+    fsb5->name_table_length    = read_hdr_32bitLE(0x10,hdr);
+    fsb5->sample_data_length   = read_hdr_32bitLE(0x14,hdr);
+    fsb5->coding_id = read_hdr_32bitLE(0x18,hdr);
     /* 0x1c (8): zero,  0x24 (16): hash,  0x34 (8): unk  */
-    BaseHeaderLength = 0x3C;
+    fsb5->base_header_length = 0x3C;
 
-    SampleHeaderStart = BaseHeaderLength;
+    if ((fsb5->sample_header_length + fsb5->name_table_length + fsb5->sample_data_length + 0x3C) != get_streamfile_size(streamFile)) goto fail;
 
-    if ((SampleHeaderLength + NameTableLength + SampleDataLength + 0x3C) != get_streamfile_size(streamFile)) goto fail;
-    if (TargetStream == 0) TargetStream = 1; /* default to 1 */
-    if (TargetStream > TotalStreams || TotalStreams <= 0) goto fail;
-
-    /* find target stream header and data offset, and read all needed values for later use
-     *  (reads one by one as the size of a single stream header is variable) */
-    for (i = 1; i <= TotalStreams; i++) {
-        off_t  DataStart = 0;
-        size_t StreamHeaderLength = 0;
-        uint32_t SampleMode1, SampleMode2;
-
-
-        /* seems ok but could use some testing against FMOD's SDK */
-        SampleMode1 = (uint32_t)read_32bitLE(SampleHeaderStart+0x00,streamFile);
-        SampleMode2 = (uint32_t)read_32bitLE(SampleHeaderStart+0x04,streamFile);
-        StreamHeaderLength += 0x08;
-
-        /* get samples */
-        NumSamples  = ((SampleMode2 >> 2) & 0x3FFFFFFF); /* bits 31..2 (30) */
-
-        /* get offset inside data section */
-        DataStart   = ((SampleMode1 >> 7) & 0x1FFFFFF) << 5; /* bits 31..8 (25) * 0x20 */
-        //SampleMode2 bits 1..0 part of DataStart for files larger than 0x3FFFFFE0?
-
-        /* get channels (from tests seems correct, but multichannel isn't very common, ex. no 4ch mode?) */
-        switch ((SampleMode1 >> 5) & 0x03) { /* bits 7..6 (2) */
-            case 0:  ChannelCount = 1; break;
-            case 1:  ChannelCount = 2; break;
-            case 2:  ChannelCount = 6; break;/* some Dark Souls 2 MPEG; some IMA ADPCM */
-            case 3:  ChannelCount = 8; break;/* some IMA ADPCM */
-            default: /* other values (ex. 10ch) are specified in the extra flags, using 0 here */
-                goto fail;
-        }
-
-        /* get sample rate  */
-        switch ((SampleMode1 >> 1) & 0x0f) { /* bits 5..1 (4) */
-            case 0:  SampleRate = 4000;  break; //???
-            case 1:  SampleRate = 8000;  break;
-            case 2:  SampleRate = 11000; break;
-            case 3:  SampleRate = 11025; break;
-            case 4:  SampleRate = 16000; break;
-            case 5:  SampleRate = 22050; break;
-            case 6:  SampleRate = 24000; break;
-            case 7:  SampleRate = 32000; break;
-            case 8:  SampleRate = 44100; break;
-            case 9:  SampleRate = 48000; break;
-            case 10: SampleRate = 96000; break; //???
-            default: /* probably specified in the extra flags */
-                SampleRate = 44100;
-                break;
-        }
+    return 1;
+fail:
+    return 0;
+}
 
-        /* get extra flags */
-        if (SampleMode1 & 0x01) { /* bit 0 (1) */
-            uint32_t ExtraFlag, ExtraFlagStart, ExtraFlagType, ExtraFlagSize, ExtraFlagEnd;
-
-            ExtraFlagStart = SampleHeaderStart+0x08;
-            do {
-                ExtraFlag = read_32bitLE(ExtraFlagStart,streamFile);
-                ExtraFlagType = (ExtraFlag >> 25) & 0x7F; /* bits 32..26 (7) */
-                ExtraFlagSize = (ExtraFlag >> 1) & 0xFFFFFF; /* bits 25..1 (24)*/
-                ExtraFlagEnd  = (ExtraFlag & 0x01); /* bit 0 (1) */
-
-                switch(ExtraFlagType) {
-                    case 0x01:  /* Channel Info */
-                        ChannelCount = read_8bit(ExtraFlagStart+0x04,streamFile);
-                        break;
-                    case 0x02:  /* Sample Rate Info */
-                        SampleRate = read_32bitLE(ExtraFlagStart+0x04,streamFile);
-                        break;
-                    case 0x03:  /* Loop Info */
-                        LoopStart = read_32bitLE(ExtraFlagStart+0x04,streamFile);
-                        if (ExtraFlagSize > 0x04) /* probably no needed */
-                            LoopEnd = read_32bitLE(ExtraFlagStart+0x08,streamFile);
-
-                        /* when start is 0 seems the song repeats with no real looping (ex. Sonic Boom Fire & Ice jingles) */
-                        LoopFlag = (LoopStart != 0x00);
-                        break;
-                    case 0x04:  /* free comment, or maybe SFX info */
-                        break;
-                    case 0x06:  /* XMA seek table */
-                        /* no need for it */
-                        break;
-                    case 0x07:  /* DSP Info (Coeffs) */
-                        DSPInfoStart = ExtraFlagStart + 0x04;
-                        break;
-                    case 0x09:  /* ATRAC9 data */
-                        break;
-                    case 0x0a:  /* XWMA data */
-                        break;
-                    case 0x0b:  /* Vorbis data */
-                        VorbisSetupId = (uint32_t)read_32bitLE(ExtraFlagStart+0x04,streamFile); /* crc32? */
-                        /* seek table format:
-                         * 0x08: table_size (total_entries = seek_table_size / (4+4)), not counting this value; can be 0
-                         * 0x0C: sample number (only some samples are saved in the table)
-                         * 0x10: offset within data, pointing to a FSB vorbis block (with the 16b block size header)
-                         * (xN entries)
-                         */
-                        break;
-                    //case 0x0d:  /* Unknown value (32b), found in some XMA2 and Vorbis */
-                    //    break;
-                    default:
-                        VGM_LOG("FSB5: unknown extra flag 0x%x at 0x%04x (size 0x%x)\n", ExtraFlagType, ExtraFlagStart, ExtraFlagSize);
-                        break;
-                }
-
-                ExtraFlagStart += 0x04 + ExtraFlagSize;
-                StreamHeaderLength += 0x04 + ExtraFlagSize;
-            } while (ExtraFlagEnd != 0x00);
-        }
+/* reads the header of stream N (1-based) at sample_header_start, and moves it to the next stream */
+static int parse_fsb5_stream(header_reader * hdr, fsb5_header * fsb5, off_t * sample_header_start, int stream_number) {
+    off_t SampleHeaderStart = *sample_header_start;
+    off_t  DataStart = 0;
+    size_t StreamHeaderLength = 0;
+    uint32_t SampleMode1, SampleMode2;
+
+
+    /* seems ok but could use some testing against FMOD's SDK */
+    SampleMode1 = (uint32_t)read_hdr_32bitLE(SampleHeaderStart+0x00,hdr);
+    SampleMode2 = (uint32_t)read_hdr_32bitLE(SampleHeaderStart+0x04,hdr);
+    StreamHeaderLength += 0x08;
+
+    /* get samples */
+    fsb5->num_samples = ((SampleMode2 >> 2) & 0x3FFFFFFF); /* bits 31..2 (30) */
+
+    /* get offset inside data section */
+    DataStart   = ((SampleMode1 >> 7) & 0x1FFFFFF) << 5; /* bits 31..8 (25) * 0x20 */
+    //SampleMode2 bits 1..0 part of DataStart for files larger than 0x3FFFFFE0?
+
+    /* get channels (from tests seems correct, but multichannel isn't very common, ex. no 4ch mode?) */
+    switch ((SampleMode1 >> 5) & 0x03) { /* bits 7..6 (2) */
+        case 0:  fsb5->channels = 1; break;
+        case 1:  fsb5->channels = 2; break;
+        case 2:  fsb5->channels = 6; break;/* some Dark Souls 2 MPEG; some IMA ADPCM */
+        case 3:  fsb5->channels = 8; break;/* some IMA ADPCM */
+        default: /* other values (ex. 10ch) are specified in the extra flags, using 0 here */
+            goto fail;
+    }
 
-        /* stream found */
-        if (i == TargetStream) {
-            StartOffset = BaseHeaderLength + SampleHeaderLength + NameTableLength + DataStart;
+    /* get sample rate  */
+    switch ((SampleMode1 >> 1) & 0x0f) { /* bits 5..1 (4) */
+        case 0:  fsb5->sample_rate = 4000;  break; //???
+        case 1:  fsb5->sample_rate = 8000;  break;
+        case 2:  fsb5->sample_rate = 11000; break;
+        case 3:  fsb5->sample_rate = 11025; break;
+        case 4:  fsb5->sample_rate = 16000; break;
+        case 5:  fsb5->sample_rate = 22050; break;
+        case 6:  fsb5->sample_rate = 24000; break;
+        case 7:  fsb5->sample_rate = 32000; break;
+        case 8:  fsb5->sample_rate = 44100; break;
+        case 9:  fsb5->sample_rate = 48000; break;
+        case 10: fsb5->sample_rate = 96000; break; //???
+        default: /* probably specified in the extra flags */
+            fsb5->sample_rate = 44100;
+            break;
+    }
 
-            /* get stream size from next stream or datasize if there is only one */
-            if (i == TotalStreams) {
-                StreamSize = SampleDataLength - DataStart;
-            } else {
-                uint32_t NextSampleMode  = (uint32_t)read_32bitLE(SampleHeaderStart+StreamHeaderLength+0x00,streamFile);
-                StreamSize = (((NextSampleMode >> 7) & 0x00FFFFFF) << 5) - DataStart;
+    /* get extra flags */
+    if (SampleMode1 & 0x01) { /* bit 0 (1) */
+        uint32_t ExtraFlag, ExtraFlagStart, ExtraFlagType, ExtraFlagSize, ExtraFlagEnd;
+
+        ExtraFlagStart = SampleHeaderStart+0x08;
+        do {
+            ExtraFlag = read_hdr_32bitLE(ExtraFlagStart,hdr);
+            ExtraFlagType = (ExtraFlag >> 25) & 0x7F; /* bits 32..26 (7) */
+            ExtraFlagSize = (ExtraFlag >> 1) & 0xFFFFFF; /* bits 25..1 (24)*/
+            ExtraFlagEnd  = (ExtraFlag & 0x01); /* bit 0 (1) */
+
+            switch(ExtraFlagType) {
+                case 0x01:  /* Channel Info */
+                    fsb5->channels = read_hdr_8bit(ExtraFlagStart+0x04,hdr);
+                    break;
+                case 0x02:  /* Sample Rate Info */
+                    fsb5->sample_rate = read_hdr_32bitLE(ExtraFlagStart+0x04,hdr);
+                    break;
+                case 0x03:  /* Loop Info */
+                    fsb5->loop_start = read_hdr_32bitLE(ExtraFlagStart+0x04,hdr);
+                    if (ExtraFlagSize > 0x04) /* probably no needed */
+                        fsb5->loop_end = read_hdr_32bitLE(ExtraFlagStart+0x08,hdr);
+
+                    /* when start is 0 seems the song repeats with no real looping (ex. Sonic Boom Fire & Ice jingles) */
+                    fsb5->loop_flag = (fsb5->loop_start != 0x00);
+                    break;
+                case 0x04:  /* free comment, or maybe SFX info */
+                    break;
+                case 0x06:  /* XMA seek table */
+                    /* no need for it */
+                    break;
+                case 0x07:  /* DSP Info (Coeffs) */
+                    fsb5->dsp_info_start = ExtraFlagStart + 0x04;
+                    break;
+                case 0x09:  /* ATRAC9 data */
+                    break;
+                case 0x0a:  /* XWMA data */
+                    break;
+                case 0x0b:  /* Vorbis data */
+                    fsb5->vorbis_setup_id = (uint32_t)read_hdr_32bitLE(ExtraFlagStart+0x04,hdr); /* crc32? */
+                    /* seek table format:
+                     * 0x08: table_size (total_entries = seek_table_size / (4+4)), not counting this value; can be 0
+                     * 0x0C: sample number (only some samples are saved in the table)
+                     * 0x10: offset within data, pointing to a FSB vorbis block (with the 16b block size header)
+                     * (xN entries)
+                     */
+                    break;
+                //case 0x0d:  /* Unknown value (32b), found in some XMA2 and Vorbis */
+                //    break;
+                default:
+                    VGM_LOG("FSB5: unknown extra flag 0x%x at 0x%04x (size 0x%x)\n", ExtraFlagType, ExtraFlagStart, ExtraFlagSize);
+                    break;
             }
 
-            break;
-        }
+            ExtraFlagStart += 0x04 + ExtraFlagSize;
+            StreamHeaderLength += 0x04 + ExtraFlagSize;
+        } while (ExtraFlagEnd != 0x00);
+    }
 
-        /* continue searching */
-        SampleHeaderStart += StreamHeaderLength;
+    /* stream found */
+    fsb5->stream_offset = fsb5->base_header_length + fsb5->sample_header_length + fsb5->name_table_length + DataStart;
+
+    /* get stream size from next stream or datasize if there is only one */
+    if (stream_number == fsb5->total_streams) {
+        fsb5->stream_size = fsb5->sample_data_length - DataStart;
+    } else {
+        uint32_t NextSampleMode  = (uint32_t)read_hdr_32bitLE(SampleHeaderStart+StreamHeaderLength+0x00,hdr);
+        fsb5->stream_size = (((NextSampleMode >> 7) & 0x00FFFFFF) << 5) - DataStart;
     }
-    /* target stream not found*/
-    if (!StartOffset || !StreamSize) goto fail;
 
     /* get stream name */
-    if (NameTableLength) {
-        NameOffset = BaseHeaderLength + SampleHeaderLength + read_32bitLE(BaseHeaderLength + SampleHeaderLength + 0x04*(TargetStream-1),streamFile);
+    fsb5->name_offset = 0;
+    if (fsb5->name_table_length) {
+        fsb5->name_offset = fsb5->base_header_length + fsb5->sample_header_length + read_hdr_32bitLE(fsb5->base_header_length + fsb5->sample_header_length + 0x04*(stream_number-1),hdr);
     }
 
+    /* continue searching */
+    *sample_header_start = SampleHeaderStart + StreamHeaderLength;
+
+    return 1;
+fail:
+    return 0;
+}
+
+static VGMSTREAM * build_fsb5_vgmstream(STREAMFILE *streamFile, fsb5_header * fsb5) {
+    VGMSTREAM * vgmstream = NULL;
+    off_t StartOffset = fsb5->stream_offset;
+    size_t StreamSize = fsb5->stream_size;
+    int ChannelCount = fsb5->channels;
+
+    /* target stream not found*/
+    if (!StartOffset || !StreamSize) goto fail;
+
 
     /* build the VGMSTREAM */
-    vgmstream = allocate_vgmstream(ChannelCount,LoopFlag);
+    vgmstream = allocate_vgmstream(ChannelCount,fsb5->loop_flag);
     if (!vgmstream) goto fail;
 
-    vgmstream->sample_rate = SampleRate;
-    vgmstream->num_streams = TotalStreams;
-    vgmstream->num_samples = NumSamples;
-    if (LoopFlag) {
-        vgmstream->loop_start_sample = LoopStart;
-        vgmstream->loop_end_sample = LoopEnd;
+    vgmstream->sample_rate = fsb5->sample_rate;
+    vgmstream->num_streams = fsb5->total_streams;
+    vgmstream->num_samples = fsb5->num_samples;
+    if (fsb5->loop_flag) {
+        vgmstream->loop_start_sample = fsb5->loop_start;
+        vgmstream->loop_end_sample = fsb5->loop_end;
     }
     vgmstream->meta_type = meta_FSB5;
-    if (NameOffset)
-        read_string(vgmstream->stream_name,STREAM_NAME_SIZE, NameOffset,streamFile);
+    if (fsb5->name_offset)
+        read_string(vgmstream->stream_name,STREAM_NAME_SIZE, fsb5->name_offset,streamFile);
 
 
     /* parse codec */
-    switch (CodingID) {
+    switch (fsb5->coding_id) {
         case 0x00:  /* FMOD_SOUND_FORMAT_NONE */
             goto fail;
 
@@ -229,7 +287,7 @@ VGMSTREAM * init_vgmstream_fsb5(STREAMFILE *streamFile) {
                 vgmstream->interleave_block_size = 0x02;
             }
 
-            dsp_read_coefs_be(vgmstream,streamFile,DSPInfoStart,0x2E);
+            dsp_read_coefs_be(vgmstream,streamFile,fsb5->dsp_info_start,0x2E);
             vgmstream->coding_type = coding_NGC_DSP;
             break;
 
@@ -300,7 +358,7 @@ VGMSTREAM * init_vgmstream_fsb5(STREAMFILE *streamFile) {
             memset(&cfg, 0, sizeof(vorbis_custom_config));
             cfg.channels = vgmstream->channels;
             cfg.sample_rate = vgmstream->sample_rate;
-            cfg.setup_id = VorbisSetupId;
+            cfg.setup_id = fsb5->vorbis_setup_id;
 
             vgmstream->layout_type = layout_none;
             vgmstream->coding_type = coding_VORBIS_custom;
@@ -327,3 +385,114 @@ fail:
     close_vgmstream(vgmstream);
     return NULL;
 }
+
+
+/* ****************************************************************************** */
+/* subsong table, with all stream headers parsed in one pass */
+
+typedef struct {
+    fsb5_header * streams; /* parsed headers, one per subsong */
+} fsb5_bank_data;
+
+static void free_fsb5_bank_data(void * bank_data) {
+    fsb5_bank_data * data = bank_data;
+    if (!data) return;
+    free(data->streams);
+    free(data);
+}
+
+static VGMSTREAM * init_fsb5_subsong(STREAMFILE *streamFile, vgmstream_subsong_table * table, int subsong) {
+    fsb5_bank_data * data = table->bank_data;
+    return build_fsb5_vgmstream(streamFile, &data->streams[subsong-1]);
+}
+
+/* codec as set when building the VGMSTREAM (returns 0 if not supported or not enabled) */
+static int get_fsb5_coding(STREAMFILE *streamFile, fsb5_header * fsb5, coding_t * coding_type) {
+    switch (fsb5->coding_id) {
+        case 0x01: *coding_type = coding_PCM8_U; return 1;
+        case 0x02: *coding_type = coding_PCM16LE; return 1;
+        case 0x05: *coding_type = coding_PCMFLOAT; return 1;
+        case 0x06: *coding_type = coding_NGC_DSP; return 1;
+        case 0x07: *coding_type = fsb5->channels > 2 ? coding_FSB_IMA : coding_XBOX; return 1;
+        case 0x09: *coding_type = coding_HEVAG; return 1;
+#ifdef VGM_USE_FFMPEG
+        case 0x0A: *coding_type = coding_FFmpeg; return 1;
+#endif
+#ifdef VGM_USE_MPEG
+        case 0x0B: /* layer from the first frame header, as the decoder does */
+            switch ((read_32bitBE(fsb5->stream_offset,streamFile) >> 17) & 0x03) {
+                case 3:  *coding_type = coding_MPEG_layer1; break;
+                case 2:  *coding_type = coding_MPEG_layer2; break;
+                default: *coding_type = coding_MPEG_layer3; break;
+            }
+            return 1;
+#endif
+#ifdef VGM_USE_VORBIS
+        case 0x0F: *coding_type = coding_VORBIS_custom; return 1;
+#endif
+        default:
+            return 0;
+    }
+}
+
+int init_subsong_table_fsb5(STREAMFILE * streamFile, vgmstream_subsong_table * table) {
+    fsb5_header fsb5 = {0};
+    fsb5_bank_data * data = NULL;
+    vgmstream_subsong_info * subsongs = NULL;
+    off_t SampleHeaderStart;
+    int i;
+    header_reader hdr;
+
+
+    if (!parse_fsb5_bank(streamFile, &hdr, &fsb5))
+        goto fail;
+    if (fsb5.total_streams <= 0) goto fail;
+
+    data = calloc(1, sizeof(fsb5_bank_data));
+    if (!data) goto fail;
+    data->streams = calloc(fsb5.total_streams, sizeof(fsb5_header));
+    if (!data->streams) goto fail;
+    subsongs = calloc(fsb5.total_streams, sizeof(vgmstream_subsong_info));
+    if (!subsongs) goto fail;
+
+    /* headers are consecutive (and values carry over), so each subsong is the state after its header */
+    SampleHeaderStart = fsb5.base_header_length;
+    for (i = 0; i < fsb5.total_streams; i++) {
+        fsb5_header * stream = &data->streams[i];
+        vgmstream_subsong_info * info = &subsongs[i];
+
+        if (!parse_fsb5_stream(&hdr, &fsb5, &SampleHeaderStart, i+1))
+            break; /* can't find next headers */
+        memcpy(stream, &fsb5, sizeof(fsb5_header));
+
+        if (!stream->stream_offset || !stream->stream_size)
+            continue;
+
+        info->supported = get_fsb5_coding(streamFile, stream, &info->coding_type);
+        info->stream_offset = stream->stream_offset;
+        info->stream_size = stream->stream_size;
+        info->channels = stream->channels;
+        info->sample_rate = stream->sample_rate;
+        info->num_samples = stream->num_samples;
+        info->loop_flag = stream->loop_flag;
+        if (stream->loop_flag) {
+            info->loop_start_sample = stream->loop_start;
+            info->loop_end_sample = stream->loop_end;
+        }
+        if (stream->name_offset)
+            read_string(info->stream_name,STREAM_NAME_SIZE, stream->name_offset,streamFile);
+    }
+
+    table->meta_type = meta_FSB5;
+    table->subsong_count = fsb5.total_streams;
+    table->subsongs = subsongs;
+    table->bank_data = data;
+    table->init_subsong = init_fsb5_subsong;
+    table->free_bank_data = free_fsb5_bank_data;
+    return 1;
+
+fail:
+    free(subsongs);
+    free_fsb5_bank_data(data);
+    return 0;
+}
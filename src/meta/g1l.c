@@ -2,8 +2,6 @@
 #include "../util.h"
 #include "../coding/coding.h"
 
-static VGMSTREAM * init_vgmstream_kt_wiibgm_offset(STREAMFILE *streamFile, off_t offset);
-
 /* Koei Tecmo G1L - pack format, sometimes containing a single stream
  *
  * It probably makes more sense to extract it externally, it's here mainly for Hyrule Warriors */
@@ -11,6 +9,8 @@ VGMSTREAM * init_vgmstream_kt_g1l(STREAMFILE *streamFile) {
 	VGMSTREAM * vgmstream = NULL;
 	int type, num_streams, target_stream = streamFile->stream_index;
 	off_t stream_offset;
+	size_t stream_size;
+	STREAMFILE * temp_streamFile = NULL;
     int32_t (*read_32bit)(off_t,STREAMFILE*) = NULL;
 
 	if (!check_extensions(streamFile,"g1l"))
@@ -37,11 +37,18 @@ VGMSTREAM * init_vgmstream_kt_g1l(STREAMFILE *streamFile) {
 	if (target_stream < 0 || target_stream > num_streams || num_streams < 1) goto fail;
 
     stream_offset = read_32bit(0x18 + 0x4*(target_stream-1),streamFile);
-    /* filesize = stream_offset - stream_next_offset*/
+    /* size up to the next stream, or 0 for the last (until EOF) */
+    stream_size = 0;
+    if (target_stream < num_streams && read_32bit(0x18 + 0x4*target_stream,streamFile) > stream_offset)
+        stream_size = read_32bit(0x18 + 0x4*target_stream,streamFile) - stream_offset;
 
     switch(type) { /* type may not be correct */
         case 0x09: /* DSP (WiiBGM) from Hyrule Warriors (Wii U) */
-            vgmstream = init_vgmstream_kt_wiibgm_offset(streamFile, stream_offset);
+            temp_streamFile = open_subfile(streamFile, stream_offset, stream_size, "dsp");
+            if (!temp_streamFile) goto fail;
+
+            vgmstream = init_vgmstream_kt_wiibgm(temp_streamFile);
+            close_streamfile(temp_streamFile);
             break;
         case 0x01: /* ATRAC3plus (RIFF) from One Piece Pirate Warriors 2 (PS3) */
         case 0x00: /* OGG (KOVS) from Romance Three Kindgoms 13 (PC)*/
@@ -59,10 +66,6 @@ fail:
 
 /* Koei Tecmo "WiiBGM" DSP format - found in Hyrule Warriors, Romance of the Three Kingdoms 12 */
 VGMSTREAM * init_vgmstream_kt_wiibgm(STREAMFILE *streamFile) {
-    return init_vgmstream_kt_wiibgm_offset(streamFile, 0x0);
-}
-
-static VGMSTREAM * init_vgmstream_kt_wiibgm_offset(STREAMFILE *streamFile, off_t offset) {
     VGMSTREAM * vgmstream = NULL;
     int loop_flag, channel_count;
     off_t start_offset;
@@ -70,22 +73,22 @@ static VGMSTREAM * init_vgmstream_kt_wiibgm_offset(STREAMFILE *streamFile, off_t
     if (!check_extensions(streamFile,"g1l,dsp"))
         goto fail;
 
-    if (read_32bitBE(offset+0x0, streamFile) != 0x57696942 && /* "WiiB" */
-        read_32bitBE(offset+0x4, streamFile) != 0x474D0000)   /* "GM\0\0" */
+    if (read_32bitBE(0x0, streamFile) != 0x57696942 && /* "WiiB" */
+        read_32bitBE(0x4, streamFile) != 0x474D0000)   /* "GM\0\0" */
         goto fail;
 
     /* check type details */
-    loop_flag = read_32bitBE(offset+0x14, streamFile) > 0;
-    channel_count = read_8bit(offset+0x23, streamFile);
+    loop_flag = read_32bitBE(0x14, streamFile) > 0;
+    channel_count = read_8bit(0x23, streamFile);
 
     /* build the VGMSTREAM */
     vgmstream = allocate_vgmstream(channel_count, loop_flag);
     if (!vgmstream) goto fail;
 
     /* fill in the vital statistics */
-    vgmstream->num_samples = read_32bitBE(offset+0x10, streamFile);
-    vgmstream->sample_rate = (uint16_t)read_16bitBE(offset+0x26, streamFile);
-    vgmstream->loop_start_sample = read_32bitBE(offset+0x14, streamFile);
+    vgmstream->num_samples = read_32bitBE(0x10, streamFile);
+    vgmstream->sample_rate = (uint16_t)read_16bitBE(0x26, streamFile);
+    vgmstream->loop_start_sample = read_32bitBE(0x14, streamFile);
     vgmstream->loop_end_sample = vgmstream->num_samples;
 
     vgmstream->coding_type = coding_NGC_DSP;
@@ -94,8 +97,8 @@ static VGMSTREAM * init_vgmstream_kt_wiibgm_offset(STREAMFILE *streamFile, off_t
 
     vgmstream->interleave_block_size = 0x1;
 
-    dsp_read_coefs_be(vgmstream,streamFile, offset+0x5C, 0x60);
-    start_offset = offset+0x800;
+    dsp_read_coefs_be(vgmstream,streamFile, 0x5C, 0x60);
+    start_offset = 0x800;
 
     if (!vgmstream_open_stream(vgmstream,streamFile,start_offset))
         goto fail;
@@ -96,7 +96,7 @@ static size_t read_bar(BARSTREAM *streamFile, uint8_t *dest, off_t offset, size_
 {
     off_t i;
     size_t read_length =
-        streamFile->real_file->read(streamFile->real_file, dest, offset, length);
+        read_streamfile(dest, offset, length, streamFile->real_file);
 
     for (i = 0; i < read_length; i++)
     {
@@ -143,17 +143,15 @@ static void close_bar(BARSTREAM *streamFile)
     return;
 }
 
-#ifdef PROFILE_STREAMFILE
-size_t get_bytes_read_bar(BARSTREAM *streamFile)
+static size_t get_bytes_read_bar(BARSTREAM *streamFile)
 {
-    return streamFile->real_file->get_bytes_read(streamFile->real_file);
+    return get_streamfile_bytes_read(streamFile->real_file);
 }
 
-int (*get_error_count)(BARSTREAM *streamFile)
+static int get_error_count_bar(BARSTREAM *streamFile)
 {
-    return streamFile->real_file->get_error_count(streamFile->real_file);
+    return get_streamfile_error_count(streamFile->real_file);
 }
-#endif
 
 STREAMFILE *wrap_bar_STREAMFILE(STREAMFILE *file)
 {
@@ -171,10 +169,8 @@ STREAMFILE *wrap_bar_STREAMFILE(STREAMFILE *file)
     streamfile->sf.get_realname = (void*)get_realname_bar;
     streamfile->sf.open = (void*)open_bar;
     streamfile->sf.close = (void*)close_bar;
-#ifdef PROFILE_STREAMFILE
-    streamfile->sf.get_bytes_read = get_bytes_read_bar;
-    streamfile->sf.get_error_count = get_error_count_bar;
-#endif
+    streamfile->sf.get_bytes_read = (void*)get_bytes_read_bar;
+    streamfile->sf.get_error_count = (void*)get_error_count_bar;
 
     streamfile->real_file = file;
 
@@ -45,20 +45,25 @@ VGMSTREAM * init_vgmstream_hca(STREAMFILE *streamFile) {
     /* HCA_Decoder context memory goes right after our codec data (reserved in alloc'ed) */
     hca = (clHCA *)(hca_data + 1);
 
-    /* pre-load streamfile so the hca_data is ready before key detection */
-    streamFile->get_name( streamFile, filename, sizeof(filename) );
-    hca_data->streamfile = streamFile->open(streamFile, filename, STREAMFILE_DEFAULT_BUFFER_SIZE);
-    if (!hca_data->streamfile) goto fail;
-
-
-    /* find decryption key in external file or preloaded list */
-    {
-        uint8_t keybuf[8];
-        if ( read_key_file(keybuf, 8, streamFile) ) {
-            ciphKey2 = get_32bitBE(keybuf+0);
-            ciphKey1 = get_32bitBE(keybuf+4);
-        } else {
-            find_hca_key(hca_data, hca, buffer, header_size, &ciphKey1, &ciphKey2);
+    if (streamFile->info_only) {
+        /* the key is only needed to decode, header info can be read without it */
+        ciphKey1 = ciphKey2 = 0;
+    }
+    else {
+        /* pre-load streamfile so the hca_data is ready before key detection */
+        streamFile->get_name( streamFile, filename, sizeof(filename) );
+        hca_data->streamfile = streamFile->open(streamFile, filename, STREAMFILE_DEFAULT_BUFFER_SIZE);
+        if (!hca_data->streamfile) goto fail;
+
+        /* find decryption key in external file or preloaded list */
+        {
+            uint8_t keybuf[8];
+            if ( read_key_file(keybuf, 8, streamFile) ) {
+                ciphKey2 = get_32bitBE(keybuf+0);
+                ciphKey1 = get_32bitBE(keybuf+4);
+            } else {
+                find_hca_key(hca_data, hca, buffer, header_size, &ciphKey1, &ciphKey2);
+            }
         }
     }
 
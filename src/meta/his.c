@@ -19,7 +19,7 @@ VGMSTREAM * init_vgmstream_his(STREAMFILE *streamFile) {
     if (strcasecmp("his",filename_extension(filename))) goto fail;
 
     /* check header magic */
-    if (0x16 != streamFile->read(streamFile, header_magic, 0, 0x16)) goto fail;
+    if (0x16 != read_streamfile(header_magic, 0, 0x16, streamFile)) goto fail;
     if (memcmp(header_magic_expected, header_magic, 0x16)) goto fail;
 
     /* data chunk label */
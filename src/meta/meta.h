@@ -177,10 +177,12 @@ VGMSTREAM * init_vgmstream_fsb(STREAMFILE * streamFile);
 VGMSTREAM * init_vgmstream_fsb4_wav(STREAMFILE * streamFile);
 
 VGMSTREAM * init_vgmstream_fsb5(STREAMFILE * streamFile);
+int init_subsong_table_fsb5(STREAMFILE * streamFile, vgmstream_subsong_table * table);
 
 VGMSTREAM * init_vgmstream_rwx(STREAMFILE * streamFile);
 
 VGMSTREAM * init_vgmstream_xwb(STREAMFILE * streamFile);
+int init_subsong_table_xwb(STREAMFILE * streamFile, vgmstream_subsong_table * table);
 
 VGMSTREAM * init_vgmstream_ps2_xa30(STREAMFILE * streamFile);
 
@@ -376,6 +378,9 @@ VGMSTREAM * init_vgmstream_aax(STREAMFILE *streamFile);
 
 VGMSTREAM * init_vgmstream_utf_dsp(STREAMFILE *streamFile);
 
+int init_streamfile_archive_afs(streamfile_archive * archive);
+int init_streamfile_archive_cpk(streamfile_archive * archive);
+
 VGMSTREAM * init_vgmstream_ngc_ffcc_str(STREAMFILE *streamFile);
 
 VGMSTREAM * init_vgmstream_sat_baka(STREAMFILE *streamFile);
@@ -539,6 +544,7 @@ VGMSTREAM * init_vgmstream_xvag(STREAMFILE* streamFile);
 VGMSTREAM * init_vgmstream_ps3_cps(STREAMFILE* streamFile);
 
 VGMSTREAM * init_vgmstream_sqex_scd(STREAMFILE* streamFile);
+int init_subsong_table_sqex_scd(STREAMFILE * streamFile, vgmstream_subsong_table * table);
 
 VGMSTREAM * init_vgmstream_ngc_nst_dsp(STREAMFILE* streamFile);
 
@@ -670,6 +676,7 @@ VGMSTREAM * init_vgmstream_wii_04sw(STREAMFILE * streamFile);
 VGMSTREAM * init_vgmstream_txth(STREAMFILE * streamFile);
 
 VGMSTREAM * init_vgmstream_ea_bnk(STREAMFILE * streamFile);
+int init_subsong_table_ea_bnk(STREAMFILE * streamFile, vgmstream_subsong_table * table);
 
 VGMSTREAM * init_vgmstream_ea_schl_fixed(STREAMFILE * streamFile);
 
@@ -680,6 +687,7 @@ VGMSTREAM * init_vgmstream_stm(STREAMFILE * streamFile);
 VGMSTREAM * init_vgmstream_ea_snu(STREAMFILE * streamFile);
 
 VGMSTREAM * init_vgmstream_awc(STREAMFILE * streamFile);
+int init_subsong_table_awc(STREAMFILE * streamFile, vgmstream_subsong_table * table);
 
 VGMSTREAM * init_vgmstream_nsw_opus(STREAMFILE * streamFile);
 
@@ -690,6 +698,7 @@ VGMSTREAM * init_vgmstream_pc_ast(STREAMFILE * streamFile);
 VGMSTREAM * init_vgmstream_naac(STREAMFILE * streamFile);
 
 VGMSTREAM * init_vgmstream_ubi_sb(STREAMFILE * streamFile);
+int init_subsong_table_ubi_sb(STREAMFILE * streamFile, vgmstream_subsong_table * table);
 
 VGMSTREAM * init_vgmstream_ezw(STREAMFILE * streamFile);
 
@@ -28,58 +28,6 @@ static size_t read_func(void *ptr, size_t size, size_t nmemb, void * datasource)
     return items_read;
 }
 
-static size_t read_func_um3(void *ptr, size_t size, size_t nmemb, void * datasource)
-{
-    ogg_vorbis_streamfile * const ov_streamfile = datasource;
-    size_t items_read;
-
-    size_t bytes_read;
-   
-    bytes_read = read_streamfile(ptr, ov_streamfile->offset + ov_streamfile->other_header_bytes, size * nmemb,
-            ov_streamfile->streamfile);
-
-    items_read = bytes_read / size;
-
-    /* first 0x800 bytes of um3 are xor'd with 0xff */
-    if (ov_streamfile->offset < 0x800) {
-        int num_crypt = 0x800-ov_streamfile->offset;
-        int i;
-
-        if (num_crypt > bytes_read) num_crypt=bytes_read;
-        for (i=0;i<num_crypt;i++)
-            ((uint8_t*)ptr)[i] ^= 0xff;
-    }
-
-    ov_streamfile->offset += items_read * size;
-
-    return items_read;
-}
-
-static size_t read_func_kovs(void *ptr, size_t size, size_t nmemb, void * datasource)
-{
-    ogg_vorbis_streamfile * const ov_streamfile = datasource;
-    size_t items_read;
-
-    size_t bytes_read;
-   
-    bytes_read = read_streamfile(ptr, ov_streamfile->offset+ov_streamfile->other_header_bytes, size * nmemb,
-            ov_streamfile->streamfile);
-
-    items_read = bytes_read / size;
-
-    /* first 0x100 bytes of KOVS are xor'd with offset */
-    if (ov_streamfile->offset < 0x100) {
-        int i;
-
-        for (i=ov_streamfile->offset;i<0x100;i++)
-            ((uint8_t*)ptr)[i-ov_streamfile->offset] ^= i;
-    }
-
-    ov_streamfile->offset += items_read * size;
-
-    return items_read;
-}
-
 static size_t read_func_scd(void *ptr, size_t size, size_t nmemb, void * datasource)
 {
     ogg_vorbis_streamfile * const ov_streamfile = datasource;
@@ -102,28 +50,6 @@ static size_t read_func_scd(void *ptr, size_t size, size_t nmemb, void * datasou
     return items_read;
 }
 
-static size_t read_func_psych(void *ptr, size_t size, size_t nmemb, void * datasource)
-{
-    ogg_vorbis_streamfile * const ov_streamfile = datasource;
-    size_t items_read;
-
-    size_t bytes_read;
-    size_t i;
-   
-    bytes_read = read_streamfile(ptr, ov_streamfile->offset + ov_streamfile->other_header_bytes, size * nmemb,
-            ov_streamfile->streamfile);
-
-    /* add 0x23 ('#') */
-    for (i=0;i<bytes_read;i++)
-        ((uint8_t*)ptr)[i] += 0x23;
-
-    items_read = bytes_read / size;
-
-    ov_streamfile->offset += items_read * size;
-
-    return items_read;
-}
-
 static int seek_func(void *datasource, ogg_int64_t offset, int whence) {
     ogg_vorbis_streamfile * const ov_streamfile = datasource;
     ogg_int64_t base_offset;
@@ -169,6 +95,8 @@ VGMSTREAM * init_vgmstream_ogg_vorbis(STREAMFILE *streamFile) {
     char filename[PATH_LIMIT];
 
     ov_callbacks callbacks;
+    STREAMFILE * temp_streamFile = NULL;
+    VGMSTREAM * vgmstream = NULL;
 
     off_t other_header_bytes = 0;
     int um3_ogg = 0;
@@ -219,15 +147,35 @@ VGMSTREAM * init_vgmstream_ogg_vorbis(STREAMFILE *streamFile) {
         psych_ogg = 1;
     }
 
-    if (um3_ogg) {
-        callbacks.read_func = read_func_um3;
-    } else if (kovs_ogg) {
-        callbacks.read_func = read_func_kovs;
-    } else if (psych_ogg) {
-        callbacks.read_func = read_func_psych;
-    } else {
-        callbacks.read_func = read_func;
+    /* decrypt through a transform STREAMFILE, that libvorbis reads normally */
+    if (um3_ogg || kovs_ogg || psych_ogg) {
+        streamfile_transform transform;
+        STREAMFILE * new_streamFile;
+
+        memset(&transform, 0, sizeof(transform));
+        if (um3_ogg) { /* first 0x800 bytes of um3 are xor'd with 0xff */
+            transform.type = STREAMFILE_TRANSFORM_XOR;
+            transform.value = 0xff;
+            transform.size = 0x800;
+        } else if (kovs_ogg) { /* first 0x100 bytes of KOVS are xor'd with offset */
+            transform.type = STREAMFILE_TRANSFORM_XOR_OFFSET;
+            transform.start = other_header_bytes;
+            transform.size = 0x100;
+        } else { /* add 0x23 ('#') */
+            transform.type = STREAMFILE_TRANSFORM_ADD;
+            transform.value = 0x23;
+        }
+
+        new_streamFile = streamFile->open(streamFile,filename,STREAMFILE_DEFAULT_BUFFER_SIZE);
+        if (!new_streamFile) goto fail;
+        temp_streamFile = open_transform_streamfile(new_streamFile, &transform, 0);
+        if (!temp_streamFile) {
+            close_streamfile(new_streamFile);
+            goto fail;
+        }
     }
+
+    callbacks.read_func = read_func;
     callbacks.seek_func = seek_func;
     callbacks.close_func = close_func;
     callbacks.tell_func = tell_func;
@@ -244,7 +192,9 @@ VGMSTREAM * init_vgmstream_ogg_vorbis(STREAMFILE *streamFile) {
 
     inf.layout_type = layout_ogg_vorbis;
 
-    return init_vgmstream_ogg_vorbis_callbacks(streamFile, filename, &callbacks, other_header_bytes, &inf);
+    vgmstream = init_vgmstream_ogg_vorbis_callbacks(temp_streamFile ? temp_streamFile : streamFile, filename, &callbacks, other_header_bytes, &inf);
+    if (temp_streamFile) close_streamfile(temp_streamFile);
+    return vgmstream;
 
 fail:
     return NULL;
@@ -91,29 +91,20 @@ struct riff_fmt_chunk {
     int interleave;
 };
 
-static int read_fmt(int big_endian, STREAMFILE * streamFile, off_t current_chunk, struct riff_fmt_chunk * fmt, int sns, int mwv) {
-
+static int read_fmt(header_reader * hdr, off_t current_chunk, struct riff_fmt_chunk * fmt, int sns, int mwv) {
+    STREAMFILE * streamFile = hdr->streamfile;
+    int big_endian = hdr->big_endian;
     int codec, bps;
-    int32_t (*read_32bit)(off_t,STREAMFILE*) = NULL;
-    int16_t (*read_16bit)(off_t,STREAMFILE*) = NULL;
-
-    if (big_endian) {
-        read_32bit = read_32bitBE;
-        read_16bit = read_16bitBE;
-    } else {
-        read_32bit = read_32bitLE;
-        read_16bit = read_16bitLE;
-    }
 
     fmt->offset = current_chunk;
-    fmt->size = read_32bit(current_chunk+0x4,streamFile);
+    fmt->size = read_hdr_32bit(current_chunk+0x4,hdr);
 
-    fmt->sample_rate = read_32bit(current_chunk+0x0c,streamFile);
-    fmt->channel_count = read_16bit(current_chunk+0x0a,streamFile);
-    fmt->block_size = read_16bit(current_chunk+0x14,streamFile);
+    fmt->sample_rate = read_hdr_32bit(current_chunk+0x0c,hdr);
+    fmt->channel_count = read_hdr_16bit(current_chunk+0x0a,hdr);
+    fmt->block_size = read_hdr_16bit(current_chunk+0x14,hdr);
 
-    bps = read_16bit(current_chunk+0x16,streamFile);
-    codec = (uint16_t)read_16bit(current_chunk+0x8,streamFile);
+    bps = read_hdr_16bit(current_chunk+0x16,hdr);
+    codec = (uint16_t)read_hdr_16bit(current_chunk+0x8,hdr);
 
     switch (codec) {
         case 0x01: /* PCM */
@@ -194,12 +185,12 @@ static int read_fmt(int big_endian, STREAMFILE * streamFile, off_t current_chunk
 
 #ifdef VGM_USE_MAIATRAC3PLUS
 		case 0xFFFE: /* WAVEFORMATEXTENSIBLE / ATRAC3plus */
-			if (read_32bit(current_chunk+0x20,streamFile) == 0xE923AABF &&
-				read_16bit(current_chunk+0x24,streamFile) == (int16_t)0xCB58 &&
-				read_16bit(current_chunk+0x26,streamFile) == 0x4471 &&
-				read_32bitLE(current_chunk+0x28,streamFile) == 0xFAFF19A1 &&
-				read_32bitLE(current_chunk+0x2C,streamFile) == 0x62CEE401) {
-				uint16_t bztmp = read_16bit(current_chunk+0x32,streamFile);
+			if (read_hdr_32bit(current_chunk+0x20,hdr) == 0xE923AABF &&
+				read_hdr_16bit(current_chunk+0x24,hdr) == (int16_t)0xCB58 &&
+				read_hdr_16bit(current_chunk+0x26,hdr) == 0x4471 &&
+				read_hdr_32bitLE(current_chunk+0x28,hdr) == 0xFAFF19A1 &&
+				read_hdr_32bitLE(current_chunk+0x2C,hdr) == 0x62CEE401) {
+				uint16_t bztmp = read_hdr_16bit(current_chunk+0x32,hdr);
 				bztmp = (bztmp >> 8) | (bztmp << 8);
 				fmt->coding_type = coding_AT3plus;
 				fmt->block_size = (bztmp & 0x3FF) * 8 + 8;
@@ -254,6 +245,8 @@ VGMSTREAM * init_vgmstream_riff(STREAMFILE *streamFile) {
 	/* Sony atrac3 / 3plus */
     int at3 = 0;
 
+    header_reader hdr;
+
     /* check extension, case insensitive */
     streamFile->get_name(streamFile,filename,sizeof(filename));
     if (strcasecmp("wav",filename_extension(filename))
@@ -284,14 +277,17 @@ VGMSTREAM * init_vgmstream_riff(STREAMFILE *streamFile) {
         }
     }
 
+    /* usually all chunks before "data" (and often the whole file header) fit in one read */
+    init_header_reader(&hdr, streamFile, 0x00, STREAMFILE_HEADER_READER_SIZE, 0);
+
     /* check header */
-    if ((uint32_t)read_32bitBE(0,streamFile)!=0x52494646) /* "RIFF" */
+    if ((uint32_t)read_hdr_32bitBE(0, &hdr)!=0x52494646) /* "RIFF" */
         goto fail;
     /* check for WAVE form */
-    if ((uint32_t)read_32bitBE(8,streamFile)!=0x57415645) /* "WAVE" */
+    if ((uint32_t)read_hdr_32bitBE(8, &hdr)!=0x57415645) /* "WAVE" */
         goto fail;
 
-    riff_size = read_32bitLE(4,streamFile);
+    riff_size = read_hdr_32bitLE(4, &hdr);
     file_size = get_streamfile_size(streamFile);
 
     /* check for tructated RIFF */
@@ -302,8 +298,8 @@ VGMSTREAM * init_vgmstream_riff(STREAMFILE *streamFile) {
         off_t current_chunk = 0xc; /* start with first chunk */
 
         while (current_chunk < file_size && current_chunk < riff_size+8) {
-            uint32_t chunk_type = read_32bitBE(current_chunk,streamFile);
-            off_t chunk_size = read_32bitLE(current_chunk+4,streamFile);
+            uint32_t chunk_type = read_hdr_32bitBE(current_chunk, &hdr);
+            off_t chunk_size = read_hdr_32bitLE(current_chunk+4, &hdr);
 
             if (current_chunk+8+chunk_size > file_size) goto fail;
 
@@ -313,8 +309,7 @@ VGMSTREAM * init_vgmstream_riff(STREAMFILE *streamFile) {
                     if (FormatChunkFound) goto fail;
                     FormatChunkFound = 1;
 
-                    if (-1 == read_fmt(0, /* big endian == false*/
-                        streamFile,
+                    if (-1 == read_fmt(&hdr,
                         current_chunk,
                         &fmt,
                         sns,
@@ -332,7 +327,7 @@ VGMSTREAM * init_vgmstream_riff(STREAMFILE *streamFile) {
                     break;
                 case 0x4C495354:    /* LIST */
                     /* what lurks within?? */
-                    switch (read_32bitBE(current_chunk + 8, streamFile)) {
+                    switch (read_hdr_32bitBE(current_chunk + 8, &hdr)) {
                         case 0x6164746C:    /* adtl */
                             /* yay, atdl is its own little world */
                             parse_adtl(current_chunk + 8, chunk_size,
@@ -345,16 +340,16 @@ VGMSTREAM * init_vgmstream_riff(STREAMFILE *streamFile) {
                     break;
                 case 0x736D706C:    /* smpl */
                     /* check loop count */
-                    if (read_32bitLE(current_chunk+0x24, streamFile)==1)
+                    if (read_hdr_32bitLE(current_chunk+0x24, &hdr)==1)
                     {
                         /* check loop info */
-                        if (read_32bitLE(current_chunk+0x2c+4, streamFile)==0)
+                        if (read_hdr_32bitLE(current_chunk+0x2c+4, &hdr)==0)
                         {
                             loop_flag = 1;
                             loop_start_offset =
-                                read_32bitLE(current_chunk+0x2c+8, streamFile);
+                                read_hdr_32bitLE(current_chunk+0x2c+8, &hdr);
                             loop_end_offset =
-                                read_32bitLE(current_chunk+0x2c+0xc,streamFile);
+                                read_hdr_32bitLE(current_chunk+0x2c+0xc, &hdr);
                         }
                     }
                     break;
@@ -366,7 +361,7 @@ VGMSTREAM * init_vgmstream_riff(STREAMFILE *streamFile) {
                 case 0x6374726c:    /* ctrl */
                     if (!mwv) break;    /* ignore if not in an mwv */
                     /* loops! */
-                    if (read_32bitLE(current_chunk+8, streamFile))
+                    if (read_hdr_32bitLE(current_chunk+8, &hdr))
                     {
                         loop_flag = 1;
                     }
@@ -374,13 +369,13 @@ VGMSTREAM * init_vgmstream_riff(STREAMFILE *streamFile) {
                     break;
                 case 0x66616374:    /* fact */
                     if (sns && chunk_size == 0x10) {
-                        fact_sample_count = read_32bitLE(current_chunk+0x8, streamFile);
+                        fact_sample_count = read_hdr_32bitLE(current_chunk+0x8, &hdr);
                     } else if (at3 && chunk_size == 0x8) {
-                        fact_sample_count = read_32bitLE(current_chunk+0x8, streamFile);
-                        fact_sample_skip  = read_32bitLE(current_chunk+0xc, streamFile);
+                        fact_sample_count = read_hdr_32bitLE(current_chunk+0x8, &hdr);
+                        fact_sample_skip  = read_hdr_32bitLE(current_chunk+0xc, &hdr);
                     } else if (at3 && chunk_size == 0xc) {
-                        fact_sample_count = read_32bitLE(current_chunk+0x8, streamFile);
-                        fact_sample_skip  = read_32bitLE(current_chunk+0x10, streamFile);
+                        fact_sample_count = read_hdr_32bitLE(current_chunk+0x8, &hdr);
+                        fact_sample_skip  = read_hdr_32bitLE(current_chunk+0x10, &hdr);
                     }
 
                     break;
@@ -657,6 +652,7 @@ VGMSTREAM * init_vgmstream_rifx(STREAMFILE *streamFile) {
     uint32_t data_size = 0;
 
     int FormatChunkFound = 0, DataChunkFound = 0, JunkFound = 0;
+    header_reader hdr;
 
     /* check extension, case insensitive */
     streamFile->get_name(streamFile,filename,sizeof(filename));
@@ -666,14 +662,16 @@ VGMSTREAM * init_vgmstream_rifx(STREAMFILE *streamFile) {
         goto fail;
     }
 
+    init_header_reader(&hdr, streamFile, 0x00, STREAMFILE_HEADER_READER_SIZE, 1);
+
     /* check header */
-    if ((uint32_t)read_32bitBE(0,streamFile)!=0x52494658) /* "RIFX" */
+    if ((uint32_t)read_hdr_32bitBE(0, &hdr)!=0x52494658) /* "RIFX" */
         goto fail;
     /* check for WAVE form */
-    if ((uint32_t)read_32bitBE(8,streamFile)!=0x57415645) /* "WAVE" */
+    if ((uint32_t)read_hdr_32bitBE(8, &hdr)!=0x57415645) /* "WAVE" */
         goto fail;
 
-    riff_size = read_32bitBE(4,streamFile);
+    riff_size = read_hdr_32bitBE(4, &hdr);
     file_size = get_streamfile_size(streamFile);
 
     /* check for tructated RIFF */
@@ -684,8 +682,8 @@ VGMSTREAM * init_vgmstream_rifx(STREAMFILE *streamFile) {
         off_t current_chunk = 0xc; /* start with first chunk */
 
         while (current_chunk < file_size && current_chunk < riff_size+8) {
-            uint32_t chunk_type = read_32bitBE(current_chunk,streamFile);
-            off_t chunk_size = read_32bitBE(current_chunk+4,streamFile);
+            uint32_t chunk_type = read_hdr_32bitBE(current_chunk, &hdr);
+            off_t chunk_size = read_hdr_32bitBE(current_chunk+4, &hdr);
 
             if (current_chunk+8+chunk_size > file_size) goto fail;
 
@@ -695,8 +693,7 @@ VGMSTREAM * init_vgmstream_rifx(STREAMFILE *streamFile) {
                     if (FormatChunkFound) goto fail;
                     FormatChunkFound = 1;
 
-                    if (-1 == read_fmt(1, /* big endian == true */
-                        streamFile,
+                    if (-1 == read_fmt(&hdr,
                         current_chunk,
                         &fmt,
                         0,  /* sns == false */
@@ -714,16 +711,16 @@ VGMSTREAM * init_vgmstream_rifx(STREAMFILE *streamFile) {
                     break;
                 case 0x736D706C:    /* smpl */
                     /* check loop count */
-                    if (read_32bitBE(current_chunk+0x24, streamFile)==1)
+                    if (read_hdr_32bitBE(current_chunk+0x24, &hdr)==1)
                     {
                         /* check loop info */
-                        if (read_32bitBE(current_chunk+0x2c+4, streamFile)==0)
+                        if (read_hdr_32bitBE(current_chunk+0x2c+4, &hdr)==0)
                         {
                             loop_flag = 1;
                             loop_start_offset =
-                                read_32bitBE(current_chunk+0x2c+8, streamFile);
+                                read_hdr_32bitBE(current_chunk+0x2c+8, &hdr);
                             loop_end_offset =
-                                read_32bitBE(current_chunk+0x2c+0xc,streamFile);
+                                read_hdr_32bitBE(current_chunk+0x2c+0xc, &hdr);
                         }
                     }
                     break;
@@ -850,6 +847,7 @@ VGMSTREAM * init_vgmstream_xnbm(STREAMFILE *streamFile) {
     size_t xnb_size, data_size;
 
     struct riff_fmt_chunk fmt;
+    header_reader hdr;
 
 
     /* check extension, case insensitive */
@@ -904,8 +902,8 @@ VGMSTREAM * init_vgmstream_xnbm(STREAMFILE *streamFile) {
         fmt_chunk_size = read_32bitLE(current_chunk, streamFile);
         current_chunk += 4;
 
-        if (-1 == read_fmt(0, /* big endian == false */
-                  streamFile,
+        init_header_reader(&hdr, streamFile, current_chunk-8, 0x08+fmt_chunk_size, 0);
+        if (-1 == read_fmt(&hdr,
                   current_chunk-8,  /* read_fmt() expects to skip "fmt "+size */
                   &fmt,
                   0,    /* sns == false */
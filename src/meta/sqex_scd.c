@@ -24,26 +24,39 @@ static void scd_ogg_decrypt_v2_callback(void *ptr, size_t size, size_t nmemb, vo
 static void scd_ogg_decrypt_v3_callback(void *ptr, size_t size, size_t nmemb, void *datasource, int bytes_read);
 #endif
 
+static int parse_scd_bank(STREAMFILE *streamFile, int * big_endian, off_t * headers_offset, int * headers_entries);
+static VGMSTREAM * build_scd_vgmstream(STREAMFILE *streamFile, int big_endian, off_t meta_offset, int headers_entries);
 
 
 VGMSTREAM * init_vgmstream_sqex_scd(STREAMFILE *streamFile) {
-    VGMSTREAM * vgmstream = NULL;
-    char filename[PATH_LIMIT];
-    off_t start_offset, tables_offset, headers_offset, meta_offset, post_meta_offset, stream_size;
-    int headers_entries;
-    int32_t loop_start, loop_end;
-
+    off_t headers_offset, meta_offset;
+    int headers_entries, big_endian;
     int target_stream = streamFile->stream_index;
-    int loop_flag = 0, channel_count, codec_id;
-    int aux_chunk_count;
-
     int32_t (*read_32bit)(off_t,STREAMFILE*) = NULL;
-    int16_t (*read_16bit)(off_t,STREAMFILE*) = NULL;
 
     /* check extension, case insensitive */
     if ( !check_extensions(streamFile, "scd") ) goto fail;
 
-    streamFile->get_name(streamFile,filename,sizeof(filename));
+    if (!parse_scd_bank(streamFile, &big_endian, &headers_offset, &headers_entries))
+        goto fail;
+    if (target_stream == 0) target_stream = 1; /* auto: default to 1 */
+    if (target_stream < 0 || target_stream > headers_entries || headers_entries < 1) goto fail;
+    read_32bit = big_endian ? read_32bitBE : read_32bitLE;
+
+    /** header table entries (each is an uint32_t offset to stream header) **/
+    meta_offset = read_32bit(headers_offset + (target_stream-1)*4,streamFile);
+
+    return build_scd_vgmstream(streamFile, big_endian, meta_offset, headers_entries);
+
+fail:
+    return NULL;
+}
+
+/* main header and offset tables */
+static int parse_scd_bank(STREAMFILE *streamFile, int * big_endian, off_t * headers_offset, int * headers_entries) {
+    off_t tables_offset;
+    int32_t (*read_32bit)(off_t,STREAMFILE*) = NULL;
+    int16_t (*read_16bit)(off_t,STREAMFILE*) = NULL;
 
     /* SEDB */
     if (read_32bitBE(0,streamFile) != 0x53454442) goto fail;
@@ -56,12 +69,14 @@ VGMSTREAM * init_vgmstream_sqex_scd(STREAMFILE *streamFile) {
 
         read_32bit = read_32bitBE;
         read_16bit = read_16bitBE;
+        *big_endian = 1;
         //size_offset = 0x14;
     } else if (read_32bitLE(8,streamFile) == 3 || /* version 2/3 LE, as seen in FFXIV for PC (and others?) */
                read_32bitLE(8,streamFile) == 2) {
 
         read_32bit = read_32bitLE;
         read_16bit = read_16bitLE;
+        *big_endian = 0;
         //size_offset = 0x10;
     } else goto fail;
 
@@ -87,14 +102,26 @@ VGMSTREAM * init_vgmstream_sqex_scd(STREAMFILE *streamFile) {
     /* 0x14: unknown (0x0) */
     /* 0x18: unknown offset */
     /* 0x1c: unknown (0x0)  */
-    headers_entries = read_16bit(tables_offset+0x04,streamFile);
-    if (target_stream == 0) target_stream = 1; /* auto: default to 1 */
-    if (target_stream < 0 || target_stream > headers_entries || headers_entries < 1) goto fail;
+    *headers_entries = read_16bit(tables_offset+0x04,streamFile);
+    *headers_offset = read_32bit(tables_offset+0x0c,streamFile);
 
-    headers_offset = read_32bit(tables_offset+0x0c,streamFile);
+    return 1;
+fail:
+    return 0;
+}
 
-    /** header table entries (each is an uint32_t offset to stream header) **/
-    meta_offset = read_32bit(headers_offset + (target_stream-1)*4,streamFile);
+static VGMSTREAM * build_scd_vgmstream(STREAMFILE *streamFile, int big_endian, off_t meta_offset, int headers_entries) {
+    VGMSTREAM * vgmstream = NULL;
+    char filename[PATH_LIMIT];
+    off_t start_offset, post_meta_offset, stream_size;
+    int32_t loop_start, loop_end;
+    int loop_flag = 0, channel_count, codec_id;
+    int aux_chunk_count;
+
+    int32_t (*read_32bit)(off_t,STREAMFILE*) = big_endian ? read_32bitBE : read_32bitLE;
+    int16_t (*read_16bit)(off_t,STREAMFILE*) = big_endian ? read_16bitBE : read_16bitLE;
+
+    streamFile->get_name(streamFile,filename,sizeof(filename));
 
     /** stream header **/
     stream_size = read_32bit(meta_offset + 0x0, streamFile);
@@ -410,6 +437,60 @@ fail:
     return NULL;
 }
 
+
+/* ****************************************************************************** */
+/* subsong table, with the offset tables read once (info from each stream built from them) */
+
+typedef struct {
+    int big_endian;
+    off_t * meta_offsets; /* stream headers, one per subsong */
+} scd_bank_data;
+
+static void free_scd_bank_data(void * bank_data) {
+    scd_bank_data * data = bank_data;
+    if (!data) return;
+    free(data->meta_offsets);
+    free(data);
+}
+
+static VGMSTREAM * init_scd_subsong(STREAMFILE *streamFile, vgmstream_subsong_table * table, int subsong) {
+    scd_bank_data * data = table->bank_data;
+    return build_scd_vgmstream(streamFile, data->big_endian, data->meta_offsets[subsong-1], table->subsong_count);
+}
+
+int init_subsong_table_sqex_scd(STREAMFILE * streamFile, vgmstream_subsong_table * table) {
+    scd_bank_data * data = NULL;
+    off_t headers_offset;
+    int headers_entries, big_endian, i;
+    int32_t (*read_32bit)(off_t,STREAMFILE*) = NULL;
+
+    if (!parse_scd_bank(streamFile, &big_endian, &headers_offset, &headers_entries))
+        goto fail;
+    if (headers_entries < 1) goto fail;
+
+    data = calloc(1, sizeof(scd_bank_data));
+    if (!data) goto fail;
+    data->meta_offsets = calloc(headers_entries, sizeof(off_t));
+    if (!data->meta_offsets) goto fail;
+
+    data->big_endian = big_endian;
+    read_32bit = big_endian ? read_32bitBE : read_32bitLE;
+    for (i = 0; i < headers_entries; i++) {
+        data->meta_offsets[i] = read_32bit(headers_offset + i*4,streamFile);
+    }
+
+    table->meta_type = meta_SQEX_SCD;
+    table->subsong_count = headers_entries;
+    table->bank_data = data;
+    table->init_subsong = init_scd_subsong;
+    table->free_bank_data = free_scd_bank_data;
+    return 1;
+
+fail:
+    free_scd_bank_data(data);
+    return 0;
+}
+
 static STREAMFILE *open_scdint_impl(SCDINTSTREAMFILE *streamfile,const char * const filename,size_t buffersize) 
 {
     SCDINTSTREAMFILE *newfile;
@@ -513,7 +594,7 @@ static STREAMFILE *open_scdint_with_STREAMFILE(STREAMFILE *file, const char * fi
     if (start_offset + total_size > file->get_size(file))
         return NULL;
     
-    scd = malloc(sizeof(SCDINTSTREAMFILE));
+    scd = calloc(1,sizeof(SCDINTSTREAMFILE));
     if (!scd)
         return NULL;
 
@@ -1,9 +1,17 @@
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+#include <sys/stat.h>
 #include "meta.h"
 #include "../coding/coding.h"
 #include "../layout/layout.h"
 #include "../util.h"
 
 #define TXT_LINE_MAX 0x2000
+#define TXTH_TEXT_MAX 0x100000  /* sanity max .txth size */
+#define TXTH_CACHE_MAX 8
 
 /* known TXTH types */
 typedef enum {
@@ -66,13 +74,85 @@ typedef struct {
 
 } txth_header;
 
+/* .txth keys, resolved once when the text is parsed */
+typedef enum {
+    KEY_CODEC,
+    KEY_CODEC_MODE,
+    KEY_INTERLEAVE,
+    KEY_ID_VALUE,
+    KEY_ID_OFFSET,
+    KEY_CHANNELS,
+    KEY_SAMPLE_RATE,
+    KEY_START_OFFSET,
+    KEY_DATA_SIZE,
+    KEY_SAMPLE_TYPE,
+    KEY_NUM_SAMPLES,
+    KEY_LOOP_START_SAMPLE,
+    KEY_LOOP_END_SAMPLE,
+    KEY_SKIP_SAMPLES,
+    KEY_LOOP_ADJUST,
+    KEY_LOOP_FLAG,
+    KEY_COEF_OFFSET,
+    KEY_COEF_SPACING,
+    KEY_COEF_ENDIANNESS,
+    KEY_COEF_MODE
+} txth_key;
+
+typedef enum {
+    VALUE_CONSTANT,   /* number or keyword, already parsed */
+    VALUE_OFFSET,     /* "@offset(:endian)($size)", read from each file */
+    VALUE_DATA_SIZE   /* "data_size", depends on previous keys */
+} txth_value_type;
+
+typedef struct {
+    txth_key key;
+    txth_value_type type;
+    uint32_t value;         /* constant, or offset */
+    int size;
+    int big_endian;
+} txth_field;
+
+/* A .txth is usually shared by every file in a folder, so its parsed fields are kept (identified by
+ * real name, size and modification time, or a checksum of the text if it isn't a plain file, so
+ * edits are seen). Fields are applied in order per file, as @offsets and sizes depend on the
+ * target file and some keys on previous ones. */
+typedef struct {
+    char filename[PATH_LIMIT];
+    size_t text_size;
+    int64_t text_mtime;     /* 0 if unknown */
+    uint32_t text_hash;     /* when mtime is unknown */
+    txth_field * fields;
+    int field_count;
+} txth_template;
+
+static txth_template * txth_cache[TXTH_CACHE_MAX];
+static int txth_cache_next = 0;
+
+#ifdef _WIN32
+static CRITICAL_SECTION txth_cache_lock;
+static vgm_once_flag txth_cache_once = VGM_ONCE_INIT;
+static void txth_cache_init(void) { InitializeCriticalSection(&txth_cache_lock); }
+static void txth_cache_lock_enter(void) {
+    vgm_once(&txth_cache_once, txth_cache_init);
+    EnterCriticalSection(&txth_cache_lock);
+}
+static void txth_cache_lock_leave(void) { LeaveCriticalSection(&txth_cache_lock); }
+#else
+static pthread_mutex_t txth_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static void txth_cache_lock_enter(void) { pthread_mutex_lock(&txth_cache_lock); }
+static void txth_cache_lock_leave(void) { pthread_mutex_unlock(&txth_cache_lock); }
+#endif
+
 static STREAMFILE * open_txth(STREAMFILE * streamFile);
 static int parse_txth(STREAMFILE * streamFile, STREAMFILE * streamText, txth_header * txth);
-static int parse_keyval(STREAMFILE * streamFile, STREAMFILE * streamText, txth_header * txth, const char * key, const char * val);
-static int parse_num(STREAMFILE * streamFile, const char * val, uint32_t * out_value);
+static txth_template * get_txth_template(STREAMFILE * streamText);
+static void free_txth_template(txth_template * tpl);
+static int parse_keyval(const char * key, const char * val, txth_field * field);
+static int parse_num(const char * val, txth_field * field);
+static int apply_field(STREAMFILE * streamFile, txth_header * txth, const txth_field * field);
+static int get_field_value(STREAMFILE * streamFile, const txth_field * field, uint32_t * out_value);
 static int get_bytes_to_samples(txth_header * txth, uint32_t bytes);
 
-
 /* TXTH - an artificial "generic" header for headerless streams.
  * Similar to GENH, but with a single separate .txth file in the dir and text-based. */
 VGMSTREAM * init_vgmstream_txth(STREAMFILE *streamFile) {
@@ -401,169 +481,276 @@ fail:
 /* Simple text parser of "key = value" lines.
  * The code is meh and error handling not exactly the best. */
 static int parse_txth(STREAMFILE * streamFile, STREAMFILE * streamText, txth_header * txth) {
-    off_t txt_offset = 0x00;
-    off_t file_size = get_streamfile_size(streamText);
+    txth_template * tpl = NULL;
+    int i;
 
     txth->data_size = get_streamfile_size(streamFile); /* for later use */
 
+    tpl = get_txth_template(streamText);
+    if (!tpl) goto fail;
+
+    /* apply fields in order, as some depend on previous ones */
+    for (i = 0; i < tpl->field_count; i++) {
+        if (!apply_field(streamFile, txth, &tpl->fields[i]))
+            goto fail;
+    }
+
+    if (!txth->loop_flag_set)
+        txth->loop_flag = txth->loop_end_sample && txth->loop_end_sample != 0xFFFFFFFF;
+
+    free_txth_template(tpl);
+    return 1;
+fail:
+    free_txth_template(tpl);
+    return 0;
+}
+
+static void free_txth_template(txth_template * tpl) {
+    if (!tpl) return;
+    free(tpl->fields);
+    free(tpl);
+}
+
+static txth_template * copy_txth_template(const txth_template * src) {
+    txth_template * tpl = malloc(sizeof(txth_template));
+    if (!tpl) return NULL;
+
+    memcpy(tpl, src, sizeof(txth_template));
+    tpl->fields = malloc(src->field_count ? src->field_count * sizeof(txth_field) : 1);
+    if (!tpl->fields) {
+        free(tpl);
+        return NULL;
+    }
+    memcpy(tpl->fields, src->fields, src->field_count * sizeof(txth_field));
+    return tpl;
+}
+
+/* parses the text's lines (separated by CRLF/LF/CR, like get_streamfile_text_line) into fields */
+static int compile_txth_template(txth_template * tpl, STREAMFILE * streamText) {
+    char * text = NULL;
+    size_t text_size = tpl->text_size;
+    size_t txt_offset = 0x00;
+    int fields_max = 0;
+
+    /* one bulk read is much cheaper than reading lines char by char */
+    text = malloc(text_size ? text_size : 1);
+    if (!text) goto fail;
+    if (read_streamfile((uint8_t*)text, 0x00, text_size, streamText) != text_size) goto fail;
+
     /* skip BOM if needed */
-    if (read_16bitLE(0x00, streamText) == 0xFFFE || read_16bitLE(0x00, streamText) == 0xFEFF)
+    if (text_size >= 2 && (((uint8_t)text[0] == 0xFF && (uint8_t)text[1] == 0xFE) || ((uint8_t)text[0] == 0xFE && (uint8_t)text[1] == 0xFF)))
         txt_offset = 0x02;
 
     /* read lines */
-    while (txt_offset < file_size) {
+    while (txt_offset < text_size) {
         char line[TXT_LINE_MAX] = {0};
         char key[TXT_LINE_MAX] = {0}, val[TXT_LINE_MAX] = {0}; /* at least as big as a line to avoid overflows (I hope) */
-        int ok, bytes_read, line_done;
+        size_t line_size = 0;
+        int ok;
+
+        while (txt_offset + line_size < text_size && text[txt_offset + line_size] != 0x0d && text[txt_offset + line_size] != 0x0a)
+            line_size++;
+        if (line_size >= TXT_LINE_MAX - 1) goto fail;
 
-        bytes_read = get_streamfile_text_line(TXT_LINE_MAX,line, txt_offset,streamText, &line_done);
-        if (!line_done) goto fail;
+        memcpy(line, text + txt_offset, line_size);
+        txt_offset += line_size;
+        if (txt_offset < text_size && text[txt_offset] == 0x0d && txt_offset + 1 < text_size && text[txt_offset + 1] == 0x0a) /* CRLF */
+            txt_offset += 2;
+        else if (txt_offset < text_size) /* CR or LF */
+            txt_offset += 1;
 
-        txt_offset += bytes_read;
-        
         /* get key/val (ignores lead/trail spaces, stops at space/comment/separator) */
         ok = sscanf(line, " %[^ \t#=] = %[^ \t#\r\n] ", key,val);
         if (ok != 2) /* ignore line if no key=val (comment or garbage) */
             continue;
 
-        if (!parse_keyval(streamFile, streamText, txth, key, val)) /* read key/val */
+        if (tpl->field_count == fields_max) {
+            txth_field * fields;
+            fields_max = fields_max ? fields_max * 2 : 32;
+            fields = realloc(tpl->fields, fields_max * sizeof(txth_field));
+            if (!fields) goto fail;
+            tpl->fields = fields;
+        }
+
+        if (!parse_keyval(key, val, &tpl->fields[tpl->field_count])) /* read key/val */
             goto fail;
+        tpl->field_count++;
     }
 
-    if (!txth->loop_flag_set)
-        txth->loop_flag = txth->loop_end_sample && txth->loop_end_sample != 0xFFFFFFFF;
-
+    free(text);
     return 1;
 fail:
+    free(text);
     return 0;
 }
 
-static int parse_keyval(STREAMFILE * streamFile, STREAMFILE * streamText, txth_header * txth, const char * key, const char * val) {
+/* checksum of the text, to identify it when it isn't a plain file */
+static int get_txth_text_hash(STREAMFILE * streamText, size_t text_size, uint32_t * out_hash) {
+    uint8_t buf[0x1000];
+    uint32_t hash = 2166136261u; /* FNV-1a */
+    off_t offset = 0;
 
-    if (0==strcmp(key,"codec")) {
-        if      (0==strcmp(val,"PSX")) txth->codec = PSX;
-        else if (0==strcmp(val,"XBOX")) txth->codec = XBOX;
-        else if (0==strcmp(val,"NGC_DTK")) txth->codec = NGC_DTK;
-        else if (0==strcmp(val,"PCM16BE")) txth->codec = PCM16BE;
-        else if (0==strcmp(val,"PCM16LE")) txth->codec = PCM16LE;
-        else if (0==strcmp(val,"PCM8")) txth->codec = PCM8;
-        else if (0==strcmp(val,"SDX2")) txth->codec = SDX2;
-        else if (0==strcmp(val,"DVI_IMA")) txth->codec = DVI_IMA;
-        else if (0==strcmp(val,"MPEG")) txth->codec = MPEG;
-        else if (0==strcmp(val,"IMA")) txth->codec = IMA;
-        else if (0==strcmp(val,"AICA")) txth->codec = AICA;
-        else if (0==strcmp(val,"MSADPCM")) txth->codec = MSADPCM;
-        else if (0==strcmp(val,"NGC_DSP")) txth->codec = NGC_DSP;
-        else if (0==strcmp(val,"PCM8_U_int")) txth->codec = PCM8_U_int;
-        else if (0==strcmp(val,"PSX_bf")) txth->codec = PSX_bf;
-        else if (0==strcmp(val,"MS_IMA")) txth->codec = MS_IMA;
-        else if (0==strcmp(val,"PCM8_U")) txth->codec = PCM8_U;
-        else if (0==strcmp(val,"APPLE_IMA4")) txth->codec = APPLE_IMA4;
-        else if (0==strcmp(val,"ATRAC3")) txth->codec = ATRAC3;
-        else if (0==strcmp(val,"ATRAC3PLUS")) txth->codec = ATRAC3PLUS;
-        else if (0==strcmp(val,"XMA1")) txth->codec = XMA1;
-        else if (0==strcmp(val,"XMA2")) txth->codec = XMA2;
-        else if (0==strcmp(val,"FFMPEG")) txth->codec = FFMPEG;
-        else if (0==strcmp(val,"AC3")) txth->codec = AC3;
-        else goto fail;
-    }
-    else if (0==strcmp(key,"codec_mode")) {
-        if (!parse_num(streamFile,val, &txth->codec_mode)) goto fail;
-    }
-    else if (0==strcmp(key,"interleave")) {
-        if (!parse_num(streamFile,val, &txth->interleave)) goto fail;
-    }
-    else if (0==strcmp(key,"id_value")) {
-        if (!parse_num(streamFile,val, &txth->id_value)) goto fail;
-    }
-    else if (0==strcmp(key,"id_offset")) {
-        if (!parse_num(streamFile,val, &txth->id_offset)) goto fail;
-        if (txth->id_value != txth->id_offset) /* evaluate current ID */
-            goto fail;
-    }
-    else if (0==strcmp(key,"channels")) {
-        if (!parse_num(streamFile,val, &txth->channels)) goto fail;
-    }
-    else if (0==strcmp(key,"sample_rate")) {
-        if (!parse_num(streamFile,val, &txth->sample_rate)) goto fail;
-    }
-    else if (0==strcmp(key,"start_offset")) {
-        if (!parse_num(streamFile,val, &txth->start_offset)) goto fail;
-        if (!txth->data_size_set)
-            txth->data_size = get_streamfile_size(streamFile) - txth->start_offset; /* re-evaluate */
-    }
-    else if (0==strcmp(key,"data_size")) {
-        if (!parse_num(streamFile,val, &txth->data_size)) goto fail;
-        txth->data_size_set = 1;
-    }
-    else if (0==strcmp(key,"sample_type")) {
-        if (0==strcmp(val,"bytes")) txth->sample_type_bytes = 1;
-        else if (0==strcmp(val,"samples")) txth->sample_type_bytes = 0;
-        else goto fail;
+    while (offset < text_size) {
+        size_t i, to_read = text_size - offset > sizeof(buf) ? sizeof(buf) : text_size - offset;
+        if (read_streamfile(buf, offset, to_read, streamText) != to_read)
+            return 0;
+        for (i = 0; i < to_read; i++) {
+            hash = (hash ^ buf[i]) * 16777619u;
+        }
+        offset += to_read;
     }
-    else if (0==strcmp(key,"num_samples")) {
-        if (0==strcmp(val,"data_size")) {
-            txth->num_samples = get_bytes_to_samples(txth, txth->data_size);
+
+    *out_hash = hash;
+    return 1;
+}
+
+/* returns a (caller owned) parsed .txth, from the cache if already seen */
+static txth_template * get_txth_template(STREAMFILE * streamText) {
+    txth_template * tpl = NULL;
+    txth_template * cached = NULL;
+    size_t text_size = get_streamfile_size(streamText);
+    int64_t text_mtime = 0;
+    uint32_t text_hash = 0;
+    char filename[PATH_LIMIT];
+    int i;
+
+    if (text_size > TXTH_TEXT_MAX) goto fail;
+    streamText->get_realname(streamText, filename, sizeof(filename));
+
+    /* identify the current version of the text */
+    {
+        struct stat st;
+        if (stat(filename, &st) == 0 && (size_t)st.st_size == text_size) {
+            text_mtime = (int64_t)st.st_mtime;
         }
         else {
-            if (!parse_num(streamFile,val, &txth->num_samples)) goto fail;
-            if (txth->sample_type_bytes)
-                txth->num_samples = get_bytes_to_samples(txth, txth->num_samples);
+            if (!get_txth_text_hash(streamText, text_size, &text_hash))
+                goto fail;
         }
     }
-    else if (0==strcmp(key,"loop_start_sample")) {
-        if (!parse_num(streamFile,val, &txth->loop_start_sample)) goto fail;
-        if (txth->sample_type_bytes)
-            txth->loop_start_sample = get_bytes_to_samples(txth, txth->loop_start_sample);
-        if (txth->loop_adjust)
-            txth->loop_start_sample += txth->loop_adjust;
+
+    txth_cache_lock_enter();
+    for (i = 0; i < TXTH_CACHE_MAX; i++) {
+        txth_template * entry = txth_cache[i];
+        if (entry && entry->text_size == text_size && entry->text_mtime == text_mtime && entry->text_hash == text_hash
+                && strcmp(entry->filename, filename) == 0) {
+            tpl = copy_txth_template(entry);
+            break;
+        }
     }
-    else if (0==strcmp(key,"loop_end_sample")) {
-        if (0==strcmp(val,"data_size")) {
-            txth->loop_end_sample = get_bytes_to_samples(txth, txth->data_size);
+    txth_cache_lock_leave();
+
+    if (tpl)
+        return tpl;
+
+
+    /* new or changed .txth */
+    tpl = calloc(1, sizeof(txth_template));
+    if (!tpl) goto fail;
+
+    strcpy(tpl->filename, filename);
+    tpl->text_size = text_size;
+    tpl->text_mtime = text_mtime;
+    tpl->text_hash = text_hash;
+    if (!compile_txth_template(tpl, streamText)) goto fail;
+
+    cached = copy_txth_template(tpl);
+    if (cached) {
+        txth_cache_lock_enter();
+        for (i = 0; i < TXTH_CACHE_MAX; i++) { /* replace old version */
+            if (txth_cache[i] && strcmp(txth_cache[i]->filename, filename) == 0)
+                break;
         }
-        else {
-            if (!parse_num(streamFile,val, &txth->loop_end_sample)) goto fail;
-            if (txth->sample_type_bytes)
-                txth->loop_end_sample = get_bytes_to_samples(txth, txth->loop_end_sample);
+        if (i == TXTH_CACHE_MAX) {
+            i = txth_cache_next;
+            txth_cache_next = (txth_cache_next + 1) % TXTH_CACHE_MAX;
         }
-        if (txth->loop_adjust)
-            txth->loop_end_sample += txth->loop_adjust;
-    }
-    else if (0==strcmp(key,"skip_samples")) {
-        if (!parse_num(streamFile,val, &txth->skip_samples)) goto fail;
-        txth->skip_samples_set = 1;
-        if (txth->sample_type_bytes)
-            txth->skip_samples = get_bytes_to_samples(txth, txth->skip_samples);
+        free_txth_template(txth_cache[i]);
+        txth_cache[i] = cached;
+        txth_cache_lock_leave();
     }
-    else if (0==strcmp(key,"loop_adjust")) {
-        if (!parse_num(streamFile,val, &txth->loop_adjust)) goto fail;
-        if (txth->sample_type_bytes)
-            txth->loop_adjust = get_bytes_to_samples(txth, txth->loop_adjust);
-    }
-    else if (0==strcmp(key,"loop_flag")) {
-        if (!parse_num(streamFile,val, &txth->loop_flag)) goto fail;
-        txth->loop_flag_set = 1;
-    }
-    else if (0==strcmp(key,"coef_offset")) {
-        if (!parse_num(streamFile,val, &txth->coef_offset)) goto fail;
+
+    return tpl;
+fail:
+    free_txth_template(tpl);
+    return NULL;
+}
+
+/* parses a key/val into a field; values that depend on the file are resolved later */
+static int parse_keyval(const char * key, const char * val, txth_field * field) {
+    memset(field, 0, sizeof(txth_field));
+    field->type = VALUE_CONSTANT;
+
+    if (0==strcmp(key,"codec")) {
+        field->key = KEY_CODEC;
+        if      (0==strcmp(val,"PSX")) field->value = PSX;
+        else if (0==strcmp(val,"XBOX")) field->value = XBOX;
+        else if (0==strcmp(val,"NGC_DTK")) field->value = NGC_DTK;
+        else if (0==strcmp(val,"PCM16BE")) field->value = PCM16BE;
+        else if (0==strcmp(val,"PCM16LE")) field->value = PCM16LE;
+        else if (0==strcmp(val,"PCM8")) field->value = PCM8;
+        else if (0==strcmp(val,"SDX2")) field->value = SDX2;
+        else if (0==strcmp(val,"DVI_IMA")) field->value = DVI_IMA;
+        else if (0==strcmp(val,"MPEG")) field->value = MPEG;
+        else if (0==strcmp(val,"IMA")) field->value = IMA;
+        else if (0==strcmp(val,"AICA")) field->value = AICA;
+        else if (0==strcmp(val,"MSADPCM")) field->value = MSADPCM;
+        else if (0==strcmp(val,"NGC_DSP")) field->value = NGC_DSP;
+        else if (0==strcmp(val,"PCM8_U_int")) field->value = PCM8_U_int;
+        else if (0==strcmp(val,"PSX_bf")) field->value = PSX_bf;
+        else if (0==strcmp(val,"MS_IMA")) field->value = MS_IMA;
+        else if (0==strcmp(val,"PCM8_U")) field->value = PCM8_U;
+        else if (0==strcmp(val,"APPLE_IMA4")) field->value = APPLE_IMA4;
+        else if (0==strcmp(val,"ATRAC3")) field->value = ATRAC3;
+        else if (0==strcmp(val,"ATRAC3PLUS")) field->value = ATRAC3PLUS;
+        else if (0==strcmp(val,"XMA1")) field->value = XMA1;
+        else if (0==strcmp(val,"XMA2")) field->value = XMA2;
+        else if (0==strcmp(val,"FFMPEG")) field->value = FFMPEG;
+        else if (0==strcmp(val,"AC3")) field->value = AC3;
+        else goto fail;
     }
-    else if (0==strcmp(key,"coef_spacing")) {
-        if (!parse_num(streamFile,val, &txth->coef_spacing)) goto fail;
+    else if (0==strcmp(key,"sample_type")) {
+        field->key = KEY_SAMPLE_TYPE;
+        if (0==strcmp(val,"bytes")) field->value = 1;
+        else if (0==strcmp(val,"samples")) field->value = 0;
+        else goto fail;
     }
     else if (0==strcmp(key,"coef_endianness")) {
+        field->key = KEY_COEF_ENDIANNESS;
         if (val[0]=='B' && val[1]=='E')
-            txth->coef_big_endian = 1;
+            field->value = 1;
         else if (val[0]=='L' && val[1]=='E')
-            txth->coef_big_endian = 0;
-        else if (!parse_num(streamFile,val, &txth->coef_big_endian)) goto fail;
+            field->value = 0;
+        else if (!parse_num(val, field)) goto fail;
     }
-    else if (0==strcmp(key,"coef_mode")) {
-        if (!parse_num(streamFile,val, &txth->coef_mode)) goto fail;
+    else if ((0==strcmp(key,"num_samples") || 0==strcmp(key,"loop_end_sample")) && 0==strcmp(val,"data_size")) {
+        field->key = (0==strcmp(key,"num_samples")) ? KEY_NUM_SAMPLES : KEY_LOOP_END_SAMPLE;
+        field->type = VALUE_DATA_SIZE;
     }
     else {
-        VGM_LOG("TXTH: unknown key=%s, val=%s\n", key,val);
-        goto fail;
+        if      (0==strcmp(key,"codec_mode")) field->key = KEY_CODEC_MODE;
+        else if (0==strcmp(key,"interleave")) field->key = KEY_INTERLEAVE;
+        else if (0==strcmp(key,"id_value")) field->key = KEY_ID_VALUE;
+        else if (0==strcmp(key,"id_offset")) field->key = KEY_ID_OFFSET;
+        else if (0==strcmp(key,"channels")) field->key = KEY_CHANNELS;
+        else if (0==strcmp(key,"sample_rate")) field->key = KEY_SAMPLE_RATE;
+        else if (0==strcmp(key,"start_offset")) field->key = KEY_START_OFFSET;
+        else if (0==strcmp(key,"data_size")) field->key = KEY_DATA_SIZE;
+        else if (0==strcmp(key,"num_samples")) field->key = KEY_NUM_SAMPLES;
+        else if (0==strcmp(key,"loop_start_sample")) field->key = KEY_LOOP_START_SAMPLE;
+        else if (0==strcmp(key,"loop_end_sample")) field->key = KEY_LOOP_END_SAMPLE;
+        else if (0==strcmp(key,"skip_samples")) field->key = KEY_SKIP_SAMPLES;
+        else if (0==strcmp(key,"loop_adjust")) field->key = KEY_LOOP_ADJUST;
+        else if (0==strcmp(key,"loop_flag")) field->key = KEY_LOOP_FLAG;
+        else if (0==strcmp(key,"coef_offset")) field->key = KEY_COEF_OFFSET;
+        else if (0==strcmp(key,"coef_spacing")) field->key = KEY_COEF_SPACING;
+        else if (0==strcmp(key,"coef_mode")) field->key = KEY_COEF_MODE;
+        else {
+            VGM_LOG("TXTH: unknown key=%s, val=%s\n", key,val);
+            goto fail;
+        }
+
+        if (!parse_num(val, field)) goto fail;
     }
 
     return 1;
@@ -571,13 +758,12 @@ fail:
     return 0;
 }
 
-static int parse_num(STREAMFILE * streamFile, const char * val, uint32_t * out_value) {
+static int parse_num(const char * val, txth_field * field) {
 
     if (val[0] == '@') { /* offset */
         uint32_t off = 0;
         char ed1 = 'L', ed2 = 'E';
         int size = 4;
-        int big_endian = 0;
         int hex = (val[1]=='0' && val[2]=='x');
 
         /* read exactly N fields in the expected format */
@@ -591,29 +777,153 @@ static int parse_num(STREAMFILE * streamFile, const char * val, uint32_t * out_v
             if (sscanf(val, hex ? "@%x" : "@%u", &off) != 1) goto fail;
         }
 
-        if (off < 0 || off > get_streamfile_size(streamFile))
-            goto fail;
-
         if (ed1 == 'B' && ed2 == 'E')
-            big_endian = 1;
+            field->big_endian = 1;
         else if (!(ed1 == 'L' && ed2 == 'E'))
             goto fail;
 
-        switch(size) {
-            case 1: *out_value = read_8bit(off,streamFile); break;
-            case 2: *out_value = big_endian ? (uint16_t)read_16bitBE(off,streamFile) : (uint16_t)read_16bitLE(off,streamFile); break;
-            case 3: *out_value = (big_endian ? (uint32_t)read_32bitBE(off,streamFile) : (uint32_t)read_32bitLE(off,streamFile)) & 0x00FFFFFF; break;
-            case 4: *out_value = big_endian ? (uint32_t)read_32bitBE(off,streamFile) : (uint32_t)read_32bitLE(off,streamFile); break;
-            default: goto fail;
-        }
+        if (size < 1 || size > 4)
+            goto fail;
+
+        field->type = VALUE_OFFSET;
+        field->value = off;
+        field->size = size;
     }
     else { /* constant */
         int hex = (val[0]=='0' && val[1]=='x');
 
-        if (sscanf(val, hex ? "%x" : "%u", out_value)!=1) goto fail;
+        if (sscanf(val, hex ? "%x" : "%u", &field->value)!=1) goto fail;
+    }
+
+    return 1;
+fail:
+    return 0;
+}
+
+/* applies a parsed field to the header, reading @offsets from the file */
+static int apply_field(STREAMFILE * streamFile, txth_header * txth, const txth_field * field) {
+
+    switch(field->key) {
+        case KEY_CODEC:
+            txth->codec = field->value;
+            break;
+        case KEY_CODEC_MODE:
+            if (!get_field_value(streamFile, field, &txth->codec_mode)) goto fail;
+            break;
+        case KEY_INTERLEAVE:
+            if (!get_field_value(streamFile, field, &txth->interleave)) goto fail;
+            break;
+        case KEY_ID_VALUE:
+            if (!get_field_value(streamFile, field, &txth->id_value)) goto fail;
+            break;
+        case KEY_ID_OFFSET:
+            if (!get_field_value(streamFile, field, &txth->id_offset)) goto fail;
+            if (txth->id_value != txth->id_offset) /* evaluate current ID */
+                goto fail;
+            break;
+        case KEY_CHANNELS:
+            if (!get_field_value(streamFile, field, &txth->channels)) goto fail;
+            break;
+        case KEY_SAMPLE_RATE:
+            if (!get_field_value(streamFile, field, &txth->sample_rate)) goto fail;
+            break;
+        case KEY_START_OFFSET:
+            if (!get_field_value(streamFile, field, &txth->start_offset)) goto fail;
+            if (!txth->data_size_set)
+                txth->data_size = get_streamfile_size(streamFile) - txth->start_offset; /* re-evaluate */
+            break;
+        case KEY_DATA_SIZE:
+            if (!get_field_value(streamFile, field, &txth->data_size)) goto fail;
+            txth->data_size_set = 1;
+            break;
+        case KEY_SAMPLE_TYPE:
+            txth->sample_type_bytes = field->value;
+            break;
+        case KEY_NUM_SAMPLES:
+            if (field->type == VALUE_DATA_SIZE) {
+                txth->num_samples = get_bytes_to_samples(txth, txth->data_size);
+            }
+            else {
+                if (!get_field_value(streamFile, field, &txth->num_samples)) goto fail;
+                if (txth->sample_type_bytes)
+                    txth->num_samples = get_bytes_to_samples(txth, txth->num_samples);
+            }
+            break;
+        case KEY_LOOP_START_SAMPLE:
+            if (!get_field_value(streamFile, field, &txth->loop_start_sample)) goto fail;
+            if (txth->sample_type_bytes)
+                txth->loop_start_sample = get_bytes_to_samples(txth, txth->loop_start_sample);
+            if (txth->loop_adjust)
+                txth->loop_start_sample += txth->loop_adjust;
+            break;
+        case KEY_LOOP_END_SAMPLE:
+            if (field->type == VALUE_DATA_SIZE) {
+                txth->loop_end_sample = get_bytes_to_samples(txth, txth->data_size);
+            }
+            else {
+                if (!get_field_value(streamFile, field, &txth->loop_end_sample)) goto fail;
+                if (txth->sample_type_bytes)
+                    txth->loop_end_sample = get_bytes_to_samples(txth, txth->loop_end_sample);
+            }
+            if (txth->loop_adjust)
+                txth->loop_end_sample += txth->loop_adjust;
+            break;
+        case KEY_SKIP_SAMPLES:
+            if (!get_field_value(streamFile, field, &txth->skip_samples)) goto fail;
+            txth->skip_samples_set = 1;
+            if (txth->sample_type_bytes)
+                txth->skip_samples = get_bytes_to_samples(txth, txth->skip_samples);
+            break;
+        case KEY_LOOP_ADJUST:
+            if (!get_field_value(streamFile, field, &txth->loop_adjust)) goto fail;
+            if (txth->sample_type_bytes)
+                txth->loop_adjust = get_bytes_to_samples(txth, txth->loop_adjust);
+            break;
+        case KEY_LOOP_FLAG:
+            if (!get_field_value(streamFile, field, &txth->loop_flag)) goto fail;
+            txth->loop_flag_set = 1;
+            break;
+        case KEY_COEF_OFFSET:
+            if (!get_field_value(streamFile, field, &txth->coef_offset)) goto fail;
+            break;
+        case KEY_COEF_SPACING:
+            if (!get_field_value(streamFile, field, &txth->coef_spacing)) goto fail;
+            break;
+        case KEY_COEF_ENDIANNESS:
+            if (!get_field_value(streamFile, field, &txth->coef_big_endian)) goto fail;
+            break;
+        case KEY_COEF_MODE:
+            if (!get_field_value(streamFile, field, &txth->coef_mode)) goto fail;
+            break;
+        default:
+            goto fail;
+    }
+
+    return 1;
+fail:
+    return 0;
+}
+
+static int get_field_value(STREAMFILE * streamFile, const txth_field * field, uint32_t * out_value) {
+    uint32_t off = field->value;
+
+    if (field->type != VALUE_OFFSET) { /* constant */
+        *out_value = field->value;
+        return 1;
+    }
+
+    if (off > get_streamfile_size(streamFile))
+        goto fail;
+
+    switch(field->size) {
+        case 1: *out_value = read_8bit(off,streamFile); break;
+        case 2: *out_value = field->big_endian ? (uint16_t)read_16bitBE(off,streamFile) : (uint16_t)read_16bitLE(off,streamFile); break;
+        case 3: *out_value = (field->big_endian ? (uint32_t)read_32bitBE(off,streamFile) : (uint32_t)read_32bitLE(off,streamFile)) & 0x00FFFFFF; break;
+        case 4: *out_value = field->big_endian ? (uint32_t)read_32bitBE(off,streamFile) : (uint32_t)read_32bitLE(off,streamFile); break;
+        default: goto fail;
     }
 
-    //VGM_LOG("TXTH: value=%s, read %u\n", val, *out_value);
+    //VGM_LOG("TXTH: offset=%x, read %u\n", off, *out_value);
     return 1;
 fail:
     return 0;
@@ -61,15 +61,15 @@ typedef struct {
 } ubi_sb_header;
 
 static int parse_sb_header(ubi_sb_header * sb, STREAMFILE *streamFile);
+static int parse_sb_bank(ubi_sb_header * sb, STREAMFILE *streamFile);
+static void parse_sb_entries(ubi_sb_header * sb, STREAMFILE *streamFile, int target_stream, ubi_sb_header * streams);
+static int parse_sb_stream(ubi_sb_header * sb, STREAMFILE *streamFile);
 static int config_sb_header_version(ubi_sb_header * sb, STREAMFILE *streamFile);
+static VGMSTREAM * build_sb_vgmstream(ubi_sb_header * sb_in, STREAMFILE *streamFile);
 
 
 /* .SBx - banks from Ubisoft's sound engine ("DARE" / "UbiSound Driver") games in ~2000-2008 */
 VGMSTREAM * init_vgmstream_ubi_sb(STREAMFILE *streamFile) {
-    VGMSTREAM * vgmstream = NULL;
-    STREAMFILE *streamData = NULL;
-    off_t start_offset;
-    int loop_flag = 0;
     ubi_sb_header sb = {0};
 
     /* check extension (number represents the platform, see later) */
@@ -85,6 +85,20 @@ VGMSTREAM * init_vgmstream_ubi_sb(STREAMFILE *streamFile) {
     if ( !parse_sb_header(&sb, streamFile) )
         goto fail;
 
+    return build_sb_vgmstream(&sb, streamFile);
+
+fail:
+    return NULL;
+}
+
+static VGMSTREAM * build_sb_vgmstream(ubi_sb_header * sb_in, STREAMFILE *streamFile) {
+    VGMSTREAM * vgmstream = NULL;
+    STREAMFILE *streamData = NULL;
+    off_t start_offset;
+    int loop_flag = 0;
+    ubi_sb_header sb;
+
+    memcpy(&sb, sb_in, sizeof(ubi_sb_header)); /* modified below */
 
     /* open external stream if needed */
     if (sb.autodetect_external) { /* works most of the time but could give false positives */
@@ -262,21 +276,39 @@ fail:
 
 
 static int parse_sb_header(ubi_sb_header * sb, STREAMFILE *streamFile) {
-    int32_t (*read_32bit)(off_t,STREAMFILE*) = NULL;
-    int16_t (*read_16bit)(off_t,STREAMFILE*) = NULL;
-    int i, ok, current_type = -1, current_id = -1;
     int target_stream = streamFile->stream_index;
 
     if (target_stream == 0) target_stream = 1;
 
-    sb->big_endian = check_extensions(streamFile, "sb3,sb6,sb7"); /* GC, PS3, Wii */
-    if (sb->big_endian) {
-        read_32bit = read_32bitBE;
-        read_16bit = read_16bitBE;
-    } else {
-        read_32bit = read_32bitLE;
-        read_16bit = read_16bitLE;
+    if (!parse_sb_bank(sb, streamFile))
+        goto fail;
+
+    /* find target stream info in section2 */
+    parse_sb_entries(sb, streamFile, target_stream, NULL);
+    if (sb->total_streams == 0) {
+        VGM_LOG("UBI SB: no streams\n");
+        goto fail;
     }
+    if (target_stream < 0 || target_stream > sb->total_streams || sb->total_streams < 1) {
+        VGM_LOG("UBI SB: wrong target stream (target=%i, total=%i)\n", target_stream, sb->total_streams);
+        goto fail;
+    }
+
+    if (!parse_sb_stream(sb, streamFile))
+        goto fail;
+
+    return 1;
+fail:
+    return 0;
+}
+
+/* fixed part and per-version config */
+static int parse_sb_bank(ubi_sb_header * sb, STREAMFILE *streamFile) {
+    int32_t (*read_32bit)(off_t,STREAMFILE*) = NULL;
+    int ok;
+
+    sb->big_endian = check_extensions(streamFile, "sb3,sb6,sb7"); /* GC, PS3, Wii */
+    read_32bit = sb->big_endian ? read_32bitBE : read_32bitLE;
 
     /* file layout is: base header, section1, section2, extra section, section3, data (all except base header can be null) */
 
@@ -299,7 +331,32 @@ static int parse_sb_header(ubi_sb_header * sb, STREAMFILE *streamFile) {
     sb->section2_size = sb->section2_entry_size * sb->section2_num;
     sb->section3_size = sb->section3_entry_size * sb->section3_num;
 
-    /* find target stream info in section2 */
+    if (!(sb->stream_id_offset || sb->has_rotating_ids) && sb->section3_num > 1) {
+        VGM_LOG("UBI SB: unexpected number of internal streams %i\n", sb->section3_num);
+        goto fail;
+    }
+
+    return 1;
+fail:
+    return 0;
+}
+
+/* walks section2 counting audio entries (total_streams), reading the target's info into sb,
+ * or every entry's into streams (bank values first) if set */
+static void parse_sb_entries(ubi_sb_header * sb, STREAMFILE *streamFile, int target_stream, ubi_sb_header * streams) {
+    int32_t (*read_32bit)(off_t,STREAMFILE*) = NULL;
+    int16_t (*read_16bit)(off_t,STREAMFILE*) = NULL;
+    ubi_sb_header * st;
+    int i, current_type = -1, current_id = -1;
+
+    if (sb->big_endian) {
+        read_32bit = read_32bitBE;
+        read_16bit = read_16bitBE;
+    } else {
+        read_32bit = read_32bitLE;
+        read_16bit = read_16bitLE;
+    }
+
     for (i = 0; i < sb->section2_num; i++) {
         off_t offset = sb->main_size + sb->section1_size + sb->section2_entry_size*i;
 
@@ -337,68 +394,68 @@ static int parse_sb_header(ubi_sb_header * sb, STREAMFILE *streamFile) {
 
         /* update streams (total_stream also doubles as current) */
         sb->total_streams++;
-        if (sb->total_streams != target_stream)
+        if (streams) {
+            st = &streams[sb->total_streams-1];
+            memcpy(st, sb, sizeof(ubi_sb_header));
+        }
+        else if (sb->total_streams != target_stream) {
             continue;
-        //;VGM_LOG("target at offset=%lx (size=%x)\n", offset, sb->section2_entry_size);
-
-        sb->header_id      = read_32bit(offset + 0x00, streamFile); /* 16b+16b group+sound id */
-        sb->header_type    = read_32bit(offset + 0x04, streamFile);
-        sb->stream_size    = read_32bit(offset + 0x08, streamFile);
-        sb->extra_offset   = read_32bit(offset + 0x0c, streamFile); /* within the extra section */
-        sb->stream_offset  = read_32bit(offset + 0x10, streamFile); /* within the data section */
-        sb->channels       = (sb->has_short_channels) ?
-                   (uint16_t)read_16bit(offset + sb->channels_offset, streamFile) :
-                   (uint32_t)read_32bit(offset + sb->channels_offset, streamFile);
-        sb->sample_rate    = read_32bit(offset + sb->sample_rate_offset, streamFile);
-        sb->stream_type    = read_32bit(offset + sb->stream_type_offset, streamFile);
-
-        if (sb->num_samples_offset)
-            sb->stream_samples = read_32bit(offset + sb->num_samples_offset, streamFile);
-
-        if (sb-> has_rotating_ids) {
-            sb->stream_id  = current_id;
-        } else if (sb->stream_id_offset) {
-            sb->stream_id  = read_32bit(offset + sb->stream_id_offset, streamFile);
+        }
+        else {
+            st = sb;
+        }
+        //;VGM_LOG("target at offset=%lx (size=%x)\n", offset, st->section2_entry_size);
+
+        st->header_id      = read_32bit(offset + 0x00, streamFile); /* 16b+16b group+sound id */
+        st->header_type    = read_32bit(offset + 0x04, streamFile);
+        st->stream_size    = read_32bit(offset + 0x08, streamFile);
+        st->extra_offset   = read_32bit(offset + 0x0c, streamFile); /* within the extra section */
+        st->stream_offset  = read_32bit(offset + 0x10, streamFile); /* within the data section */
+        st->channels       = (st->has_short_channels) ?
+                   (uint16_t)read_16bit(offset + st->channels_offset, streamFile) :
+                   (uint32_t)read_32bit(offset + st->channels_offset, streamFile);
+        st->sample_rate    = read_32bit(offset + st->sample_rate_offset, streamFile);
+        st->stream_type    = read_32bit(offset + st->stream_type_offset, streamFile);
+
+        if (st->num_samples_offset)
+            st->stream_samples = read_32bit(offset + st->num_samples_offset, streamFile);
+
+        if (st->has_rotating_ids) {
+            st->stream_id  = current_id;
+        } else if (st->stream_id_offset) {
+            st->stream_id  = read_32bit(offset + st->stream_id_offset, streamFile);
         }
 
         /* external stream name can be found in the header (first versions) or the extra table (later versions) */
-        if (sb->stream_name_offset) {
-            read_string(sb->stream_name, sb->stream_name_size, offset + sb->stream_name_offset, streamFile);
+        if (st->stream_name_offset) {
+            read_string(st->stream_name, st->stream_name_size, offset + st->stream_name_offset, streamFile);
         } else {
-            sb->stream_name_offset = read_32bit(offset + sb->extra_name_offset, streamFile);
-            read_string(sb->stream_name, sb->stream_name_size, sb->main_size + sb->section1_size + sb->section2_size + sb->stream_name_offset, streamFile);
+            st->stream_name_offset = read_32bit(offset + st->extra_name_offset, streamFile);
+            read_string(st->stream_name, st->stream_name_size, st->main_size + st->section1_size + st->section2_size + st->stream_name_offset, streamFile);
         }
 
         /* not always set and must be derived */
-        if (sb->external_flag_offset) {
-            sb->is_external = read_32bit(offset + sb->external_flag_offset, streamFile);
-        } else if (sb->has_extra_name_flag && read_32bit(offset + sb->extra_name_offset, streamFile) != 0xFFFFFFFF) {
-            sb->is_external = 1; /* -1 in extra_name means internal */
-        } else if (sb->section3_num == 0) {
-            sb->is_external = 1;
+        if (st->external_flag_offset) {
+            st->is_external = read_32bit(offset + st->external_flag_offset, streamFile);
+        } else if (st->has_extra_name_flag && read_32bit(offset + st->extra_name_offset, streamFile) != 0xFFFFFFFF) {
+            st->is_external = 1; /* -1 in extra_name means internal */
+        } else if (st->section3_num == 0) {
+            st->is_external = 1;
         } else {
-            sb->autodetect_external = 1;
+            st->autodetect_external = 1;
 
-            if (sb->stream_name[0] == '\0')
-                sb->autodetect_external = 0; /* no name */
-            if (sb->extra_size > 0 && sb->stream_name_offset > sb->extra_size)
-                sb->autodetect_external = 0; /* name outside extra table == is internal */
+            if (st->stream_name[0] == '\0')
+                st->autodetect_external = 0; /* no name */
+            if (st->extra_size > 0 && st->stream_name_offset > st->extra_size)
+                st->autodetect_external = 0; /* name outside extra table == is internal */
         }
     }
-    if (sb->total_streams == 0) {
-        VGM_LOG("UBI SB: no streams\n");
-        goto fail;
-    }
-    if (target_stream < 0 || target_stream > sb->total_streams || sb->total_streams < 1) {
-        VGM_LOG("UBI SB: wrong target stream (target=%i, total=%i)\n", target_stream, sb->total_streams);
-        goto fail;
-    }
-
-    if (!(sb->stream_id_offset || sb->has_rotating_ids) && sb->section3_num > 1) {
-        VGM_LOG("UBI SB: unexpected number of internal streams %i\n", sb->section3_num);
-        goto fail;
-    }
+}
 
+/* codec and final offset of a stream read from section2 */
+static int parse_sb_stream(ubi_sb_header * sb, STREAMFILE *streamFile) {
+    int32_t (*read_32bit)(off_t,STREAMFILE*) = sb->big_endian ? read_32bitBE : read_32bitLE;
+    int i;
 
     /* happens in some versions */
     if (sb->stream_type > 0xFF) {
@@ -810,3 +867,65 @@ static int config_sb_header_version(ubi_sb_header * sb, STREAMFILE *streamFile)
 
     return 0;
 }
+
+
+/* ****************************************************************************** */
+/* subsong table, with section2 walked once (info from each stream built from it, as sizes
+ * and samples may need external streams) */
+
+typedef struct {
+    ubi_sb_header * streams; /* parsed headers, one per subsong (failed ones have no codec set) */
+    int * streams_ok;
+} ubi_sb_bank_data;
+
+static void free_ubi_sb_bank_data(void * bank_data) {
+    ubi_sb_bank_data * data = bank_data;
+    if (!data) return;
+    free(data->streams);
+    free(data->streams_ok);
+    free(data);
+}
+
+static VGMSTREAM * init_ubi_sb_subsong(STREAMFILE *streamFile, vgmstream_subsong_table * table, int subsong) {
+    ubi_sb_bank_data * data = table->bank_data;
+    if (!data->streams_ok[subsong-1])
+        return NULL;
+    return build_sb_vgmstream(&data->streams[subsong-1], streamFile);
+}
+
+int init_subsong_table_ubi_sb(STREAMFILE * streamFile, vgmstream_subsong_table * table) {
+    ubi_sb_header sb = {0};
+    ubi_sb_bank_data * data = NULL;
+    int i;
+
+
+    if (!parse_sb_bank(&sb, streamFile))
+        goto fail;
+    parse_sb_entries(&sb, streamFile, 0, NULL); /* count */
+    if (sb.total_streams <= 0)
+        goto fail;
+
+    data = calloc(1, sizeof(ubi_sb_bank_data));
+    if (!data) goto fail;
+    data->streams = calloc(sb.total_streams, sizeof(ubi_sb_header));
+    data->streams_ok = calloc(sb.total_streams, sizeof(int));
+    if (!data->streams || !data->streams_ok) goto fail;
+
+    table->subsong_count = sb.total_streams;
+    sb.total_streams = 0;
+    parse_sb_entries(&sb, streamFile, 0, data->streams);
+    for (i = 0; i < table->subsong_count; i++) {
+        data->streams[i].total_streams = table->subsong_count;
+        data->streams_ok[i] = parse_sb_stream(&data->streams[i], streamFile);
+    }
+
+    table->meta_type = meta_UBI_SB;
+    table->bank_data = data;
+    table->init_subsong = init_ubi_sb_subsong;
+    table->free_bank_data = free_ubi_sb_bank_data;
+    return 1;
+
+fail:
+    free_ubi_sb_bank_data(data);
+    return 0;
+}
@@ -64,36 +64,60 @@ typedef struct {
 } xwb_header;
 
 static void get_xsb_name(char * buf, size_t maxsize, int target_stream, xwb_header * xwb, STREAMFILE *streamFile);
+static int parse_xwb_bank(STREAMFILE *streamFile, xwb_header * xwb);
+static int parse_xwb_stream(STREAMFILE *streamFile, xwb_header * xwb, int target_stream);
+static VGMSTREAM * build_xwb_vgmstream(STREAMFILE *streamFile, xwb_header * xwb, const char * stream_name);
 
 
 /* XWB - XACT Wave Bank (Microsoft SDK format for XBOX/XBOX360/Windows) */
 VGMSTREAM * init_vgmstream_xwb(STREAMFILE *streamFile) {
-    VGMSTREAM * vgmstream = NULL;
-    off_t start_offset, off, suboff;
     xwb_header xwb;
+    char stream_name[STREAM_NAME_SIZE] = {0};
     int target_stream = streamFile->stream_index;
-    int32_t (*read_32bit)(off_t,STREAMFILE*) = NULL;
+
+
+    if (!parse_xwb_bank(streamFile, &xwb))
+        goto fail;
+
+    if (target_stream == 0) target_stream = 1; /* auto: default to 1 */
+    if (target_stream < 0 || target_stream > xwb.streams || xwb.streams < 1) goto fail;
+
+    if (!parse_xwb_stream(streamFile, &xwb, target_stream))
+        goto fail;
+
+    get_xsb_name(stream_name,STREAM_NAME_SIZE, target_stream, &xwb, streamFile);
+
+    return build_xwb_vgmstream(streamFile, &xwb, stream_name);
+
+fail:
+    return NULL;
+}
+
+/* reads main bank info, shared by all streams */
+static int parse_xwb_bank(STREAMFILE *streamFile, xwb_header * xwb_p) {
+    off_t off, suboff;
+    xwb_header xwb;
+    header_reader hdr;
 
 
     /* basic checks */
     if (!check_extensions(streamFile,"xwb")) goto fail;
 
-    if ((read_32bitBE(0x00,streamFile) != 0x57424E44) &&    /* "WBND" (LE) */
-        (read_32bitBE(0x00,streamFile) != 0x444E4257))      /* "DNBW" (BE) */
+    /* main header and segments (WAVEBANKDATA is usually right after) */
+    init_header_reader(&hdr, streamFile, 0x00, 0x200, 1);
+
+    if ((read_hdr_32bitBE(0x00,&hdr) != 0x57424E44) &&    /* "WBND" (LE) */
+        (read_hdr_32bitBE(0x00,&hdr) != 0x444E4257))      /* "DNBW" (BE) */
         goto fail;
 
     memset(&xwb,0,sizeof(xwb_header));
 
-    xwb.little_endian = read_32bitBE(0x00,streamFile) == 0x57424E44;/* WBND */
-    if (xwb.little_endian) {
-        read_32bit = read_32bitLE;
-    } else {
-        read_32bit = read_32bitBE;
-    }
+    xwb.little_endian = read_hdr_32bitBE(0x00,&hdr) == 0x57424E44;/* WBND */
+    hdr.big_endian = !xwb.little_endian;
 
 
     /* read main header (WAVEBANKHEADER) */
-    xwb.version = read_32bit(0x04, streamFile); /* XACT3: 0x04=tool version, 0x08=header version */
+    xwb.version = read_hdr_32bit(0x04, &hdr); /* XACT3: 0x04=tool version, 0x08=header version */
 
     /* Crackdown 1 X360, essentially XACT2 but may have split header in some cases */
     if (xwb.version == XACT_CRACKDOWN)
@@ -101,7 +125,7 @@ VGMSTREAM * init_vgmstream_xwb(STREAMFILE *streamFile) {
 
     /* read segment offsets (SEGIDX) */
     if (xwb.version <= XACT1_0_MAX) {
-        xwb.streams     = read_32bit(0x0c, streamFile);
+        xwb.streams     = read_hdr_32bit(0x0c, &hdr);
         /* 0x10: bank name */
         xwb.entry_elem_size = 0x14;
         xwb.entry_offset= 0x50;
@@ -111,48 +135,60 @@ VGMSTREAM * init_vgmstream_xwb(STREAMFILE *streamFile) {
     }
     else {
         off = xwb.version <= XACT2_2_MAX ? 0x08 : 0x0c;
-        xwb.base_offset = read_32bit(off+0x00, streamFile);//BANKDATA
-        xwb.base_size   = read_32bit(off+0x04, streamFile);
-        xwb.entry_offset= read_32bit(off+0x08, streamFile);//ENTRYMETADATA
-        xwb.entry_size  = read_32bit(off+0x0c, streamFile);
+        xwb.base_offset = read_hdr_32bit(off+0x00, &hdr);//BANKDATA
+        xwb.base_size   = read_hdr_32bit(off+0x04, &hdr);
+        xwb.entry_offset= read_hdr_32bit(off+0x08, &hdr);//ENTRYMETADATA
+        xwb.entry_size  = read_hdr_32bit(off+0x0c, &hdr);
         /* go to last segment (XACT2/3 have 5 segments, XACT1 4) */
         //0x10: XACT1/2: ENTRYNAMES,  XACT3: SEEKTABLES
         //0x14: XACT1: none (ENTRYWAVEDATA), XACT2: EXTRA, XACT3: ENTRYNAMES
         suboff = xwb.version <= XACT1_1_MAX ? 0x08 : 0x08+0x08;
-        xwb.data_offset = read_32bit(off+0x10+suboff, streamFile);//ENTRYWAVEDATA
-        xwb.data_size   = read_32bit(off+0x14+suboff, streamFile);
+        xwb.data_offset = read_hdr_32bit(off+0x10+suboff, &hdr);//ENTRYWAVEDATA
+        xwb.data_size   = read_hdr_32bit(off+0x14+suboff, &hdr);
 
         /* for Techland's XWB with no data */
         if (xwb.base_offset == 0) goto fail;
 
         /* read base entry (WAVEBANKDATA) */
         off = xwb.base_offset;
-        xwb.base_flags  = (uint32_t)read_32bit(off+0x00, streamFile);
-        xwb.streams     = read_32bit(off+0x04, streamFile);
+        xwb.base_flags  = (uint32_t)read_hdr_32bit(off+0x00, &hdr);
+        xwb.streams     = read_hdr_32bit(off+0x04, &hdr);
         /* 0x08 bank_name */
         suboff = 0x08 + (xwb.version <= XACT1_1_MAX ? 0x10 : 0x40);
-        xwb.entry_elem_size = read_32bit(off+suboff+0x00, streamFile);
+        xwb.entry_elem_size = read_hdr_32bit(off+suboff+0x00, &hdr);
         /* suboff+0x04: meta name entry size */
-        xwb.entry_alignment = read_32bit(off+suboff+0x08, streamFile); /* usually 1 dvd sector */
-        xwb.format = read_32bit(off+suboff+0x0c, streamFile); /* compact mode only */
+        xwb.entry_alignment = read_hdr_32bit(off+suboff+0x08, &hdr); /* usually 1 dvd sector */
+        xwb.format = read_hdr_32bit(off+suboff+0x0c, &hdr); /* compact mode only */
         /* suboff+0x10: build time 64b (XACT2/3) */
     }
 
-    if (target_stream == 0) target_stream = 1; /* auto: default to 1 */
-    if (target_stream < 0 || target_stream > xwb.streams || xwb.streams < 1) goto fail;
+    memcpy(xwb_p, &xwb, sizeof(xwb_header));
+    return 1;
+fail:
+    return 0;
+}
+
+/* reads a stream's entry into a copy of the bank info */
+static int parse_xwb_stream(STREAMFILE *streamFile, xwb_header * xwb_p, int target_stream) {
+    off_t off;
+    xwb_header xwb;
+    header_reader hdr;
+
+    memcpy(&xwb, xwb_p, sizeof(xwb_header));
 
 
     /* read stream entry (WAVEBANKENTRY) */
     off = xwb.entry_offset + (target_stream-1) * xwb.entry_elem_size;
+    init_header_reader(&hdr, streamFile, off, xwb.entry_elem_size, !xwb.little_endian);
 
     if (xwb.base_flags & WAVEBANK_FLAGS_COMPACT) { /* compact entry */
         /* offset_in_sectors:21 and sector_alignment_in_bytes:11 */
-        uint32_t entry      = (uint32_t)read_32bit(off+0x00, streamFile);
+        uint32_t entry      = (uint32_t)read_hdr_32bit(off+0x00, &hdr);
         xwb.stream_offset   = xwb.data_offset + (entry >> 11) * xwb.entry_alignment + (entry & 0x7FF);
 
         /* find size (up to next entry or data end) */
         if (xwb.streams > 1) {
-            entry = (uint32_t)read_32bit(off+xwb.entry_size, streamFile);
+            entry = (uint32_t)read_hdr_32bit(off+xwb.entry_size, &hdr);
             xwb.stream_size = xwb.stream_offset -
                     (xwb.data_offset + (entry >> 11) * xwb.entry_alignment + (entry & 0x7FF));
         } else {
@@ -160,31 +196,31 @@ VGMSTREAM * init_vgmstream_xwb(STREAMFILE *streamFile) {
         }
     }
     else if (xwb.version <= XACT1_0_MAX) {
-        xwb.format          = (uint32_t)read_32bit(off+0x00, streamFile);
-        xwb.stream_offset   = xwb.data_offset + (uint32_t)read_32bit(off+0x04, streamFile);
-        xwb.stream_size     = (uint32_t)read_32bit(off+0x08, streamFile);
+        xwb.format          = (uint32_t)read_hdr_32bit(off+0x00, &hdr);
+        xwb.stream_offset   = xwb.data_offset + (uint32_t)read_hdr_32bit(off+0x04, &hdr);
+        xwb.stream_size     = (uint32_t)read_hdr_32bit(off+0x08, &hdr);
 
-        xwb.loop_start      = (uint32_t)read_32bit(off+0x0c, streamFile);
-        xwb.loop_end        = (uint32_t)read_32bit(off+0x10, streamFile);//length
+        xwb.loop_start      = (uint32_t)read_hdr_32bit(off+0x0c, &hdr);
+        xwb.loop_end        = (uint32_t)read_hdr_32bit(off+0x10, &hdr);//length
     }
     else {
-        uint32_t entry_info = (uint32_t)read_32bit(off+0x00, streamFile);
+        uint32_t entry_info = (uint32_t)read_hdr_32bit(off+0x00, &hdr);
         if (xwb.version <= XACT1_1_MAX) {
             xwb.entry_flags = entry_info;
         } else {
             xwb.entry_flags = (entry_info) & 0xF; /*4b*/
             xwb.num_samples = (entry_info >> 4) & 0x0FFFFFFF; /*28b*/
         }
-        xwb.format          = (uint32_t)read_32bit(off+0x04, streamFile);
-        xwb.stream_offset   = xwb.data_offset + (uint32_t)read_32bit(off+0x08, streamFile);
-        xwb.stream_size     = (uint32_t)read_32bit(off+0x0c, streamFile);
+        xwb.format          = (uint32_t)read_hdr_32bit(off+0x04, &hdr);
+        xwb.stream_offset   = xwb.data_offset + (uint32_t)read_hdr_32bit(off+0x08, &hdr);
+        xwb.stream_size     = (uint32_t)read_hdr_32bit(off+0x0c, &hdr);
 
 		if (xwb.version <= XACT2_1_MAX) { /* LoopRegion (bytes) */
-            xwb.loop_start  = (uint32_t)read_32bit(off+0x10, streamFile);
-            xwb.loop_end    = (uint32_t)read_32bit(off+0x14, streamFile);//length (LoopRegion) or offset (XMALoopRegion in late XACT2)
+            xwb.loop_start  = (uint32_t)read_hdr_32bit(off+0x10, &hdr);
+            xwb.loop_end    = (uint32_t)read_hdr_32bit(off+0x14, &hdr);//length (LoopRegion) or offset (XMALoopRegion in late XACT2)
         } else { /* LoopRegion (samples) */
-            xwb.loop_start_sample   = (uint32_t)read_32bit(off+0x10, streamFile);
-            xwb.loop_end_sample     = (uint32_t)read_32bit(off+0x14, streamFile) + xwb.loop_start_sample;
+            xwb.loop_start_sample   = (uint32_t)read_hdr_32bit(off+0x10, &hdr);
+            xwb.loop_end_sample     = (uint32_t)read_hdr_32bit(off+0x14, &hdr) + xwb.loop_start_sample;
         }
     }
 
@@ -344,6 +380,19 @@ VGMSTREAM * init_vgmstream_xwb(STREAMFILE *streamFile) {
         xwb.num_samples += 64 + 512;
     }
 
+    memcpy(xwb_p, &xwb, sizeof(xwb_header));
+    return 1;
+fail:
+    return 0;
+}
+
+static VGMSTREAM * build_xwb_vgmstream(STREAMFILE *streamFile, xwb_header * xwb_p, const char * stream_name) {
+    VGMSTREAM * vgmstream = NULL;
+    off_t start_offset;
+    xwb_header xwb;
+
+    memcpy(&xwb, xwb_p, sizeof(xwb_header));
+
 
     /* build the VGMSTREAM */
     vgmstream = allocate_vgmstream(xwb.channels,xwb.loop_flag);
@@ -355,7 +404,10 @@ VGMSTREAM * init_vgmstream_xwb(STREAMFILE *streamFile) {
     vgmstream->loop_end_sample   = xwb.loop_end_sample;
     vgmstream->num_streams = xwb.streams;
     vgmstream->meta_type = meta_XWB;
-    get_xsb_name(vgmstream->stream_name,STREAM_NAME_SIZE, target_stream, &xwb, streamFile);
+    if (stream_name) {
+        strncpy(vgmstream->stream_name, stream_name, STREAM_NAME_SIZE);
+        vgmstream->stream_name[STREAM_NAME_SIZE-1] = '\0';
+    }
 
     switch(xwb.codec) {
         case PCM:
@@ -536,20 +588,33 @@ typedef struct {
 
     size_t xsb_wavebanks_count;
     off_t xsb_nameoffsets_offset;
+
+    /* selection */
+    int selected_wavebank;
+    int start_sound;
+    STREAMFILE * streamFile; /* for reading names */
 } xsb_header;
 
 
-/* try to find the stream name in a companion XSB file, a comically complex cue format. */
-static void get_xsb_name(char * buf, size_t maxsize, int target_stream, xwb_header * xwb, STREAMFILE *streamXwb) {
+static void free_xsb(xsb_header * xsb) {
+    free(xsb->xsb_sounds);
+    free(xsb->xsb_wavebanks);
+    if (xsb->streamFile) close_streamfile(xsb->streamFile);
+    memset(xsb,0,sizeof(xsb_header));
+}
+
+/* parse the companion XSB file, a comically complex cue format, to get stream names later */
+static int parse_xsb(xsb_header * xsb_p, xwb_header * xwb, STREAMFILE *streamXwb) {
     STREAMFILE *streamFile = NULL;
-    int i,j, start_sound, cfg__start_sound = 0, cfg__selected_wavebank = 0;
+    int i,j, cfg__start_sound = 0, cfg__selected_wavebank = 0;
     int xsb_version;
-    off_t off, suboff, name_offset = 0;
+    off_t off, suboff;
     int32_t (*read_32bit)(off_t,STREAMFILE*) = NULL;
     int16_t (*read_16bit)(off_t,STREAMFILE*) = NULL;
     xsb_header xsb;
 
     memset(&xsb,0,sizeof(xsb_header)); /* before any "fail"! */
+    memset(xsb_p,0,sizeof(xsb_header));
 
 
     streamFile = open_stream_ext(streamXwb, "xsb");
@@ -796,15 +861,29 @@ static void get_xsb_name(char * buf, size_t maxsize, int target_stream, xwb_head
         //    CHECK_EXIT(xwb->xsb_wavebanks[cfg->selected_wavebank-1].sound_count != xwb->streams_count, "ERROR: number of streams in xsb wavebank different than xwb (xsb %i vs xwb %i), use -s to specify (1=first)", xwb->xsb_wavebanks[cfg->selected_wavebank-1].sound_count, xwb->streams_count);
     }
 
-    /* *************************** */
+    xsb.selected_wavebank = cfg__selected_wavebank;
+    xsb.start_sound = cfg__start_sound ? cfg__start_sound-1 : 0;
+    xsb.streamFile = streamFile;
+
+    memcpy(xsb_p, &xsb, sizeof(xsb_header));
+    return 1;
+
+fail:
+    free(xsb.xsb_sounds);
+    free(xsb.xsb_wavebanks);
+    if (streamFile) close_streamfile(streamFile);
+    return 0;
+}
 
-    start_sound = cfg__start_sound ? cfg__start_sound-1 : 0;
+/* find the stream name in a parsed XSB */
+static void get_xsb_name_parsed(char * buf, size_t maxsize, int target_stream, xsb_header * xsb) {
+    off_t name_offset = 0;
+    int i;
 
     /* get name offset */
-    for (i = start_sound; i < xsb.xsb_sounds_count; i++) {
-        xsb_sound *s = &(xsb.xsb_sounds[i]);
-        VGM_LOG("wa=%i, sel=%i, si=%i vs ti=%i\n", s->wavebank, cfg__selected_wavebank, s->stream_index, target_stream);
-        if (s->wavebank == cfg__selected_wavebank-1
+    for (i = xsb->start_sound; i < xsb->xsb_sounds_count; i++) {
+        xsb_sound *s = &(xsb->xsb_sounds[i]);
+        if (s->wavebank == xsb->selected_wavebank-1
                 && s->stream_index == target_stream-1){
             name_offset = s->name_offset;
             break;
@@ -812,13 +891,122 @@ static void get_xsb_name(char * buf, size_t maxsize, int target_stream, xwb_head
     }
 
     if (name_offset)
-        read_string(buf,maxsize, name_offset,streamFile);
+        read_string(buf,maxsize, name_offset,xsb->streamFile);
+}
+
+/* try to find the stream name in a companion XSB file */
+static void get_xsb_name(char * buf, size_t maxsize, int target_stream, xwb_header * xwb, STREAMFILE *streamXwb) {
+    xsb_header xsb;
+
+    if (!parse_xsb(&xsb, xwb, streamXwb))
+        return;
+    get_xsb_name_parsed(buf,maxsize, target_stream, &xsb);
+    free_xsb(&xsb);
+}
+
+
+/* ****************************************************************************** */
+/* subsong table, with the bank and XSB parsed once */
+
+typedef struct {
+    xwb_header * streams; /* parsed headers, one per subsong */
+} xwb_bank_data;
+
+static void free_xwb_bank_data(void * bank_data) {
+    xwb_bank_data * data = bank_data;
+    if (!data) return;
+    free(data->streams);
+    free(data);
+}
+
+static VGMSTREAM * init_xwb_subsong(STREAMFILE *streamFile, vgmstream_subsong_table * table, int subsong) {
+    xwb_bank_data * data = table->bank_data;
+    return build_xwb_vgmstream(streamFile, &data->streams[subsong-1], table->subsongs[subsong-1].stream_name);
+}
+
+/* codec as set when building the VGMSTREAM (returns 0 if not enabled) */
+static int get_xwb_coding(xwb_header * xwb, coding_t * coding_type) {
+    switch(xwb->codec) {
+        case PCM:
+            *coding_type = xwb->bits_per_sample == 0 ? coding_PCM8 :
+                    (xwb->little_endian ? coding_PCM16LE : coding_PCM16BE);
+            return 1;
+        case XBOX_ADPCM:
+            *coding_type = coding_XBOX;
+            return 1;
+        case MS_ADPCM:
+            *coding_type = coding_MSADPCM;
+            return 1;
+#ifdef VGM_USE_FFMPEG
+        case XMA1:
+        case XMA2:
+        case WMA:
+        case XWMA:
+        case ATRAC3:
+        case OGG:
+            *coding_type = coding_FFmpeg;
+            return 1;
+#endif
+        default:
+            return 0;
+    }
+}
+
+int init_subsong_table_xwb(STREAMFILE * streamFile, vgmstream_subsong_table * table) {
+    xwb_header xwb;
+    xsb_header xsb;
+    xwb_bank_data * data = NULL;
+    vgmstream_subsong_info * subsongs = NULL;
+    int i, has_xsb = 0;
 
-    //return; /* no return, let free */
+
+    if (!parse_xwb_bank(streamFile, &xwb))
+        goto fail;
+    if (xwb.streams < 1) goto fail;
+
+    data = calloc(1, sizeof(xwb_bank_data));
+    if (!data) goto fail;
+    data->streams = calloc(xwb.streams, sizeof(xwb_header));
+    if (!data->streams) goto fail;
+    subsongs = calloc(xwb.streams, sizeof(vgmstream_subsong_info));
+    if (!subsongs) goto fail;
+
+    has_xsb = parse_xsb(&xsb, &xwb, streamFile);
+
+    for (i = 0; i < xwb.streams; i++) {
+        xwb_header * stream = &data->streams[i];
+        vgmstream_subsong_info * info = &subsongs[i];
+
+        memcpy(stream, &xwb, sizeof(xwb_header));
+        if (!parse_xwb_stream(streamFile, stream, i+1))
+            continue; /* unsupported entry, others may be fine */
+
+        info->supported = get_xwb_coding(stream, &info->coding_type);
+        info->stream_offset = stream->stream_offset;
+        info->stream_size = stream->stream_size;
+        info->channels = stream->channels;
+        info->sample_rate = stream->sample_rate;
+        info->num_samples = stream->num_samples;
+        info->loop_flag = stream->loop_flag;
+        info->loop_start_sample = stream->loop_start_sample;
+        info->loop_end_sample = stream->loop_end_sample;
+        if (has_xsb)
+            get_xsb_name_parsed(info->stream_name,STREAM_NAME_SIZE, i+1, &xsb);
+    }
+
+    if (has_xsb)
+        free_xsb(&xsb);
+
+    table->meta_type = meta_XWB;
+    table->subsong_count = xwb.streams;
+    table->subsongs = subsongs;
+    table->bank_data = data;
+    table->init_subsong = init_xwb_subsong;
+    table->free_bank_data = free_xwb_bank_data;
+    return 1;
 
 fail:
-    free(xsb.xsb_sounds);
-    free(xsb.xsb_wavebanks);
-    if (streamFile) close_streamfile(streamFile);
-    return;
+    free(subsongs);
+    free_xwb_bank_data(data);
+    return 0;
 }
@@ -1,6 +1,16 @@
 #ifndef _MSC_VER
 #include <unistd.h>
 #endif
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include <ctype.h>
 #include "streamfile.h"
 #include "util.h"
 #include "vgmstream.h"
@@ -11,6 +21,217 @@
  * Only matters for metas that get num_samples wrong (bigger than total data). */
 #define STREAMFILE_IGNORE_EOF 0
 
+/* **************************************************** */
+
+/* Directory listing cache. Metas probe many companion files by name (.txth, .hcakey, L/R pairs,
+ * header/data pairs, etc) and most don't exist, so each probe is a failed fopen. When enabled,
+ * the first lookup in a dir reads its listing once, and later opens of missing files fail in memory.
+ * Shared by all stdio STREAMFILEs; files created while enabled aren't seen until flushed. */
+
+#define DIR_CACHE_MAX 32
+
+typedef struct {
+    char path[PATH_LIMIT];  /* dir, including separator (or empty for current dir) */
+    char ** names;          /* sorted filenames, pointing into buf */
+    int count;
+    char * buf;
+} dir_cache_entry;
+
+static dir_cache_entry * dir_cache[DIR_CACHE_MAX];
+static int dir_cache_next = 0; /* round-robin replacement */
+static int dir_cache_enabled = 0;
+
+#ifdef _WIN32
+static CRITICAL_SECTION dir_cache_lock;
+static int dir_cache_lock_init = 0;
+static void dir_cache_lock_enter(void) { EnterCriticalSection(&dir_cache_lock); }
+static void dir_cache_lock_leave(void) { LeaveCriticalSection(&dir_cache_lock); }
+#else
+static pthread_mutex_t dir_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static void dir_cache_lock_enter(void) { pthread_mutex_lock(&dir_cache_lock); }
+static void dir_cache_lock_leave(void) { pthread_mutex_unlock(&dir_cache_lock); }
+#endif
+
+/* case insensitive as some filesystems are; a false positive only means a normal fopen */
+static int dir_cache_compare(const void * a, const void * b) {
+    return strcasecmp(*(const char **)a, *(const char **)b);
+}
+
+static void free_dir_cache_entry(dir_cache_entry * entry) {
+    if (!entry) return;
+    free(entry->names);
+    free(entry->buf);
+    free(entry);
+}
+
+/* adds a name to the entry's buffers, growing them as needed */
+static int add_dir_cache_name(dir_cache_entry * entry, const char * name, size_t * buf_used, size_t * buf_size, int * names_size) {
+    size_t name_len = strlen(name) + 1;
+
+    if (*buf_used + name_len > *buf_size) {
+        char * new_buf;
+        size_t new_size = (*buf_size) * 2 + name_len;
+        new_buf = realloc(entry->buf, new_size);
+        if (!new_buf) return 0;
+        entry->buf = new_buf;
+        *buf_size = new_size;
+    }
+    if (entry->count >= *names_size) {
+        char ** new_names;
+        int new_size = (*names_size) * 2 + 16;
+        new_names = realloc(entry->names, new_size * sizeof(char*));
+        if (!new_names) return 0;
+        entry->names = new_names;
+        *names_size = new_size;
+    }
+
+    /* names point to offsets for now, as buf may move */
+    memcpy(entry->buf + *buf_used, name, name_len);
+    entry->names[entry->count] = (char*)(*buf_used);
+    entry->count++;
+    *buf_used += name_len;
+    return 1;
+}
+
+/* reads a directory listing (returns NULL if it can't be read) */
+static dir_cache_entry * load_dir_cache_entry(const char * path) {
+    dir_cache_entry * entry = NULL;
+    size_t buf_used = 0, buf_size = 0;
+    int names_size = 0, i;
+
+    entry = calloc(1, sizeof(dir_cache_entry));
+    if (!entry) goto fail;
+
+    strncpy(entry->path, path, sizeof(entry->path));
+    entry->path[sizeof(entry->path)-1] = '\0';
+
+#ifdef _WIN32
+    {
+        char pattern[PATH_LIMIT];
+        WIN32_FIND_DATAA data;
+        HANDLE handle;
+
+        snprintf(pattern, sizeof(pattern), "%s*", path);
+        handle = FindFirstFileA(pattern, &data);
+        if (handle == INVALID_HANDLE_VALUE) goto fail;
+        do {
+            if (!add_dir_cache_name(entry, data.cFileName, &buf_used, &buf_size, &names_size)) {
+                FindClose(handle);
+                goto fail;
+            }
+        } while (FindNextFileA(handle, &data));
+        FindClose(handle);
+    }
+#else
+    {
+        DIR * dir;
+        struct dirent * dirent;
+
+        dir = opendir(path[0] != '\0' ? path : ".");
+        if (!dir) goto fail;
+        while ((dirent = readdir(dir)) != NULL) {
+            if (!add_dir_cache_name(entry, dirent->d_name, &buf_used, &buf_size, &names_size)) {
+                closedir(dir);
+                goto fail;
+            }
+        }
+        closedir(dir);
+    }
+#endif
+
+    for (i = 0; i < entry->count; i++) {
+        entry->names[i] = entry->buf + (size_t)entry->names[i];
+    }
+    if (entry->count > 1)
+        qsort(entry->names, entry->count, sizeof(char*), dir_cache_compare);
+
+    return entry;
+fail:
+    free_dir_cache_entry(entry);
+    return NULL;
+}
+
+/* Checks if a file exists using the cached listing of its dir.
+ * Returns 1 if found, 0 if not, and -1 if unknown (cache disabled or dir can't be read). */
+static int dir_cache_find_file(const char * filename) {
+    char path[PATH_LIMIT];
+    const char * name;
+    const char * sep;
+    dir_cache_entry * entry = NULL;
+    int i, found = -1;
+
+    if (!dir_cache_enabled)
+        return -1;
+
+    /* split into dir (with separator) and name */
+    sep = strrchr(filename, DIR_SEPARATOR);
+#ifdef _WIN32
+    {
+        const char * sep2 = strrchr(filename, '/');
+        if (sep2 > sep) sep = sep2;
+    }
+#endif
+    name = sep ? sep + 1 : filename;
+    if (name - filename >= PATH_LIMIT)
+        return -1;
+    memcpy(path, filename, name - filename);
+    path[name - filename] = '\0';
+
+    dir_cache_lock_enter();
+
+    for (i = 0; i < DIR_CACHE_MAX; i++) {
+        if (dir_cache[i] && strcmp(dir_cache[i]->path, path) == 0) {
+            entry = dir_cache[i];
+            break;
+        }
+    }
+
+    if (!entry) {
+        entry = load_dir_cache_entry(path);
+        if (entry) {
+            free_dir_cache_entry(dir_cache[dir_cache_next]);
+            dir_cache[dir_cache_next] = entry;
+            dir_cache_next = (dir_cache_next + 1) % DIR_CACHE_MAX;
+        }
+    }
+
+    if (entry) {
+        found = bsearch(&name, entry->names, entry->count, sizeof(char*), dir_cache_compare) != NULL;
+    }
+
+    dir_cache_lock_leave();
+
+    return found;
+}
+
+void set_streamfile_dir_cache(int enable) {
+#ifdef _WIN32
+    if (!dir_cache_lock_init) {
+        InitializeCriticalSection(&dir_cache_lock);
+        dir_cache_lock_init = 1;
+    }
+#endif
+    if (!enable)
+        flush_streamfile_dir_cache();
+    dir_cache_enabled = enable;
+}
+
+void flush_streamfile_dir_cache(void) {
+    int i;
+
+#ifdef _WIN32
+    if (!dir_cache_lock_init)
+        return;
+#endif
+    dir_cache_lock_enter();
+    for (i = 0; i < DIR_CACHE_MAX; i++) {
+        free_dir_cache_entry(dir_cache[i]);
+        dir_cache[i] = NULL;
+    }
+    dir_cache_next = 0;
+    dir_cache_lock_leave();
+}
+
 
 /* a STREAMFILE that operates via standard IO using a buffer */
 typedef struct {
@@ -20,16 +241,105 @@ typedef struct {
     off_t offset;           /* current offset */
     size_t validsize;       /* current buffer size */
     uint8_t * buffer;       /* data buffer */
-    size_t buffersize;      /* max buffer size */
+    size_t buffersize;      /* allocated buffer size */
     size_t filesize;        /* cached file size (max offset) */
-#ifdef PROFILE_STREAMFILE
-    size_t bytes_read;
+    size_t bytes_read;      /* counters */
     int error_count;
-#endif
+
+    size_t refill_size;     /* bytes read per refill, adapted to the access pattern */
+    size_t refill_min;
+    size_t refill_max;
+    off_t used_end;         /* end of the data used from the current buffer */
+    off_t last_stride;      /* distance between the last two refills */
+    int refills;
 } STDIOSTREAMFILE;
 
 static STREAMFILE * open_stdio_streamfile_buffer(const char * const filename, size_t buffersize);
 static STREAMFILE * open_stdio_streamfile_buffer_by_file(FILE *infile,const char * const filename, size_t buffersize);
+static STREAMFILE * open_pread_streamfile_buffer(const char * const filename, size_t buffersize);
+
+/* Picks the next refill size from where it starts relative to the previous one: continuing it
+ * (sequential) doubles it, a repeated jump (strided, like interleaved blocks) sizes it to what was
+ * used of the last buffer, and anything else (random, like metas parsing a bank) halves it. */
+static void adapt_refill_stdio(STDIOSTREAMFILE * streamfile, off_t offset) {
+    streamfile_stats * stats = &streamfile->sf.stats;
+    off_t buffer_end = streamfile->offset + streamfile->validsize;
+    off_t stride = offset - streamfile->offset;
+    size_t refill_size = streamfile->refill_size;
+
+    if (streamfile->refill_min == streamfile->refill_max)
+        goto done; /* fixed buffering */
+    if (streamfile->refills++ == 0)
+        goto done; /* first read: nothing to compare */
+
+    if (offset >= buffer_end && offset <= buffer_end + STREAMFILE_STDIO_REFILL_MIN) {
+        stats->access = STREAMFILE_ACCESS_SEQUENTIAL;
+        refill_size *= 2;
+    }
+    else if (stride != 0 && stride == streamfile->last_stride) {
+        size_t used = streamfile->used_end > streamfile->offset ? streamfile->used_end - streamfile->offset : 0;
+        stats->access = STREAMFILE_ACCESS_STRIDED;
+        refill_size = (used + STREAMFILE_STDIO_REFILL_MIN - 1) / STREAMFILE_STDIO_REFILL_MIN * STREAMFILE_STDIO_REFILL_MIN;
+    }
+    else {
+        stats->access = STREAMFILE_ACCESS_RANDOM;
+        refill_size /= 2;
+    }
+
+    if (refill_size < streamfile->refill_min)
+        refill_size = streamfile->refill_min;
+    if (refill_size > streamfile->refill_max)
+        refill_size = streamfile->refill_max;
+    streamfile->refill_size = refill_size;
+done:
+    streamfile->last_stride = stride;
+    stats->refill_size = streamfile->refill_size;
+}
+
+/* refills the buffer at offset with at least length bytes (if possible), returns the
+ * requested size (validsize may be less at EOF) or 0 on seek errors */
+static size_t refill_stdio(STDIOSTREAMFILE * streamfile, off_t offset, size_t length) {
+    size_t refill_size;
+
+    adapt_refill_stdio(streamfile, offset);
+    refill_size = streamfile->refill_size;
+    if (refill_size < length)
+        refill_size = length;
+
+    /* grow the buffer if the pattern asks for it (keeping the current one on failure) */
+    if (refill_size > streamfile->buffersize) {
+        uint8_t * buffer = realloc(streamfile->buffer, refill_size);
+        if (buffer) {
+            streamfile->buffer = buffer;
+            streamfile->buffersize = refill_size;
+        }
+        else {
+            refill_size = streamfile->buffersize;
+        }
+    }
+
+    streamfile->validsize = 0; /* buffer is empty now */
+    streamfile->used_end = offset;
+
+    /* position to new offset */
+    if (fseeko(streamfile->infile,offset,SEEK_SET)) {
+        streamfile->offset = streamfile->filesize;
+        streamfile->error_count++;
+        return 0; /* fail miserably (fseek shouldn't fail and reach this) */
+    }
+    streamfile->offset = offset;
+
+    /* fill the buffer */
+    streamfile->validsize = fread(streamfile->buffer,sizeof(uint8_t),refill_size,streamfile->infile);
+    if (ferror(streamfile->infile)) {
+        clearerr(streamfile->infile);
+        streamfile->error_count++;
+    }
+
+    streamfile->bytes_read += streamfile->validsize;
+    streamfile->sf.stats.bytes_read += streamfile->validsize;
+    return refill_size;
+}
 
 static size_t read_the_rest(uint8_t * dest, off_t offset, size_t length, STDIOSTREAMFILE * streamfile) {
     size_t length_read_total=0;
@@ -45,6 +355,7 @@ static size_t read_the_rest(uint8_t * dest, off_t offset, size_t length, STDIOST
         length -= length_read;
         offset += length_read;
         dest += length_read;
+        streamfile->used_end = offset;
     }
 
     /* What would make more sense here is to read the whole request
@@ -59,10 +370,11 @@ static size_t read_the_rest(uint8_t * dest, off_t offset, size_t length, STDIOST
     while (length > 0) {
         size_t length_to_read;
         size_t length_read;
-        streamfile->validsize = 0; /* buffer is empty now */
+        size_t refill_size;
 
         /* request outside file: ignore to avoid seek/read */
         if (offset > streamfile->filesize) {
+            streamfile->validsize = 0; /* buffer is empty now */
             streamfile->offset = streamfile->filesize;
             VGM_LOG_ONCE("ERROR: reading over filesize 0x%x @ 0x%lx + 0x%x (buggy meta?)\n", streamfile->filesize, offset, length);
 
@@ -74,68 +386,2655 @@ static size_t read_the_rest(uint8_t * dest, off_t offset, size_t length, STDIOST
 #endif
         }
 
-        /* position to new offset */
-        if (fseeko(streamfile->infile,offset,SEEK_SET)) {
-            streamfile->offset = streamfile->filesize;
-#ifdef PROFILE_STREAMFILE
-            streamfile->error_count++;
-#endif
-            return 0; /* fail miserably (fseek shouldn't fail and reach this) */
+        refill_size = refill_stdio(streamfile, offset, 0);
+        if (!refill_size)
+            return 0;
+        length_read = streamfile->validsize;
+
+        /* decide how much must be read this time */
+        if (length > refill_size)
+            length_to_read = refill_size;
+        else
+            length_to_read = length;
+
+        /* if we can't get enough to satisfy the request (EOF) we give up */
+        if (length_read < length_to_read) {
+            memcpy(dest,streamfile->buffer,length_read);
+
+#if STREAMFILE_IGNORE_EOF
+            memset(dest+length_read,0,length-length_read);
+            return length_read_total + length; /* partially-read + 0-set buffer */
+#else
+            return length_read_total + length_read; /* partially-read buffer */
+#endif
+        }
+
+        /* use the new buffer */
+        memcpy(dest,streamfile->buffer,length_to_read);
+        streamfile->used_end = offset + length_to_read;
+        length_read_total += length_to_read;
+        length -= length_to_read;
+        dest += length_to_read;
+        offset += length_to_read;
+    }
+
+    return length_read_total;
+}
+
+static size_t read_stdio(STDIOSTREAMFILE *streamfile,uint8_t * dest, off_t offset, size_t length) {
+
+    if (!streamfile || !dest || length<=0)
+        return 0;
+
+    /* request outside file: ignore to avoid seek/read in read_the_rest() */
+    if (offset > streamfile->filesize) {
+        streamfile->validsize = 0; /* buffer is empty now */
+        streamfile->offset = streamfile->filesize;
+        VGM_LOG_ONCE("ERROR: offset over filesize 0x%x @ 0x%lx + 0x%x (buggy meta?)\n", streamfile->filesize, offset, length);
+
+#if STREAMFILE_IGNORE_EOF
+        memset(dest,0,length);
+        return length; /* 0-set buffer */
+#else
+        return 0; /* nothing to read */
+#endif
+    }
+
+    /* just copy if entire request is within the buffer */
+    if (offset >= streamfile->offset && offset + length <= streamfile->offset + streamfile->validsize) {
+        off_t offset_into_buffer = offset - streamfile->offset;
+        memcpy(dest,streamfile->buffer + offset_into_buffer,length);
+        if (offset + length > streamfile->used_end)
+            streamfile->used_end = offset + length;
+        return length;
+    }
+
+    /* request outside buffer: new fread */
+    {
+        size_t length_read = read_the_rest(dest,offset,length,streamfile);
+        if (length_read < length)
+            streamfile->error_count++;
+        return length_read;
+    }
+}
+
+static void close_stdio(STDIOSTREAMFILE * streamfile) {
+    fclose(streamfile->infile);
+    free(streamfile->buffer);
+    free(streamfile);
+}
+
+static const uint8_t * peek_stdio(STDIOSTREAMFILE *streamfile, off_t offset, size_t length, size_t * avail) {
+    off_t offset_into_buffer;
+
+    /* not in the buffer: refill from offset, as a read would */
+    if (!(offset >= streamfile->offset && offset < streamfile->offset + streamfile->validsize)) {
+        if (offset < 0 || offset >= streamfile->filesize || length > streamfile->refill_max)
+            return NULL;
+
+        if (!refill_stdio(streamfile, offset, length) || !streamfile->validsize)
+            return NULL;
+    }
+
+    offset_into_buffer = offset - streamfile->offset;
+    *avail = streamfile->validsize - offset_into_buffer;
+    if (offset + (length < *avail ? length : *avail) > streamfile->used_end)
+        streamfile->used_end = offset + (length < *avail ? length : *avail);
+    return streamfile->buffer + offset_into_buffer;
+}
+
+static size_t get_size_stdio(STDIOSTREAMFILE * streamfile) {
+    return streamfile->filesize;
+}
+
+static off_t get_offset_stdio(STDIOSTREAMFILE *streamFile) {
+    return streamFile->offset;
+}
+
+static void get_name_stdio(STDIOSTREAMFILE *streamfile,char *buffer,size_t length) {
+    strncpy(buffer,streamfile->name,length);
+    buffer[length-1]='\0';
+}
+
+static size_t get_bytes_read_stdio(STDIOSTREAMFILE *streamFile) {
+    return streamFile->bytes_read;
+}
+static int get_error_count_stdio(STDIOSTREAMFILE *streamFile) {
+    return streamFile->error_count;
+}
+
+static STREAMFILE *open_stdio(STDIOSTREAMFILE *streamFile,const char * const filename,size_t buffersize) {
+    int newfd;
+    FILE *newfile;
+    STREAMFILE *newstreamFile;
+
+    if (!filename)
+        return NULL;
+
+    // if same name, duplicate the file pointer we already have open
+    if (!strcmp(streamFile->name,filename)) {
+        if (((newfd = dup(fileno(streamFile->infile))) >= 0) &&
+            (newfile = fdopen( newfd, "rb" ))) 
+        {
+            newstreamFile = open_stdio_streamfile_buffer_by_file(newfile,filename,buffersize);
+            if (newstreamFile) { 
+                return newstreamFile;
+            }
+            // failure, close it and try the default path (which will probably fail a second time)
+            fclose(newfile);
+        }
+    }
+    // a normal open, open a new file
+    return open_stdio_streamfile_buffer(filename,buffersize);
+}
+
+static STREAMFILE * open_stdio_streamfile_buffer_by_file(FILE *infile,const char * const filename, size_t buffersize) {
+    uint8_t * buffer;
+    STDIOSTREAMFILE * streamfile;
+
+    buffer = calloc(buffersize,1);
+    if (!buffer) {
+        return NULL;
+    }
+
+    streamfile = calloc(1,sizeof(STDIOSTREAMFILE));
+    if (!streamfile) {
+        free(buffer);
+        return NULL;
+    }
+
+    streamfile->sf.read = (void*)read_stdio;
+    streamfile->sf.get_size = (void*)get_size_stdio;
+    streamfile->sf.get_offset = (void*)get_offset_stdio;
+    streamfile->sf.get_name = (void*)get_name_stdio;
+    streamfile->sf.get_realname = (void*)get_name_stdio;
+    streamfile->sf.open = (void*)open_stdio;
+    streamfile->sf.close = (void*)close_stdio;
+    streamfile->sf.get_bytes_read = (void*)get_bytes_read_stdio;
+    streamfile->sf.get_error_count = (void*)get_error_count_stdio;
+    streamfile->sf.peek = (void*)peek_stdio;
+
+    streamfile->infile = infile;
+    streamfile->buffersize = buffersize;
+    streamfile->buffer = buffer;
+
+    /* smaller than default buffers are a caller's choice (like the page cache's one page base): keep them fixed */
+    streamfile->refill_size = buffersize;
+    if (buffersize < STREAMFILE_DEFAULT_BUFFER_SIZE) {
+        streamfile->refill_min = buffersize;
+        streamfile->refill_max = buffersize;
+    }
+    else {
+        streamfile->refill_min = STREAMFILE_STDIO_REFILL_MIN;
+        streamfile->refill_max = buffersize > STREAMFILE_STDIO_REFILL_MAX ? buffersize : STREAMFILE_STDIO_REFILL_MAX;
+    }
+    streamfile->sf.stats.refill_size = buffersize;
+
+    strncpy(streamfile->name,filename,sizeof(streamfile->name));
+    streamfile->name[sizeof(streamfile->name)-1] = '\0';
+
+    /* cache filesize */
+    fseeko(streamfile->infile,0,SEEK_END);
+    streamfile->filesize = ftello(streamfile->infile);
+
+    return &streamfile->sf;
+}
+
+static STREAMFILE * open_stdio_streamfile_buffer(const char * const filename, size_t buffersize) {
+    FILE * infile;
+    STREAMFILE *streamFile;
+
+    /* skip the fopen if the dir listing says the file isn't there */
+    if (dir_cache_find_file(filename) == 0)
+        return NULL;
+
+    infile = fopen(filename,"rb");
+    if (!infile) return NULL;
+
+    streamFile = open_stdio_streamfile_buffer_by_file(infile,filename,buffersize);
+    if (!streamFile) {
+        fclose(infile);
+    }
+
+    return streamFile;
+}
+
+
+STREAMFILE * open_stdio_streamfile(const char * filename) {
+    return open_stdio_streamfile_buffer(filename,STREAMFILE_DEFAULT_BUFFER_SIZE);
+}
+
+STREAMFILE * open_stdio_streamfile_by_file(FILE * file, const char * filename) {
+    return open_stdio_streamfile_buffer_by_file(file,filename,STREAMFILE_DEFAULT_BUFFER_SIZE);
+}
+
+/* **************************************************** */
+
+/* A STREAMFILE that reads from a read-only memory mapping of the whole file, so reads are a memcpy
+ * without seeks or fread calls. Re-opening the same name returns a new view of the same mapping
+ * (each with its own position), so channels don't map the file again. Views of one mapping are
+ * expected to be used from one thread at a time, like the VGMSTREAM that owns them. */
+
+#define MMAP_SEQUENTIAL_READS 4         /* consecutive reads before considering access sequential */
+#define MMAP_READAHEAD_SIZE 0x100000    /* sequential views ask the OS to prefetch this much ahead */
+
+typedef struct {
+    uint8_t * data;
+    size_t size;
+    int refs;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+} mmap_mapping;
+
+typedef struct {
+    STREAMFILE sf;          /* callbacks */
+    mmap_mapping * mapping; /* shared by views */
+    char name[PATH_LIMIT];
+    off_t offset;           /* current offset (end of last read) */
+    int sequential_reads;   /* current run of reads starting where the last ended */
+    off_t readahead_offset; /* prefetch done up to this point */
+    size_t bytes_read;      /* counters */
+    int error_count;
+} MMAPSTREAMFILE;
+
+static void close_mmap_mapping(mmap_mapping * mapping) {
+    if (!mapping) return;
+
+    mapping->refs--;
+    if (mapping->refs > 0)
+        return;
+
+#ifdef _WIN32
+    if (mapping->data) UnmapViewOfFile(mapping->data);
+    if (mapping->mapping) CloseHandle(mapping->mapping);
+    if (mapping->file != INVALID_HANDLE_VALUE) CloseHandle(mapping->file);
+#else
+    if (mapping->data) munmap(mapping->data, mapping->size);
+#endif
+    free(mapping);
+}
+
+/* maps the whole file, or returns NULL if it can't be done (empty files, too big for the address space, etc) */
+static mmap_mapping * open_mmap_mapping(const char * const filename) {
+    mmap_mapping * mapping = calloc(1, sizeof(mmap_mapping));
+    if (!mapping) return NULL;
+    mapping->refs = 1;
+
+#ifdef _WIN32
+    {
+        LARGE_INTEGER size;
+
+        mapping->file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (mapping->file == INVALID_HANDLE_VALUE) goto fail;
+        if (!GetFileSizeEx(mapping->file, &size) || size.QuadPart <= 0 || (uint64_t)size.QuadPart > (size_t)-1)
+            goto fail;
+        mapping->size = (size_t)size.QuadPart;
+
+        mapping->mapping = CreateFileMappingA(mapping->file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (!mapping->mapping) goto fail;
+        mapping->data = MapViewOfFile(mapping->mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!mapping->data) goto fail;
+    }
+#else
+    {
+        struct stat st;
+        void * data;
+        int fd = open(filename, O_RDONLY);
+        if (fd < 0) goto fail;
+
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0 || (uint64_t)st.st_size > (size_t)-1) {
+            close(fd);
+            goto fail;
+        }
+        mapping->size = (size_t)st.st_size;
+
+        data = mmap(NULL, mapping->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd); /* the mapping keeps the file */
+        if (data == MAP_FAILED) goto fail;
+        mapping->data = data;
+
+#ifdef MADV_RANDOM
+        /* detection reads small scattered headers, no need to read ahead until a view goes sequential */
+        madvise(mapping->data, mapping->size, MADV_RANDOM);
+#endif
+    }
+#endif
+
+    return mapping;
+
+fail:
+#ifdef _WIN32
+    if (!mapping->file) mapping->file = INVALID_HANDLE_VALUE;
+#endif
+    close_mmap_mapping(mapping);
+    return NULL;
+}
+
+/* asks the OS to prefetch data ahead of a view that is reading sequentially (ex. decoding a channel) */
+static void mmap_readahead(MMAPSTREAMFILE *streamfile) {
+#if !defined(_WIN32) && defined(MADV_WILLNEED)
+    static size_t page_size = 0;
+    off_t start, end;
+
+    if (streamfile->offset + MMAP_READAHEAD_SIZE/2 < streamfile->readahead_offset)
+        return; /* enough prefetched */
+
+    if (!page_size)
+        page_size = sysconf(_SC_PAGESIZE);
+
+    start = streamfile->offset > streamfile->readahead_offset ? streamfile->offset : streamfile->readahead_offset;
+    start -= start % page_size;
+    end = streamfile->offset + MMAP_READAHEAD_SIZE;
+    if (end > streamfile->mapping->size)
+        end = streamfile->mapping->size;
+    if (start >= end)
+        return;
+
+    madvise(streamfile->mapping->data + start, end - start, MADV_WILLNEED);
+    streamfile->readahead_offset = end;
+#endif
+}
+
+static void mmap_track_access(MMAPSTREAMFILE *streamfile, off_t offset) {
+    if (offset == streamfile->offset)
+        streamfile->sequential_reads++;
+    else
+        streamfile->sequential_reads = 0;
+}
+
+static size_t read_mmap(MMAPSTREAMFILE *streamfile, uint8_t * dest, off_t offset, size_t length) {
+    size_t filesize;
+
+    if (!streamfile || !dest || length<=0)
+        return 0;
+    filesize = streamfile->mapping->size;
+
+    /* request outside file */
+    if (offset < 0 || offset > filesize) {
+        streamfile->offset = filesize;
+        VGM_LOG_ONCE("ERROR: offset over filesize 0x%x @ 0x%lx + 0x%x (buggy meta?)\n", filesize, offset, length);
+        streamfile->error_count++;
+#if STREAMFILE_IGNORE_EOF
+        memset(dest,0,length);
+        return length; /* 0-set buffer */
+#else
+        return 0; /* nothing to read */
+#endif
+    }
+
+    mmap_track_access(streamfile, offset);
+
+    if (length > filesize - offset) {
+        size_t length_read = filesize - offset;
+        memcpy(dest, streamfile->mapping->data + offset, length_read);
+        streamfile->bytes_read += length_read;
+        streamfile->offset = filesize;
+        streamfile->error_count++;
+#if STREAMFILE_IGNORE_EOF
+        memset(dest + length_read,0,length - length_read);
+        return length; /* partially-read + 0-set buffer */
+#else
+        return length_read; /* partially-read buffer */
+#endif
+    }
+
+    memcpy(dest, streamfile->mapping->data + offset, length);
+    streamfile->bytes_read += length;
+    streamfile->offset = offset + length;
+
+    if (streamfile->sequential_reads >= MMAP_SEQUENTIAL_READS)
+        mmap_readahead(streamfile);
+
+    return length;
+}
+
+static const uint8_t * peek_mmap(MMAPSTREAMFILE *streamfile, off_t offset, size_t length, size_t * avail) {
+    size_t filesize = streamfile->mapping->size;
+
+    if (offset < 0 || offset >= filesize)
+        return NULL;
+
+    mmap_track_access(streamfile, offset);
+
+    *avail = filesize - offset;
+    if (length > *avail)
+        length = *avail;
+    streamfile->bytes_read += length;
+    streamfile->offset = offset + length;
+
+    if (streamfile->sequential_reads >= MMAP_SEQUENTIAL_READS)
+        mmap_readahead(streamfile);
+
+    return streamfile->mapping->data + offset;
+}
+
+static size_t get_size_mmap(MMAPSTREAMFILE * streamfile) {
+    return streamfile->mapping->size;
+}
+static off_t get_offset_mmap(MMAPSTREAMFILE *streamfile) {
+    return streamfile->offset;
+}
+static void get_name_mmap(MMAPSTREAMFILE *streamfile, char *buffer, size_t length) {
+    strncpy(buffer,streamfile->name,length);
+    buffer[length-1]='\0';
+}
+static size_t get_bytes_read_mmap(MMAPSTREAMFILE *streamfile) {
+    return streamfile->bytes_read;
+}
+static int get_error_count_mmap(MMAPSTREAMFILE *streamfile) {
+    return streamfile->error_count;
+}
+static void close_mmap(MMAPSTREAMFILE *streamfile) {
+    close_mmap_mapping(streamfile->mapping);
+    free(streamfile);
+}
+
+static STREAMFILE * open_mmap_streamfile_by_mapping(mmap_mapping * mapping, const char * const filename);
+
+static STREAMFILE *open_mmap(MMAPSTREAMFILE *streamfile, const char * const filename, size_t buffersize) {
+    if (!filename)
+        return NULL;
+
+    /* same file: new view of the current mapping */
+    if (!strcmp(streamfile->name,filename)) {
+        STREAMFILE * new_sf = open_mmap_streamfile_by_mapping(streamfile->mapping, filename);
+        if (new_sf) {
+            streamfile->mapping->refs++;
+            return new_sf;
+        }
+    }
+
+    return open_mmap_streamfile(filename);
+}
+
+static STREAMFILE * open_mmap_streamfile_by_mapping(mmap_mapping * mapping, const char * const filename) {
+    MMAPSTREAMFILE * this_sf = calloc(1,sizeof(MMAPSTREAMFILE));
+    if (!this_sf) return NULL;
+
+    this_sf->sf.read = (void*)read_mmap;
+    this_sf->sf.get_size = (void*)get_size_mmap;
+    this_sf->sf.get_offset = (void*)get_offset_mmap;
+    this_sf->sf.get_name = (void*)get_name_mmap;
+    this_sf->sf.get_realname = (void*)get_name_mmap;
+    this_sf->sf.open = (void*)open_mmap;
+    this_sf->sf.close = (void*)close_mmap;
+    this_sf->sf.get_bytes_read = (void*)get_bytes_read_mmap;
+    this_sf->sf.get_error_count = (void*)get_error_count_mmap;
+    this_sf->sf.peek = (void*)peek_mmap;
+
+    this_sf->mapping = mapping;
+    strncpy(this_sf->name,filename,sizeof(this_sf->name));
+    this_sf->name[sizeof(this_sf->name)-1] = '\0';
+
+    return &this_sf->sf;
+}
+
+STREAMFILE * open_mmap_streamfile(const char * filename) {
+    mmap_mapping * mapping;
+    STREAMFILE * streamFile;
+
+    if (dir_cache_find_file(filename) == 0)
+        return NULL;
+
+    mapping = open_mmap_mapping(filename);
+    if (!mapping) /* can't be mapped, but may be still readable */
+        return open_stdio_streamfile(filename);
+
+    streamFile = open_mmap_streamfile_by_mapping(mapping, filename);
+    if (!streamFile) {
+        close_mmap_mapping(mapping);
+        return NULL;
+    }
+
+    return streamFile;
+}
+
+/* **************************************************** */
+
+/* A STREAMFILE that reads with positioned reads (pread, or ReadFile with an offset) from a file
+ * descriptor shared by all files opened with the same name. There is no shared file position, so
+ * each STREAMFILE (reader) only keeps its own buffer, and readers of the same file can be used
+ * from different threads at the same time. A single reader still can't be shared between threads. */
+
+typedef struct {
+#ifdef _WIN32
+    HANDLE file;
+#else
+    int fd;
+#endif
+    size_t size;
+    int refs;               /* under pread_file_lock, as readers may be closed from any thread */
+} pread_file;
+
+typedef struct {
+    STREAMFILE sf;          /* callbacks */
+    pread_file * file;      /* shared by readers */
+    char name[PATH_LIMIT];
+    off_t offset;           /* buffer offset */
+    size_t validsize;       /* current buffer size */
+    uint8_t * buffer;       /* data buffer */
+    size_t buffersize;      /* max buffer size */
+    size_t bytes_read;      /* counters */
+    int error_count;
+} PREADSTREAMFILE;
+
+#ifdef _WIN32
+static volatile LONG pread_file_lock = 0;
+static void pread_file_lock_enter(void) { while (InterlockedCompareExchange(&pread_file_lock, 1, 0) != 0) Sleep(0); }
+static void pread_file_lock_leave(void) { InterlockedExchange(&pread_file_lock, 0); }
+#else
+static pthread_mutex_t pread_file_lock = PTHREAD_MUTEX_INITIALIZER;
+static void pread_file_lock_enter(void) { pthread_mutex_lock(&pread_file_lock); }
+static void pread_file_lock_leave(void) { pthread_mutex_unlock(&pread_file_lock); }
+#endif
+
+static void close_pread_file(pread_file * file) {
+    int refs;
+
+    pread_file_lock_enter();
+    refs = --file->refs;
+    pread_file_lock_leave();
+    if (refs > 0)
+        return;
+
+#ifdef _WIN32
+    CloseHandle(file->file);
+#else
+    close(file->fd);
+#endif
+    free(file);
+}
+
+static pread_file * open_pread_file(const char * const filename) {
+    pread_file * file = calloc(1, sizeof(pread_file));
+    if (!file) return NULL;
+    file->refs = 1;
+
+#ifdef _WIN32
+    {
+        LARGE_INTEGER size;
+
+        file->file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file->file == INVALID_HANDLE_VALUE) goto fail;
+        if (!GetFileSizeEx(file->file, &size)) {
+            CloseHandle(file->file);
+            goto fail;
+        }
+        file->size = (size_t)size.QuadPart;
+    }
+#else
+    {
+        struct stat st;
+
+        file->fd = open(filename, O_RDONLY);
+        if (file->fd < 0) goto fail;
+        if (fstat(file->fd, &st) != 0 || S_ISDIR(st.st_mode)) {
+            close(file->fd);
+            goto fail;
+        }
+        file->size = (size_t)st.st_size;
+    }
+#endif
+
+    return file;
+
+fail:
+    free(file);
+    return NULL;
+}
+
+/* positioned read from the shared file, returns bytes read (-1 on errors) */
+static int64_t pread_file_read(pread_file * file, uint8_t * dest, off_t offset, size_t length) {
+#ifdef _WIN32
+    OVERLAPPED ov;
+    DWORD length_read = 0;
+
+    memset(&ov, 0, sizeof(OVERLAPPED));
+    ov.Offset = (DWORD)((uint64_t)offset & 0xFFFFFFFF);
+    ov.OffsetHigh = (DWORD)((uint64_t)offset >> 32);
+    if (!ReadFile(file->file, dest, (DWORD)length, &length_read, &ov)) {
+        if (GetLastError() != ERROR_HANDLE_EOF)
+            return -1;
+    }
+    return length_read;
+#else
+    size_t length_read_total = 0;
+
+    while (length_read_total < length) {
+        ssize_t length_read = pread(file->fd, dest + length_read_total, length - length_read_total, offset + length_read_total);
+        if (length_read < 0)
+            return -1;
+        if (length_read == 0)
+            break; /* EOF */
+        length_read_total += length_read;
+    }
+    return length_read_total;
+#endif
+}
+
+static size_t read_pread(PREADSTREAMFILE *streamfile, uint8_t * dest, off_t offset, size_t length) {
+    size_t filesize, length_read_total = 0;
+
+    if (!streamfile || !dest || length<=0)
+        return 0;
+    filesize = streamfile->file->size;
+
+    /* request outside file: ignore to avoid reading */
+    if (offset < 0 || offset > filesize) {
+        streamfile->offset = filesize;
+        streamfile->validsize = 0;
+        VGM_LOG_ONCE("ERROR: offset over filesize 0x%x @ 0x%lx + 0x%x (buggy meta?)\n", filesize, offset, length);
+        streamfile->error_count++;
+#if STREAMFILE_IGNORE_EOF
+        memset(dest,0,length);
+        return length; /* 0-set buffer */
+#else
+        return 0; /* nothing to read */
+#endif
+    }
+
+    /* use what's in the buffer */
+    if (offset >= streamfile->offset && offset < streamfile->offset + streamfile->validsize) {
+        off_t offset_into_buffer = offset - streamfile->offset;
+        size_t length_read = streamfile->validsize - offset_into_buffer;
+        if (length_read > length)
+            length_read = length;
+
+        memcpy(dest, streamfile->buffer + offset_into_buffer, length_read);
+        length_read_total += length_read;
+        length -= length_read;
+        offset += length_read;
+        dest += length_read;
+    }
+
+    if (length > 0) {
+        int64_t length_read;
+
+        if (length >= streamfile->buffersize) {
+            /* big reads go straight to dest */
+            length_read = pread_file_read(streamfile->file, dest, offset, length);
+            if (length_read < 0) length_read = 0;
+            streamfile->bytes_read += length_read;
+            streamfile->sf.stats.bytes_read += length_read;
+            streamfile->offset = offset + length_read;
+            streamfile->validsize = 0;
+        }
+        else {
+            length_read = pread_file_read(streamfile->file, streamfile->buffer, offset, streamfile->buffersize);
+            if (length_read < 0) length_read = 0;
+            streamfile->bytes_read += length_read;
+            streamfile->sf.stats.bytes_read += length_read;
+            streamfile->offset = offset;
+            streamfile->validsize = length_read;
+            if (streamfile->validsize == 0)
+                streamfile->offset = filesize;
+
+            if (length_read > length)
+                length_read = length;
+            memcpy(dest, streamfile->buffer, length_read);
+        }
+
+        length_read_total += length_read;
+        if (length_read < length) {
+            streamfile->error_count++;
+#if STREAMFILE_IGNORE_EOF
+            memset(dest + length_read,0,length - length_read);
+            return length_read_total + (length - length_read); /* partially-read + 0-set buffer */
+#endif
+        }
+    }
+
+    return length_read_total;
+}
+
+static const uint8_t * peek_pread(PREADSTREAMFILE *streamfile, off_t offset, size_t length, size_t * avail) {
+    off_t offset_into_buffer;
+
+    /* not in the buffer: refill from offset, as a read would */
+    if (!(offset >= streamfile->offset && offset < streamfile->offset + streamfile->validsize)) {
+        int64_t length_read;
+
+        if (offset < 0 || offset >= streamfile->file->size || length > streamfile->buffersize)
+            return NULL;
+
+        length_read = pread_file_read(streamfile->file, streamfile->buffer, offset, streamfile->buffersize);
+        if (length_read <= 0) {
+            streamfile->validsize = 0;
+            streamfile->error_count++;
+            return NULL;
+        }
+        streamfile->bytes_read += length_read;
+        streamfile->sf.stats.bytes_read += length_read;
+        streamfile->offset = offset;
+        streamfile->validsize = length_read;
+    }
+
+    offset_into_buffer = offset - streamfile->offset;
+    *avail = streamfile->validsize - offset_into_buffer;
+    return streamfile->buffer + offset_into_buffer;
+}
+
+static size_t get_size_pread(PREADSTREAMFILE * streamfile) {
+    return streamfile->file->size;
+}
+static off_t get_offset_pread(PREADSTREAMFILE *streamfile) {
+    return streamfile->offset;
+}
+static void get_name_pread(PREADSTREAMFILE *streamfile, char *buffer, size_t length) {
+    strncpy(buffer,streamfile->name,length);
+    buffer[length-1]='\0';
+}
+static size_t get_bytes_read_pread(PREADSTREAMFILE *streamfile) {
+    return streamfile->bytes_read;
+}
+static int get_error_count_pread(PREADSTREAMFILE *streamfile) {
+    return streamfile->error_count;
+}
+static void close_pread(PREADSTREAMFILE *streamfile) {
+    close_pread_file(streamfile->file);
+    free(streamfile->buffer);
+    free(streamfile);
+}
+
+static STREAMFILE * open_pread_streamfile_by_file(pread_file * file, const char * const filename, size_t buffersize);
+
+static STREAMFILE *open_pread(PREADSTREAMFILE *streamfile, const char * const filename, size_t buffersize) {
+    if (!filename)
+        return NULL;
+
+    /* same file: new reader of the current descriptor */
+    if (!strcmp(streamfile->name,filename)) {
+        STREAMFILE * new_sf;
+
+        pread_file_lock_enter();
+        streamfile->file->refs++;
+        pread_file_lock_leave();
+
+        new_sf = open_pread_streamfile_by_file(streamfile->file, filename, buffersize);
+        if (new_sf)
+            return new_sf;
+        close_pread_file(streamfile->file);
+    }
+
+    return open_pread_streamfile_buffer(filename, buffersize);
+}
+
+static STREAMFILE * open_pread_streamfile_by_file(pread_file * file, const char * const filename, size_t buffersize) {
+    PREADSTREAMFILE * this_sf;
+
+    if (!buffersize)
+        buffersize = STREAMFILE_DEFAULT_BUFFER_SIZE;
+
+    this_sf = calloc(1,sizeof(PREADSTREAMFILE));
+    if (!this_sf) return NULL;
+
+    this_sf->buffer = malloc(buffersize);
+    if (!this_sf->buffer) {
+        free(this_sf);
+        return NULL;
+    }
+    this_sf->buffersize = buffersize;
+
+    this_sf->sf.read = (void*)read_pread;
+    this_sf->sf.get_size = (void*)get_size_pread;
+    this_sf->sf.get_offset = (void*)get_offset_pread;
+    this_sf->sf.get_name = (void*)get_name_pread;
+    this_sf->sf.get_realname = (void*)get_name_pread;
+    this_sf->sf.open = (void*)open_pread;
+    this_sf->sf.close = (void*)close_pread;
+    this_sf->sf.get_bytes_read = (void*)get_bytes_read_pread;
+    this_sf->sf.get_error_count = (void*)get_error_count_pread;
+    this_sf->sf.peek = (void*)peek_pread;
+
+    this_sf->file = file;
+    strncpy(this_sf->name,filename,sizeof(this_sf->name));
+    this_sf->name[sizeof(this_sf->name)-1] = '\0';
+
+    return &this_sf->sf;
+}
+
+static STREAMFILE * open_pread_streamfile_buffer(const char * const filename, size_t buffersize) {
+    pread_file * file;
+    STREAMFILE * streamFile;
+
+    if (dir_cache_find_file(filename) == 0)
+        return NULL;
+
+    file = open_pread_file(filename);
+    if (!file) return NULL;
+
+    streamFile = open_pread_streamfile_by_file(file, filename, buffersize);
+    if (!streamFile) {
+        close_pread_file(file);
+        return NULL;
+    }
+
+    return streamFile;
+}
+
+STREAMFILE * open_pread_streamfile(const char * filename) {
+    return open_pread_streamfile_buffer(filename,STREAMFILE_DEFAULT_BUFFER_SIZE);
+}
+
+
+/* **************************************************** */
+
+/* A STREAMFILE that reads straight from a caller-owned buffer. Opening the same name returns
+ * another view of the buffer; other names (companion files) go through an optional resolver. */
+typedef struct {
+    STREAMFILE sf;          /* callbacks */
+    const uint8_t * buf;    /* not owned */
+    size_t size;
+    char name[PATH_LIMIT];
+    off_t offset;           /* current offset (end of last read) */
+    memory_streamfile_resolver resolver;
+    void * resolver_data;
+    size_t bytes_read;      /* counters */
+    int error_count;
+} MEMORYSTREAMFILE;
+
+static size_t read_memory(MEMORYSTREAMFILE *streamfile, uint8_t * dest, off_t offset, size_t length) {
+    size_t length_read;
+
+    if (!streamfile || !dest || length<=0)
+        return 0;
+
+    if (offset < 0 || offset > streamfile->size) {
+        streamfile->offset = streamfile->size;
+        VGM_LOG_ONCE("ERROR: offset over filesize 0x%x @ 0x%lx + 0x%x (buggy meta?)\n", streamfile->size, offset, length);
+        streamfile->error_count++;
+#if STREAMFILE_IGNORE_EOF
+        memset(dest,0,length);
+        return length; /* 0-set buffer */
+#else
+        return 0; /* nothing to read */
+#endif
+    }
+
+    length_read = length;
+    if (length_read > streamfile->size - offset) {
+        length_read = streamfile->size - offset;
+        streamfile->error_count++;
+    }
+
+    memcpy(dest, streamfile->buf + offset, length_read);
+    streamfile->bytes_read += length_read;
+    streamfile->offset = offset + length_read;
+
+#if STREAMFILE_IGNORE_EOF
+    memset(dest + length_read,0,length - length_read);
+    return length; /* partially-read + 0-set buffer */
+#else
+    return length_read;
+#endif
+}
+static const uint8_t * peek_memory(MEMORYSTREAMFILE *streamfile, off_t offset, size_t length, size_t * avail) {
+    if (offset < 0 || offset >= streamfile->size)
+        return NULL;
+
+    *avail = streamfile->size - offset;
+    if (length > *avail)
+        length = *avail;
+    streamfile->bytes_read += length;
+    streamfile->offset = offset + length;
+    return streamfile->buf + offset;
+}
+static size_t get_size_memory(MEMORYSTREAMFILE * streamfile) {
+    return streamfile->size;
+}
+static off_t get_offset_memory(MEMORYSTREAMFILE *streamfile) {
+    return streamfile->offset;
+}
+static void get_name_memory(MEMORYSTREAMFILE *streamfile, char *buffer, size_t length) {
+    strncpy(buffer,streamfile->name,length);
+    buffer[length-1]='\0';
+}
+static size_t get_bytes_read_memory(MEMORYSTREAMFILE *streamfile) {
+    return streamfile->bytes_read;
+}
+static int get_error_count_memory(MEMORYSTREAMFILE *streamfile) {
+    return streamfile->error_count;
+}
+static void close_memory(MEMORYSTREAMFILE *streamfile) {
+    free(streamfile);
+}
+static STREAMFILE *open_memory(MEMORYSTREAMFILE *streamfile, const char * const filename, size_t buffersize) {
+    if (!filename)
+        return NULL;
+
+    if (!strcmp(streamfile->name,filename))
+        return open_memory_streamfile_by_resolver(streamfile->buf, streamfile->size, filename, streamfile->resolver, streamfile->resolver_data);
+
+    if (!streamfile->resolver)
+        return NULL;
+    return streamfile->resolver(streamfile->resolver_data, filename);
+}
+
+STREAMFILE * open_memory_streamfile_by_resolver(const uint8_t * buf, size_t size, const char * name, memory_streamfile_resolver resolver, void * resolver_data) {
+    MEMORYSTREAMFILE * this_sf;
+
+    if (!buf && size)
+        return NULL;
+    if (!name)
+        name = "";
+
+    this_sf = calloc(1,sizeof(MEMORYSTREAMFILE));
+    if (!this_sf) return NULL;
+
+    this_sf->sf.read = (void*)read_memory;
+    this_sf->sf.get_size = (void*)get_size_memory;
+    this_sf->sf.get_offset = (void*)get_offset_memory;
+    this_sf->sf.get_name = (void*)get_name_memory;
+    this_sf->sf.get_realname = (void*)get_name_memory;
+    this_sf->sf.open = (void*)open_memory;
+    this_sf->sf.close = (void*)close_memory;
+    this_sf->sf.get_bytes_read = (void*)get_bytes_read_memory;
+    this_sf->sf.get_error_count = (void*)get_error_count_memory;
+    this_sf->sf.peek = (void*)peek_memory;
+
+    this_sf->buf = buf;
+    this_sf->size = size;
+    this_sf->resolver = resolver;
+    this_sf->resolver_data = resolver_data;
+    strncpy(this_sf->name,name,sizeof(this_sf->name));
+    this_sf->name[sizeof(this_sf->name)-1] = '\0';
+
+    return &this_sf->sf;
+}
+
+STREAMFILE * open_memory_streamfile(const uint8_t * buf, size_t size, const char * name) {
+    return open_memory_streamfile_by_resolver(buf, size, name, NULL, NULL);
+}
+
+/* **************************************************** */
+
+/* A STREAMFILE that reads through a size-bounded LRU cache of fixed-size pages of another
+ * STREAMFILE. Opening the same name returns another view (with its own position) over the same
+ * cache, so channels reading the same file share pages and a single underlying file. Views of one
+ * cache are expected to be used from one thread at a time, like the VGMSTREAM that owns them. */
+
+#define PAGE_CACHE_PAGE_SIZE STREAMFILE_PAGE_CACHE_PAGE_SIZE
+#define PAGE_CACHE_MIN_PAGES 4
+
+typedef struct {
+    off_t offset;           /* page start, or -1 if unused */
+    size_t size;            /* valid bytes (less than a page at EOF) */
+    int prev;               /* LRU list (most recent first) */
+    int next;
+    int hash_next;          /* next page in bucket */
+} page_cache_page;
+
+typedef struct {
+    STREAMFILE *inner_sf;   /* owned */
+    size_t filesize;
+    int refs;
+    uint8_t * data;         /* page_count pages */
+    page_cache_page * pages;
+    int page_count;
+    int * buckets;          /* hash of page index to pages, or -1 */
+    int bucket_mask;
+    int lru_head;
+    int lru_tail;
+    size_t bytes_read;      /* counters */
+    int error_count;
+} page_cache;
+
+typedef struct {
+    STREAMFILE sf;          /* callbacks */
+    page_cache * cache;     /* shared by views */
+    off_t offset;           /* current offset (end of last read) */
+    int last_page;          /* last used page, checked first */
+    int error_count;        /* this view's, as views of a cache are counted separately */
+} PAGECACHESTREAMFILE;
+
+static int page_cache_bucket(page_cache * cache, off_t page_offset) {
+    return (int)((uint32_t)(page_offset / PAGE_CACHE_PAGE_SIZE) * 2654435761u) & cache->bucket_mask;
+}
+
+static void page_cache_unlink(page_cache * cache, int page) {
+    page_cache_page * p = &cache->pages[page];
+    if (p->prev >= 0) cache->pages[p->prev].next = p->next;
+    else cache->lru_head = p->next;
+    if (p->next >= 0) cache->pages[p->next].prev = p->prev;
+    else cache->lru_tail = p->prev;
+}
+
+static void page_cache_touch(page_cache * cache, int page) {
+    page_cache_page * p = &cache->pages[page];
+    if (cache->lru_head == page)
+        return;
+    page_cache_unlink(cache, page);
+    p->prev = -1;
+    p->next = cache->lru_head;
+    cache->pages[cache->lru_head].prev = page;
+    cache->lru_head = page;
+}
+
+/* returns the page with this offset, loading it over the least recently used one if needed */
+static int page_cache_get(page_cache * cache, off_t page_offset) {
+    int page, bucket = page_cache_bucket(cache, page_offset);
+    int * link;
+
+    for (page = cache->buckets[bucket]; page >= 0; page = cache->pages[page].hash_next) {
+        if (cache->pages[page].offset == page_offset) {
+            page_cache_touch(cache, page);
+            return page;
+        }
+    }
+
+    /* evict */
+    page = cache->lru_tail;
+    if (cache->pages[page].offset >= 0) {
+        link = &cache->buckets[page_cache_bucket(cache, cache->pages[page].offset)];
+        while (*link != page)
+            link = &cache->pages[*link].hash_next;
+        *link = cache->pages[page].hash_next;
+    }
+
+    /* load */
+    {
+        size_t to_read = PAGE_CACHE_PAGE_SIZE;
+        if (page_offset + to_read > cache->filesize)
+            to_read = cache->filesize - page_offset;
+        cache->pages[page].offset = page_offset;
+        cache->pages[page].size = read_streamfile(cache->data + (size_t)page * PAGE_CACHE_PAGE_SIZE, page_offset, to_read, cache->inner_sf);
+        cache->bytes_read += cache->pages[page].size;
+        if (cache->pages[page].size < to_read)
+            cache->error_count++;
+    }
+
+    cache->pages[page].hash_next = cache->buckets[bucket];
+    cache->buckets[bucket] = page;
+    page_cache_touch(cache, page);
+    return page;
+}
+
+static void close_page_cache(page_cache * cache) {
+    if (!cache) return;
+    cache->refs--;
+    if (cache->refs > 0)
+        return;
+
+    if (cache->inner_sf) close_streamfile(cache->inner_sf);
+    free(cache->data);
+    free(cache->pages);
+    free(cache->buckets);
+    free(cache);
+}
+
+/* finds the page for this view, counting filled pages (and their errors) into the view's stats */
+static int get_page_cache_page(PAGECACHESTREAMFILE *streamfile, off_t page_offset) {
+    page_cache * cache = streamfile->cache;
+    int page = streamfile->last_page;
+
+    if (page < 0 || cache->pages[page].offset != page_offset) {
+        size_t bytes_read = cache->bytes_read;
+        int error_count = cache->error_count;
+        page = page_cache_get(cache, page_offset);
+        streamfile->last_page = page;
+        streamfile->sf.stats.bytes_read += cache->bytes_read - bytes_read;
+        streamfile->error_count += cache->error_count - error_count;
+    }
+    return page;
+}
+
+static size_t read_page_cache(PAGECACHESTREAMFILE *streamfile, uint8_t * dest, off_t offset, size_t length) {
+    page_cache * cache;
+    size_t length_read_total = 0;
+
+    if (!streamfile || !dest || length<=0)
+        return 0;
+    cache = streamfile->cache;
+
+    if (offset < 0 || offset > cache->filesize) {
+        streamfile->offset = cache->filesize;
+        VGM_LOG_ONCE("ERROR: offset over filesize 0x%x @ 0x%lx + 0x%x (buggy meta?)\n", cache->filesize, offset, length);
+        streamfile->error_count++;
+#if STREAMFILE_IGNORE_EOF
+        memset(dest,0,length);
+        return length; /* 0-set buffer */
+#else
+        return 0; /* nothing to read */
+#endif
+    }
+
+    while (length > 0 && offset < cache->filesize) {
+        off_t page_offset = offset - (offset % PAGE_CACHE_PAGE_SIZE);
+        size_t offset_into_page = offset - page_offset;
+        size_t length_page;
+        int page = get_page_cache_page(streamfile, page_offset);
+
+        if (offset_into_page >= cache->pages[page].size)
+            break; /* read error */
+        length_page = cache->pages[page].size - offset_into_page;
+        if (length_page > length)
+            length_page = length;
+
+        memcpy(dest, cache->data + (size_t)page * PAGE_CACHE_PAGE_SIZE + offset_into_page, length_page);
+        length_read_total += length_page;
+        length -= length_page;
+        offset += length_page;
+        dest += length_page;
+    }
+    streamfile->offset = offset;
+
+    if (length > 0) {
+        streamfile->error_count++;
+#if STREAMFILE_IGNORE_EOF
+        memset(dest,0,length);
+        return length_read_total + length; /* partially-read + 0-set buffer */
+#endif
+    }
+    return length_read_total;
+}
+static const uint8_t * peek_page_cache(PAGECACHESTREAMFILE *streamfile, off_t offset, size_t length, size_t * avail) {
+    page_cache * cache = streamfile->cache;
+    off_t page_offset;
+    size_t offset_into_page;
+    int page;
+
+    if (offset < 0 || offset >= cache->filesize)
+        return NULL;
+
+    page_offset = offset - (offset % PAGE_CACHE_PAGE_SIZE);
+    offset_into_page = offset - page_offset;
+    page = get_page_cache_page(streamfile, page_offset);
+
+    if (offset_into_page >= cache->pages[page].size)
+        return NULL; /* read error */
+    *avail = cache->pages[page].size - offset_into_page;
+    streamfile->offset = offset + (length < *avail ? length : *avail);
+    return cache->data + (size_t)page * PAGE_CACHE_PAGE_SIZE + offset_into_page;
+}
+static size_t get_size_page_cache(PAGECACHESTREAMFILE * streamfile) {
+    return streamfile->cache->filesize;
+}
+static off_t get_offset_page_cache(PAGECACHESTREAMFILE *streamfile) {
+    return streamfile->offset;
+}
+static void get_name_page_cache(PAGECACHESTREAMFILE *streamfile, char *buffer, size_t length) {
+    streamfile->cache->inner_sf->get_name(streamfile->cache->inner_sf, buffer, length);
+}
+static void get_realname_page_cache(PAGECACHESTREAMFILE *streamfile, char *buffer, size_t length) {
+    streamfile->cache->inner_sf->get_realname(streamfile->cache->inner_sf, buffer, length);
+}
+static size_t get_bytes_read_page_cache(PAGECACHESTREAMFILE *streamfile) {
+    return streamfile->cache->bytes_read;
+}
+static int get_error_count_page_cache(PAGECACHESTREAMFILE *streamfile) {
+    return streamfile->error_count;
+}
+static void close_page_cache_sf(PAGECACHESTREAMFILE *streamfile) {
+    close_page_cache(streamfile->cache);
+    free(streamfile);
+}
+
+static STREAMFILE * open_page_cache_view(page_cache * cache);
+
+static STREAMFILE *open_page_cache(PAGECACHESTREAMFILE *streamfile, const char * const filename, size_t buffersize) {
+    char name[PATH_LIMIT];
+
+    if (!filename)
+        return NULL;
+
+    /* same file: new view of the current cache */
+    streamfile->cache->inner_sf->get_name(streamfile->cache->inner_sf, name, sizeof(name));
+    if (!strcmp(name,filename))
+        return open_page_cache_view(streamfile->cache);
+
+    /* companion files aren't cached */
+    return streamfile->cache->inner_sf->open(streamfile->cache->inner_sf, filename, buffersize);
+}
+
+static STREAMFILE * open_page_cache_view(page_cache * cache) {
+    PAGECACHESTREAMFILE * this_sf = calloc(1,sizeof(PAGECACHESTREAMFILE));
+    if (!this_sf) return NULL;
+
+    this_sf->sf.read = (void*)read_page_cache;
+    this_sf->sf.get_size = (void*)get_size_page_cache;
+    this_sf->sf.get_offset = (void*)get_offset_page_cache;
+    this_sf->sf.get_name = (void*)get_name_page_cache;
+    this_sf->sf.get_realname = (void*)get_realname_page_cache;
+    this_sf->sf.open = (void*)open_page_cache;
+    this_sf->sf.close = (void*)close_page_cache_sf;
+    this_sf->sf.get_bytes_read = (void*)get_bytes_read_page_cache;
+    this_sf->sf.get_error_count = (void*)get_error_count_page_cache;
+    this_sf->sf.peek = (void*)peek_page_cache;
+    this_sf->sf.stream_index = cache->inner_sf->stream_index;
+    this_sf->sf.info_only = cache->inner_sf->info_only;
+
+    this_sf->cache = cache;
+    this_sf->last_page = -1;
+    cache->refs++;
+
+    return &this_sf->sf;
+}
+
+STREAMFILE * open_page_cache_streamfile(STREAMFILE *streamFile, size_t cache_size) {
+    page_cache * cache = NULL;
+    STREAMFILE * new_sf;
+    int i, bucket_count;
+
+    if (!streamFile)
+        return NULL;
+
+    cache = calloc(1, sizeof(page_cache));
+    if (!cache) goto fail;
+
+    cache->page_count = cache_size / PAGE_CACHE_PAGE_SIZE;
+    if (cache->page_count < PAGE_CACHE_MIN_PAGES)
+        cache->page_count = PAGE_CACHE_MIN_PAGES;
+    for (bucket_count = 1; bucket_count < cache->page_count * 2; bucket_count *= 2)
+        ;
+    cache->bucket_mask = bucket_count - 1;
+
+    cache->data = malloc((size_t)cache->page_count * PAGE_CACHE_PAGE_SIZE);
+    cache->pages = calloc(cache->page_count, sizeof(page_cache_page));
+    cache->buckets = malloc(bucket_count * sizeof(int));
+    if (!cache->data || !cache->pages || !cache->buckets) goto fail;
+
+    for (i = 0; i < bucket_count; i++) {
+        cache->buckets[i] = -1;
+    }
+    for (i = 0; i < cache->page_count; i++) {
+        cache->pages[i].offset = -1;
+        cache->pages[i].prev = i - 1;
+        cache->pages[i].next = (i + 1 < cache->page_count) ? i + 1 : -1;
+        cache->pages[i].hash_next = -1;
+    }
+    cache->lru_head = 0;
+    cache->lru_tail = cache->page_count - 1;
+
+    cache->inner_sf = streamFile;
+    cache->filesize = get_streamfile_size(streamFile);
+
+    new_sf = open_page_cache_view(cache);
+    if (!new_sf) goto fail; /* not owned until here */
+    return new_sf;
+
+fail:
+    if (cache) {
+        free(cache->data);
+        free(cache->pages);
+        free(cache->buckets);
+        free(cache);
+    }
+    return NULL;
+}
+
+/* **************************************************** */
+
+/* Transform STREAMFILE: decrypts another STREAMFILE into its own buffer as it's refilled, so each
+ * byte is transformed once no matter how many times (or how small) it's read afterwards. */
+
+typedef struct {
+    STREAMFILE sf;
+
+    STREAMFILE * inner_sf;
+    streamfile_transform transform; /* key points to own copy */
+    size_t filesize;
+    off_t offset;           /* last read end, for get_offset */
+
+    uint8_t * buffer;
+    size_t buffersize;
+    off_t buffer_offset;    /* file offset of buffer[0] */
+    size_t validsize;
+} TRANSFORMSTREAMFILE;
+
+/* kernels work on 64-bit words, which compilers also vectorize */
+static uint64_t transform_pattern(uint8_t value) {
+    uint64_t pattern = value;
+    pattern |= pattern << 8;
+    pattern |= pattern << 16;
+    pattern |= pattern << 32;
+    return pattern;
+}
+
+static void transform_xor(uint8_t * buf, size_t length, uint8_t value) {
+    uint64_t pattern = transform_pattern(value);
+    size_t i;
+
+    for (i = 0; i + 8 <= length; i += 8) {
+        uint64_t word;
+        memcpy(&word, buf + i, 8);
+        word ^= pattern;
+        memcpy(buf + i, &word, 8);
+    }
+    for (; i < length; i++) {
+        buf[i] ^= value;
+    }
+}
+
+static void transform_add(uint8_t * buf, size_t length, uint8_t value) {
+    uint64_t pattern = transform_pattern(value);
+    uint64_t high = transform_pattern(0x80);
+    size_t i;
+
+    /* add per byte: low 7 bits without carry into the next byte, then the top bit */
+    for (i = 0; i + 8 <= length; i += 8) {
+        uint64_t word;
+        memcpy(&word, buf + i, 8);
+        word = ((word & ~high) + (pattern & ~high)) ^ ((word ^ pattern) & high);
+        memcpy(buf + i, &word, 8);
+    }
+    for (; i < length; i++) {
+        buf[i] += value;
+    }
+}
+
+static void transform_xor_key(uint8_t * buf, size_t length, const uint8_t * key, size_t key_size, size_t key_pos) {
+    size_t i;
+
+    key_pos = key_pos % key_size;
+    for (i = 0; i < length; i++) {
+        buf[i] ^= key[key_pos];
+        if (++key_pos == key_size)
+            key_pos = 0;
+    }
+}
+
+static void transform_xor_offset(uint8_t * buf, size_t length, uint8_t value, size_t pos) {
+    size_t i;
+
+    for (i = 0; i < length; i++) {
+        buf[i] ^= (uint8_t)(pos + i + value);
+    }
+}
+
+/* applies the transform to the part of buf (with data at offset) that is inside the transform's range */
+static void transform_buffer(const streamfile_transform * transform, uint8_t * buf, off_t offset, size_t length) {
+    off_t start = offset, end = offset + length;
+
+    if (start < transform->start)
+        start = transform->start;
+    if (transform->size && end > transform->start + (off_t)transform->size)
+        end = transform->start + transform->size;
+    if (start >= end)
+        return;
+
+    buf += start - offset;
+    length = end - start;
+    switch (transform->type) {
+        case STREAMFILE_TRANSFORM_XOR:
+            transform_xor(buf, length, transform->value);
+            break;
+        case STREAMFILE_TRANSFORM_ADD:
+            transform_add(buf, length, transform->value);
+            break;
+        case STREAMFILE_TRANSFORM_XOR_KEY:
+            transform_xor_key(buf, length, transform->key, transform->key_size, start - transform->start);
+            break;
+        case STREAMFILE_TRANSFORM_XOR_OFFSET:
+            transform_xor_offset(buf, length, transform->value, start - transform->start);
+            break;
+        default:
+            break;
+    }
+}
+
+static int fill_transform(TRANSFORMSTREAMFILE *streamfile, off_t offset) {
+    streamfile->buffer_offset = offset;
+    streamfile->validsize = read_streamfile(streamfile->buffer, offset, streamfile->buffersize, streamfile->inner_sf);
+    streamfile->sf.stats.bytes_read += streamfile->validsize;
+    transform_buffer(&streamfile->transform, streamfile->buffer, offset, streamfile->validsize);
+    return streamfile->validsize > 0;
+}
+
+static size_t read_transform(TRANSFORMSTREAMFILE *streamfile, uint8_t * dest, off_t offset, size_t length) {
+    size_t length_read_total = 0;
+
+    if (!streamfile || !dest || length<=0)
+        return 0;
+
+    if (offset < 0 || offset >= streamfile->filesize) {
+        streamfile->offset = streamfile->filesize;
+        return read_streamfile(dest, offset, length, streamfile->inner_sf); /* let the inner file log/0-set */
+    }
+
+    while (length > 0) {
+        size_t length_to_read;
+
+        if (!(offset >= streamfile->buffer_offset && offset < streamfile->buffer_offset + streamfile->validsize)) {
+            /* big reads don't go through the buffer */
+            if (length >= streamfile->buffersize) {
+                size_t length_read = read_streamfile(dest, offset, length, streamfile->inner_sf);
+                streamfile->sf.stats.bytes_read += length_read;
+                transform_buffer(&streamfile->transform, dest, offset, length_read);
+                length_read_total += length_read;
+                offset += length_read;
+                break;
+            }
+
+            if (!fill_transform(streamfile, offset))
+                break;
+        }
+
+        length_to_read = streamfile->validsize - (offset - streamfile->buffer_offset);
+        if (length_to_read > length)
+            length_to_read = length;
+        memcpy(dest, streamfile->buffer + (offset - streamfile->buffer_offset), length_to_read);
+        length_read_total += length_to_read;
+        length -= length_to_read;
+        dest += length_to_read;
+        offset += length_to_read;
+    }
+
+    streamfile->offset = offset;
+    return length_read_total;
+}
+static const uint8_t * peek_transform(TRANSFORMSTREAMFILE *streamfile, off_t offset, size_t length, size_t * avail) {
+    if (!(offset >= streamfile->buffer_offset && offset < streamfile->buffer_offset + streamfile->validsize)) {
+        if (offset < 0 || offset >= streamfile->filesize || length > streamfile->buffersize)
+            return NULL;
+        if (!fill_transform(streamfile, offset))
+            return NULL;
+    }
+
+    *avail = streamfile->validsize - (offset - streamfile->buffer_offset);
+    streamfile->offset = offset + (length < *avail ? length : *avail);
+    return streamfile->buffer + (offset - streamfile->buffer_offset);
+}
+static size_t get_size_transform(TRANSFORMSTREAMFILE * streamfile) {
+    return streamfile->filesize;
+}
+static off_t get_offset_transform(TRANSFORMSTREAMFILE *streamfile) {
+    return streamfile->offset;
+}
+static void get_name_transform(TRANSFORMSTREAMFILE *streamfile, char *buffer, size_t length) {
+    streamfile->inner_sf->get_name(streamfile->inner_sf, buffer, length);
+}
+static void get_realname_transform(TRANSFORMSTREAMFILE *streamfile, char *buffer, size_t length) {
+    streamfile->inner_sf->get_realname(streamfile->inner_sf, buffer, length);
+}
+static size_t get_bytes_read_transform(TRANSFORMSTREAMFILE *streamfile) {
+    return get_streamfile_bytes_read(streamfile->inner_sf);
+}
+static int get_error_count_transform(TRANSFORMSTREAMFILE *streamfile) {
+    return get_streamfile_error_count(streamfile->inner_sf);
+}
+static void close_transform(TRANSFORMSTREAMFILE *streamfile) {
+    close_streamfile(streamfile->inner_sf);
+    free((void*)streamfile->transform.key);
+    free(streamfile->buffer);
+    free(streamfile);
+}
+
+static STREAMFILE *open_transform(TRANSFORMSTREAMFILE *streamfile, const char * const filename, size_t buffersize) {
+    char name[PATH_LIMIT];
+    STREAMFILE * new_inner_sf;
+    STREAMFILE * new_sf;
+
+    if (!filename)
+        return NULL;
+
+    new_inner_sf = streamfile->inner_sf->open(streamfile->inner_sf, filename, buffersize);
+    if (!new_inner_sf)
+        return NULL;
+
+    /* companion files aren't transformed */
+    streamfile->inner_sf->get_name(streamfile->inner_sf, name, sizeof(name));
+    if (strcmp(name,filename) != 0)
+        return new_inner_sf;
+
+    new_sf = open_transform_streamfile(new_inner_sf, &streamfile->transform, streamfile->buffersize);
+    if (!new_sf) {
+        close_streamfile(new_inner_sf);
+        return NULL;
+    }
+    return new_sf;
+}
+
+STREAMFILE * open_transform_streamfile(STREAMFILE *streamFile, const streamfile_transform * transform, size_t buffer_size) {
+    TRANSFORMSTREAMFILE * this_sf;
+
+    if (!streamFile || !transform)
+        return NULL;
+    if (transform->type == STREAMFILE_TRANSFORM_XOR_KEY && (!transform->key || !transform->key_size))
+        return NULL;
+    if (buffer_size == 0)
+        buffer_size = STREAMFILE_DEFAULT_BUFFER_SIZE;
+
+    this_sf = calloc(1,sizeof(TRANSFORMSTREAMFILE));
+    if (!this_sf) goto fail;
+
+    this_sf->sf.read = (void*)read_transform;
+    this_sf->sf.get_size = (void*)get_size_transform;
+    this_sf->sf.get_offset = (void*)get_offset_transform;
+    this_sf->sf.get_name = (void*)get_name_transform;
+    this_sf->sf.get_realname = (void*)get_realname_transform;
+    this_sf->sf.open = (void*)open_transform;
+    this_sf->sf.close = (void*)close_transform;
+    this_sf->sf.get_bytes_read = (void*)get_bytes_read_transform;
+    this_sf->sf.get_error_count = (void*)get_error_count_transform;
+    this_sf->sf.peek = (void*)peek_transform;
+    this_sf->sf.stream_index = streamFile->stream_index;
+    this_sf->sf.info_only = streamFile->info_only;
+
+    this_sf->transform = *transform;
+    this_sf->transform.key = NULL;
+    if (transform->type == STREAMFILE_TRANSFORM_XOR_KEY) {
+        uint8_t * key = malloc(transform->key_size);
+        if (!key) goto fail;
+        memcpy(key, transform->key, transform->key_size);
+        this_sf->transform.key = key;
+    }
+
+    this_sf->buffer = malloc(buffer_size);
+    if (!this_sf->buffer) goto fail;
+    this_sf->buffersize = buffer_size;
+
+    this_sf->inner_sf = streamFile;
+    this_sf->filesize = get_streamfile_size(streamFile);
+
+    return &this_sf->sf;
+
+fail:
+    if (this_sf) {
+        free((void*)this_sf->transform.key);
+        free(this_sf->buffer);
+        free(this_sf);
+    }
+    return NULL;
+}
+
+
+/* **************************************************** */
+
+/* Subfile STREAMFILE: a window of another STREAMFILE, with a fake name, for files inside banks.
+ * The first one borrows the original STREAMFILE; re-opens own their (re-opened) original. */
+
+typedef struct {
+    STREAMFILE sf;
+
+    STREAMFILE * inner_sf;
+    int owns_inner;
+    off_t start;            /* window offset in inner_sf */
+    size_t size;
+    off_t offset;           /* last read end (within the window), for get_offset */
+    char name[PATH_LIMIT];  /* fake name */
+} SUBFILESTREAMFILE;
+
+static size_t read_subfile(SUBFILESTREAMFILE *streamfile, uint8_t * dest, off_t offset, size_t length) {
+    size_t length_read, bytes_read;
+
+    if (!streamfile || !dest || length<=0)
+        return 0;
+
+    if (offset < 0 || offset >= streamfile->size) {
+        streamfile->offset = streamfile->size;
+#if STREAMFILE_IGNORE_EOF
+        memset(dest,0,length);
+        return length; /* 0-set buffer */
+#else
+        return 0; /* nothing to read */
+#endif
+    }
+
+    if (length > streamfile->size - offset)
+        length = streamfile->size - offset;
+    bytes_read = streamfile->inner_sf->stats.bytes_read;
+    length_read = read_streamfile(dest, streamfile->start + offset, length, streamfile->inner_sf);
+    streamfile->sf.stats.bytes_read += streamfile->inner_sf->stats.bytes_read - bytes_read; /* no buffer of its own */
+    streamfile->offset = offset + length_read;
+    return length_read;
+}
+static const uint8_t * peek_subfile(SUBFILESTREAMFILE *streamfile, off_t offset, size_t length, size_t * avail) {
+    const uint8_t * ptr;
+    size_t bytes_read;
+
+    if (offset < 0 || offset >= streamfile->size)
+        return NULL;
+
+    if (length > streamfile->size - offset)
+        length = streamfile->size - offset;
+    bytes_read = streamfile->inner_sf->stats.bytes_read;
+    ptr = peek_streamfile(streamfile->inner_sf, streamfile->start + offset, length, avail);
+    streamfile->sf.stats.bytes_read += streamfile->inner_sf->stats.bytes_read - bytes_read;
+    if (!ptr)
+        return NULL;
+
+    if (*avail > streamfile->size - offset)
+        *avail = streamfile->size - offset;
+    streamfile->offset = offset + (length < *avail ? length : *avail);
+    return ptr;
+}
+static size_t get_size_subfile(SUBFILESTREAMFILE * streamfile) {
+    return streamfile->size;
+}
+static off_t get_offset_subfile(SUBFILESTREAMFILE *streamfile) {
+    return streamfile->offset;
+}
+static void get_name_subfile(SUBFILESTREAMFILE *streamfile, char *buffer, size_t length) {
+    strncpy(buffer, streamfile->name, length);
+    buffer[length-1] = '\0';
+}
+static void get_realname_subfile(SUBFILESTREAMFILE *streamfile, char *buffer, size_t length) {
+    streamfile->inner_sf->get_realname(streamfile->inner_sf, buffer, length);
+}
+static size_t get_bytes_read_subfile(SUBFILESTREAMFILE *streamfile) {
+    return get_streamfile_bytes_read(streamfile->inner_sf);
+}
+static int get_error_count_subfile(SUBFILESTREAMFILE *streamfile) {
+    return get_streamfile_error_count(streamfile->inner_sf);
+}
+static void close_subfile(SUBFILESTREAMFILE *streamfile) {
+    if (streamfile->owns_inner)
+        close_streamfile(streamfile->inner_sf);
+    free(streamfile);
+}
+
+static STREAMFILE * open_subfile_window(STREAMFILE *streamFile, off_t offset, size_t size, const char * name, int owns_inner);
+
+static STREAMFILE *open_subfile_impl(SUBFILESTREAMFILE *streamfile, const char * const filename, size_t buffersize) {
+    char name[PATH_LIMIT];
+    STREAMFILE * new_inner_sf;
+    STREAMFILE * new_sf;
+
+    if (!filename)
+        return NULL;
+
+    /* companion files (same folder) */
+    if (strcmp(filename, streamfile->name) != 0)
+        return streamfile->inner_sf->open(streamfile->inner_sf, filename, buffersize);
+
+    /* same file: new window over a new original, so it can outlive the borrowed one */
+    streamfile->inner_sf->get_name(streamfile->inner_sf, name, sizeof(name));
+    new_inner_sf = streamfile->inner_sf->open(streamfile->inner_sf, name, buffersize);
+    if (!new_inner_sf)
+        return NULL;
+
+    new_sf = open_subfile_window(new_inner_sf, streamfile->start, streamfile->size, streamfile->name, 1);
+    if (!new_sf) {
+        close_streamfile(new_inner_sf);
+        return NULL;
+    }
+    return new_sf;
+}
+
+static STREAMFILE * open_subfile_window(STREAMFILE *streamFile, off_t offset, size_t size, const char * name, int owns_inner) {
+    SUBFILESTREAMFILE * this_sf = calloc(1,sizeof(SUBFILESTREAMFILE));
+    if (!this_sf) return NULL;
+
+    this_sf->sf.read = (void*)read_subfile;
+    this_sf->sf.get_size = (void*)get_size_subfile;
+    this_sf->sf.get_offset = (void*)get_offset_subfile;
+    this_sf->sf.get_name = (void*)get_name_subfile;
+    this_sf->sf.get_realname = (void*)get_realname_subfile;
+    this_sf->sf.open = (void*)open_subfile_impl;
+    this_sf->sf.close = (void*)close_subfile;
+    this_sf->sf.get_bytes_read = (void*)get_bytes_read_subfile;
+    this_sf->sf.get_error_count = (void*)get_error_count_subfile;
+    this_sf->sf.peek = (void*)peek_subfile;
+    this_sf->sf.info_only = streamFile->info_only;
+
+    this_sf->inner_sf = streamFile;
+    this_sf->owns_inner = owns_inner;
+    this_sf->start = offset;
+    this_sf->size = size;
+    strncpy(this_sf->name, name, sizeof(this_sf->name));
+    this_sf->name[sizeof(this_sf->name)-1] = '\0';
+
+    return &this_sf->sf;
+}
+
+STREAMFILE * open_subfile(STREAMFILE *streamFile, off_t offset, size_t size, const char * fake_ext) {
+    char name[PATH_LIMIT];
+    size_t filesize;
+
+    if (!streamFile)
+        return NULL;
+
+    /* clamp to the original's size */
+    filesize = get_streamfile_size(streamFile);
+    if (offset < 0 || offset > filesize)
+        return NULL;
+    if (size == 0 || size > filesize - offset)
+        size = filesize - offset;
+
+    streamFile->get_name(streamFile,name,sizeof(name));
+    if (fake_ext) {
+        size_t base_length = filename_extension(name) - name; /* up to the dot (or end if none) */
+        if (name[base_length] == '\0' && (base_length == 0 || name[base_length-1] != '.') && base_length + 1 < sizeof(name))
+            name[base_length++] = '.';
+        snprintf(name + base_length, sizeof(name) - base_length, "%s", fake_ext);
+    }
+
+    return open_subfile_window(streamFile, offset, size, name, 0);
+}
+
+
+/* **************************************************** */
+
+/* Pipe STREAMFILE: reads a non-seekable input (stdin, sockets) once, in order, keeping its start
+ * in memory for header probes, the latest data in a memory ring for decoding, and what leaves the
+ * ring in a spill file (bounded too, for endless streams), so loops and re-reads work as long as
+ * the data is still kept. All views opened with the same name share the input, and each counts
+ * its own failed reads (data no longer kept, or input errors while it was reading). */
+
+typedef struct {
+    FILE * infile;
+    int eof;
+    size_t size;            /* expected size (0 if unknown) */
+    off_t captured;         /* bytes read from infile */
+
+    uint8_t * head;         /* [0, head_size) */
+    size_t head_size;
+    uint8_t * ring;         /* [captured - ring_valid, captured), at offset % STREAMFILE_PIPE_RING_SIZE */
+    size_t ring_valid;
+    FILE * spill;           /* [spill_start, captured - ring_valid), at offset % spill_size */
+    size_t spill_size;      /* multiple of the ring size */
+    off_t spill_start;
+
+    off_t lost_offset;      /* lowest offset of data needed after it was no longer kept */
+    size_t lost_size;       /* bytes needed after they were no longer kept (all reads) */
+    int lost_count;
+
+    size_t bytes_read;
+    int refcount;
+    char name[PATH_LIMIT];
+} pipe_spool;
+
+typedef struct {
+    STREAMFILE sf;
+    pipe_spool * spool;
+    off_t offset;           /* last read end, for get_offset */
+    int error_count;
+} PIPESTREAMFILE;
+
+static int pipe_spill_io(pipe_spool * spool, uint8_t * buf, off_t offset, size_t length, int write) {
+    while (length > 0) {
+        off_t spill_offset = offset % spool->spill_size;
+        size_t length_io = spool->spill_size - spill_offset;
+        if (length_io > length)
+            length_io = length;
+
+        if (fseeko(spool->spill, spill_offset, SEEK_SET))
+            return 0;
+        if (write) {
+            if (fwrite(buf, 1, length_io, spool->spill) != length_io)
+                return 0;
+        }
+        else {
+            if (fread(buf, 1, length_io, spool->spill) != length_io)
+                return 0;
+            spool->bytes_read += length_io;
+        }
+        buf += length_io;
+        offset += length_io;
+        length -= length_io;
+    }
+    return 1;
+}
+
+/* reads the input until offset is captured (or EOF), returns 0 on input/spill errors */
+static int pipe_capture(pipe_spool * spool, off_t offset) {
+    int ok = 1;
+
+    while (spool->captured < offset && !spool->eof) {
+        size_t ring_pos = spool->captured % STREAMFILE_PIPE_RING_SIZE;
+        size_t length = STREAMFILE_PIPE_RING_SIZE - ring_pos; /* never wraps the ring or the spill */
+        size_t length_read;
+        if (length > STREAMFILE_PIPE_RING_SIZE / 8)
+            length = STREAMFILE_PIPE_RING_SIZE / 8;
+
+        /* move the ring's oldest data that will be overwritten to the spill */
+        if (spool->ring_valid + length > STREAMFILE_PIPE_RING_SIZE) {
+            off_t evict_offset = spool->captured - spool->ring_valid;
+            size_t evict_length = spool->ring_valid + length - STREAMFILE_PIPE_RING_SIZE;
+
+            if (spool->spill && pipe_spill_io(spool, spool->ring + evict_offset % STREAMFILE_PIPE_RING_SIZE, evict_offset, evict_length, 1)) {
+                if (evict_offset + evict_length - spool->spill_start > spool->spill_size)
+                    spool->spill_start = evict_offset + evict_length - spool->spill_size;
+            }
+            else {
+                if (spool->spill)
+                    ok = 0; /* spill write failed */
+                spool->spill_start = evict_offset + evict_length; /* lost */
+            }
+            spool->ring_valid -= evict_length;
+        }
+
+        length_read = fread(spool->ring + ring_pos, 1, length, spool->infile);
+        if (length_read < length) {
+            if (ferror(spool->infile))
+                ok = 0;
+            spool->eof = 1;
+        }
+
+        if (spool->captured < spool->head_size) {
+            size_t head_length = spool->head_size - spool->captured;
+            if (head_length > length_read)
+                head_length = length_read;
+            memcpy(spool->head + spool->captured, spool->ring + ring_pos, head_length);
+        }
+
+        spool->bytes_read += length_read;
+        spool->captured += length_read;
+        spool->ring_valid += length_read;
+    }
+
+    return ok;
+}
+
+/* copies kept data at offset (already captured), returns bytes copied before a gap */
+static size_t pipe_copy(pipe_spool * spool, uint8_t * dest, off_t offset, size_t length) {
+    size_t length_copied = 0;
+    off_t ring_start = spool->captured - spool->ring_valid;
+
+    while (length > 0) {
+        size_t length_part;
+
+        if (offset < spool->head_size && offset < spool->captured) {
+            length_part = (spool->captured < spool->head_size ? spool->captured : spool->head_size) - offset;
+            if (length_part > length)
+                length_part = length;
+            memcpy(dest, spool->head + offset, length_part);
+        }
+        else if (offset >= ring_start && offset < spool->captured) {
+            size_t ring_pos = offset % STREAMFILE_PIPE_RING_SIZE;
+            length_part = STREAMFILE_PIPE_RING_SIZE - ring_pos;
+            if (length_part > spool->captured - offset)
+                length_part = spool->captured - offset;
+            if (length_part > length)
+                length_part = length;
+            memcpy(dest, spool->ring + ring_pos, length_part);
+        }
+        else if (offset >= spool->spill_start && offset < ring_start) {
+            length_part = ring_start - offset;
+            if (length_part > length)
+                length_part = length;
+            if (!pipe_spill_io(spool, dest, offset, length_part, 0))
+                break;
+        }
+        else {
+            break; /* no longer kept (backward seek to before spill_start), logged by the caller */
+        }
+
+        length_copied += length_part;
+        dest += length_part;
+        offset += length_part;
+        length -= length_part;
+    }
+
+    return length_copied;
+}
+
+static size_t read_pipe(PIPESTREAMFILE *streamfile, uint8_t * dest, off_t offset, size_t length) {
+    pipe_spool * spool;
+    size_t length_read, bytes_read;
+
+    if (!streamfile || !dest || length<=0)
+        return 0;
+    spool = streamfile->spool;
+    bytes_read = spool->bytes_read;
+
+    if (offset < 0) {
+        streamfile->error_count++;
+        return 0;
+    }
+
+    if (!pipe_capture(spool, offset + length))
+        streamfile->error_count++;
+    length_read = (offset < spool->captured) ? pipe_copy(spool, dest, offset, length) : 0;
+    streamfile->sf.stats.bytes_read += spool->bytes_read - bytes_read;
+
+    /* stopped at a gap: a meta/layout went back further than the head + spill keep */
+    if (length_read < length && offset + length_read < spool->spill_start) {
+        off_t lost_offset = offset + length_read;
+        size_t lost_size = spool->spill_start - lost_offset;
+        if (lost_size > length - length_read)
+            lost_size = length - length_read;
+
+        VGM_LOG("PIPE: read at 0x%lx lost 0x%lx bytes (kept from 0x%lx, captured 0x%lx)\n",
+                (unsigned long)lost_offset, (unsigned long)lost_size, (unsigned long)spool->spill_start, (unsigned long)spool->captured);
+        if (!spool->lost_count || lost_offset < spool->lost_offset)
+            spool->lost_offset = lost_offset;
+        spool->lost_size += lost_size;
+        spool->lost_count++;
+    }
+    streamfile->offset = spool->eof && offset + length_read >= spool->captured ? spool->captured : offset + length_read;
+
+    if (length_read < length) {
+        streamfile->error_count++;
+#if STREAMFILE_IGNORE_EOF
+        memset(dest + length_read,0,length - length_read);
+        return length; /* partially-read + 0-set buffer */
+#endif
+    }
+    return length_read;
+}
+static size_t get_size_pipe(PIPESTREAMFILE * streamfile) {
+    pipe_spool * spool = streamfile->spool;
+
+    /* unknown size: small inputs are captured to get it, bigger ones report an upper bound until
+     * their end is read (metas validating sizes against it still work), as reading the whole input
+     * would delay decoding and drop the start of inputs bigger than what's kept */
+    if (!spool->size && !spool->eof && spool->captured < STREAMFILE_PIPE_RING_SIZE) {
+        size_t bytes_read = spool->bytes_read;
+        if (!pipe_capture(spool, STREAMFILE_PIPE_RING_SIZE))
+            streamfile->error_count++;
+        streamfile->sf.stats.bytes_read += spool->bytes_read - bytes_read;
+    }
+
+    if (spool->eof)
+        return spool->captured;
+    return spool->size ? spool->size : STREAMFILE_PIPE_SIZE_MAX;
+}
+static off_t get_offset_pipe(PIPESTREAMFILE *streamfile) {
+    return streamfile->offset;
+}
+static void get_name_pipe(PIPESTREAMFILE *streamfile, char *buffer, size_t length) {
+    strncpy(buffer, streamfile->spool->name, length);
+    buffer[length-1] = '\0';
+}
+static size_t get_bytes_read_pipe(PIPESTREAMFILE *streamfile) {
+    return streamfile->spool->bytes_read;
+}
+static int get_error_count_pipe(PIPESTREAMFILE *streamfile) {
+    return streamfile->error_count;
+}
+static void close_pipe(PIPESTREAMFILE *streamfile) {
+    pipe_spool * spool = streamfile->spool;
+
+    if (--spool->refcount == 0) {
+        if (spool->spill) fclose(spool->spill);
+        free(spool->head);
+        free(spool->ring);
+        free(spool);
+    }
+    free(streamfile);
+}
+
+static STREAMFILE * open_pipe_view(pipe_spool * spool);
+
+static STREAMFILE *open_pipe(PIPESTREAMFILE *streamfile, const char * const filename, size_t buffersize) {
+    if (!filename)
+        return NULL;
+
+    /* same name: new view of the input, others are regular files */
+    if (!strcmp(filename, streamfile->spool->name))
+        return open_pipe_view(streamfile->spool);
+    return open_stdio_streamfile_buffer(filename, buffersize);
+}
+
+static STREAMFILE * open_pipe_view(pipe_spool * spool) {
+    PIPESTREAMFILE * this_sf = calloc(1,sizeof(PIPESTREAMFILE));
+    if (!this_sf) return NULL;
+
+    this_sf->sf.read = (void*)read_pipe;
+    this_sf->sf.get_size = (void*)get_size_pipe;
+    this_sf->sf.get_offset = (void*)get_offset_pipe;
+    this_sf->sf.get_name = (void*)get_name_pipe;
+    this_sf->sf.get_realname = (void*)get_name_pipe;
+    this_sf->sf.open = (void*)open_pipe;
+    this_sf->sf.close = (void*)close_pipe;
+    this_sf->sf.get_bytes_read = (void*)get_bytes_read_pipe;
+    this_sf->sf.get_error_count = (void*)get_error_count_pipe;
+
+    this_sf->spool = spool;
+    spool->refcount++;
+
+    return &this_sf->sf;
+}
+
+STREAMFILE * open_pipe_streamfile(FILE * file, const char * name, size_t size, size_t spill_size) {
+    pipe_spool * spool = NULL;
+    STREAMFILE * new_sf;
+
+    if (!file || !name)
+        return NULL;
+
+    spool = calloc(1,sizeof(pipe_spool));
+    if (!spool) goto fail;
+
+    spool->head_size = STREAMFILE_PIPE_HEAD_SIZE;
+    spool->head = malloc(spool->head_size);
+    spool->ring = malloc(STREAMFILE_PIPE_RING_SIZE);
+    if (!spool->head || !spool->ring) goto fail;
+    spool->spill = tmpfile(); /* if it can't be made, data leaving the ring is lost */
+    if (!spill_size)
+        spill_size = STREAMFILE_PIPE_SPILL_SIZE;
+    spool->spill_size = (spill_size + STREAMFILE_PIPE_RING_SIZE - 1) / STREAMFILE_PIPE_RING_SIZE * STREAMFILE_PIPE_RING_SIZE;
+
+    spool->infile = file;
+    spool->size = size;
+    strncpy(spool->name, name, sizeof(spool->name));
+    spool->name[sizeof(spool->name)-1] = '\0';
+
+    new_sf = open_pipe_view(spool);
+    if (!new_sf) goto fail;
+    return new_sf;
+
+fail:
+    if (spool) {
+        if (spool->spill) fclose(spool->spill);
+        free(spool->head);
+        free(spool->ring);
+        free(spool);
+    }
+    return NULL;
+}
+
+int get_pipe_streamfile_loss(STREAMFILE *streamFile, off_t * lost_offset, size_t * lost_size) {
+    pipe_spool * spool;
+
+    if (!streamFile || streamFile->close != (void*)close_pipe) {
+        if (lost_offset) *lost_offset = 0;
+        if (lost_size) *lost_size = 0;
+        return 0;
+    }
+
+    spool = ((PIPESTREAMFILE*)streamFile)->spool;
+    if (lost_offset) *lost_offset = spool->lost_offset;
+    if (lost_size) *lost_size = spool->lost_size;
+    return spool->lost_count;
+}
+
+/* **************************************************** */
+
+/* Archive entry STREAMFILE: a window of an archive, like a subfile, that resolves companion
+ * files (same archive dir) to other entries. */
+
+typedef struct {
+    STREAMFILE sf;
+
+    streamfile_archive * archive;
+    STREAMFILE * inner_sf;  /* the archive's STREAMFILE (shared by all entries) */
+    int index;              /* entry index, for re-opens */
+    off_t start;            /* entry offset in the archive */
+    size_t size;
+    off_t offset;           /* last read end (within the entry), for get_offset */
+    char name[PATH_LIMIT];  /* archive path + entry name */
+} ARCHIVESTREAMFILE;
+
+static void release_streamfile_archive(streamfile_archive * archive) {
+    if (--archive->refcount > 0)
+        return;
+    close_streamfile(archive->streamfile);
+    free(archive->entries);
+    free(archive->name);
+    free(archive);
+}
+
+static size_t read_archive(ARCHIVESTREAMFILE *streamfile, uint8_t * dest, off_t offset, size_t length) {
+    size_t length_read, bytes_read;
+
+    if (!streamfile || !dest || length<=0)
+        return 0;
+
+    if (offset < 0 || offset >= streamfile->size) {
+        streamfile->offset = streamfile->size;
+#if STREAMFILE_IGNORE_EOF
+        memset(dest,0,length);
+        return length; /* 0-set buffer */
+#else
+        return 0; /* nothing to read */
+#endif
+    }
+
+    if (length > streamfile->size - offset)
+        length = streamfile->size - offset;
+    bytes_read = streamfile->inner_sf->stats.bytes_read;
+    length_read = read_streamfile(dest, streamfile->start + offset, length, streamfile->inner_sf);
+    streamfile->sf.stats.bytes_read += streamfile->inner_sf->stats.bytes_read - bytes_read; /* no buffer of its own */
+    streamfile->offset = offset + length_read;
+    return length_read;
+}
+static const uint8_t * peek_archive(ARCHIVESTREAMFILE *streamfile, off_t offset, size_t length, size_t * avail) {
+    const uint8_t * ptr;
+    size_t bytes_read;
+
+    if (offset < 0 || offset >= streamfile->size)
+        return NULL;
+
+    if (length > streamfile->size - offset)
+        length = streamfile->size - offset;
+    bytes_read = streamfile->inner_sf->stats.bytes_read;
+    ptr = peek_streamfile(streamfile->inner_sf, streamfile->start + offset, length, avail);
+    streamfile->sf.stats.bytes_read += streamfile->inner_sf->stats.bytes_read - bytes_read;
+    if (!ptr)
+        return NULL;
+
+    if (*avail > streamfile->size - offset)
+        *avail = streamfile->size - offset;
+    streamfile->offset = offset + (length < *avail ? length : *avail);
+    return ptr;
+}
+static size_t get_size_archive(ARCHIVESTREAMFILE * streamfile) {
+    return streamfile->size;
+}
+static off_t get_offset_archive(ARCHIVESTREAMFILE *streamfile) {
+    return streamfile->offset;
+}
+static void get_name_archive(ARCHIVESTREAMFILE *streamfile, char *buffer, size_t length) {
+    strncpy(buffer, streamfile->name, length);
+    buffer[length-1] = '\0';
+}
+static void get_realname_archive(ARCHIVESTREAMFILE *streamfile, char *buffer, size_t length) {
+    streamfile->inner_sf->get_realname(streamfile->inner_sf, buffer, length); /* entries only exist inside */
+}
+static size_t get_bytes_read_archive(ARCHIVESTREAMFILE *streamfile) {
+    return get_streamfile_bytes_read(streamfile->inner_sf);
+}
+static int get_error_count_archive(ARCHIVESTREAMFILE *streamfile) {
+    return get_streamfile_error_count(streamfile->inner_sf);
+}
+static void close_archive(ARCHIVESTREAMFILE *streamfile) {
+    release_streamfile_archive(streamfile->archive);
+    free(streamfile);
+}
+
+static STREAMFILE *open_archive(ARCHIVESTREAMFILE *streamfile, const char * const filename, size_t buffersize) {
+    streamfile_archive * archive = streamfile->archive;
+    size_t archive_length = strlen(archive->name);
+    char name[PATH_LIMIT];
+    const char * path;
+
+    if (!filename)
+        return NULL;
+
+    /* files outside the archive */
+    if (strncmp(filename, archive->name, archive_length) != 0 || filename[archive_length] != DIR_SEPARATOR)
+        return archive->streamfile->open(archive->streamfile, filename, buffersize);
+
+    /* this entry again (a new file for a channel), by index as names may come from a lookup */
+    if (strcmp(filename, streamfile->name) == 0)
+        return open_streamfile_archive_entry(archive, streamfile->index);
+
+    /* other entries */
+    {
+        int index = find_streamfile_archive_entry(archive, filename + archive_length + 1);
+        if (index >= 0)
+            return open_streamfile_archive_entry(archive, index);
+    }
+
+    /* not in the archive: try next to it, as if the archive was its dir */
+    strncpy(name, archive->name, sizeof(name));
+    name[sizeof(name)-1] = '\0';
+    path = strrchr(name, DIR_SEPARATOR);
+    snprintf(name + (path ? path - name + 1 : 0), sizeof(name) - (path ? path - name + 1 : 0), "%s", filename + archive_length + 1);
+    return archive->streamfile->open(archive->streamfile, name, buffersize);
+}
+
+streamfile_archive * allocate_streamfile_archive(STREAMFILE *streamFile) {
+    streamfile_archive * archive = NULL;
+    char name[PATH_LIMIT];
+
+    archive = calloc(1,sizeof(streamfile_archive));
+    if (!archive) goto fail;
+
+    streamFile->get_name(streamFile, name, sizeof(name));
+    archive->name = malloc(strlen(name) + 1);
+    if (!archive->name) goto fail;
+    strcpy(archive->name, name);
+
+    archive->streamfile = streamFile->open(streamFile, archive->name, STREAMFILE_DEFAULT_BUFFER_SIZE);
+    if (!archive->streamfile) goto fail;
+    archive->refcount = 1;
+
+    return archive;
+
+fail:
+    if (archive) free(archive->name);
+    free(archive);
+    return NULL;
+}
+
+int add_streamfile_archive_entry(streamfile_archive * archive, const char * name, off_t offset, size_t size) {
+    streamfile_archive_entry * entry;
+
+    if (offset < 0 || offset > get_streamfile_size(archive->streamfile) || size > get_streamfile_size(archive->streamfile) - offset)
+        return 0;
+
+    if (archive->entry_count == archive->entry_max) {
+        int entry_max = archive->entry_max ? archive->entry_max * 2 : 64;
+        streamfile_archive_entry * entries = realloc(archive->entries, entry_max * sizeof(streamfile_archive_entry));
+        if (!entries) return 0;
+        archive->entries = entries;
+        archive->entry_max = entry_max;
+    }
+
+    entry = &archive->entries[archive->entry_count++];
+    strncpy(entry->name, name, sizeof(entry->name));
+    entry->name[sizeof(entry->name)-1] = '\0';
+    entry->offset = offset;
+    entry->size = size;
+    return 1;
+}
+
+/* case insensitive compare where '/' and '\\' are the same (CPK paths use '/') */
+static int compare_archive_entry_name(const char * name1, const char * name2) {
+    for (; *name1 && *name2; name1++, name2++) {
+        int c1 = (*name1 == '\\') ? '/' : tolower((unsigned char)*name1);
+        int c2 = (*name2 == '\\') ? '/' : tolower((unsigned char)*name2);
+        if (c1 != c2)
+            return c1 - c2;
+    }
+    return *name1 - *name2;
+}
+
+int find_streamfile_archive_entry(streamfile_archive * archive, const char * name) {
+    int i;
+
+    for (i = 0; i < archive->entry_count; i++) {
+        if (compare_archive_entry_name(archive->entries[i].name, name) == 0)
+            return i;
+    }
+    return -1;
+}
+
+STREAMFILE * open_streamfile_archive_entry(streamfile_archive * archive, int index) {
+    ARCHIVESTREAMFILE * this_sf = NULL;
+    streamfile_archive_entry * entry;
+
+    if (!archive || index < 0 || index >= archive->entry_count)
+        return NULL;
+    entry = &archive->entries[index];
+
+    this_sf = calloc(1,sizeof(ARCHIVESTREAMFILE));
+    if (!this_sf) return NULL;
+
+    /* all entries read through the archive's file (kept open by the refcount) */
+    this_sf->inner_sf = archive->streamfile;
+
+    this_sf->sf.read = (void*)read_archive;
+    this_sf->sf.get_size = (void*)get_size_archive;
+    this_sf->sf.get_offset = (void*)get_offset_archive;
+    this_sf->sf.get_name = (void*)get_name_archive;
+    this_sf->sf.get_realname = (void*)get_realname_archive;
+    this_sf->sf.open = (void*)open_archive;
+    this_sf->sf.close = (void*)close_archive;
+    this_sf->sf.get_bytes_read = (void*)get_bytes_read_archive;
+    this_sf->sf.get_error_count = (void*)get_error_count_archive;
+    this_sf->sf.peek = (void*)peek_archive;
+
+    this_sf->archive = archive;
+    archive->refcount++;
+    this_sf->index = index;
+    this_sf->start = entry->offset;
+    this_sf->size = entry->size;
+    snprintf(this_sf->name, sizeof(this_sf->name), "%s%c%s", archive->name, DIR_SEPARATOR, entry->name);
+
+    return &this_sf->sf;
+}
+
+void close_streamfile_archive(streamfile_archive * archive) {
+    if (!archive) return;
+    release_streamfile_archive(archive);
+}
+
+
+/* **************************************************** */
+
+/* Extension sets for check_extensions. Each list is compiled once into a bitset of indexes in the
+ * format list, so checks become a lookup of the file's extension index, which probe STREAMFILEs get
+ * once per detection. Sets are keyed by the list's contents (and keep a copy of it), so lists in
+ * reused buffers are fine and the same list from different places shares a set. Extensions not in
+ * the format list use the old string compare. */
+
+#define EXT_SET_EXT_MAX 32          /* longer extensions aren't indexed */
+#define EXT_SET_TABLE_SIZE 1024     /* power of 2, more than the number of distinct lists */
+
+typedef struct {
+    const char * exts;      /* copy of the list (after the bits) */
+    uint32_t hash;          /* hash of the list */
+    int has_unlisted;       /* list has extensions not in the format list */
+    uint32_t bits[1];       /* one bit per format index (variable size) */
+} ext_set;
+
+static ext_set * volatile ext_sets[EXT_SET_TABLE_SIZE];
+static int ext_set_format_count = -1;
+
+#ifdef _WIN32
+static CRITICAL_SECTION ext_set_lock;
+static vgm_once_flag ext_set_once = VGM_ONCE_INIT;
+static void ext_set_init(void) { InitializeCriticalSection(&ext_set_lock); }
+static void ext_set_lock_enter(void) {
+    vgm_once(&ext_set_once, ext_set_init);
+    EnterCriticalSection(&ext_set_lock);
+}
+static void ext_set_lock_leave(void) { LeaveCriticalSection(&ext_set_lock); }
+#else
+static pthread_mutex_t ext_set_lock = PTHREAD_MUTEX_INITIALIZER;
+static void ext_set_lock_enter(void) { pthread_mutex_lock(&ext_set_lock); }
+static void ext_set_lock_leave(void) { pthread_mutex_unlock(&ext_set_lock); }
+#endif
+
+/* table slots are read without the lock, so a set must be complete before its slot is seen */
+#if defined(__GNUC__)
+#define ext_set_load(slot) __atomic_load_n(slot, __ATOMIC_ACQUIRE)
+#define ext_set_store(slot, set) __atomic_store_n(slot, set, __ATOMIC_RELEASE)
+#elif defined(_WIN32)
+#define ext_set_load(slot) (*(slot)) /* MSVC volatile reads are acquire */
+#define ext_set_store(slot, set) InterlockedExchangePointer((PVOID volatile *)(slot), set)
+#else
+#define ext_set_load(slot) (*(slot))
+#define ext_set_store(slot, set) (*(slot) = (set))
+#endif
+
+/* gets the lowercase extension of a file and its index in the format list (-1 if not found or too long) */
+static int get_extension_index(STREAMFILE *streamFile, char * ext, size_t ext_size) {
+    char filename[PATH_LIMIT];
+    const char * file_ext;
+    size_t i;
+
+    streamFile->get_name(streamFile,filename,sizeof(filename));
+    file_ext = filename_extension(filename);
+
+    for (i = 0; file_ext[i] != '\0' && i + 1 < ext_size; i++) {
+        ext[i] = (file_ext[i] >= 'A' && file_ext[i] <= 'Z') ? file_ext[i] + ('a' - 'A') : file_ext[i];
+    }
+    ext[i] = '\0';
+    if (file_ext[i] != '\0')
+        return -1;
+    return vgmstream_get_format_index(ext);
+}
+
+/* compares against each extension in a comma-separated list */
+static int check_extension_list(const char * ext, const char * cmp_exts) {
+    const char * cmp_ext = NULL;
+    const char * ststr_res = NULL;
+    size_t ext_len, cmp_len;
+
+    ext_len = strlen(ext);
+
+    cmp_ext = cmp_exts;
+    do {
+        ststr_res = strstr(cmp_ext, ",");
+        cmp_len = ststr_res == NULL
+                  ? strlen(cmp_ext) /* total length if more not found */
+                  : (intptr_t)ststr_res - (intptr_t)cmp_ext; /* find next ext; ststr_res should always be greater than cmp_ext, resulting in a positive cmp_len */
+
+        if (ext_len == cmp_len && strncasecmp(ext,cmp_ext, ext_len) == 0)
+            return 1;
+
+        cmp_ext = ststr_res;
+        if (cmp_ext != NULL)
+            cmp_ext = cmp_ext + 1; /* skip comma */
+
+    } while (cmp_ext != NULL);
+
+    return 0;
+}
+
+static ext_set * compile_ext_set(const char * cmp_exts, uint32_t hash) {
+    ext_set * set;
+    const char * cmp_ext = cmp_exts;
+    size_t words = (ext_set_format_count + 31) / 32;
+    size_t exts_size = strlen(cmp_exts) + 1;
+
+    set = calloc(1, sizeof(ext_set) + words * sizeof(uint32_t) + exts_size);
+    if (!set) return NULL;
+    memcpy((char *)(set->bits + words + 1), cmp_exts, exts_size);
+    set->exts = (const char *)(set->bits + words + 1);
+    set->hash = hash;
+
+    while (1) {
+        char ext[EXT_SET_EXT_MAX];
+        size_t i, ext_len = strcspn(cmp_ext, ",");
+        int index = -1;
+
+        if (ext_len < sizeof(ext)) {
+            for (i = 0; i < ext_len; i++) {
+                ext[i] = (cmp_ext[i] >= 'A' && cmp_ext[i] <= 'Z') ? cmp_ext[i] + ('a' - 'A') : cmp_ext[i];
+            }
+            ext[ext_len] = '\0';
+            index = vgmstream_get_format_index(ext);
+        }
+
+        if (index >= 0)
+            set->bits[index / 32] |= 1u << (index % 32);
+        else
+            set->has_unlisted = 1;
+
+        if (cmp_ext[ext_len] != ',')
+            break;
+        cmp_ext += ext_len + 1;
+    }
+
+    return set;
+}
+
+/* finds the compiled set for a list, or compiles it (NULL if the table is full) */
+static ext_set * get_ext_set(const char * cmp_exts) {
+    ext_set * set;
+    uint32_t hash = 2166136261u; /* FNV-1a */
+    const char * c;
+    int i, pos;
+
+    for (c = cmp_exts; *c != '\0'; c++) {
+        hash = (hash ^ (uint8_t)*c) * 16777619u;
+    }
+
+    /* lock-free lookup, as sets are never modified or removed once added */
+    for (i = 0; i < EXT_SET_TABLE_SIZE; i++) {
+        pos = (hash + i) & (EXT_SET_TABLE_SIZE - 1);
+        set = ext_set_load(&ext_sets[pos]);
+        if (!set)
+            break;
+        if (set->hash == hash && strcmp(set->exts, cmp_exts) == 0)
+            return set;
+    }
+
+    ext_set_lock_enter();
+    if (ext_set_format_count < 0) {
+        size_t format_count;
+        vgmstream_get_formats(&format_count);
+        ext_set_format_count = format_count;
+    }
+
+    set = NULL;
+    for (i = 0; i < EXT_SET_TABLE_SIZE; i++) {
+        pos = (hash + i) & (EXT_SET_TABLE_SIZE - 1);
+        if (ext_sets[pos] && ext_sets[pos]->hash == hash && strcmp(ext_sets[pos]->exts, cmp_exts) == 0) {
+            set = ext_sets[pos]; /* added by another thread */
+            break;
+        }
+        if (!ext_sets[pos]) {
+            set = compile_ext_set(cmp_exts, hash);
+            if (set)
+                ext_set_store(&ext_sets[pos], set);
+            break;
+        }
+    }
+    ext_set_lock_leave();
+
+    return set;
+}
+
+
+/* **************************************************** */
+
+/* A STREAMFILE that reads another STREAMFILE ahead on a background thread when access is
+ * sequential (as when decoding), so reads are served from buffers already filled. Reads are done in
+ * buffers aligned to buffer_size; after a few sequential reads the next buffers are queued, and a
+ * random read cancels queued ones. All read-ahead files share a single I/O thread, which ends when
+ * no files are left. The inner STREAMFILE is only used by one thread at a time. */
+
+#define READAHEAD_SEQUENTIAL_READS 2    /* sequential reads before reading ahead */
+
+enum { RA_FREE, RA_QUEUED, RA_LOADING, RA_READY };
+
+typedef struct {
+    int state;
+    off_t offset;           /* aligned to buffer_size */
+    size_t size;            /* valid bytes */
+    uint8_t * data;
+    uint32_t last_used;
+} readahead_buffer;
+
+typedef struct _READAHEADSTREAMFILE {
+    STREAMFILE sf;          /* callbacks */
+    STREAMFILE *inner_sf;   /* owned */
+    size_t filesize;
+    size_t buffer_size;
+    int buffer_count;
+    readahead_buffer * buffers;
+    int io_busy;            /* inner_sf is being read */
+    off_t offset;           /* end of last read */
+    int sequential_reads;
+    uint32_t use_tick;
+    size_t hits;            /* counters */
+    size_t waits;
+    size_t misses;
+    int error_count;
+    struct _READAHEADSTREAMFILE * next; /* in the list of files served by the I/O thread */
+} READAHEADSTREAMFILE;
+
+/* state shared with the I/O thread, always under readahead_lock */
+static READAHEADSTREAMFILE * readahead_files = NULL;
+static int readahead_thread_running = 0;
+
+#ifdef _WIN32
+/* XP has no condition variables: waits use a manual-reset event, and a signal releases the threads
+ * waiting at the time (those of an older generation), the last of them resetting the event */
+static CRITICAL_SECTION readahead_lock;
+static HANDLE readahead_event;
+static int readahead_waiters = 0;
+static int readahead_releases = 0;
+static unsigned int readahead_generation = 0;
+static vgm_once_flag readahead_once = VGM_ONCE_INIT;
+static void readahead_init(void) {
+    InitializeCriticalSection(&readahead_lock);
+    readahead_event = CreateEvent(NULL, TRUE, FALSE, NULL);
+}
+static void readahead_lock_enter(void) {
+    vgm_once(&readahead_once, readahead_init);
+    EnterCriticalSection(&readahead_lock);
+}
+static void readahead_lock_leave(void) { LeaveCriticalSection(&readahead_lock); }
+static void readahead_wait(void) {
+    unsigned int generation = readahead_generation;
+
+    readahead_waiters++;
+    do {
+        LeaveCriticalSection(&readahead_lock);
+        WaitForSingleObject(readahead_event, INFINITE);
+        EnterCriticalSection(&readahead_lock);
+    } while (readahead_releases == 0 || readahead_generation == generation);
+    readahead_waiters--;
+    if (--readahead_releases == 0)
+        ResetEvent(readahead_event);
+}
+static void readahead_signal(void) {
+    if (readahead_waiters > 0) {
+        readahead_releases = readahead_waiters;
+        readahead_generation++;
+        SetEvent(readahead_event);
+    }
+}
+#else
+static pthread_mutex_t readahead_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t readahead_cond = PTHREAD_COND_INITIALIZER;
+static void readahead_lock_enter(void) { pthread_mutex_lock(&readahead_lock); }
+static void readahead_lock_leave(void) { pthread_mutex_unlock(&readahead_lock); }
+static void readahead_wait(void) { pthread_cond_wait(&readahead_cond, &readahead_lock); }
+static void readahead_signal(void) { pthread_cond_broadcast(&readahead_cond); }
+#endif
+
+/* fills a buffer from the inner file (called with io_busy set and without the lock) */
+static void readahead_fill(READAHEADSTREAMFILE *streamfile, readahead_buffer * buffer) {
+    size_t to_read = streamfile->buffer_size;
+    if (buffer->offset + to_read > streamfile->filesize)
+        to_read = streamfile->filesize - buffer->offset;
+    buffer->size = read_streamfile(buffer->data, buffer->offset, to_read, streamfile->inner_sf);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI readahead_thread(void * arg) {
+#else
+static void * readahead_thread(void * arg) {
+#endif
+    readahead_lock_enter();
+    while (readahead_files) {
+        READAHEADSTREAMFILE * sf;
+        readahead_buffer * buffer = NULL;
+
+        /* find the nearest queued buffer of any idle file */
+        for (sf = readahead_files; sf != NULL && !buffer; sf = sf->next) {
+            int i;
+            if (sf->io_busy)
+                continue;
+            for (i = 0; i < sf->buffer_count; i++) {
+                if (sf->buffers[i].state == RA_QUEUED && (!buffer || sf->buffers[i].offset < buffer->offset))
+                    buffer = &sf->buffers[i];
+            }
+            if (buffer)
+                break;
+        }
+
+        if (!buffer) {
+            readahead_wait();
+            continue;
         }
-        streamfile->offset = offset;
 
-        /* decide how much must be read this time */
-        if (length > streamfile->buffersize)
-            length_to_read = streamfile->buffersize;
-        else
-            length_to_read = length;
+        buffer->state = RA_LOADING;
+        sf->io_busy = 1;
+        readahead_lock_leave();
 
-        /* fill the buffer */
-        length_read = fread(streamfile->buffer,sizeof(uint8_t),streamfile->buffersize,streamfile->infile);
-        streamfile->validsize = length_read;
+        readahead_fill(sf, buffer);
 
-#ifdef PROFILE_STREAMFILE
-        if (ferror(streamfile->infile)) {
-            clearerr(streamfile->infile);
-            streamfile->error_count++;
-        }
+        readahead_lock_enter();
+        buffer->state = RA_READY;
+        sf->io_busy = 0;
+        readahead_signal();
+    }
+    readahead_thread_running = 0;
+    readahead_lock_leave();
+    return 0;
+}
 
-        streamfile->bytes_read += length_read;
-#endif
+/* queues buffers after the current offset (called with the lock held) */
+static void readahead_queue(READAHEADSTREAMFILE *streamfile) {
+    off_t offset = streamfile->offset - (streamfile->offset % streamfile->buffer_size);
+    int i, j, queued = 0;
 
-        /* if we can't get enough to satisfy the request (EOF) we give up */
-        if (length_read < length_to_read) {
-            memcpy(dest,streamfile->buffer,length_read);
+    for (j = 0; j < streamfile->buffer_count && offset < streamfile->filesize; j++, offset += streamfile->buffer_size) {
+        readahead_buffer * victim = NULL;
 
-#if STREAMFILE_IGNORE_EOF
-            memset(dest+length_read,0,length-length_read);
-            return length_read_total + length; /* partially-read + 0-set buffer */
-#else
-            return length_read_total + length_read; /* partially-read buffer */
-#endif
+        for (i = 0; i < streamfile->buffer_count; i++) {
+            if (streamfile->buffers[i].state != RA_FREE && streamfile->buffers[i].offset == offset)
+                break;
+        }
+        if (i < streamfile->buffer_count)
+            continue; /* already loaded or loading */
+
+        /* reuse free buffers or buffers already passed */
+        for (i = 0; i < streamfile->buffer_count; i++) {
+            readahead_buffer * buffer = &streamfile->buffers[i];
+            if (buffer->state == RA_FREE) {
+                victim = buffer;
+                break;
+            }
+            if (buffer->state == RA_READY && buffer->offset + (off_t)streamfile->buffer_size < streamfile->offset
+                    && (!victim || buffer->last_used < victim->last_used))
+                victim = buffer;
         }
+        if (!victim)
+            break;
 
-        /* use the new buffer */
-        memcpy(dest,streamfile->buffer,length_to_read);
-        length_read_total += length_to_read;
-        length -= length_to_read;
-        dest += length_to_read;
-        offset += length_to_read;
+        victim->state = RA_QUEUED;
+        victim->offset = offset;
+        queued = 1;
     }
 
-    return length_read_total;
+    if (queued)
+        readahead_signal();
 }
 
-static size_t read_stdio(STDIOSTREAMFILE *streamfile,uint8_t * dest, off_t offset, size_t length) {
+static size_t read_readahead(READAHEADSTREAMFILE *streamfile, uint8_t * dest, off_t offset, size_t length) {
+    size_t length_read_total = 0;
+    int waited = 0, missed = 0;
 
     if (!streamfile || !dest || length<=0)
         return 0;
 
-    /* request outside file: ignore to avoid seek/read in read_the_rest() */
-    if (offset > streamfile->filesize) {
+    if (offset < 0 || offset > streamfile->filesize) {
         streamfile->offset = streamfile->filesize;
         VGM_LOG_ONCE("ERROR: offset over filesize 0x%x @ 0x%lx + 0x%x (buggy meta?)\n", streamfile->filesize, offset, length);
-
+        streamfile->error_count++;
 #if STREAMFILE_IGNORE_EOF
         memset(dest,0,length);
         return length; /* 0-set buffer */
@@ -144,140 +3043,516 @@ static size_t read_stdio(STDIOSTREAMFILE *streamfile,uint8_t * dest, off_t offse
 #endif
     }
 
-    /* just copy if entire request is within the buffer */
-    if (offset >= streamfile->offset && offset + length <= streamfile->offset + streamfile->validsize) {
-        off_t offset_into_buffer = offset - streamfile->offset;
-        memcpy(dest,streamfile->buffer + offset_into_buffer,length);
-        return length;
+    readahead_lock_enter();
+
+    /* near the last read (decoders may re-read or skip a bit), or random access: drop queued
+     * buffers, as they won't be used soon */
+    if (offset >= streamfile->offset - (off_t)streamfile->buffer_size && offset <= streamfile->offset + (off_t)streamfile->buffer_size) {
+        streamfile->sequential_reads++;
+    }
+    else {
+        int i;
+        streamfile->sequential_reads = 0;
+        for (i = 0; i < streamfile->buffer_count; i++) {
+            if (streamfile->buffers[i].state == RA_QUEUED)
+                streamfile->buffers[i].state = RA_FREE;
+        }
     }
 
-    /* request outside buffer: new fread */
-    {
-        size_t length_read = read_the_rest(dest,offset,length,streamfile);
-#ifdef PROFILE_STREAMFILE
-        if (length_read < length) 
-            streamfile->error_count++;
+    while (length > 0 && offset < streamfile->filesize) {
+        off_t buffer_offset = offset - (offset % streamfile->buffer_size);
+        readahead_buffer * buffer = NULL;
+        size_t offset_into_buffer, length_buffer;
+        int i;
+
+        for (i = 0; i < streamfile->buffer_count; i++) {
+            if (streamfile->buffers[i].state != RA_FREE && streamfile->buffers[i].offset == buffer_offset) {
+                buffer = &streamfile->buffers[i];
+                break;
+            }
+        }
+
+        if (buffer && buffer->state == RA_LOADING) {
+            /* being read: wait for it */
+            waited = 1;
+            readahead_wait();
+            continue;
+        }
+
+        if (!buffer || buffer->state == RA_QUEUED) {
+            /* not read yet: read it now, over a free buffer or the least recently used one */
+            if (!buffer) {
+                for (i = 0; i < streamfile->buffer_count; i++) {
+                    readahead_buffer * candidate = &streamfile->buffers[i];
+                    if (candidate->state == RA_FREE) {
+                        buffer = candidate;
+                        break;
+                    }
+                    if (candidate->state == RA_READY && (!buffer || candidate->last_used < buffer->last_used))
+                        buffer = candidate;
+                }
+            }
+            if (!buffer || streamfile->io_busy) {
+                waited = 1;
+                readahead_wait();
+                continue;
+            }
+
+            missed = 1;
+            buffer->state = RA_LOADING;
+            buffer->offset = buffer_offset;
+            streamfile->io_busy = 1;
+            readahead_lock_leave();
+
+            readahead_fill(streamfile, buffer);
+            streamfile->sf.stats.bytes_read += buffer->size; /* only sync fills, the I/O thread doesn't touch stats */
+
+            readahead_lock_enter();
+            buffer->state = RA_READY;
+            streamfile->io_busy = 0;
+            readahead_signal();
+        }
+
+        buffer->last_used = ++streamfile->use_tick;
+        offset_into_buffer = offset - buffer->offset;
+        if (offset_into_buffer >= buffer->size)
+            break; /* read error */
+        length_buffer = buffer->size - offset_into_buffer;
+        if (length_buffer > length)
+            length_buffer = length;
+
+        memcpy(dest, buffer->data + offset_into_buffer, length_buffer);
+        length_read_total += length_buffer;
+        length -= length_buffer;
+        offset += length_buffer;
+        dest += length_buffer;
+    }
+    streamfile->offset = offset;
+
+    if (missed)
+        streamfile->misses++;
+    else if (waited)
+        streamfile->waits++;
+    else
+        streamfile->hits++;
+
+    if (streamfile->sequential_reads >= READAHEAD_SEQUENTIAL_READS)
+        readahead_queue(streamfile);
+
+    readahead_lock_leave();
+
+    if (length > 0) {
+        streamfile->error_count++;
+#if STREAMFILE_IGNORE_EOF
+        memset(dest,0,length);
+        return length_read_total + length; /* partially-read + 0-set buffer */
 #endif
-        return length_read;
     }
+    return length_read_total;
 }
 
-static void close_stdio(STDIOSTREAMFILE * streamfile) {
-    fclose(streamfile->infile);
-    free(streamfile->buffer);
-    free(streamfile);
+/* borrows from a ready buffer (the last used isn't reused until the next read), or NULL to read */
+static const uint8_t * peek_readahead(READAHEADSTREAMFILE *streamfile, off_t offset, size_t length, size_t * avail) {
+    const uint8_t * ptr = NULL;
+    off_t buffer_offset;
+    int i;
+
+    if (offset < 0 || offset >= streamfile->filesize)
+        return NULL;
+    buffer_offset = offset - (offset % streamfile->buffer_size);
+
+    readahead_lock_enter();
+    for (i = 0; i < streamfile->buffer_count; i++) {
+        readahead_buffer * buffer = &streamfile->buffers[i];
+        if (buffer->state != RA_READY || buffer->offset != buffer_offset || offset - buffer->offset >= buffer->size)
+            continue;
+
+        if (offset >= streamfile->offset - (off_t)streamfile->buffer_size && offset <= streamfile->offset + (off_t)streamfile->buffer_size)
+            streamfile->sequential_reads++;
+        buffer->last_used = ++streamfile->use_tick;
+
+        *avail = buffer->size - (offset - buffer->offset);
+        ptr = buffer->data + (offset - buffer->offset);
+        streamfile->offset = offset + (length < *avail ? length : *avail);
+        streamfile->hits++;
+
+        if (streamfile->sequential_reads >= READAHEAD_SEQUENTIAL_READS)
+            readahead_queue(streamfile);
+        break;
+    }
+    readahead_lock_leave();
+
+    return ptr;
 }
 
-static size_t get_size_stdio(STDIOSTREAMFILE * streamfile) {
+static size_t get_size_readahead(READAHEADSTREAMFILE * streamfile) {
     return streamfile->filesize;
 }
-
-static off_t get_offset_stdio(STDIOSTREAMFILE *streamFile) {
-    return streamFile->offset;
+static off_t get_offset_readahead(READAHEADSTREAMFILE *streamfile) {
+    return streamfile->offset;
 }
-
-static void get_name_stdio(STDIOSTREAMFILE *streamfile,char *buffer,size_t length) {
-    strncpy(buffer,streamfile->name,length);
-    buffer[length-1]='\0';
+static void get_name_readahead(READAHEADSTREAMFILE *streamfile, char *buffer, size_t length) {
+    streamfile->inner_sf->get_name(streamfile->inner_sf, buffer, length);
 }
-
-#ifdef PROFILE_STREAMFILE
-static size_t get_bytes_read_stdio(STDIOSTREAMFILE *streamFile) {
-    return streamFile->bytes_read;
+static void get_realname_readahead(READAHEADSTREAMFILE *streamfile, char *buffer, size_t length) {
+    streamfile->inner_sf->get_realname(streamfile->inner_sf, buffer, length);
 }
-static size_t get_error_count_stdio(STDIOSTREAMFILE *streamFile) {
-    return streamFile->error_count;
+static size_t get_bytes_read_readahead(READAHEADSTREAMFILE *streamfile) {
+    size_t bytes_read;
+    readahead_lock_enter();
+    bytes_read = get_streamfile_bytes_read(streamfile->inner_sf);
+    readahead_lock_leave();
+    return bytes_read;
+}
+static int get_error_count_readahead(READAHEADSTREAMFILE *streamfile) {
+    return streamfile->error_count;
 }
-#endif
 
-static STREAMFILE *open_stdio(STDIOSTREAMFILE *streamFile,const char * const filename,size_t buffersize) {
-    int newfd;
-    FILE *newfile;
-    STREAMFILE *newstreamFile;
+static void close_readahead(READAHEADSTREAMFILE *streamfile) {
+    READAHEADSTREAMFILE ** link;
+    int i;
+
+    /* stop serving this file (waiting for any read in progress) */
+    readahead_lock_enter();
+    while (streamfile->io_busy)
+        readahead_wait();
+    for (link = &readahead_files; *link != NULL; link = &(*link)->next) {
+        if (*link == streamfile) {
+            *link = streamfile->next;
+            break;
+        }
+    }
+    readahead_signal(); /* the thread ends if it was the last file */
+    readahead_lock_leave();
+
+    close_streamfile(streamfile->inner_sf);
+    for (i = 0; i < streamfile->buffer_count; i++) {
+        free(streamfile->buffers[i].data);
+    }
+    free(streamfile->buffers);
+    free(streamfile);
+}
+
+static STREAMFILE *open_readahead(READAHEADSTREAMFILE *streamfile, const char * const filename, size_t buffersize) {
+    char name[PATH_LIMIT];
+    STREAMFILE * new_inner_sf;
+    STREAMFILE * new_sf;
 
     if (!filename)
         return NULL;
 
-    // if same name, duplicate the file pointer we already have open
-    if (!strcmp(streamFile->name,filename)) {
-        if (((newfd = dup(fileno(streamFile->infile))) >= 0) &&
-            (newfile = fdopen( newfd, "rb" ))) 
-        {
-            newstreamFile = open_stdio_streamfile_buffer_by_file(newfile,filename,buffersize);
-            if (newstreamFile) { 
-                return newstreamFile;
+    readahead_lock_enter(); /* inner_sf may be in use by the I/O thread */
+    while (streamfile->io_busy)
+        readahead_wait();
+    streamfile->io_busy = 1;
+    readahead_lock_leave();
+
+    streamfile->inner_sf->get_name(streamfile->inner_sf, name, sizeof(name));
+    new_inner_sf = streamfile->inner_sf->open(streamfile->inner_sf, filename, buffersize);
+
+    readahead_lock_enter();
+    streamfile->io_busy = 0;
+    readahead_signal();
+    readahead_lock_leave();
+
+    /* companion files are usually small and read once */
+    if (!new_inner_sf || strcmp(name,filename) != 0)
+        return new_inner_sf;
+
+    new_sf = open_readahead_streamfile(new_inner_sf, streamfile->buffer_size, streamfile->buffer_count);
+    if (!new_sf)
+        close_streamfile(new_inner_sf);
+    return new_sf;
+}
+
+STREAMFILE * open_readahead_streamfile(STREAMFILE *streamFile, size_t buffer_size, int buffer_count) {
+    READAHEADSTREAMFILE * this_sf = NULL;
+    int i;
+
+    if (!streamFile)
+        return NULL;
+    if (!buffer_size)
+        buffer_size = STREAMFILE_DEFAULT_BUFFER_SIZE;
+    if (buffer_count < 2)
+        buffer_count = 2;
+
+    this_sf = calloc(1,sizeof(READAHEADSTREAMFILE));
+    if (!this_sf) goto fail;
+
+    this_sf->buffers = calloc(buffer_count, sizeof(readahead_buffer));
+    if (!this_sf->buffers) goto fail;
+    this_sf->buffer_count = buffer_count;
+    for (i = 0; i < buffer_count; i++) {
+        this_sf->buffers[i].data = malloc(buffer_size);
+        if (!this_sf->buffers[i].data) goto fail;
+    }
+
+    this_sf->sf.read = (void*)read_readahead;
+    this_sf->sf.get_size = (void*)get_size_readahead;
+    this_sf->sf.get_offset = (void*)get_offset_readahead;
+    this_sf->sf.get_name = (void*)get_name_readahead;
+    this_sf->sf.get_realname = (void*)get_realname_readahead;
+    this_sf->sf.open = (void*)open_readahead;
+    this_sf->sf.close = (void*)close_readahead;
+    this_sf->sf.get_bytes_read = (void*)get_bytes_read_readahead;
+    this_sf->sf.get_error_count = (void*)get_error_count_readahead;
+    this_sf->sf.peek = (void*)peek_readahead;
+    this_sf->sf.stream_index = streamFile->stream_index;
+    this_sf->sf.info_only = streamFile->info_only;
+
+    this_sf->inner_sf = streamFile;
+    this_sf->filesize = get_streamfile_size(streamFile);
+    this_sf->buffer_size = buffer_size;
+
+    /* register and start the I/O thread if needed */
+    readahead_lock_enter();
+    if (!readahead_thread_running) {
+        int started;
+#ifdef _WIN32
+        HANDLE thread = CreateThread(NULL, 0, readahead_thread, NULL, 0, NULL);
+        started = (thread != NULL);
+        if (thread) CloseHandle(thread);
+#else
+        pthread_t thread;
+        started = (pthread_create(&thread, NULL, readahead_thread, NULL) == 0);
+        if (started) pthread_detach(thread);
+#endif
+        if (!started) {
+            readahead_lock_leave();
+            goto fail;
+        }
+        readahead_thread_running = 1;
+    }
+    this_sf->next = readahead_files;
+    readahead_files = this_sf;
+    readahead_lock_leave();
+
+    return &this_sf->sf;
+
+fail:
+    if (this_sf) {
+        if (this_sf->buffers) {
+            for (i = 0; i < this_sf->buffer_count; i++) {
+                free(this_sf->buffers[i].data);
             }
-            // failure, close it and try the default path (which will probably fail a second time)
-            fclose(newfile);
         }
+        free(this_sf->buffers);
+        free(this_sf);
     }
-    // a normal open, open a new file
-    return open_stdio_streamfile_buffer(filename,buffersize);
+    return NULL;
 }
 
-static STREAMFILE * open_stdio_streamfile_buffer_by_file(FILE *infile,const char * const filename, size_t buffersize) {
-    uint8_t * buffer;
-    STDIOSTREAMFILE * streamfile;
+int get_readahead_streamfile_stats(STREAMFILE *streamFile, size_t * hits, size_t * waits, size_t * misses) {
+    READAHEADSTREAMFILE * this_sf = (READAHEADSTREAMFILE*)streamFile;
 
-    buffer = calloc(buffersize,1);
-    if (!buffer) {
-        return NULL;
+    if (!streamFile || streamFile->read != (void*)read_readahead) {
+        if (hits) *hits = 0;
+        if (waits) *waits = 0;
+        if (misses) *misses = 0;
+        return 0;
     }
 
-    streamfile = calloc(1,sizeof(STDIOSTREAMFILE));
-    if (!streamfile) {
-        free(buffer);
-        return NULL;
-    }
+    if (hits) *hits = this_sf->hits;
+    if (waits) *waits = this_sf->waits;
+    if (misses) *misses = this_sf->misses;
+    return 1;
+}
 
-    streamfile->sf.read = (void*)read_stdio;
-    streamfile->sf.get_size = (void*)get_size_stdio;
-    streamfile->sf.get_offset = (void*)get_offset_stdio;
-    streamfile->sf.get_name = (void*)get_name_stdio;
-    streamfile->sf.get_realname = (void*)get_name_stdio;
-    streamfile->sf.open = (void*)open_stdio;
-    streamfile->sf.close = (void*)close_stdio;
-#ifdef PROFILE_STREAMFILE
-    streamfile->sf.get_bytes_read = (void*)get_bytes_read_stdio;
-    streamfile->sf.get_error_count = (void*)get_error_count_stdio;
-#endif
 
-    streamfile->infile = infile;
-    streamfile->buffersize = buffersize;
-    streamfile->buffer = buffer;
+/* **************************************************** */
 
-    strncpy(streamfile->name,filename,sizeof(streamfile->name));
-    streamfile->name[sizeof(streamfile->name)-1] = '\0';
+/* a STREAMFILE that serves reads from the start and end of another STREAMFILE, fetched once
+ * (the end when first read, as for pipes it means waiting for the whole input) */
+typedef struct {
+    STREAMFILE sf;
+    STREAMFILE *inner_sf;   /* not owned */
+    size_t filesize;
+    uint8_t * head;         /* data from 0 */
+    size_t head_size;
+    uint8_t * tail;         /* data from tail_offset to filesize (once fetched) */
+    off_t tail_offset;
+    size_t tail_size;
+    int tail_fetched;
+    size_t read_calls;      /* counters */
+    size_t read_bytes;
+    int open_count;
+    char ext[EXT_SET_EXT_MAX]; /* lowercase extension, for check_extensions */
+    int ext_index;          /* in the format list, or -1 */
+} PROBESTREAMFILE;
+
+static void fetch_probe_tail(PROBESTREAMFILE *streamfile) {
+    size_t tail_size = streamfile->filesize - streamfile->tail_offset;
+    size_t bytes_read = streamfile->inner_sf->stats.bytes_read;
+
+    streamfile->tail_fetched = 1;
+    streamfile->tail = malloc(tail_size);
+    if (!streamfile->tail) return; /* reads go to the inner file */
+    streamfile->tail_size = read_streamfile(streamfile->tail, streamfile->tail_offset, tail_size, streamfile->inner_sf);
+    streamfile->sf.stats.bytes_read += streamfile->inner_sf->stats.bytes_read - bytes_read;
+}
 
-    /* cache filesize */
-    fseeko(streamfile->infile,0,SEEK_END);
-    streamfile->filesize = ftello(streamfile->infile);
+static size_t read_probe(PROBESTREAMFILE *streamfile, uint8_t * dest, off_t offset, size_t length) {
+    size_t length_read, bytes_read;
 
-    return &streamfile->sf;
+    streamfile->read_calls++;
+    streamfile->read_bytes += length;
+
+    if (offset >= 0 && offset + length <= streamfile->head_size) {
+        memcpy(dest, streamfile->head + offset, length);
+        return length;
+    }
+    if (!streamfile->tail_fetched && streamfile->tail_offset && offset >= streamfile->tail_offset)
+        fetch_probe_tail(streamfile);
+    if (streamfile->tail_size && offset >= streamfile->tail_offset && offset + length <= streamfile->tail_offset + streamfile->tail_size) {
+        memcpy(dest, streamfile->tail + (offset - streamfile->tail_offset), length);
+        return length;
+    }
+
+    bytes_read = streamfile->inner_sf->stats.bytes_read;
+    length_read = read_streamfile(dest, offset, length, streamfile->inner_sf);
+    streamfile->sf.stats.bytes_read += streamfile->inner_sf->stats.bytes_read - bytes_read;
+    return length_read;
+}
+static const uint8_t * peek_probe(PROBESTREAMFILE *streamfile, off_t offset, size_t length, size_t * avail) {
+    if (offset >= 0 && offset < streamfile->head_size) {
+        *avail = streamfile->head_size - offset;
+        streamfile->read_calls++;
+        streamfile->read_bytes += length;
+        return streamfile->head + offset;
+    }
+    if (!streamfile->tail_fetched && streamfile->tail_offset && offset >= streamfile->tail_offset)
+        fetch_probe_tail(streamfile);
+    if (streamfile->tail_size && offset >= streamfile->tail_offset && offset < streamfile->tail_offset + streamfile->tail_size) {
+        *avail = streamfile->tail_offset + streamfile->tail_size - offset;
+        streamfile->read_calls++;
+        streamfile->read_bytes += length;
+        return streamfile->tail + (offset - streamfile->tail_offset);
+    }
+    return NULL; /* not read through the inner file, as it could be used by channels */
+}
+static size_t get_size_probe(PROBESTREAMFILE *streamfile) {
+    return streamfile->filesize;
+}
+static off_t get_offset_probe(PROBESTREAMFILE *streamfile) {
+    return streamfile->inner_sf->get_offset(streamfile->inner_sf);
+}
+static void get_name_probe(PROBESTREAMFILE *streamfile, char *buffer, size_t length) {
+    streamfile->inner_sf->get_name(streamfile->inner_sf, buffer, length);
+}
+static void get_realname_probe(PROBESTREAMFILE *streamfile, char *buffer, size_t length) {
+    streamfile->inner_sf->get_realname(streamfile->inner_sf, buffer, length);
+}
+static STREAMFILE *open_probe(PROBESTREAMFILE *streamfile, const char * const filename, size_t buffersize) {
+    /* opened files may outlive detection (ex. channels), so they don't use the window */
+    STREAMFILE * new_sf = streamfile->inner_sf->open(streamfile->inner_sf, filename, buffersize);
+    if (new_sf)
+        streamfile->open_count++;
+    return new_sf;
+}
+static size_t get_bytes_read_probe(PROBESTREAMFILE *streamfile) {
+    return get_streamfile_bytes_read(streamfile->inner_sf);
+}
+static int get_error_count_probe(PROBESTREAMFILE *streamfile) {
+    return get_streamfile_error_count(streamfile->inner_sf);
+}
+static void close_probe(PROBESTREAMFILE *streamfile) {
+    free(streamfile->head);
+    free(streamfile->tail);
+    free(streamfile);
 }
 
-static STREAMFILE * open_stdio_streamfile_buffer(const char * const filename, size_t buffersize) {
-    FILE * infile;
-    STREAMFILE *streamFile;
+STREAMFILE * open_probe_streamfile(STREAMFILE *streamFile, size_t window_size) {
+    PROBESTREAMFILE * this_sf;
 
-    infile = fopen(filename,"rb");
-    if (!infile) return NULL;
+    if (!streamFile)
+        return NULL;
 
-    streamFile = open_stdio_streamfile_buffer_by_file(infile,filename,buffersize);
-    if (!streamFile) {
-        fclose(infile);
+    this_sf = calloc(1,sizeof(PROBESTREAMFILE));
+    if (!this_sf) goto fail;
+
+    this_sf->sf.read = (void*)read_probe;
+    this_sf->sf.get_size = (void*)get_size_probe;
+    this_sf->sf.get_offset = (void*)get_offset_probe;
+    this_sf->sf.get_name = (void*)get_name_probe;
+    this_sf->sf.get_realname = (void*)get_realname_probe;
+    this_sf->sf.open = (void*)open_probe;
+    this_sf->sf.close = (void*)close_probe;
+    this_sf->sf.get_bytes_read = (void*)get_bytes_read_probe;
+    this_sf->sf.get_error_count = (void*)get_error_count_probe;
+    this_sf->sf.peek = (void*)peek_probe;
+    this_sf->sf.stream_index = streamFile->stream_index;
+    this_sf->sf.info_only = streamFile->info_only;
+
+    this_sf->inner_sf = streamFile;
+    this_sf->filesize = get_streamfile_size(streamFile);
+    this_sf->ext_index = get_extension_index(streamFile, this_sf->ext, sizeof(this_sf->ext));
+
+    /* prefetch the start (most headers), and set the end's window (some footers/indexes) */
+    this_sf->head_size = window_size > this_sf->filesize ? this_sf->filesize : window_size;
+    this_sf->head = malloc(this_sf->head_size ? this_sf->head_size : 1);
+    if (!this_sf->head) goto fail;
+    this_sf->head_size = read_streamfile(this_sf->head, 0, this_sf->head_size, streamFile);
+
+    if (this_sf->filesize > this_sf->head_size) {
+        this_sf->tail_offset = this_sf->filesize - window_size;
+        if (this_sf->tail_offset < this_sf->head_size)
+            this_sf->tail_offset = this_sf->head_size;
     }
 
-    return streamFile;
+    return &this_sf->sf;
+
+fail:
+    if (this_sf) close_probe(this_sf);
+    return NULL;
 }
 
+int get_probe_streamfile_counters(STREAMFILE *streamFile, size_t * read_calls, size_t * read_bytes, int * open_count) {
+    PROBESTREAMFILE * this_sf = (PROBESTREAMFILE*)streamFile;
 
-STREAMFILE * open_stdio_streamfile(const char * filename) {
-    return open_stdio_streamfile_buffer(filename,STREAMFILE_DEFAULT_BUFFER_SIZE);
+    if (!streamFile || streamFile->close != (void*)close_probe) {
+        if (read_calls) *read_calls = 0;
+        if (read_bytes) *read_bytes = 0;
+        if (open_count) *open_count = 0;
+        return 0;
+    }
+
+    if (read_calls) *read_calls = this_sf->read_calls;
+    if (read_bytes) *read_bytes = this_sf->read_bytes;
+    if (open_count) *open_count = this_sf->open_count;
+    return 1;
 }
 
-STREAMFILE * open_stdio_streamfile_by_file(FILE * file, const char * filename) {
-    return open_stdio_streamfile_buffer_by_file(file,filename,STREAMFILE_DEFAULT_BUFFER_SIZE);
+
+/* **************************************************** */
+
+void init_header_reader(header_reader * hdr, STREAMFILE * streamfile, off_t offset, size_t size, int big_endian) {
+    hdr->streamfile = streamfile;
+    hdr->big_endian = big_endian;
+    hdr->errors = 0;
+    hdr->offset = offset;
+    hdr->size = 0;
+
+    if (offset < 0)
+        return;
+    if (size > STREAMFILE_HEADER_READER_SIZE)
+        size = STREAMFILE_HEADER_READER_SIZE;
+    hdr->size = read_streamfile(hdr->buf, offset, size, streamfile);
+}
+
+/* field outside the loaded block: load a new one starting at offset */
+const uint8_t * load_header_reader(header_reader * hdr, off_t offset, size_t length) {
+    if (offset < 0 || length > STREAMFILE_HEADER_READER_SIZE)
+        goto fail;
+
+    hdr->offset = offset;
+    hdr->size = read_streamfile(hdr->buf, offset, STREAMFILE_HEADER_READER_SIZE, hdr->streamfile);
+    if (hdr->size < length)
+        goto fail;
+
+    return hdr->buf;
+fail:
+    hdr->errors++;
+    return NULL;
 }
 
 
@@ -519,33 +3794,35 @@ fail:
  * returns 0 on failure
  */
 int check_extensions(STREAMFILE *streamFile, const char * cmp_exts) {
-    char filename[PATH_LIMIT];
-    const char * ext = NULL;
-    const char * cmp_ext = NULL;
-    const char * ststr_res = NULL;
-    size_t ext_len, cmp_len;
-
-    streamFile->get_name(streamFile,filename,sizeof(filename));
-    ext = filename_extension(filename);
-    ext_len = strlen(ext);
-
-    cmp_ext = cmp_exts;
-    do {
-        ststr_res = strstr(cmp_ext, ",");
-        cmp_len = ststr_res == NULL
-                  ? strlen(cmp_ext) /* total length if more not found */
-                  : (intptr_t)ststr_res - (intptr_t)cmp_ext; /* find next ext; ststr_res should always be greater than cmp_ext, resulting in a positive cmp_len */
-
-        if (ext_len == cmp_len && strncasecmp(ext,cmp_ext, ext_len) == 0)
-            return 1;
-
-        cmp_ext = ststr_res;
-        if (cmp_ext != NULL)
-            cmp_ext = cmp_ext + 1; /* skip comma */
+    char ext_buf[EXT_SET_EXT_MAX];
+    const char * ext;
+    int ext_index;
+    ext_set * set;
+
+    /* probe STREAMFILEs already have the extension (always the case during detection) */
+    if (streamFile->close == (void*)close_probe) {
+        PROBESTREAMFILE * probe_sf = (PROBESTREAMFILE*)streamFile;
+        ext = probe_sf->ext;
+        ext_index = probe_sf->ext_index;
+    }
+    else {
+        ext = ext_buf;
+        ext_index = get_extension_index(streamFile, ext_buf, sizeof(ext_buf));
+    }
 
-    } while (cmp_ext != NULL);
+    set = get_ext_set(cmp_exts);
+    if (set && ext_index >= 0)
+        return (set->bits[ext_index / 32] >> (ext_index % 32)) & 1;
+    if (set && !set->has_unlisted)
+        return 0;
 
-    return 0;
+    /* unusual extension, or too long (not indexed, so compare the full name) */
+    if (ext_index < 0 && strlen(ext) + 1 >= sizeof(ext_buf)) {
+        char filename[PATH_LIMIT];
+        streamFile->get_name(streamFile,filename,sizeof(filename));
+        return check_extension_list(filename_extension(filename), cmp_exts);
+    }
+    return check_extension_list(ext, cmp_exts);
 }
 
 
@@ -33,6 +33,16 @@
 #endif
 
 #define STREAMFILE_DEFAULT_BUFFER_SIZE 0x8000
+#define STREAMFILE_PROBE_WINDOW_SIZE 0x8000
+#define STREAMFILE_PAGE_CACHE_PAGE_SIZE 0x2000
+#define STREAMFILE_HEADER_READER_SIZE 0x1000
+#define STREAMFILE_STDIO_REFILL_MIN 0x1000  /* bounds of the stdio adaptive refill size (default or bigger buffers) */
+#define STREAMFILE_STDIO_REFILL_MAX 0x40000
+#define STREAMFILE_PIPE_HEAD_SIZE 0x10000    /* pipe input kept in memory from the start */
+#define STREAMFILE_PIPE_RING_SIZE 0x100000   /* latest pipe input kept in memory */
+#define STREAMFILE_PIPE_SPILL_SIZE 0x40000000 /* older pipe input kept in a temp file (default) */
+#define STREAMFILE_PIPE_SIZE_MAX 0x7FFFFFFF    /* size of pipe inputs of unknown size until their end is read */
+#define STREAMFILE_ARCHIVE_NAME_SIZE 0x100
 
 #ifndef DIR_SEPARATOR
 #if defined (_WIN32) || defined (WIN32)
@@ -42,6 +52,33 @@
 #endif
 #endif
 
+/* access pattern detected by backends that adapt their buffering to it (stdio) */
+typedef enum {
+    STREAMFILE_ACCESS_UNKNOWN = 0,  /* not detected (or fixed buffering) */
+    STREAMFILE_ACCESS_SEQUENTIAL,   /* refills continue the previous buffer: grow refills */
+    STREAMFILE_ACCESS_STRIDED,      /* refills jump by a constant distance: refill what each jump uses */
+    STREAMFILE_ACCESS_RANDOM        /* anything else: shrink refills */
+} streamfile_access_t;
+
+/* I/O counters kept in every STREAMFILE. Reads and seeks are counted by read_streamfile/peek_streamfile
+ * (and helpers), bytes_read by the backend when it fills its buffer from the OS or the STREAMFILE it wraps
+ * (unbuffered wrappers pass the inner file's count up), so reads that didn't increase it were served from
+ * the backend's buffer/cache/memory (hits). */
+typedef struct {
+    size_t reads;               /* read and peek calls */
+    size_t buffer_hits;         /* reads served without reading from the OS/inner file */
+    size_t buffer_misses;       /* reads that had to */
+    size_t seeks;               /* reads not starting where the previous one ended */
+    size_t bytes_read;          /* bytes read from the OS/inner file */
+    size_t bytes_copied;        /* bytes copied out to callers (peeks copy nothing) */
+    size_t max_backward_seek;   /* largest distance a read went back from the previous one's end */
+    int error_count;            /* read errors (from get_error_count, filled by get_streamfile_stats) */
+    streamfile_access_t access; /* last detected access pattern (adaptive backends only) */
+    size_t refill_size;         /* buffer refill size chosen for it */
+
+    off_t next_offset;          /* end of the previous read */
+} streamfile_stats;
+
 /* struct representing a file with callbacks. Code should use STREAMFILEs and not std C functions
  * to do file operations, as plugins may need to provide their own callbacks. */
 typedef struct _STREAMFILE {
@@ -55,16 +92,27 @@ typedef struct _STREAMFILE {
     struct _STREAMFILE * (*open)(struct _STREAMFILE *,const char * const filename,size_t buffersize);
     void (*close)(struct _STREAMFILE *);
 
-#ifdef PROFILE_STREAMFILE
+    /* optional I/O counters for profiling (NULL if not supported) */
     size_t (*get_bytes_read)(struct _STREAMFILE *);
     int (*get_error_count)(struct _STREAMFILE *);
-#endif
+
+    /* optional zero-copy read (NULL if not supported): returns a pointer to the data at offset in the
+     * STREAMFILE's own buffer/memory, valid until the next call on it, and sets how many bytes are
+     * there (may be less than length). Returns NULL if the data can't be served that way. */
+    const uint8_t * (*peek)(struct _STREAMFILE *, off_t offset, size_t length, size_t * avail);
 
 
     /* Substream selection for files with multiple streams. Manually used in metas if supported.
      * Not ideal here, but it's the simplest way to pass to all init_vgmstream_x functions. */
     int stream_index; /* 0=default/auto (first), 1=first, N=Nth */
 
+    /* Metadata-only open: metas and codec inits may skip decoder setup and key searches,
+     * as the resulting VGMSTREAM is only used to get info and won't be rendered. */
+    int info_only;
+
+    /* I/O counters, see streamfile_stats */
+    streamfile_stats stats;
+
 } STREAMFILE;
 
 /* create a STREAMFILE from path */
@@ -73,15 +121,155 @@ STREAMFILE * open_stdio_streamfile(const char * filename);
 /* create a STREAMFILE from pre-opened file path */
 STREAMFILE * open_stdio_streamfile_by_file(FILE * file, const char * filename);
 
+/* create a STREAMFILE that reads from a memory mapping of the file, sharing it with other files
+ * opened with the same name (falls back to stdio if the file can't be mapped) */
+STREAMFILE * open_mmap_streamfile(const char * filename);
+
+/* create a STREAMFILE that reads with positioned reads (no shared file position), sharing the
+ * descriptor with other files opened with the same name, so each can be used from its own thread */
+STREAMFILE * open_pread_streamfile(const char * filename);
+
+/* opens companion files (same dir, other names) of a memory STREAMFILE, returning NULL if not found */
+typedef STREAMFILE * (*memory_streamfile_resolver)(void * resolver_data, const char * filename);
+
+/* create a STREAMFILE that reads from a buffer, named as a file (ext matters for detection).
+ * The buffer isn't copied and must stay valid until the STREAMFILE and any opened from it are closed.
+ * Without a resolver, only the same name can be re-opened. */
+STREAMFILE * open_memory_streamfile(const uint8_t * buf, size_t size, const char * name);
+STREAMFILE * open_memory_streamfile_by_resolver(const uint8_t * buf, size_t size, const char * name, memory_streamfile_resolver resolver, void * resolver_data);
+
+/* enable or disable a shared cache of directory listings, so stdio opens of missing companion files
+ * (.txth, .hcakey, L/R pairs, etc) fail without touching the filesystem. Files created while
+ * enabled won't be found until the cache is flushed. */
+void set_streamfile_dir_cache(int enable);
+void flush_streamfile_dir_cache(void);
+
+/* create a STREAMFILE that reads another STREAMFILE ahead in buffer_count buffers of buffer_size on a
+ * background thread when access is sequential. Opening the same name returns a new read-ahead file.
+ * The original STREAMFILE is closed with it (if this fails it's left open). */
+STREAMFILE * open_readahead_streamfile(STREAMFILE *streamFile, size_t buffer_size, int buffer_count);
+
+/* get reads done through a read-ahead STREAMFILE: served from ready buffers, that waited for
+ * the I/O thread, and read synchronously. Returns 0 (and zeroes) if it's not a read-ahead STREAMFILE. */
+int get_readahead_streamfile_stats(STREAMFILE *streamFile, size_t * hits, size_t * waits, size_t * misses);
+
+/* create a STREAMFILE that serves reads at the start and end of another STREAMFILE from memory,
+ * for detection where many metas read the same headers. The original STREAMFILE isn't closed. */
+STREAMFILE * open_probe_streamfile(STREAMFILE *streamFile, size_t window_size);
+
+/* create a STREAMFILE that reads another STREAMFILE through an LRU cache of pages of up to cache_size.
+ * Opening the same name returns a new view sharing the cache. The original STREAMFILE is closed with
+ * the last view (if this fails it's left open). */
+STREAMFILE * open_page_cache_streamfile(STREAMFILE *streamFile, size_t cache_size);
+
+/* transforms for open_transform_streamfile, applied to bytes in [start, start+size) (size 0: until EOF),
+ * where pos is the byte's offset from start */
+typedef enum {
+    STREAMFILE_TRANSFORM_XOR,           /* byte ^ value */
+    STREAMFILE_TRANSFORM_ADD,           /* byte + value */
+    STREAMFILE_TRANSFORM_XOR_KEY,       /* byte ^ key[pos % key_size] */
+    STREAMFILE_TRANSFORM_XOR_OFFSET     /* byte ^ (pos + value) */
+} streamfile_transform_t;
+
+typedef struct {
+    streamfile_transform_t type;
+    uint8_t value;
+    const uint8_t * key;    /* copied on open */
+    size_t key_size;
+    off_t start;
+    size_t size;
+} streamfile_transform;
+
+/* create a STREAMFILE that returns another STREAMFILE's bytes with a transform applied (simple encryption),
+ * done once per buffer_size buffer (0: default). Transform files can be stacked. Opening the same name
+ * returns a new transform file, others aren't transformed.
+ * The original STREAMFILE is closed with it (if this fails it's left open). */
+STREAMFILE * open_transform_streamfile(STREAMFILE *streamFile, const streamfile_transform * transform, size_t buffer_size);
+
+/* create a STREAMFILE that is a window of size bytes (0: until EOF) at offset of another STREAMFILE,
+ * named like it but with fake_ext (if not NULL), to parse files inside banks with their own metas.
+ * Reads go through the original, which isn't closed and must outlive it. Opening the same name
+ * re-opens the original into a new window that owns it, others open files next to the original. */
+STREAMFILE * open_subfile(STREAMFILE *streamFile, off_t offset, size_t size, const char * fake_ext);
+
+/* create a STREAMFILE that reads a non-seekable file (stdin, sockets) once as it's read, named as a file
+ * (ext matters for detection). Besides the start and latest data kept in memory (STREAMFILE_PIPE_HEAD_SIZE
+ * and _RING_SIZE), up to spill_size bytes (0: STREAMFILE_PIPE_SPILL_SIZE) of older data are kept in a temp file.
+ * Reads can go back only to data still kept, and fail otherwise (counted in the error count and as lost).
+ * With size 0 (unknown) inputs smaller than the ring report their size, and bigger ones STREAMFILE_PIPE_SIZE_MAX
+ * until their end is read, so metas that take data sizes from the file size need it passed if known.
+ * Opening the same name returns a new view of the input, others open regular files. The file isn't closed. */
+STREAMFILE * open_pipe_streamfile(FILE * file, const char * name, size_t size, size_t spill_size);
+
+/* entry of a streamfile_archive */
+typedef struct {
+    char name[STREAMFILE_ARCHIVE_NAME_SIZE]; /* path inside the archive (generated if it has no names) */
+    off_t offset;
+    size_t size;
+} streamfile_archive_entry;
+
+/* An archive (AFS, CPK...) whose table of contents is read once (see open_streamfile_archive).
+ * Entries open as STREAMFILEs named "(archive path)/(entry name)" that read the archive in place,
+ * all through the archive's one STREAMFILE (kept while entries are open), so there is no extraction,
+ * copy or extra open per entry. Entry names use DIR_SEPARATOR for dirs and are unique. */
+typedef struct {
+    STREAMFILE * streamfile;    /* archive file */
+    int entry_count;
+    streamfile_archive_entry * entries;
+    int entry_max;
+    int refcount;               /* archive handle and open entries (all used from the same thread) */
+    char * name;                /* archive path */
+} streamfile_archive;
+
+/* create an empty archive on a re-open of the STREAMFILE (which isn't kept), for archive parsers */
+streamfile_archive * allocate_streamfile_archive(STREAMFILE *streamFile);
+/* add an entry (for archive parsers; names must be unique), returns 0 on error */
+int add_streamfile_archive_entry(streamfile_archive * archive, const char * name, off_t offset, size_t size);
+/* get an entry's index by name (case insensitive, either separator), or -1 if not found */
+int find_streamfile_archive_entry(streamfile_archive * archive, const char * name);
+/* create a STREAMFILE of an entry. Opening other names from it looks for them in the archive first
+ * (companion files), then next to the archive. */
+STREAMFILE * open_streamfile_archive_entry(streamfile_archive * archive, int index);
+/* close the archive (entries still open keep it alive) */
+void close_streamfile_archive(streamfile_archive * archive);
+
+/* get reads of a pipe's input that needed data no longer kept, with the lowest offset and total bytes
+ * they missed (any view of the input), returns 0 (and zeroes) if none or not a pipe */
+int get_pipe_streamfile_loss(STREAMFILE *streamFile, off_t * lost_offset, size_t * lost_size);
+
+/* get reads done through a probe STREAMFILE and files opened from it, returns 0 (and zeroes) if not a probe */
+int get_probe_streamfile_counters(STREAMFILE *streamFile, size_t * read_calls, size_t * read_bytes, int * open_count);
 
 /* close a file, destroy the STREAMFILE object */
 static inline void close_streamfile(STREAMFILE * streamfile) {
     streamfile->close(streamfile);
 }
 
+static inline void count_streamfile_read(STREAMFILE * streamfile, off_t offset, size_t length, size_t length_copied, size_t bytes_read_before) {
+    streamfile_stats * stats = &streamfile->stats;
+
+    stats->reads++;
+    if (stats->bytes_read != bytes_read_before)
+        stats->buffer_misses++;
+    else
+        stats->buffer_hits++;
+    if (offset != stats->next_offset) {
+        size_t backward_seek = offset < stats->next_offset ? (size_t)(stats->next_offset - offset) : 0; /* unsigned compare (C++) */
+        stats->seeks++;
+        if (backward_seek > stats->max_backward_seek)
+            stats->max_backward_seek = backward_seek;
+    }
+    stats->next_offset = offset + length;
+    stats->bytes_copied += length_copied;
+}
+
 /* read from a file, returns number of bytes read */
 static inline size_t read_streamfile(uint8_t * dest, off_t offset, size_t length, STREAMFILE * streamfile) {
-    return streamfile->read(streamfile,dest,offset,length);
+    size_t bytes_read = streamfile->stats.bytes_read;
+    size_t length_read = streamfile->read(streamfile,dest,offset,length);
+
+    count_streamfile_read(streamfile, offset, length_read, length_read, bytes_read);
+    return length_read;
 }
 
 /* return file size */
@@ -89,7 +277,6 @@ static inline size_t get_streamfile_size(STREAMFILE * streamfile) {
     return streamfile->get_size(streamfile);
 }
 
-#ifdef PROFILE_STREAMFILE
 /* return how many bytes we read into buffers */
 static inline size_t get_streamfile_bytes_read(STREAMFILE * streamfile) {
     if (streamfile->get_bytes_read)
@@ -105,53 +292,174 @@ static inline int get_streamfile_error_count(STREAMFILE * streamfile) {
     else
         return 0;
 }
-#endif
+
+/* get the file's I/O counters */
+static inline void get_streamfile_stats(STREAMFILE * streamfile, streamfile_stats * stats) {
+    *stats = streamfile->stats;
+    stats->error_count = get_streamfile_error_count(streamfile);
+}
+
+/* get a pointer to the data at offset, borrowed from the STREAMFILE (valid until the next read),
+ * or NULL if not possible; avail is set to the bytes that can be used from it */
+static inline const uint8_t * peek_streamfile(STREAMFILE * streamfile, off_t offset, size_t length, size_t * avail) {
+    size_t peek_avail = 0;
+    const uint8_t * ptr = NULL;
+
+    if (streamfile->peek) {
+        size_t bytes_read = streamfile->stats.bytes_read;
+        ptr = streamfile->peek(streamfile, offset, length, &peek_avail);
+        if (ptr)
+            count_streamfile_read(streamfile, offset, length < peek_avail ? length : peek_avail, 0, bytes_read);
+    }
+    if (avail)
+        *avail = ptr ? peek_avail : 0;
+    return ptr;
+}
+
+/* get a pointer to length bytes at offset, borrowed from the STREAMFILE if the whole range is there,
+ * or copied into buf otherwise. Returns NULL if they can't be read, but bytes that couldn't are set
+ * to 0xFF in buf (what read_8bit returns), so decoders may use buf anyway rather than failing. */
+static inline const uint8_t * read_streamfile_ptr(uint8_t * buf, off_t offset, size_t length, STREAMFILE * streamfile) {
+    size_t length_read;
+
+    if (streamfile->peek) {
+        size_t avail = 0;
+        size_t bytes_read = streamfile->stats.bytes_read;
+        const uint8_t * ptr = streamfile->peek(streamfile, offset, length, &avail);
+        if (ptr && avail >= length) {
+            count_streamfile_read(streamfile, offset, length, 0, bytes_read);
+            return ptr;
+        }
+    }
+
+    length_read = offset < 0 ? 0 : read_streamfile(buf,offset,length,streamfile);
+    if (length_read < length) {
+        memset(buf + length_read, 0xFF, length - length_read);
+        return NULL;
+    }
+    return buf;
+}
 
 /* Sometimes you just need an int, and we're doing the buffering.
 * Note, however, that if these fail to read they'll return -1,
 * so that should not be a valid value or there should be some backup. */
 static inline int16_t read_16bitLE(off_t offset, STREAMFILE * streamfile) {
     uint8_t buf[2];
+    const uint8_t * ptr = read_streamfile_ptr(buf,offset,2,streamfile);
 
-    if (read_streamfile(buf,offset,2,streamfile)!=2) return -1;
-    return get_16bitLE(buf);
+    if (!ptr) return -1;
+    return get_16bitLE((uint8_t *)ptr);
 }
 static inline int16_t read_16bitBE(off_t offset, STREAMFILE * streamfile) {
     uint8_t buf[2];
+    const uint8_t * ptr = read_streamfile_ptr(buf,offset,2,streamfile);
 
-    if (read_streamfile(buf,offset,2,streamfile)!=2) return -1;
-    return get_16bitBE(buf);
+    if (!ptr) return -1;
+    return get_16bitBE((uint8_t *)ptr);
 }
 static inline int32_t read_32bitLE(off_t offset, STREAMFILE * streamfile) {
     uint8_t buf[4];
+    const uint8_t * ptr = read_streamfile_ptr(buf,offset,4,streamfile);
 
-    if (read_streamfile(buf,offset,4,streamfile)!=4) return -1;
-    return get_32bitLE(buf);
+    if (!ptr) return -1;
+    return get_32bitLE((uint8_t *)ptr);
 }
 static inline int32_t read_32bitBE(off_t offset, STREAMFILE * streamfile) {
     uint8_t buf[4];
+    const uint8_t * ptr = read_streamfile_ptr(buf,offset,4,streamfile);
 
-    if (read_streamfile(buf,offset,4,streamfile)!=4) return -1;
-    return get_32bitBE(buf);
+    if (!ptr) return -1;
+    return get_32bitBE((uint8_t *)ptr);
 }
 static inline int64_t read_64bitLE(off_t offset, STREAMFILE * streamfile) {
     uint8_t buf[8];
+    const uint8_t * ptr = read_streamfile_ptr(buf,offset,8,streamfile);
 
-    if (read_streamfile(buf,offset,8,streamfile)!=8) return -1;
-    return get_64bitLE(buf);
+    if (!ptr) return -1;
+    return get_64bitLE((uint8_t *)ptr);
 }
 static inline int64_t read_64bitBE(off_t offset, STREAMFILE * streamfile) {
     uint8_t buf[8];
+    const uint8_t * ptr = read_streamfile_ptr(buf,offset,8,streamfile);
 
-    if (read_streamfile(buf,offset,8,streamfile)!=8) return -1;
-    return get_64bitBE(buf);
+    if (!ptr) return -1;
+    return get_64bitBE((uint8_t *)ptr);
 }
 
 static inline int8_t read_8bit(off_t offset, STREAMFILE * streamfile) {
     uint8_t buf[1];
+    const uint8_t * ptr = read_streamfile_ptr(buf,offset,1,streamfile);
+
+    if (!ptr) return -1;
+    return ptr[0];
+}
+
+/* Header reader: loads a block of the file once and decodes fields from it, to avoid
+ * a STREAMFILE read per field. Fields outside the block reload it at that offset.
+ * Failed reads return -1 like read_Nbit, and are counted in 'errors'. */
+typedef struct {
+    STREAMFILE * streamfile;
+    off_t offset;       /* file offset of buf[0] */
+    size_t size;        /* valid bytes in buf */
+    int big_endian;     /* for read_hdr_Nbit */
+    int errors;
+    uint8_t buf[STREAMFILE_HEADER_READER_SIZE];
+} header_reader;
+
+void init_header_reader(header_reader * hdr, STREAMFILE * streamfile, off_t offset, size_t size, int big_endian);
+const uint8_t * load_header_reader(header_reader * hdr, off_t offset, size_t length);
+
+static inline const uint8_t * get_header_reader_ptr(header_reader * hdr, off_t offset, size_t length) {
+    if (offset >= hdr->offset && offset + length <= hdr->offset + hdr->size)
+        return hdr->buf + (offset - hdr->offset);
+    return load_header_reader(hdr, offset, length);
+}
 
-    if (read_streamfile(buf,offset,1,streamfile)!=1) return -1;
-    return buf[0];
+static inline int8_t read_hdr_8bit(off_t offset, header_reader * hdr) {
+    const uint8_t * ptr = get_header_reader_ptr(hdr,offset,1);
+    if (!ptr) return -1;
+    return ptr[0];
+}
+static inline int16_t read_hdr_16bitLE(off_t offset, header_reader * hdr) {
+    const uint8_t * ptr = get_header_reader_ptr(hdr,offset,2);
+    if (!ptr) return -1;
+    return get_16bitLE((uint8_t *)ptr);
+}
+static inline int16_t read_hdr_16bitBE(off_t offset, header_reader * hdr) {
+    const uint8_t * ptr = get_header_reader_ptr(hdr,offset,2);
+    if (!ptr) return -1;
+    return get_16bitBE((uint8_t *)ptr);
+}
+static inline int32_t read_hdr_32bitLE(off_t offset, header_reader * hdr) {
+    const uint8_t * ptr = get_header_reader_ptr(hdr,offset,4);
+    if (!ptr) return -1;
+    return get_32bitLE((uint8_t *)ptr);
+}
+static inline int32_t read_hdr_32bitBE(off_t offset, header_reader * hdr) {
+    const uint8_t * ptr = get_header_reader_ptr(hdr,offset,4);
+    if (!ptr) return -1;
+    return get_32bitBE((uint8_t *)ptr);
+}
+static inline int64_t read_hdr_64bitLE(off_t offset, header_reader * hdr) {
+    const uint8_t * ptr = get_header_reader_ptr(hdr,offset,8);
+    if (!ptr) return -1;
+    return get_64bitLE((uint8_t *)ptr);
+}
+static inline int64_t read_hdr_64bitBE(off_t offset, header_reader * hdr) {
+    const uint8_t * ptr = get_header_reader_ptr(hdr,offset,8);
+    if (!ptr) return -1;
+    return get_64bitBE((uint8_t *)ptr);
+}
+
+/* reads using the reader's endianness */
+static inline int16_t read_hdr_16bit(off_t offset, header_reader * hdr) {
+    return hdr->big_endian ? read_hdr_16bitBE(offset,hdr) : read_hdr_16bitLE(offset,hdr);
+}
+static inline int32_t read_hdr_32bit(off_t offset, header_reader * hdr) {
+    return hdr->big_endian ? read_hdr_32bitBE(offset,hdr) : read_hdr_32bitLE(offset,hdr);
+}
+static inline int64_t read_hdr_64bit(off_t offset, header_reader * hdr) {
+    return hdr->big_endian ? read_hdr_64bitBE(offset,hdr) : read_hdr_64bitLE(offset,hdr);
 }
 
 /* various STREAMFILE helpers functions */
@@ -166,6 +474,8 @@ int read_string(char * buf, size_t bufsize, off_t offset, STREAMFILE *streamFile
 int read_key_file(uint8_t * buf, size_t bufsize, STREAMFILE *streamFile);
 int read_pos_file(uint8_t * buf, size_t bufsize, STREAMFILE *streamFile);
 
+/* Checks if the file's extension is in a comma-separated list (ex. "adx" or "adx,aix"), returns 0 if not.
+ * Lists are compiled once and cached by their contents, so checks with the same list are cheap. */
 int check_extensions(STREAMFILE *streamFile, const char * cmp_exts);
 
 int find_chunk_be(STREAMFILE *streamFile, uint32_t chunk_id, off_t start_offset, int full_chunk_size, off_t *out_chunk_offset, size_t *out_chunk_size);
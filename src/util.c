@@ -1,4 +1,7 @@
 #include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
 #include "util.h"
 #include "streamtypes.h"
 
@@ -105,3 +108,22 @@ void concatn(int length, char * dst, const char * src) {
         dst[i]=src[j];
     dst[i]='\0';
 }
+
+#ifdef _WIN32
+/* no InitOnceExecuteOnce in XP: 0=not done, 1=running, 2=done */
+void vgm_once(vgm_once_flag * flag, void (*init)(void)) {
+    if (InterlockedCompareExchange(flag, 2, 2) == 2)
+        return;
+    if (InterlockedCompareExchange(flag, 1, 0) == 0) {
+        init();
+        InterlockedExchange(flag, 2);
+        return;
+    }
+    while (InterlockedCompareExchange(flag, 2, 2) != 2)
+        Sleep(0);
+}
+#else
+void vgm_once(vgm_once_flag * flag, void (*init)(void)) {
+    pthread_once(flag, init);
+}
+#endif
@@ -76,6 +76,18 @@ void swap_samples_le(sample *buf, int count);
 
 void concatn(int length, char * dst, const char * src);
 
+/* Runs init the first time it's called with a flag (set to VGM_ONCE_INIT), even if called from several
+ * threads at once (others wait until it's done). For tables and locks set up on first use. */
+#ifdef _WIN32
+typedef volatile long vgm_once_flag;
+#define VGM_ONCE_INIT 0
+#else
+#include <pthread.h>
+typedef pthread_once_t vgm_once_flag;
+#define VGM_ONCE_INIT PTHREAD_ONCE_INIT
+#endif
+void vgm_once(vgm_once_flag * flag, void (*init)(void));
+
 
 /* Simple stdout logging for debugging and regression testing purposes.
  * Needs C99 variadic macros, uses do..while to force ; as statement */
@@ -5,6 +5,11 @@
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
+#include <time.h>
+#include <sys/stat.h>
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#endif
 #include "vgmstream.h"
 #include "meta/meta.h"
 #include "layout/layout.h"
@@ -13,470 +18,751 @@
 static void try_dual_file_stereo(VGMSTREAM * opened_vgmstream, STREAMFILE *streamFile, VGMSTREAM* (*init_vgmstream_function)(STREAMFILE*));
 
 
+typedef struct {
+    VGMSTREAM * (*function)(STREAMFILE *streamFile);
+    const char * name;  /* for profiling and the probe cache */
+} init_vgmstream_entry;
+
 /* List of functions that will recognize files */
-VGMSTREAM * (*init_vgmstream_functions[])(STREAMFILE *streamFile) = {
-    init_vgmstream_adx,
-    init_vgmstream_brstm,
-	init_vgmstream_bfwav,
-	init_vgmstream_bfstm,
-	init_vgmstream_mca,
-	init_vgmstream_btsnd,
-    init_vgmstream_nds_strm,
-    init_vgmstream_agsc,
-    init_vgmstream_ngc_adpdtk,
-    init_vgmstream_rsf,
-    init_vgmstream_afc,
-    init_vgmstream_ast,
-    init_vgmstream_halpst,
-    init_vgmstream_rs03,
-    init_vgmstream_ngc_dsp_std,
-    init_vgmstream_ngc_mdsp_std,
-	init_vgmstream_ngc_dsp_csmp,
-    init_vgmstream_cstr,
-    init_vgmstream_gcsw,
-    init_vgmstream_ps2_ads,
-    init_vgmstream_ps2_npsf,
-    init_vgmstream_rwsd,
-    init_vgmstream_cdxa,
-    init_vgmstream_ps2_rxws,
-    init_vgmstream_ps2_rxw,
-    init_vgmstream_ps2_int,
-    init_vgmstream_ngc_dsp_stm,
-    init_vgmstream_ps2_exst,
-    init_vgmstream_ps2_svag,
-    init_vgmstream_ps2_mib,
-    init_vgmstream_ngc_mpdsp,
-    init_vgmstream_ps2_mic,
-    init_vgmstream_ngc_dsp_std_int,
-    init_vgmstream_raw,
-    init_vgmstream_ps2_vag,
-    init_vgmstream_psx_gms,
-    init_vgmstream_ps2_str,
-    init_vgmstream_ps2_ild,
-    init_vgmstream_ps2_pnb,
-    init_vgmstream_xbox_wavm,
-    init_vgmstream_xbox_xwav,
-    init_vgmstream_ngc_str,
-    init_vgmstream_ea_schl,
-    init_vgmstream_caf,
-    init_vgmstream_ps2_vpk,
-    init_vgmstream_genh,
+const init_vgmstream_entry init_vgmstream_functions[] = {
+    {init_vgmstream_adx, "adx"},
+    {init_vgmstream_brstm, "brstm"},
+	{init_vgmstream_bfwav, "bfwav"},
+	{init_vgmstream_bfstm, "bfstm"},
+	{init_vgmstream_mca, "mca"},
+	{init_vgmstream_btsnd, "btsnd"},
+    {init_vgmstream_nds_strm, "nds_strm"},
+    {init_vgmstream_agsc, "agsc"},
+    {init_vgmstream_ngc_adpdtk, "ngc_adpdtk"},
+    {init_vgmstream_rsf, "rsf"},
+    {init_vgmstream_afc, "afc"},
+    {init_vgmstream_ast, "ast"},
+    {init_vgmstream_halpst, "halpst"},
+    {init_vgmstream_rs03, "rs03"},
+    {init_vgmstream_ngc_dsp_std, "ngc_dsp_std"},
+    {init_vgmstream_ngc_mdsp_std, "ngc_mdsp_std"},
+	{init_vgmstream_ngc_dsp_csmp, "ngc_dsp_csmp"},
+    {init_vgmstream_cstr, "cstr"},
+    {init_vgmstream_gcsw, "gcsw"},
+    {init_vgmstream_ps2_ads, "ps2_ads"},
+    {init_vgmstream_ps2_npsf, "ps2_npsf"},
+    {init_vgmstream_rwsd, "rwsd"},
+    {init_vgmstream_cdxa, "cdxa"},
+    {init_vgmstream_ps2_rxws, "ps2_rxws"},
+    {init_vgmstream_ps2_rxw, "ps2_rxw"},
+    {init_vgmstream_ps2_int, "ps2_int"},
+    {init_vgmstream_ngc_dsp_stm, "ngc_dsp_stm"},
+    {init_vgmstream_ps2_exst, "ps2_exst"},
+    {init_vgmstream_ps2_svag, "ps2_svag"},
+    {init_vgmstream_ps2_mib, "ps2_mib"},
+    {init_vgmstream_ngc_mpdsp, "ngc_mpdsp"},
+    {init_vgmstream_ps2_mic, "ps2_mic"},
+    {init_vgmstream_ngc_dsp_std_int, "ngc_dsp_std_int"},
+    {init_vgmstream_raw, "raw"},
+    {init_vgmstream_ps2_vag, "ps2_vag"},
+    {init_vgmstream_psx_gms, "psx_gms"},
+    {init_vgmstream_ps2_str, "ps2_str"},
+    {init_vgmstream_ps2_ild, "ps2_ild"},
+    {init_vgmstream_ps2_pnb, "ps2_pnb"},
+    {init_vgmstream_xbox_wavm, "xbox_wavm"},
+    {init_vgmstream_xbox_xwav, "xbox_xwav"},
+    {init_vgmstream_ngc_str, "ngc_str"},
+    {init_vgmstream_ea_schl, "ea_schl"},
+    {init_vgmstream_caf, "caf"},
+    {init_vgmstream_ps2_vpk, "ps2_vpk"},
+    {init_vgmstream_genh, "genh"},
 #ifdef VGM_USE_VORBIS
-    init_vgmstream_ogg_vorbis,
-    init_vgmstream_sli_ogg,
-    init_vgmstream_sfl,
+    {init_vgmstream_ogg_vorbis, "ogg_vorbis"},
+    {init_vgmstream_sli_ogg, "sli_ogg"},
+    {init_vgmstream_sfl, "sfl"},
 #endif
 #if 0
-	init_vgmstream_mp4_aac,
+	{init_vgmstream_mp4_aac, "mp4_aac"},
 #endif
 #if defined(VGM_USE_MP4V2) && defined(VGM_USE_FDKAAC)
-	init_vgmstream_akb,
+	{init_vgmstream_akb, "akb"},
 #endif
-    init_vgmstream_sadb,
-    init_vgmstream_ps2_bmdx,
-    init_vgmstream_wsi,
-    init_vgmstream_aifc,
-    init_vgmstream_str_snds,
-    init_vgmstream_ws_aud,
-    init_vgmstream_ahx,
-    init_vgmstream_ivb,
-    init_vgmstream_svs,
-    init_vgmstream_riff,
-    init_vgmstream_rifx,
-    init_vgmstream_pos,
-    init_vgmstream_nwa,
-    init_vgmstream_ea_1snh,
-    init_vgmstream_xss,
-    init_vgmstream_sl3,
-    init_vgmstream_hgc1,
-    init_vgmstream_aus,
-    init_vgmstream_rws,
-    init_vgmstream_fsb,
-    init_vgmstream_fsb4_wav,
-    init_vgmstream_fsb5,
-    init_vgmstream_rwx,
-    init_vgmstream_xwb,
-    init_vgmstream_ps2_xa30,
-    init_vgmstream_musc,
-    init_vgmstream_musx_v004,
-    init_vgmstream_musx_v005,
-    init_vgmstream_musx_v006,
-    init_vgmstream_musx_v010,
-    init_vgmstream_musx_v201,
-    init_vgmstream_leg,
-    init_vgmstream_filp,
-    init_vgmstream_ikm,
-    init_vgmstream_sfs,
-    init_vgmstream_bg00,
-    init_vgmstream_sat_dvi,
-    init_vgmstream_dc_kcey,
-    init_vgmstream_ps2_rstm,
-    init_vgmstream_acm,
-    init_vgmstream_mus_acm,
-    init_vgmstream_ps2_kces,
-    init_vgmstream_ps2_dxh,
-    init_vgmstream_ps2_psh,
-    init_vgmstream_scd_pcm,
-	init_vgmstream_ps2_pcm,
-    init_vgmstream_ps2_rkv,
-    init_vgmstream_ps2_psw,
-    init_vgmstream_ps2_vas,
-    init_vgmstream_ps2_tec,
-    init_vgmstream_ps2_enth,
-    init_vgmstream_sdt,
-    init_vgmstream_aix,
-    init_vgmstream_ngc_tydsp,
-    init_vgmstream_ngc_swd,
-    init_vgmstream_capdsp,
-    init_vgmstream_xbox_wvs,
-    init_vgmstream_ngc_wvs,
-    init_vgmstream_dc_str,
-    init_vgmstream_dc_str_v2,
-    init_vgmstream_xbox_matx,
-    init_vgmstream_dec,
-    init_vgmstream_vs,
-    init_vgmstream_dc_str,
-    init_vgmstream_dc_str_v2,
-    init_vgmstream_xbox_xmu,
-    init_vgmstream_xbox_xvas,
-    init_vgmstream_ngc_bh2pcm,
-    init_vgmstream_sat_sap,
-    init_vgmstream_dc_idvi,
-    init_vgmstream_ps2_rnd,
-    init_vgmstream_wii_idsp,
-    init_vgmstream_kraw,
-    init_vgmstream_ps2_omu,
-    init_vgmstream_ps2_xa2,
+    {init_vgmstream_sadb, "sadb"},
+    {init_vgmstream_ps2_bmdx, "ps2_bmdx"},
+    {init_vgmstream_wsi, "wsi"},
+    {init_vgmstream_aifc, "aifc"},
+    {init_vgmstream_str_snds, "str_snds"},
+    {init_vgmstream_ws_aud, "ws_aud"},
+    {init_vgmstream_ahx, "ahx"},
+    {init_vgmstream_ivb, "ivb"},
+    {init_vgmstream_svs, "svs"},
+    {init_vgmstream_riff, "riff"},
+    {init_vgmstream_rifx, "rifx"},
+    {init_vgmstream_pos, "pos"},
+    {init_vgmstream_nwa, "nwa"},
+    {init_vgmstream_ea_1snh, "ea_1snh"},
+    {init_vgmstream_xss, "xss"},
+    {init_vgmstream_sl3, "sl3"},
+    {init_vgmstream_hgc1, "hgc1"},
+    {init_vgmstream_aus, "aus"},
+    {init_vgmstream_rws, "rws"},
+    {init_vgmstream_fsb, "fsb"},
+    {init_vgmstream_fsb4_wav, "fsb4_wav"},
+    {init_vgmstream_fsb5, "fsb5"},
+    {init_vgmstream_rwx, "rwx"},
+    {init_vgmstream_xwb, "xwb"},
+    {init_vgmstream_ps2_xa30, "ps2_xa30"},
+    {init_vgmstream_musc, "musc"},
+    {init_vgmstream_musx_v004, "musx_v004"},
+    {init_vgmstream_musx_v005, "musx_v005"},
+    {init_vgmstream_musx_v006, "musx_v006"},
+    {init_vgmstream_musx_v010, "musx_v010"},
+    {init_vgmstream_musx_v201, "musx_v201"},
+    {init_vgmstream_leg, "leg"},
+    {init_vgmstream_filp, "filp"},
+    {init_vgmstream_ikm, "ikm"},
+    {init_vgmstream_sfs, "sfs"},
+    {init_vgmstream_bg00, "bg00"},
+    {init_vgmstream_sat_dvi, "sat_dvi"},
+    {init_vgmstream_dc_kcey, "dc_kcey"},
+    {init_vgmstream_ps2_rstm, "ps2_rstm"},
+    {init_vgmstream_acm, "acm"},
+    {init_vgmstream_mus_acm, "mus_acm"},
+    {init_vgmstream_ps2_kces, "ps2_kces"},
+    {init_vgmstream_ps2_dxh, "ps2_dxh"},
+    {init_vgmstream_ps2_psh, "ps2_psh"},
+    {init_vgmstream_scd_pcm, "scd_pcm"},
+	{init_vgmstream_ps2_pcm, "ps2_pcm"},
+    {init_vgmstream_ps2_rkv, "ps2_rkv"},
+    {init_vgmstream_ps2_psw, "ps2_psw"},
+    {init_vgmstream_ps2_vas, "ps2_vas"},
+    {init_vgmstream_ps2_tec, "ps2_tec"},
+    {init_vgmstream_ps2_enth, "ps2_enth"},
+    {init_vgmstream_sdt, "sdt"},
+    {init_vgmstream_aix, "aix"},
+    {init_vgmstream_ngc_tydsp, "ngc_tydsp"},
+    {init_vgmstream_ngc_swd, "ngc_swd"},
+    {init_vgmstream_capdsp, "capdsp"},
+    {init_vgmstream_xbox_wvs, "xbox_wvs"},
+    {init_vgmstream_ngc_wvs, "ngc_wvs"},
+    {init_vgmstream_dc_str, "dc_str"},
+    {init_vgmstream_dc_str_v2, "dc_str_v2"},
+    {init_vgmstream_xbox_matx, "xbox_matx"},
+    {init_vgmstream_dec, "dec"},
+    {init_vgmstream_vs, "vs"},
+    {init_vgmstream_dc_str, "dc_str"},
+    {init_vgmstream_dc_str_v2, "dc_str_v2"},
+    {init_vgmstream_xbox_xmu, "xbox_xmu"},
+    {init_vgmstream_xbox_xvas, "xbox_xvas"},
+    {init_vgmstream_ngc_bh2pcm, "ngc_bh2pcm"},
+    {init_vgmstream_sat_sap, "sat_sap"},
+    {init_vgmstream_dc_idvi, "dc_idvi"},
+    {init_vgmstream_ps2_rnd, "ps2_rnd"},
+    {init_vgmstream_wii_idsp, "wii_idsp"},
+    {init_vgmstream_kraw, "kraw"},
+    {init_vgmstream_ps2_omu, "ps2_omu"},
+    {init_vgmstream_ps2_xa2, "ps2_xa2"},
     //init_vgmstream_idsp,
-    init_vgmstream_idsp2,
-    init_vgmstream_idsp3,
-    init_vgmstream_idsp4,
-    init_vgmstream_ngc_ymf,
-    init_vgmstream_sadl,
-    init_vgmstream_ps2_ccc,
-    init_vgmstream_psx_fag,
-    init_vgmstream_ps2_mihb,
-    init_vgmstream_ngc_pdt,
-    init_vgmstream_wii_mus,
-    init_vgmstream_dc_asd,
-    init_vgmstream_naomi_spsd,
-    init_vgmstream_rsd2vag,
-    init_vgmstream_rsd2pcmb,
-    init_vgmstream_rsd2xadp,
-	init_vgmstream_rsd3vag,
-	init_vgmstream_rsd3gadp,
-    init_vgmstream_rsd3pcm,
-	init_vgmstream_rsd3pcmb,
-    init_vgmstream_rsd4pcmb,
-    init_vgmstream_rsd4pcm,
-	init_vgmstream_rsd4radp,
-    init_vgmstream_rsd4vag,
-    init_vgmstream_rsd6vag,
-    init_vgmstream_rsd6wadp,
-    init_vgmstream_rsd6xadp,
-    init_vgmstream_rsd6radp,
-    init_vgmstream_bgw,
-    init_vgmstream_spw,
-    init_vgmstream_ps2_ass,
-    init_vgmstream_waa_wac_wad_wam,
-    init_vgmstream_seg,
-    init_vgmstream_nds_strm_ffta2,
-    init_vgmstream_str_asr,
-    init_vgmstream_zwdsp,
-    init_vgmstream_gca,
-    init_vgmstream_spt_spd,
-    init_vgmstream_ish_isd,
-    init_vgmstream_gsp_gsb,
-    init_vgmstream_ydsp,
-    init_vgmstream_msvp,
-    init_vgmstream_ngc_ssm,
-    init_vgmstream_ps2_joe,
-    init_vgmstream_vgs,
-    init_vgmstream_dc_dcsw_dcs,
-    init_vgmstream_wii_smp,
-    init_vgmstream_emff_ps2,
-    init_vgmstream_emff_ngc,
-    init_vgmstream_thp,
-    init_vgmstream_wii_sts,
-    init_vgmstream_ps2_p2bt,
-    init_vgmstream_ps2_gbts,
-    init_vgmstream_wii_sng,
-    init_vgmstream_ngc_dsp_iadp,
-    init_vgmstream_aax,
-    init_vgmstream_utf_dsp,
-    init_vgmstream_ngc_ffcc_str,
-    init_vgmstream_sat_baka,
-    init_vgmstream_nds_swav,
-    init_vgmstream_ps2_vsf,
-    init_vgmstream_nds_rrds,
-    init_vgmstream_ps2_tk5,
-    init_vgmstream_ps2_vsf_tta,
-    init_vgmstream_ads,
-    init_vgmstream_wii_str,
-    init_vgmstream_ps2_mcg,
-    init_vgmstream_zsd,
-    init_vgmstream_ps2_vgs,
-    init_vgmstream_RedSpark,
-    init_vgmstream_ivaud,
-    init_vgmstream_wii_wsd,
-    init_vgmstream_wii_ndp,
-    init_vgmstream_ps2_sps,
-    init_vgmstream_ps2_xa2_rrp,
-    init_vgmstream_nds_hwas,
-	init_vgmstream_ngc_lps,
-    init_vgmstream_ps2_snd,
-    init_vgmstream_naomi_adpcm,
-	init_vgmstream_sd9,
-	init_vgmstream_2dx9,
-	init_vgmstream_dsp_ygo,
-    init_vgmstream_ps2_vgv,
-    init_vgmstream_ngc_gcub,
-    init_vgmstream_maxis_xa,
-    init_vgmstream_ngc_sck_dsp,
-    init_vgmstream_apple_caff,
-	init_vgmstream_pc_mxst,
-	init_vgmstream_sab,
-    init_vgmstream_exakt_sc,
-    init_vgmstream_wii_bns,
-    init_vgmstream_wii_was,
-    init_vgmstream_pona_3do,
-    init_vgmstream_pona_psx,
-    init_vgmstream_xbox_hlwav,
-    init_vgmstream_stx,
-    init_vgmstream_myspd,
-    init_vgmstream_his,
-	init_vgmstream_ps2_ast,
-	init_vgmstream_dmsg,
-    init_vgmstream_ngc_dsp_aaap,
-    init_vgmstream_ngc_dsp_konami,
-    init_vgmstream_ps2_ster,
-    init_vgmstream_ps2_wb,
-    init_vgmstream_bnsf,
-    init_vgmstream_s14_sss,
-    init_vgmstream_ps2_gcm,
-    init_vgmstream_ps2_smpl,
-    init_vgmstream_ps2_msa,
-    init_vgmstream_ps2_voi,
-    init_vgmstream_ps2_khv,
-    init_vgmstream_pc_smp,
-    init_vgmstream_ngc_bo2,
-    init_vgmstream_dsp_ddsp,
-    init_vgmstream_p3d,
-	init_vgmstream_ps2_tk1,
-	init_vgmstream_ps2_adsc,
-    init_vgmstream_ngc_dsp_mpds,
-    init_vgmstream_dsp_str_ig,
-    init_vgmstream_psx_mgav,
-    init_vgmstream_ngc_dsp_sth_str1,
-    init_vgmstream_ngc_dsp_sth_str2,
-    init_vgmstream_ngc_dsp_sth_str3,
-    init_vgmstream_ps2_b1s,
-    init_vgmstream_ps2_wad,
-    init_vgmstream_dsp_xiii,
-    init_vgmstream_dsp_cabelas,
-    init_vgmstream_ps2_adm,
-	init_vgmstream_ps2_lpcm,
-    init_vgmstream_dsp_bdsp,
-	init_vgmstream_ps2_vms,
-	init_vgmstream_xau,
-    init_vgmstream_gh3_bar,
-    init_vgmstream_ffw,
-    init_vgmstream_dsp_dspw,
-    init_vgmstream_ps2_jstm,
-    init_vgmstream_xvag,
-	init_vgmstream_ps3_cps,
-    init_vgmstream_sqex_scd,
-    init_vgmstream_ngc_nst_dsp,
-    init_vgmstream_baf,
-    init_vgmstream_ps3_msf,
-	init_vgmstream_nub_vag,
-	init_vgmstream_ps3_past,
-    init_vgmstream_sgxd,
-	init_vgmstream_ngca,
-	init_vgmstream_wii_ras,
-	init_vgmstream_ps2_spm,
-	init_vgmstream_x360_tra,
-	init_vgmstream_ps2_iab,
-	init_vgmstream_ps2_strlr,
-    init_vgmstream_lsf_n1nj4n,
-	init_vgmstream_vawx,
-    init_vgmstream_pc_snds,
-	init_vgmstream_ps2_wmus,
-	init_vgmstream_hyperscan_kvag,
-	init_vgmstream_ios_psnd,
-	init_vgmstream_pc_adp_bos,
-	init_vgmstream_pc_adp_otns,
-    init_vgmstream_eb_sfx,
-    init_vgmstream_eb_sf0,
-	init_vgmstream_ps3_klbs,
-    init_vgmstream_ps2_mtaf,
-	init_vgmstream_tun,
-	init_vgmstream_wpd,
-	init_vgmstream_mn_str,
-	init_vgmstream_mss,
-	init_vgmstream_ps2_hsf,
-	init_vgmstream_ps3_ivag,
-	init_vgmstream_ps2_2pfs,
-    init_vgmstream_xnbm,
-	init_vgmstream_rsd6oogv,
-	init_vgmstream_ubi_ckd,
-	init_vgmstream_ps2_vbk,
-	init_vgmstream_otm,
-	init_vgmstream_bcstm,
-	init_vgmstream_3ds_idsp,
-    init_vgmstream_kt_g1l,
-    init_vgmstream_kt_wiibgm,
-    init_vgmstream_hca,
-    init_vgmstream_ps2_svag_snk,
-    init_vgmstream_ps2_vds_vdm,
-    init_vgmstream_x360_cxs,
-    init_vgmstream_dsp_adx,
-    init_vgmstream_akb_multi,
-    init_vgmstream_akb2_multi,
+    {init_vgmstream_idsp2, "idsp2"},
+    {init_vgmstream_idsp3, "idsp3"},
+    {init_vgmstream_idsp4, "idsp4"},
+    {init_vgmstream_ngc_ymf, "ngc_ymf"},
+    {init_vgmstream_sadl, "sadl"},
+    {init_vgmstream_ps2_ccc, "ps2_ccc"},
+    {init_vgmstream_psx_fag, "psx_fag"},
+    {init_vgmstream_ps2_mihb, "ps2_mihb"},
+    {init_vgmstream_ngc_pdt, "ngc_pdt"},
+    {init_vgmstream_wii_mus, "wii_mus"},
+    {init_vgmstream_dc_asd, "dc_asd"},
+    {init_vgmstream_naomi_spsd, "naomi_spsd"},
+    {init_vgmstream_rsd2vag, "rsd2vag"},
+    {init_vgmstream_rsd2pcmb, "rsd2pcmb"},
+    {init_vgmstream_rsd2xadp, "rsd2xadp"},
+	{init_vgmstream_rsd3vag, "rsd3vag"},
+	{init_vgmstream_rsd3gadp, "rsd3gadp"},
+    {init_vgmstream_rsd3pcm, "rsd3pcm"},
+	{init_vgmstream_rsd3pcmb, "rsd3pcmb"},
+    {init_vgmstream_rsd4pcmb, "rsd4pcmb"},
+    {init_vgmstream_rsd4pcm, "rsd4pcm"},
+	{init_vgmstream_rsd4radp, "rsd4radp"},
+    {init_vgmstream_rsd4vag, "rsd4vag"},
+    {init_vgmstream_rsd6vag, "rsd6vag"},
+    {init_vgmstream_rsd6wadp, "rsd6wadp"},
+    {init_vgmstream_rsd6xadp, "rsd6xadp"},
+    {init_vgmstream_rsd6radp, "rsd6radp"},
+    {init_vgmstream_bgw, "bgw"},
+    {init_vgmstream_spw, "spw"},
+    {init_vgmstream_ps2_ass, "ps2_ass"},
+    {init_vgmstream_waa_wac_wad_wam, "waa_wac_wad_wam"},
+    {init_vgmstream_seg, "seg"},
+    {init_vgmstream_nds_strm_ffta2, "nds_strm_ffta2"},
+    {init_vgmstream_str_asr, "str_asr"},
+    {init_vgmstream_zwdsp, "zwdsp"},
+    {init_vgmstream_gca, "gca"},
+    {init_vgmstream_spt_spd, "spt_spd"},
+    {init_vgmstream_ish_isd, "ish_isd"},
+    {init_vgmstream_gsp_gsb, "gsp_gsb"},
+    {init_vgmstream_ydsp, "ydsp"},
+    {init_vgmstream_msvp, "msvp"},
+    {init_vgmstream_ngc_ssm, "ngc_ssm"},
+    {init_vgmstream_ps2_joe, "ps2_joe"},
+    {init_vgmstream_vgs, "vgs"},
+    {init_vgmstream_dc_dcsw_dcs, "dc_dcsw_dcs"},
+    {init_vgmstream_wii_smp, "wii_smp"},
+    {init_vgmstream_emff_ps2, "emff_ps2"},
+    {init_vgmstream_emff_ngc, "emff_ngc"},
+    {init_vgmstream_thp, "thp"},
+    {init_vgmstream_wii_sts, "wii_sts"},
+    {init_vgmstream_ps2_p2bt, "ps2_p2bt"},
+    {init_vgmstream_ps2_gbts, "ps2_gbts"},
+    {init_vgmstream_wii_sng, "wii_sng"},
+    {init_vgmstream_ngc_dsp_iadp, "ngc_dsp_iadp"},
+    {init_vgmstream_aax, "aax"},
+    {init_vgmstream_utf_dsp, "utf_dsp"},
+    {init_vgmstream_ngc_ffcc_str, "ngc_ffcc_str"},
+    {init_vgmstream_sat_baka, "sat_baka"},
+    {init_vgmstream_nds_swav, "nds_swav"},
+    {init_vgmstream_ps2_vsf, "ps2_vsf"},
+    {init_vgmstream_nds_rrds, "nds_rrds"},
+    {init_vgmstream_ps2_tk5, "ps2_tk5"},
+    {init_vgmstream_ps2_vsf_tta, "ps2_vsf_tta"},
+    {init_vgmstream_ads, "ads"},
+    {init_vgmstream_wii_str, "wii_str"},
+    {init_vgmstream_ps2_mcg, "ps2_mcg"},
+    {init_vgmstream_zsd, "zsd"},
+    {init_vgmstream_ps2_vgs, "ps2_vgs"},
+    {init_vgmstream_RedSpark, "RedSpark"},
+    {init_vgmstream_ivaud, "ivaud"},
+    {init_vgmstream_wii_wsd, "wii_wsd"},
+    {init_vgmstream_wii_ndp, "wii_ndp"},
+    {init_vgmstream_ps2_sps, "ps2_sps"},
+    {init_vgmstream_ps2_xa2_rrp, "ps2_xa2_rrp"},
+    {init_vgmstream_nds_hwas, "nds_hwas"},
+	{init_vgmstream_ngc_lps, "ngc_lps"},
+    {init_vgmstream_ps2_snd, "ps2_snd"},
+    {init_vgmstream_naomi_adpcm, "naomi_adpcm"},
+	{init_vgmstream_sd9, "sd9"},
+	{init_vgmstream_2dx9, "2dx9"},
+	{init_vgmstream_dsp_ygo, "dsp_ygo"},
+    {init_vgmstream_ps2_vgv, "ps2_vgv"},
+    {init_vgmstream_ngc_gcub, "ngc_gcub"},
+    {init_vgmstream_maxis_xa, "maxis_xa"},
+    {init_vgmstream_ngc_sck_dsp, "ngc_sck_dsp"},
+    {init_vgmstream_apple_caff, "apple_caff"},
+	{init_vgmstream_pc_mxst, "pc_mxst"},
+	{init_vgmstream_sab, "sab"},
+    {init_vgmstream_exakt_sc, "exakt_sc"},
+    {init_vgmstream_wii_bns, "wii_bns"},
+    {init_vgmstream_wii_was, "wii_was"},
+    {init_vgmstream_pona_3do, "pona_3do"},
+    {init_vgmstream_pona_psx, "pona_psx"},
+    {init_vgmstream_xbox_hlwav, "xbox_hlwav"},
+    {init_vgmstream_stx, "stx"},
+    {init_vgmstream_myspd, "myspd"},
+    {init_vgmstream_his, "his"},
+	{init_vgmstream_ps2_ast, "ps2_ast"},
+	{init_vgmstream_dmsg, "dmsg"},
+    {init_vgmstream_ngc_dsp_aaap, "ngc_dsp_aaap"},
+    {init_vgmstream_ngc_dsp_konami, "ngc_dsp_konami"},
+    {init_vgmstream_ps2_ster, "ps2_ster"},
+    {init_vgmstream_ps2_wb, "ps2_wb"},
+    {init_vgmstream_bnsf, "bnsf"},
+    {init_vgmstream_s14_sss, "s14_sss"},
+    {init_vgmstream_ps2_gcm, "ps2_gcm"},
+    {init_vgmstream_ps2_smpl, "ps2_smpl"},
+    {init_vgmstream_ps2_msa, "ps2_msa"},
+    {init_vgmstream_ps2_voi, "ps2_voi"},
+    {init_vgmstream_ps2_khv, "ps2_khv"},
+    {init_vgmstream_pc_smp, "pc_smp"},
+    {init_vgmstream_ngc_bo2, "ngc_bo2"},
+    {init_vgmstream_dsp_ddsp, "dsp_ddsp"},
+    {init_vgmstream_p3d, "p3d"},
+	{init_vgmstream_ps2_tk1, "ps2_tk1"},
+	{init_vgmstream_ps2_adsc, "ps2_adsc"},
+    {init_vgmstream_ngc_dsp_mpds, "ngc_dsp_mpds"},
+    {init_vgmstream_dsp_str_ig, "dsp_str_ig"},
+    {init_vgmstream_psx_mgav, "psx_mgav"},
+    {init_vgmstream_ngc_dsp_sth_str1, "ngc_dsp_sth_str1"},
+    {init_vgmstream_ngc_dsp_sth_str2, "ngc_dsp_sth_str2"},
+    {init_vgmstream_ngc_dsp_sth_str3, "ngc_dsp_sth_str3"},
+    {init_vgmstream_ps2_b1s, "ps2_b1s"},
+    {init_vgmstream_ps2_wad, "ps2_wad"},
+    {init_vgmstream_dsp_xiii, "dsp_xiii"},
+    {init_vgmstream_dsp_cabelas, "dsp_cabelas"},
+    {init_vgmstream_ps2_adm, "ps2_adm"},
+	{init_vgmstream_ps2_lpcm, "ps2_lpcm"},
+    {init_vgmstream_dsp_bdsp, "dsp_bdsp"},
+	{init_vgmstream_ps2_vms, "ps2_vms"},
+	{init_vgmstream_xau, "xau"},
+    {init_vgmstream_gh3_bar, "gh3_bar"},
+    {init_vgmstream_ffw, "ffw"},
+    {init_vgmstream_dsp_dspw, "dsp_dspw"},
+    {init_vgmstream_ps2_jstm, "ps2_jstm"},
+    {init_vgmstream_xvag, "xvag"},
+	{init_vgmstream_ps3_cps, "ps3_cps"},
+    {init_vgmstream_sqex_scd, "sqex_scd"},
+    {init_vgmstream_ngc_nst_dsp, "ngc_nst_dsp"},
+    {init_vgmstream_baf, "baf"},
+    {init_vgmstream_ps3_msf, "ps3_msf"},
+	{init_vgmstream_nub_vag, "nub_vag"},
+	{init_vgmstream_ps3_past, "ps3_past"},
+    {init_vgmstream_sgxd, "sgxd"},
+	{init_vgmstream_ngca, "ngca"},
+	{init_vgmstream_wii_ras, "wii_ras"},
+	{init_vgmstream_ps2_spm, "ps2_spm"},
+	{init_vgmstream_x360_tra, "x360_tra"},
+	{init_vgmstream_ps2_iab, "ps2_iab"},
+	{init_vgmstream_ps2_strlr, "ps2_strlr"},
+    {init_vgmstream_lsf_n1nj4n, "lsf_n1nj4n"},
+	{init_vgmstream_vawx, "vawx"},
+    {init_vgmstream_pc_snds, "pc_snds"},
+	{init_vgmstream_ps2_wmus, "ps2_wmus"},
+	{init_vgmstream_hyperscan_kvag, "hyperscan_kvag"},
+	{init_vgmstream_ios_psnd, "ios_psnd"},
+	{init_vgmstream_pc_adp_bos, "pc_adp_bos"},
+	{init_vgmstream_pc_adp_otns, "pc_adp_otns"},
+    {init_vgmstream_eb_sfx, "eb_sfx"},
+    {init_vgmstream_eb_sf0, "eb_sf0"},
+	{init_vgmstream_ps3_klbs, "ps3_klbs"},
+    {init_vgmstream_ps2_mtaf, "ps2_mtaf"},
+	{init_vgmstream_tun, "tun"},
+	{init_vgmstream_wpd, "wpd"},
+	{init_vgmstream_mn_str, "mn_str"},
+	{init_vgmstream_mss, "mss"},
+	{init_vgmstream_ps2_hsf, "ps2_hsf"},
+	{init_vgmstream_ps3_ivag, "ps3_ivag"},
+	{init_vgmstream_ps2_2pfs, "ps2_2pfs"},
+    {init_vgmstream_xnbm, "xnbm"},
+	{init_vgmstream_rsd6oogv, "rsd6oogv"},
+	{init_vgmstream_ubi_ckd, "ubi_ckd"},
+	{init_vgmstream_ps2_vbk, "ps2_vbk"},
+	{init_vgmstream_otm, "otm"},
+	{init_vgmstream_bcstm, "bcstm"},
+	{init_vgmstream_3ds_idsp, "3ds_idsp"},
+    {init_vgmstream_kt_g1l, "kt_g1l"},
+    {init_vgmstream_kt_wiibgm, "kt_wiibgm"},
+    {init_vgmstream_hca, "hca"},
+    {init_vgmstream_ps2_svag_snk, "ps2_svag_snk"},
+    {init_vgmstream_ps2_vds_vdm, "ps2_vds_vdm"},
+    {init_vgmstream_x360_cxs, "x360_cxs"},
+    {init_vgmstream_dsp_adx, "dsp_adx"},
+    {init_vgmstream_akb_multi, "akb_multi"},
+    {init_vgmstream_akb2_multi, "akb2_multi"},
 #ifdef VGM_USE_FFMPEG
-    init_vgmstream_mp4_aac_ffmpeg,
+    {init_vgmstream_mp4_aac_ffmpeg, "mp4_aac_ffmpeg"},
 #endif
-    init_vgmstream_bik,
-    init_vgmstream_x360_ast,
-    init_vgmstream_wwise,
-    init_vgmstream_ubi_raki,
-    init_vgmstream_x360_pasx,
-    init_vgmstream_nub_xma,
-    init_vgmstream_xma,
-    init_vgmstream_sxd,
-    init_vgmstream_ogl,
-    init_vgmstream_mc3,
-    init_vgmstream_gtd,
-    init_vgmstream_rsd6xma,
-    init_vgmstream_ta_aac_x360,
-    init_vgmstream_ta_aac_ps3,
-    init_vgmstream_ps3_mta2,
-    init_vgmstream_ngc_ulw,
-    init_vgmstream_pc_xa30,
-    init_vgmstream_wii_04sw,
-    init_vgmstream_ea_bnk,
-    init_vgmstream_ea_schl_fixed,
-    init_vgmstream_sk_aud,
-    init_vgmstream_stm,
-    init_vgmstream_ea_snu,
-    init_vgmstream_awc,
-    init_vgmstream_nsw_opus,
-    init_vgmstream_pc_al2,
-    init_vgmstream_pc_ast,
-    init_vgmstream_naac,
-    init_vgmstream_ubi_sb,
-    init_vgmstream_ezw,
-    init_vgmstream_vxn,
-    init_vgmstream_ea_snr_sns,
-    init_vgmstream_ea_sps,
-    init_vgmstream_ngc_vid1,
-    init_vgmstream_flx,
-
-    init_vgmstream_txth,  /* should go at the end (lower priority) */
+    {init_vgmstream_bik, "bik"},
+    {init_vgmstream_x360_ast, "x360_ast"},
+    {init_vgmstream_wwise, "wwise"},
+    {init_vgmstream_ubi_raki, "ubi_raki"},
+    {init_vgmstream_x360_pasx, "x360_pasx"},
+    {init_vgmstream_nub_xma, "nub_xma"},
+    {init_vgmstream_xma, "xma"},
+    {init_vgmstream_sxd, "sxd"},
+    {init_vgmstream_ogl, "ogl"},
+    {init_vgmstream_mc3, "mc3"},
+    {init_vgmstream_gtd, "gtd"},
+    {init_vgmstream_rsd6xma, "rsd6xma"},
+    {init_vgmstream_ta_aac_x360, "ta_aac_x360"},
+    {init_vgmstream_ta_aac_ps3, "ta_aac_ps3"},
+    {init_vgmstream_ps3_mta2, "ps3_mta2"},
+    {init_vgmstream_ngc_ulw, "ngc_ulw"},
+    {init_vgmstream_pc_xa30, "pc_xa30"},
+    {init_vgmstream_wii_04sw, "wii_04sw"},
+    {init_vgmstream_ea_bnk, "ea_bnk"},
+    {init_vgmstream_ea_schl_fixed, "ea_schl_fixed"},
+    {init_vgmstream_sk_aud, "sk_aud"},
+    {init_vgmstream_stm, "stm"},
+    {init_vgmstream_ea_snu, "ea_snu"},
+    {init_vgmstream_awc, "awc"},
+    {init_vgmstream_nsw_opus, "nsw_opus"},
+    {init_vgmstream_pc_al2, "pc_al2"},
+    {init_vgmstream_pc_ast, "pc_ast"},
+    {init_vgmstream_naac, "naac"},
+    {init_vgmstream_ubi_sb, "ubi_sb"},
+    {init_vgmstream_ezw, "ezw"},
+    {init_vgmstream_vxn, "vxn"},
+    {init_vgmstream_ea_snr_sns, "ea_snr_sns"},
+    {init_vgmstream_ea_sps, "ea_sps"},
+    {init_vgmstream_ngc_vid1, "ngc_vid1"},
+    {init_vgmstream_flx, "flx"},
+
+    {init_vgmstream_txth, "txth"},  /* should go at the end (lower priority) */
 #ifdef VGM_USE_FFMPEG
-    init_vgmstream_ffmpeg, /* should go at the end */
+    {init_vgmstream_ffmpeg, "ffmpeg"}, /* should go at the end */
 #endif
 };
 
 
-/* internal version with all parameters */
-static VGMSTREAM * init_vgmstream_internal(STREAMFILE *streamFile) {
-    int i, fcns_size;
-    
-    if (!streamFile)
-        return NULL;
+
+
+/* Detection hints: extensions + header id that a meta needs, so likely candidates can be tried
+ * before the full list. If all fail the regular ordered scan is done, so hints are only an
+ * optimization. Only add metas that check the id at 0x00, and that are the first meta in
+ * init_vgmstream_functions that may accept the ext+id (metas without id/ext checks count),
+ * or the hint would skip that meta's priority. Rows after the first for an ext+id are dropped. */
+typedef struct {
+    VGMSTREAM * (*init_vgmstream_function)(STREAMFILE *streamFile);
+    const char * exts;  /* comma-separated, lowercase */
+    uint32_t id;        /* 32-bit BE at 0x00 */
+} init_vgmstream_hint;
+
+static const init_vgmstream_hint init_vgmstream_hints[] = {
+    {init_vgmstream_brstm,          "brstm,brstmspm",   0x5253544D}, /* "RSTM" */
+    {init_vgmstream_bfwav,          "bfwav,fwav,bfwavnsmbu", 0x46574156}, /* "FWAV" */
+    {init_vgmstream_bfstm,          "bfstm",            0x4653544D}, /* "FSTM" */
+    {init_vgmstream_ps2_npsf,       "nps,npsf",         0x4E505346}, /* "NPSF" */
+    {init_vgmstream_ea_schl,        "asf,mus,eam,sng,aud,sx,strm,xa,xsf,exa,stm,ast", 0x5343486C}, /* "SCHl" (not .str: ps2_str has no id) */
+    {init_vgmstream_genh,           "genh",             0x47454e48}, /* "GENH" */
+    {init_vgmstream_riff,           "wav,lwav",         0x52494646}, /* "RIFF" */
+    {init_vgmstream_fsb5,           "fsb",              0x46534235}, /* "FSB5" */
+    {init_vgmstream_xwb,            "xwb",              0x57424E44}, /* "WBND" */
+    {init_vgmstream_xwb,            "xwb",              0x444E4257}, /* "DNBW" */
+    {init_vgmstream_musc,           "mus,musc",         0x4D555343}, /* "MUSC" */
+    {init_vgmstream_vgs,            "vgs",              0x56675321}, /* "VgS!" */
+    {init_vgmstream_xvag,           "xvag",             0x58564147}, /* "XVAG" */
+    {init_vgmstream_sgxd,           "sgx,sgd",          0x53475844}, /* "SGXD" */
+    {init_vgmstream_vawx,           "vawx,xwv",         0x56415758}, /* "VAWX" */
+    {init_vgmstream_ps2_mtaf,       "mtaf",             0x4d544146}, /* "MTAF" */
+    {init_vgmstream_x360_ast,       "ast",              0x41535442}, /* "ASTB" */
+#if defined(VGM_USE_MP4V2) && defined(VGM_USE_FDKAAC)
+    {init_vgmstream_akb,            "akb",              0x414B4220}, /* "AKB " (has priority over akb_multi) */
+#endif
+    {init_vgmstream_akb_multi,      "akb",              0x414B4220}, /* "AKB " */
+    {init_vgmstream_akb2_multi,     "akb",              0x414B4232}, /* "AKB2" */
+    {init_vgmstream_mc3,            "mc3",              0x4D504333}, /* "MPC3" */
+    {init_vgmstream_gtd,            "gtd",              0x47485320}, /* "GHS " */
+    {init_vgmstream_wii_04sw,       "04sw",             0x30345357}, /* "04SW" (not .xa: cdxa may take headerless) */
+    {init_vgmstream_naac,           "naac",             0x41414320}, /* "AAC " */
+    {init_vgmstream_vxn,            "vxn",              0x566F784E}, /* "VoxN" */
+    {init_vgmstream_awc,            "awc",              0x41444154}, /* "ADAT" */
+    {init_vgmstream_awc,            "awc",              0x54414441}, /* "TADA" */
+};
+
+#define HINT_EXT_MAX 16         /* longest extension in hints + 1 */
+#define HINT_NODES_MAX 128      /* total extensions in hints */
+#define HINT_HASH_SIZE 256      /* power of 2 */
+#define HINT_CANDIDATES_MAX 8   /* max candidates for a single ext+id */
+
+typedef struct {
+    char ext[HINT_EXT_MAX];
+    uint32_t id;
+    int fcn_index;              /* index in init_vgmstream_functions */
+    int next;                   /* next node in bucket, or -1 */
+} init_vgmstream_hint_node;
+
+static init_vgmstream_hint_node hint_nodes[HINT_NODES_MAX];
+static int hint_buckets[HINT_HASH_SIZE];
+static vgm_once_flag hint_table_once = VGM_ONCE_INIT;
+
+static uint32_t hint_hash(const char * ext, uint32_t id) {
+    uint32_t hash = 2166136261u; /* FNV-1a */
+    int i;
+
+    for (i = 0; ext[i] != '\0'; i++) {
+        hash = (hash ^ (uint8_t)ext[i]) * 16777619u;
+    }
+    for (i = 0; i < 4; i++) {
+        hash = (hash ^ ((id >> (i*8)) & 0xFF)) * 16777619u;
+    }
+    return hash & (HINT_HASH_SIZE - 1);
+}
+
+/* builds the ext+id table from the hint list (once, see vgm_once) */
+static void build_hint_table(void) {
+    int i, fcns_size, hints_size, node_count = 0;
+
+    for (i = 0; i < HINT_HASH_SIZE; i++) {
+        hint_buckets[i] = -1;
+    }
 
     fcns_size = (sizeof(init_vgmstream_functions)/sizeof(init_vgmstream_functions[0]));
-    /* try a series of formats, see which works */
-    for (i=0; i < fcns_size; i++) {
-        /* call init function and see if valid VGMSTREAM was returned */
-        VGMSTREAM * vgmstream = (init_vgmstream_functions[i])(streamFile);
-        if (!vgmstream)
+    hints_size = (sizeof(init_vgmstream_hints)/sizeof(init_vgmstream_hints[0]));
+    for (i = 0; i < hints_size; i++) {
+        const init_vgmstream_hint * hint = &init_vgmstream_hints[i];
+        const char * ext = hint->exts;
+        int fcn_index;
+
+        /* metas may be disabled in this build */
+        for (fcn_index = 0; fcn_index < fcns_size; fcn_index++) {
+            if (init_vgmstream_functions[fcn_index].function == hint->init_vgmstream_function)
+                break;
+        }
+        if (fcn_index == fcns_size)
             continue;
 
-        /* fail if there is nothing to play (without this check vgmstream can generate empty files) */
-        if (vgmstream->num_samples <= 0) {
-            VGM_LOG("VGMSTREAM: wrong num_samples (ns=%i / 0x%08x)\n", vgmstream->num_samples, vgmstream->num_samples);
-            close_vgmstream(vgmstream);
-            continue;
+        while (*ext != '\0') {
+            init_vgmstream_hint_node * node;
+            size_t ext_len = strcspn(ext, ",");
+            uint32_t bucket;
+            int other;
+
+            if (node_count >= HINT_NODES_MAX || ext_len >= HINT_EXT_MAX) {
+                VGM_LOG("VGMSTREAM: ignored hint for function %i\n", fcn_index);
+                break;
+            }
+
+            node = &hint_nodes[node_count];
+            memcpy(node->ext, ext, ext_len);
+            node->ext[ext_len] = '\0';
+            node->id = hint->id;
+            node->fcn_index = fcn_index;
+
+            /* only the first function for an ext+id may be hinted, as others would skip its priority */
+            bucket = hint_hash(node->ext, node->id);
+            for (other = hint_buckets[bucket]; other >= 0; other = hint_nodes[other].next) {
+                if (hint_nodes[other].id == node->id && strcmp(hint_nodes[other].ext, node->ext) == 0)
+                    break;
+            }
+            if (other >= 0) {
+                VGM_LOG("VGMSTREAM: ignored hint for function %i (ext %s already hinted)\n", fcn_index, node->ext);
+                if (fcn_index < hint_nodes[other].fcn_index)
+                    hint_nodes[other].fcn_index = fcn_index;
+            }
+            else {
+                node->next = hint_buckets[bucket];
+                hint_buckets[bucket] = node_count;
+                node_count++;
+            }
+
+            ext += ext_len;
+            if (*ext == ',') ext++;
         }
+    }
+}
+
+/* Finds functions that declared this file's ext+id, sorted by priority. Returns the count. */
+static int get_hint_candidates(STREAMFILE *streamFile, int * candidates, int candidates_max) {
+    char filename[PATH_LIMIT];
+    char ext[HINT_EXT_MAX];
+    const char * file_ext;
+    uint32_t id;
+    int i, node, count = 0;
 
-        /* everything should have a reasonable sample rate (300 is Wwise min) */
-        if (vgmstream->sample_rate < 300 || vgmstream->sample_rate > 96000) {
-            VGM_LOG("VGMSTREAM: wrong sample rate (sr=%i)\n", vgmstream->sample_rate);
-            close_vgmstream(vgmstream);
+    vgm_once(&hint_table_once, build_hint_table);
+
+    streamFile->get_name(streamFile,filename,sizeof(filename));
+    file_ext = filename_extension(filename);
+    if (strlen(file_ext) >= HINT_EXT_MAX)
+        return 0;
+    for (i = 0; file_ext[i] != '\0'; i++) {
+        ext[i] = (file_ext[i] >= 'A' && file_ext[i] <= 'Z') ? file_ext[i] + ('a' - 'A') : file_ext[i];
+    }
+    ext[i] = '\0';
+
+    id = (uint32_t)read_32bitBE(0x00,streamFile);
+
+    for (node = hint_buckets[hint_hash(ext, id)]; node >= 0; node = hint_nodes[node].next) {
+        int fcn_index = hint_nodes[node].fcn_index;
+        int pos;
+
+        if (hint_nodes[node].id != id || strcmp(hint_nodes[node].ext, ext) != 0)
             continue;
+        if (count >= candidates_max)
+            break;
+
+        /* insert sorted, ignoring dupes */
+        for (pos = 0; pos < count && candidates[pos] < fcn_index; pos++)
+            ;
+        if (pos < count && candidates[pos] == fcn_index)
+            continue;
+        memmove(&candidates[pos+1], &candidates[pos], (count - pos) * sizeof(int));
+        candidates[pos] = fcn_index;
+        count++;
+    }
+
+    return count;
+}
+
+/* calls an init function and validates the result, returns a VGMSTREAM ready to play */
+static VGMSTREAM * validate_vgmstream(VGMSTREAM * vgmstream, STREAMFILE *streamFile, int fcn_index, int skip_dual_stereo);
+
+static VGMSTREAM * init_vgmstream_function_index(STREAMFILE *streamFile, int fcn_index, int skip_dual_stereo) {
+    /* call init function and see if valid VGMSTREAM was returned */
+    VGMSTREAM * vgmstream = (init_vgmstream_functions[fcn_index].function)(streamFile);
+    return validate_vgmstream(vgmstream, streamFile, fcn_index, skip_dual_stereo);
+}
+
+/* checks and finishes a VGMSTREAM returned by the init function at fcn_index */
+static VGMSTREAM * validate_vgmstream(VGMSTREAM * vgmstream, STREAMFILE *streamFile, int fcn_index, int skip_dual_stereo) {
+    if (!vgmstream)
+        return NULL;
+
+    /* fail if there is nothing to play (without this check vgmstream can generate empty files) */
+    if (vgmstream->num_samples <= 0) {
+        VGM_LOG("VGMSTREAM: wrong num_samples (ns=%i / 0x%08x)\n", vgmstream->num_samples, vgmstream->num_samples);
+        close_vgmstream(vgmstream);
+        return NULL;
+    }
+
+    /* everything should have a reasonable sample rate (300 is Wwise min) */
+    if (vgmstream->sample_rate < 300 || vgmstream->sample_rate > 96000) {
+        VGM_LOG("VGMSTREAM: wrong sample rate (sr=%i)\n", vgmstream->sample_rate);
+        close_vgmstream(vgmstream);
+        return NULL;
+    }
+
+    /* Sanify loops! */
+    if (vgmstream->loop_flag) {
+        if ((vgmstream->loop_end_sample <= vgmstream->loop_start_sample)
+                || (vgmstream->loop_end_sample > vgmstream->num_samples)
+                || (vgmstream->loop_start_sample < 0) ) {
+            vgmstream->loop_flag = 0;
+            VGM_LOG("VGMSTREAM: wrong loops ignored (lss=%i, lse=%i, ns=%i)\n", vgmstream->loop_start_sample, vgmstream->loop_end_sample, vgmstream->num_samples);
         }
-            
-        /* Sanify loops! */
-        if (vgmstream->loop_flag) {
-            if ((vgmstream->loop_end_sample <= vgmstream->loop_start_sample)
-                    || (vgmstream->loop_end_sample > vgmstream->num_samples)
-                    || (vgmstream->loop_start_sample < 0) ) {
-                vgmstream->loop_flag = 0;
-                VGM_LOG("VGMSTREAM: wrong loops ignored (lss=%i, lse=%i, ns=%i)\n", vgmstream->loop_start_sample, vgmstream->loop_end_sample, vgmstream->num_samples);
-            }
-        }
-
-        /* test if candidate for dual stereo */
-        if (vgmstream->channels == 1 && (
-                    (vgmstream->meta_type == meta_DSP_STD) ||
-                    (vgmstream->meta_type == meta_PS2_VAGp) ||
-                    (vgmstream->meta_type == meta_GENH) ||
-                    (vgmstream->meta_type == meta_TXTH) ||
-                    (vgmstream->meta_type == meta_KRAW) ||
-                    (vgmstream->meta_type == meta_PS2_MIB) ||
-                    (vgmstream->meta_type == meta_NGC_LPS) ||
-                    (vgmstream->meta_type == meta_DSP_YGO) ||
-                    (vgmstream->meta_type == meta_DSP_AGSC) ||
-                    (vgmstream->meta_type == meta_PS2_SMPL) ||
-                    (vgmstream->meta_type == meta_NGCA) ||
-                    (vgmstream->meta_type == meta_NUB_VAG) ||
-                    (vgmstream->meta_type == meta_SPT_SPD) ||
-                    (vgmstream->meta_type == meta_EB_SFX) ||
-                    (vgmstream->meta_type == meta_CWAV)
-                    )) {
-            try_dual_file_stereo(vgmstream, streamFile, init_vgmstream_functions[i]);
-        }
+    }
+
+    /* test if candidate for dual stereo */
+    if (!skip_dual_stereo && vgmstream->channels == 1 && (
+                (vgmstream->meta_type == meta_DSP_STD) ||
+                (vgmstream->meta_type == meta_PS2_VAGp) ||
+                (vgmstream->meta_type == meta_GENH) ||
+                (vgmstream->meta_type == meta_TXTH) ||
+                (vgmstream->meta_type == meta_KRAW) ||
+                (vgmstream->meta_type == meta_PS2_MIB) ||
+                (vgmstream->meta_type == meta_NGC_LPS) ||
+                (vgmstream->meta_type == meta_DSP_YGO) ||
+                (vgmstream->meta_type == meta_DSP_AGSC) ||
+                (vgmstream->meta_type == meta_PS2_SMPL) ||
+                (vgmstream->meta_type == meta_NGCA) ||
+                (vgmstream->meta_type == meta_NUB_VAG) ||
+                (vgmstream->meta_type == meta_SPT_SPD) ||
+                (vgmstream->meta_type == meta_EB_SFX) ||
+                (vgmstream->meta_type == meta_CWAV)
+                )) {
+        try_dual_file_stereo(vgmstream, streamFile, init_vgmstream_functions[fcn_index].function);
+    }
 
 
 #ifdef VGM_DEBUG_OUTPUT
 #ifdef VGM_USE_FFMPEG
-        /* debug fun */
-        if (vgmstream->coding_type != coding_FFmpeg){
-            int i = 0;
+    /* debug fun */
+    if (vgmstream->coding_type != coding_FFmpeg){
+        int i = 0;
 
-            /* probable segfault but some layouts/codecs can ignore these */
-            for (i = 0; i < vgmstream->channels; i++) {
-                VGM_ASSERT(vgmstream->ch[i].streamfile == NULL, "VGMSTREAM: null streamfile in ch%i\n",i);
-            }
+        /* probable segfault but some layouts/codecs can ignore these */
+        for (i = 0; i < vgmstream->channels; i++) {
+            VGM_ASSERT(vgmstream->ch[i].streamfile == NULL, "VGMSTREAM: null streamfile in ch%i\n",i);
         }
+    }
 #endif
 #endif/*VGM_DEBUG_OUTPUT*/
 
 
 #ifdef VGM_USE_FFMPEG
-        /* check FFmpeg streams here, for lack of a better place */
-        if (vgmstream->coding_type == coding_FFmpeg) {
-            ffmpeg_codec_data *data = (ffmpeg_codec_data *) vgmstream->codec_data;
-            if (data->streamCount && !vgmstream->num_streams) {
-                vgmstream->num_streams = data->streamCount;
-            }
+    /* check FFmpeg streams here, for lack of a better place */
+    if (vgmstream->coding_type == coding_FFmpeg) {
+        ffmpeg_codec_data *data = (ffmpeg_codec_data *) vgmstream->codec_data;
+        if (data->streamCount && !vgmstream->num_streams) {
+            vgmstream->num_streams = data->streamCount;
         }
+    }
 #endif
 
-        /* save info */
-        vgmstream->stream_index = streamFile->stream_index;
+    /* save info */
+    vgmstream->stream_index = streamFile->stream_index;
+    vgmstream->info_only = streamFile->info_only;
 
-        /* save start things so we can restart for seeking */
-        memcpy(vgmstream->start_ch,vgmstream->ch,sizeof(VGMSTREAMCHANNEL)*vgmstream->channels);
-        memcpy(vgmstream->start_vgmstream,vgmstream,sizeof(VGMSTREAM));
+    /* save start things so we can restart for seeking */
+    memcpy(vgmstream->start_ch,vgmstream->ch,sizeof(VGMSTREAMCHANNEL)*vgmstream->channels);
+    memcpy(vgmstream->start_vgmstream,vgmstream,sizeof(VGMSTREAM));
 
-        return vgmstream;
+    return vgmstream;
+}
+
+/* wall clock in seconds, for profiling */
+static double get_vgmstream_profile_time(void) {
+#if defined(_WIN32)
+    return (double)clock() / CLOCKS_PER_SEC; /* wall time in MSVCRT */
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+#endif
+}
+
+/* calls an init function and adds its time and I/O to the profile */
+static VGMSTREAM * init_vgmstream_function_profile(STREAMFILE *streamFile, int fcn_index, int is_probe, vgmstream_probe_profile * profile) {
+    VGMSTREAM * vgmstream;
+    vgmstream_probe_profile_entry * entry;
+    size_t read_calls = 0, read_bytes = 0, bytes_read;
+    int open_count = 0;
+    double start_time;
+
+    if (!profile)
+        return init_vgmstream_function_index(streamFile, fcn_index, 0);
+
+    entry = &profile->entries[fcn_index];
+    if (is_probe)
+        get_probe_streamfile_counters(streamFile, &read_calls, &read_bytes, &open_count);
+    bytes_read = get_streamfile_bytes_read(streamFile);
+    start_time = get_vgmstream_profile_time();
+
+    vgmstream = init_vgmstream_function_index(streamFile, fcn_index, 0);
+
+    entry->seconds += get_vgmstream_profile_time() - start_time;
+    entry->bytes_read += get_streamfile_bytes_read(streamFile) - bytes_read;
+    if (is_probe) {
+        size_t new_read_calls, new_read_bytes;
+        int new_open_count;
+        get_probe_streamfile_counters(streamFile, &new_read_calls, &new_read_bytes, &new_open_count);
+        entry->read_calls += new_read_calls - read_calls;
+        entry->read_bytes += new_read_bytes - read_bytes;
+        entry->open_count += new_open_count - open_count;
+    }
+    entry->calls++;
+    if (vgmstream)
+        entry->accepted++;
+
+    return vgmstream;
+}
+
+/* internal version with all parameters, also returns the index of the function that worked (or -1) */
+static VGMSTREAM * init_vgmstream_internal(STREAMFILE *streamFile, int * out_fcn_index, vgmstream_probe_profile * profile) {
+    int i, j, fcns_size;
+    int candidates[HINT_CANDIDATES_MAX];
+    int candidate_count;
+    int is_probe;
+    VGMSTREAM * vgmstream = NULL;
+    STREAMFILE * probeFile = NULL;
+
+    if (!streamFile)
+        return NULL;
+
+    /* metas read mostly the same header bytes, so serve them from memory while detecting */
+    probeFile = open_probe_streamfile(streamFile, STREAMFILE_PROBE_WINDOW_SIZE);
+    is_probe = (probeFile != NULL);
+    if (!probeFile)
+        probeFile = streamFile;
+
+    fcns_size = (sizeof(init_vgmstream_functions)/sizeof(init_vgmstream_functions[0]));
+
+    /* try formats that declared this ext+id first */
+    candidate_count = get_hint_candidates(probeFile, candidates, HINT_CANDIDATES_MAX);
+    for (i = 0; i < candidate_count; i++) {
+        vgmstream = init_vgmstream_function_profile(probeFile, candidates[i], is_probe, profile);
+        if (vgmstream) {
+            i = candidates[i];
+            goto done;
+        }
+    }
+
+    /* try a series of formats, see which works */
+    for (i=0; i < fcns_size; i++) {
+        /* already tried above */
+        for (j = 0; j < candidate_count && candidates[j] != i; j++)
+            ;
+        if (j < candidate_count)
+            continue;
+
+        vgmstream = init_vgmstream_function_profile(probeFile, i, is_probe, profile);
+        if (vgmstream)
+            goto done;
     }
 
     /* not supported */
-    return NULL;
+    i = -1;
+done:
+    if (out_fcn_index)
+        *out_fcn_index = i;
+    if (probeFile != streamFile)
+        close_streamfile(probeFile);
+    return vgmstream;
 }
 
 /* format detection and VGMSTREAM setup, uses default parameters */
@@ -491,7 +777,213 @@ VGMSTREAM * init_vgmstream(const char * const filename) {
 }
 
 VGMSTREAM * init_vgmstream_from_STREAMFILE(STREAMFILE *streamFile) {
-    return init_vgmstream_internal(streamFile);
+    return init_vgmstream_internal(streamFile, NULL, NULL);
+}
+
+/* format detection for info only (playlists/library scans), skipping decoder setup when possible */
+VGMSTREAM * init_vgmstream_info(const char * const filename) {
+    VGMSTREAM *vgmstream = NULL;
+    STREAMFILE *streamFile = open_stdio_streamfile(filename);
+    if (streamFile) {
+        streamFile->info_only = 1;
+        vgmstream = init_vgmstream_from_STREAMFILE(streamFile);
+        close_streamfile(streamFile);
+    }
+    return vgmstream;
+}
+
+VGMSTREAM * init_vgmstream_from_STREAMFILE_profile(STREAMFILE *streamFile, vgmstream_probe_profile * profile) {
+    return init_vgmstream_internal(streamFile, NULL, profile);
+}
+
+vgmstream_probe_profile * allocate_vgmstream_probe_profile(void) {
+    vgmstream_probe_profile * profile;
+    int i;
+
+    profile = calloc(1, sizeof(vgmstream_probe_profile));
+    if (!profile) return NULL;
+
+    profile->entry_count = (sizeof(init_vgmstream_functions)/sizeof(init_vgmstream_functions[0]));
+    profile->entries = calloc(profile->entry_count, sizeof(vgmstream_probe_profile_entry));
+    if (!profile->entries) {
+        free(profile);
+        return NULL;
+    }
+
+    for (i = 0; i < profile->entry_count; i++) {
+        profile->entries[i].name = init_vgmstream_functions[i].name;
+    }
+    return profile;
+}
+
+void close_vgmstream_probe_profile(vgmstream_probe_profile * profile) {
+    if (!profile)
+        return;
+    free(profile->entries);
+    free(profile);
+}
+
+/* formats that can list all subsongs from a single header parse */
+static const struct {
+    VGMSTREAM * (*init_vgmstream_function)(STREAMFILE *);
+    int (*init_subsong_table)(STREAMFILE *, vgmstream_subsong_table *);
+} subsong_table_functions[] = {
+    {init_vgmstream_fsb5, init_subsong_table_fsb5},
+    {init_vgmstream_xwb, init_subsong_table_xwb},
+    {init_vgmstream_awc, init_subsong_table_awc},
+    {init_vgmstream_ubi_sb, init_subsong_table_ubi_sb},
+    {init_vgmstream_sqex_scd, init_subsong_table_sqex_scd},
+    {init_vgmstream_ea_bnk, init_subsong_table_ea_bnk},
+};
+
+static void set_vgmstream_subsong_info(vgmstream_subsong_info * info, VGMSTREAM * vgmstream) {
+    info->supported = 1;
+    info->stream_offset = vgmstream->ch[0].channel_start_offset;
+    info->coding_type = vgmstream->coding_type;
+    info->channels = vgmstream->channels;
+    info->sample_rate = vgmstream->sample_rate;
+    info->num_samples = vgmstream->num_samples;
+    info->loop_flag = vgmstream->loop_flag;
+    info->loop_start_sample = vgmstream->loop_start_sample;
+    info->loop_end_sample = vgmstream->loop_end_sample;
+    memcpy(info->stream_name, vgmstream->stream_name, STREAM_NAME_SIZE);
+}
+
+vgmstream_subsong_table * get_vgmstream_subsong_table(STREAMFILE *streamFile) {
+    vgmstream_subsong_table * table = NULL;
+    VGMSTREAM * vgmstream = NULL;
+    int stream_index, info_only;
+    int fcn_index, i;
+
+    if (!streamFile)
+        return NULL;
+    stream_index = streamFile->stream_index;
+    info_only = streamFile->info_only;
+
+    table = calloc(1, sizeof(vgmstream_subsong_table));
+    if (!table) goto fail;
+
+    /* detect format (and subsong count) with the first subsong */
+    streamFile->stream_index = 0;
+    streamFile->info_only = 1;
+    vgmstream = init_vgmstream_internal(streamFile, &fcn_index, NULL);
+    if (!vgmstream) goto fail;
+
+    table->fcn_index = fcn_index;
+    table->meta_type = vgmstream->meta_type;
+
+    /* formats that parse all subsongs at once */
+    for (i = 0; i < sizeof(subsong_table_functions) / sizeof(subsong_table_functions[0]); i++) {
+        if (subsong_table_functions[i].init_vgmstream_function != init_vgmstream_functions[fcn_index].function)
+            continue;
+        if (!subsong_table_functions[i].init_subsong_table(streamFile, table))
+            break; /* try the generic way */
+        if (table->subsongs)
+            goto done;
+
+        /* info needs the stream data (external files, codec headers): open each from the parsed bank */
+        table->subsongs = calloc(table->subsong_count, sizeof(vgmstream_subsong_info));
+        if (!table->subsongs) goto fail;
+        for (i = 0; i < table->subsong_count; i++) {
+            VGMSTREAM * subsong_vgmstream;
+
+            streamFile->stream_index = i+1;
+            subsong_vgmstream = table->init_subsong(streamFile, table, i+1);
+            subsong_vgmstream = validate_vgmstream(subsong_vgmstream, streamFile, fcn_index, 0);
+            if (!subsong_vgmstream)
+                continue;
+            set_vgmstream_subsong_info(&table->subsongs[i], subsong_vgmstream);
+            close_vgmstream(subsong_vgmstream);
+        }
+        goto done;
+    }
+
+    /* others: open each subsong (info only) with the meta that detected the file */
+    table->subsong_count = vgmstream->num_streams > 0 ? vgmstream->num_streams : 1;
+    table->subsongs = calloc(table->subsong_count, sizeof(vgmstream_subsong_info));
+    if (!table->subsongs) goto fail;
+
+    set_vgmstream_subsong_info(&table->subsongs[0], vgmstream);
+    for (i = 1; i < table->subsong_count; i++) {
+        VGMSTREAM * subsong_vgmstream;
+
+        streamFile->stream_index = i+1;
+        subsong_vgmstream = init_vgmstream_function_index(streamFile, fcn_index, 0);
+        if (!subsong_vgmstream)
+            continue;
+        set_vgmstream_subsong_info(&table->subsongs[i], subsong_vgmstream);
+        close_vgmstream(subsong_vgmstream);
+    }
+
+done:
+    close_vgmstream(vgmstream);
+    streamFile->stream_index = stream_index;
+    streamFile->info_only = info_only;
+    return table;
+fail:
+    close_vgmstream(vgmstream);
+    close_vgmstream_subsong_table(table);
+    streamFile->stream_index = stream_index;
+    streamFile->info_only = info_only;
+    return NULL;
+}
+
+VGMSTREAM * init_vgmstream_from_subsong_table(STREAMFILE *streamFile, vgmstream_subsong_table * table, int subsong) {
+    VGMSTREAM * vgmstream = NULL;
+    int stream_index;
+
+    if (!streamFile || !table || subsong < 1 || subsong > table->subsong_count)
+        return NULL;
+    if (!table->subsongs[subsong-1].supported)
+        return NULL;
+
+    stream_index = streamFile->stream_index;
+    streamFile->stream_index = subsong;
+
+    if (table->init_subsong) {
+        /* build from the parsed bank */
+        vgmstream = table->init_subsong(streamFile, table, subsong);
+        vgmstream = validate_vgmstream(vgmstream, streamFile, table->fcn_index, 0);
+    }
+    else {
+        /* skip detection at least */
+        vgmstream = init_vgmstream_function_index(streamFile, table->fcn_index, 0);
+    }
+
+    streamFile->stream_index = stream_index;
+    return vgmstream;
+}
+
+void close_vgmstream_subsong_table(vgmstream_subsong_table * table) {
+    if (!table)
+        return;
+    if (table->free_bank_data)
+        table->free_bank_data(table->bank_data);
+    free(table->subsongs);
+    free(table);
+}
+
+/* archive parsers, tried in order */
+static int (*archive_init_functions[])(streamfile_archive * archive) = {
+    init_streamfile_archive_afs,
+    init_streamfile_archive_cpk,
+};
+
+streamfile_archive * open_streamfile_archive(STREAMFILE *streamFile) {
+    streamfile_archive * archive = allocate_streamfile_archive(streamFile);
+    int i;
+
+    if (!archive)
+        return NULL;
+
+    for (i = 0; i < sizeof(archive_init_functions)/sizeof(archive_init_functions[0]); i++) {
+        archive->entry_count = 0;
+        if (archive_init_functions[i](archive) && archive->entry_count > 0)
+            return archive;
+    }
+
+    close_streamfile_archive(archive);
+    return NULL;
 }
 
 /* Reset a VGMSTREAM to its state at the start of playback.
@@ -508,6 +1000,10 @@ void reset_vgmstream(VGMSTREAM * vgmstream) {
      * Otherwise hit_loop will be 0 and it will be copied over anyway when we
      * really hit the loop start. */
 
+    /* codec state may not exist in metadata-only mode */
+    if (vgmstream->info_only)
+        return;
+
 #ifdef VGM_USE_VORBIS
     if (vgmstream->coding_type==coding_ogg_vorbis) {
         reset_ogg_vorbis(vgmstream);
@@ -921,6 +1417,12 @@ int32_t get_vgmstream_play_samples(double looptimes, double fadeseconds, double
 
 /* decode data into sample buffer */
 void render_vgmstream(sample * buffer, int32_t sample_count, VGMSTREAM * vgmstream) {
+    /* metadata-only streams have no decoder set up */
+    if (vgmstream->info_only) {
+        memset(buffer, 0, sample_count * vgmstream->channels * sizeof(sample));
+        return;
+    }
+
     switch (vgmstream->layout_type) {
         case layout_interleave:
         case layout_interleave_shortblock:
@@ -1284,24 +1786,80 @@ int get_vgmstream_shortframe_size(VGMSTREAM * vgmstream) {
     }
 }
 
-void decode_vgmstream_mem(VGMSTREAM * vgmstream, int samples_written, int samples_to_do, sample * buffer, uint8_t * data, int channel) {
+/* decodes one channel from the bytes of its current frame, for codecs with a _frame entry point */
+static void decode_vgmstream_frame(VGMSTREAM * vgmstream, int samples_written, int samples_to_do, sample * buffer, const uint8_t * frame, int channel) {
+    VGMSTREAMCHANNEL * stream = &vgmstream->ch[channel];
+    sample * outbuf = buffer+samples_written*vgmstream->channels+channel;
+    int first_sample = vgmstream->samples_into_block % get_vgmstream_samples_per_frame(vgmstream);
 
     switch (vgmstream->coding_type) {
         case coding_NGC_DSP:
-            decode_ngc_dsp_mem(&vgmstream->ch[channel],
-                    buffer+samples_written*vgmstream->channels+channel,
-                    vgmstream->channels,vgmstream->samples_into_block,
-                    samples_to_do, data);
+            decode_ngc_dsp_frame(stream,outbuf,vgmstream->channels,first_sample,samples_to_do,frame);
+            break;
+        case coding_NGC_AFC:
+            decode_ngc_afc_frame(stream,outbuf,vgmstream->channels,first_sample,samples_to_do,frame);
+            break;
+        case coding_NGC_DTK:
+            decode_ngc_dtk_frame(stream,outbuf,vgmstream->channels,first_sample,samples_to_do,channel,frame);
+            break;
+        case coding_PSX:
+            decode_psx_frame(stream,outbuf,vgmstream->channels,first_sample,samples_to_do,frame);
+            break;
+        case coding_XBOX_int:
+            decode_xbox_ima_int_frame(stream,outbuf,vgmstream->channels,first_sample,samples_to_do,frame);
+            break;
+        case coding_RAD_IMA_mono:
+            decode_rad_ima_mono_frame(stream,outbuf,vgmstream->channels,first_sample,samples_to_do,frame);
+            break;
+        case coding_APPLE_IMA4:
+            decode_apple_ima4_frame(stream,outbuf,vgmstream->channels,first_sample,samples_to_do,frame);
             break;
         default:
             break;
     }
 }
 
+/* fetches each channel's current frame once and decodes from its bytes, rather than each decoder reading per nibble */
+static void decode_vgmstream_frames(VGMSTREAM * vgmstream, int samples_written, int samples_to_do, sample * buffer) {
+    uint8_t frame_buf[0x40]; /* frame sizes are much smaller than this */
+    int samples_per_frame = get_vgmstream_samples_per_frame(vgmstream);
+    int frame_size = get_vgmstream_frame_size(vgmstream);
+    int chan;
+
+    for (chan=0;chan<vgmstream->channels;chan++) {
+        VGMSTREAMCHANNEL * stream = &vgmstream->ch[chan];
+        off_t frame_offset = stream->offset + (vgmstream->samples_into_block / samples_per_frame) * frame_size;
+        const uint8_t * frame = read_streamfile_ptr(frame_buf, frame_offset, frame_size, stream->streamfile);
+        if (!frame) frame = frame_buf; /* unreadable bytes are 0xFF, as read_8bit */
+
+        decode_vgmstream_frame(vgmstream, samples_written, samples_to_do, buffer, frame, chan);
+    }
+}
+
+void decode_vgmstream_mem(VGMSTREAM * vgmstream, int samples_written, int samples_to_do, sample * buffer, uint8_t * data, int channel) {
+    int samples_per_frame = get_vgmstream_samples_per_frame(vgmstream);
+    int frame_size = get_vgmstream_frame_size(vgmstream);
+
+    if (samples_per_frame <= 0)
+        return;
+
+    decode_vgmstream_frame(vgmstream, samples_written, samples_to_do, buffer,
+            data + (vgmstream->samples_into_block / samples_per_frame) * frame_size, channel);
+}
+
 void decode_vgmstream(VGMSTREAM * vgmstream, int samples_written, int samples_to_do, sample * buffer) {
     int chan;
 
     switch (vgmstream->coding_type) {
+        case coding_NGC_DSP:
+        case coding_NGC_AFC:
+        case coding_NGC_DTK:
+        case coding_PSX:
+        case coding_XBOX_int:
+        case coding_RAD_IMA_mono:
+        case coding_APPLE_IMA4:
+            decode_vgmstream_frames(vgmstream, samples_written, samples_to_do, buffer);
+            break;
         case coding_CRI_ADX:
             for (chan=0;chan<vgmstream->channels;chan++) {
                 decode_adx(&vgmstream->ch[chan],buffer+samples_written*vgmstream->channels+chan,
@@ -1338,13 +1896,6 @@ void decode_vgmstream(VGMSTREAM * vgmstream, int samples_written, int samples_to
                         vgmstream->interleave_block_size);
             }
 
-            break;
-        case coding_NGC_DSP:
-            for (chan=0;chan<vgmstream->channels;chan++) {
-                decode_ngc_dsp(&vgmstream->ch[chan],buffer+samples_written*vgmstream->channels+chan,
-                        vgmstream->channels,vgmstream->samples_into_block,
-                        samples_to_do);
-            }
             break;
         case coding_PCM16LE:
             for (chan=0;chan<vgmstream->channels;chan++) {
@@ -1454,13 +2005,6 @@ void decode_vgmstream(VGMSTREAM * vgmstream, int samples_written, int samples_to
                         samples_to_do,chan);
             }
             break;
-        case coding_XBOX_int:
-            for (chan=0;chan<vgmstream->channels;chan++) {
-                decode_xbox_ima_int(&vgmstream->ch[chan],buffer+samples_written*vgmstream->channels+chan,
-                        vgmstream->channels,vgmstream->samples_into_block,
-                        samples_to_do,chan);
-            }
-            break;
         case coding_MS_IMA:
             for (chan=0;chan<vgmstream->channels;chan++) {
                 decode_ms_ima(vgmstream,&vgmstream->ch[chan],buffer+samples_written*vgmstream->channels+chan,
@@ -1475,20 +2019,6 @@ void decode_vgmstream(VGMSTREAM * vgmstream, int samples_written, int samples_to
                         samples_to_do,chan);
             }
             break;
-        case coding_RAD_IMA_mono:
-            for (chan=0;chan<vgmstream->channels;chan++) {
-                decode_rad_ima_mono(&vgmstream->ch[chan],buffer+samples_written*vgmstream->channels+chan,
-                        vgmstream->channels,vgmstream->samples_into_block,
-                        samples_to_do);
-            }
-            break;
-        case coding_NGC_DTK:
-            for (chan=0;chan<vgmstream->channels;chan++) {
-                decode_ngc_dtk(&vgmstream->ch[chan],buffer+samples_written*vgmstream->channels+chan,
-                        vgmstream->channels,vgmstream->samples_into_block,
-                        samples_to_do,chan);
-            }
-            break;
         case coding_G721:
             for (chan=0;chan<vgmstream->channels;chan++) {
                 decode_g721(&vgmstream->ch[chan],buffer+samples_written*vgmstream->channels+chan,
@@ -1496,20 +2026,6 @@ void decode_vgmstream(VGMSTREAM * vgmstream, int samples_written, int samples_to
                         samples_to_do);
             }
             break;
-        case coding_NGC_AFC:
-            for (chan=0;chan<vgmstream->channels;chan++) {
-                decode_ngc_afc(&vgmstream->ch[chan],buffer+samples_written*vgmstream->channels+chan,
-                        vgmstream->channels,vgmstream->samples_into_block,
-                        samples_to_do);
-            }
-            break;
-        case coding_PSX:
-            for (chan=0;chan<vgmstream->channels;chan++) {
-                decode_psx(&vgmstream->ch[chan],buffer+samples_written*vgmstream->channels+chan,
-                        vgmstream->channels,vgmstream->samples_into_block,
-                        samples_to_do);
-            }
-            break;
         case coding_PSX_badflags:
             for (chan=0;chan<vgmstream->channels;chan++) {
                 decode_psx_badflags(&vgmstream->ch[chan],buffer+samples_written*vgmstream->channels+chan,
@@ -1662,13 +2178,6 @@ void decode_vgmstream(VGMSTREAM * vgmstream, int samples_written, int samples_to
                         samples_to_do);
             }
             break;
-        case coding_APPLE_IMA4:
-            for (chan=0;chan<vgmstream->channels;chan++) {
-                decode_apple_ima4(&vgmstream->ch[chan],buffer+samples_written*vgmstream->channels+chan,
-                        vgmstream->channels,vgmstream->samples_into_block,
-                        samples_to_do);
-            }
-            break;
         case coding_SNDS_IMA:
             for (chan=0;chan<vgmstream->channels;chan++) {
                 decode_snds_ima(&vgmstream->ch[chan],buffer+samples_written*vgmstream->channels+chan,
@@ -2248,6 +2757,7 @@ static void try_dual_file_stereo(VGMSTREAM * opened_vgmstream, STREAMFILE *strea
     /* try to init other channel (new_filename now has the opposite name) */
     dual_streamFile = streamFile->open(streamFile,new_filename,STREAMFILE_DEFAULT_BUFFER_SIZE);
     if (!dual_streamFile) goto fail;
+    dual_streamFile->info_only = streamFile->info_only;
 
     new_vgmstream = init_vgmstream_function(dual_streamFile); /* use the init that just worked, no other should work */
     close_streamfile(dual_streamFile);
@@ -2479,6 +2989,43 @@ int get_vgmstream_average_bitrate(VGMSTREAM * vgmstream)
     return bitrate;
 }
 
+void get_vgmstream_streamfile_stats(VGMSTREAM * vgmstream, streamfile_stats * stats)
+{
+    int i, j;
+    int channels = get_vgmstream_channel_count(vgmstream);
+
+    memset(stats, 0, sizeof(streamfile_stats));
+
+    for (i = 0; i < channels; i++) {
+        STREAMFILE * streamFile = get_vgmstream_streamfile(vgmstream, i);
+        streamfile_stats file_stats;
+
+        if (!streamFile)
+            continue;
+        for (j = 0; j < i; j++) {
+            if (get_vgmstream_streamfile(vgmstream, j) == streamFile)
+                break;
+        }
+        if (j < i)
+            continue; /* shared between channels, already counted */
+
+        get_streamfile_stats(streamFile, &file_stats);
+        stats->reads += file_stats.reads;
+        stats->buffer_hits += file_stats.buffer_hits;
+        stats->buffer_misses += file_stats.buffer_misses;
+        stats->seeks += file_stats.seeks;
+        stats->bytes_read += file_stats.bytes_read;
+        stats->bytes_copied += file_stats.bytes_copied;
+        stats->error_count += file_stats.error_count;
+        if (file_stats.max_backward_seek > stats->max_backward_seek)
+            stats->max_backward_seek = file_stats.max_backward_seek;
+        if (file_stats.access != STREAMFILE_ACCESS_UNKNOWN && file_stats.refill_size >= stats->refill_size) {
+            stats->access = file_stats.access;
+            stats->refill_size = file_stats.refill_size;
+        }
+    }
+}
+
 
 /**
  * Inits vgmstreams' channels doing two things:
@@ -2488,6 +3035,7 @@ int get_vgmstream_average_bitrate(VGMSTREAM * vgmstream)
  */
 int vgmstream_open_stream(VGMSTREAM * vgmstream, STREAMFILE *streamFile, off_t start_offset) {
     STREAMFILE * file;
+    STREAMFILE * cache_file = NULL;
     char filename[PATH_LIMIT];
     int ch;
     int use_streamfile_per_channel = 0;
@@ -2504,8 +3052,8 @@ int vgmstream_open_stream(VGMSTREAM * vgmstream, STREAMFILE *streamFile, off_t s
         return 1;
 #endif
 
-    /* if interleave is big enough keep a buffer per channel */
-    if (vgmstream->interleave_block_size * vgmstream->channels >= STREAMFILE_DEFAULT_BUFFER_SIZE) {
+    /* if interleave is big enough keep a view per channel, sharing a page cache (pointless if it won't be played) */
+    if (vgmstream->interleave_block_size * vgmstream->channels >= STREAMFILE_DEFAULT_BUFFER_SIZE && !streamFile->info_only) {
         use_streamfile_per_channel = 1;
     }
 
@@ -2522,6 +3070,16 @@ int vgmstream_open_stream(VGMSTREAM * vgmstream, STREAMFILE *streamFile, off_t s
             file = streamFile->open(streamFile,filename, STREAMFILE_DEFAULT_BUFFER_SIZE);
             if (!file) goto fail;
         }
+        else {
+            /* channels read far apart: share one file through a page cache, with a few pages per channel */
+            STREAMFILE * base_file = streamFile->open(streamFile,filename, STREAMFILE_PAGE_CACHE_PAGE_SIZE);
+            if (!base_file) goto fail;
+            cache_file = open_page_cache_streamfile(base_file, vgmstream->channels * 2 * STREAMFILE_PAGE_CACHE_PAGE_SIZE);
+            if (!cache_file) {
+                close_streamfile(base_file);
+                goto fail;
+            }
+        }
 
         for (ch=0; ch < vgmstream->channels; ch++) {
             off_t offset;
@@ -2531,9 +3089,9 @@ int vgmstream_open_stream(VGMSTREAM * vgmstream, STREAMFILE *streamFile, off_t s
                 offset = start_offset + vgmstream->interleave_block_size*ch;
             }
 
-            /* open new one if needed */
+            /* open new view if needed */
             if (use_streamfile_per_channel) {
-                file = streamFile->open(streamFile,filename, STREAMFILE_DEFAULT_BUFFER_SIZE);
+                file = (ch == 0) ? cache_file : cache_file->open(cache_file,filename, STREAMFILE_DEFAULT_BUFFER_SIZE);
                 if (!file) goto fail;
             }
 
@@ -2554,3 +3112,459 @@ fail:
     /* open streams will be closed in close_vgmstream(), hopefully called by the meta */
     return 0;
 }
+
+
+/* **************************************************** */
+
+/* Persistent detection cache: a binary file with a header and fixed-size records sorted by key,
+ * so it can be mapped and binary searched directly. New results are kept in memory (a simple
+ * open addressing table) and merged into the file on flush. Records are only valid for the
+ * same list of init functions, so the header keeps a hash of their names (order included)
+ * and the file is ignored if that changes. */
+
+#define PROBE_CACHE_ID          0x56474D43  /* "VGMC" */
+#define PROBE_CACHE_VERSION     2
+#define PROBE_CACHE_HEADER_SIZE 0x10
+
+typedef struct {
+    uint64_t path_hash;         /* key */
+    int32_t stream_index;       /* key */
+    int32_t fcn_index;          /* -1 = not supported */
+    uint64_t file_size;
+    int64_t file_mtime;
+    int32_t meta_type;
+    int32_t num_streams;
+    int32_t num_samples;
+    int32_t sample_rate;
+    int32_t channels;
+    int32_t loop_flag;
+    int32_t loop_start_sample;
+    int32_t loop_end_sample;
+} probe_cache_record;
+
+struct vgmstream_probe_cache {
+    char * path;
+
+    /* loaded file */
+    uint8_t * file_data;
+    size_t file_data_size;
+    int file_mapped;
+    const probe_cache_record * records;
+    size_t record_count;
+
+    /* new results */
+    probe_cache_record * pending;
+    uint8_t * pending_used;
+    size_t pending_count;
+    size_t pending_size;        /* power of 2 */
+};
+
+static uint64_t probe_cache_hash_path(const char * path) {
+    uint64_t hash = 14695981039346656037ull; /* FNV-1a */
+    while (*path) {
+        hash = (hash ^ (uint8_t)*path++) * 1099511628211ull;
+    }
+    return hash;
+}
+
+static int probe_cache_compare(const probe_cache_record * a, uint64_t path_hash, int32_t stream_index) {
+    if (a->path_hash != path_hash)
+        return a->path_hash < path_hash ? -1 : 1;
+    if (a->stream_index != stream_index)
+        return a->stream_index < stream_index ? -1 : 1;
+    return 0;
+}
+
+static int probe_cache_sort_cmp(const void * a, const void * b) {
+    const probe_cache_record * rb = b;
+    return probe_cache_compare(a, rb->path_hash, rb->stream_index);
+}
+
+static uint32_t probe_cache_fcns_size(void) {
+    return (uint32_t)(sizeof(init_vgmstream_functions)/sizeof(init_vgmstream_functions[0]));
+}
+
+static uint32_t probe_cache_fcns_hash(void) {
+    uint32_t hash = 2166136261u; /* FNV-1a of all names, separators included */
+    uint32_t i;
+
+    for (i = 0; i < probe_cache_fcns_size(); i++) {
+        const char * name = init_vgmstream_functions[i].name;
+        do {
+            hash = (hash ^ (uint8_t)*name) * 16777619u;
+        } while (*name++ != '\0');
+    }
+    return hash;
+}
+
+static probe_cache_record * probe_cache_find_pending(vgmstream_probe_cache * cache, uint64_t path_hash, int32_t stream_index, int for_insert) {
+    size_t pos;
+
+    if (!cache->pending_size)
+        return NULL;
+
+    pos = (size_t)(path_hash ^ (uint32_t)stream_index) & (cache->pending_size - 1);
+    while (cache->pending_used[pos]) {
+        if (probe_cache_compare(&cache->pending[pos], path_hash, stream_index) == 0)
+            return &cache->pending[pos];
+        pos = (pos + 1) & (cache->pending_size - 1);
+    }
+    if (!for_insert)
+        return NULL;
+    cache->pending_used[pos] = 1;
+    cache->pending_count++;
+    return &cache->pending[pos];
+}
+
+static const probe_cache_record * probe_cache_find(vgmstream_probe_cache * cache, uint64_t path_hash, int32_t stream_index) {
+    const probe_cache_record * record;
+    size_t lo = 0, hi = cache->record_count;
+
+    record = probe_cache_find_pending(cache, path_hash, stream_index, 0);
+    if (record)
+        return record;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        int cmp = probe_cache_compare(&cache->records[mid], path_hash, stream_index);
+        if (cmp == 0)
+            return &cache->records[mid];
+        if (cmp < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return NULL;
+}
+
+static int probe_cache_add(vgmstream_probe_cache * cache, const probe_cache_record * record) {
+    probe_cache_record * slot;
+
+    /* keep load under 50% */
+    if ((cache->pending_count + 1) * 2 > cache->pending_size) {
+        probe_cache_record * old_pending = cache->pending;
+        uint8_t * old_pending_used = cache->pending_used;
+        size_t i, old_size = cache->pending_size;
+
+        cache->pending_size = old_size ? old_size * 2 : 1024;
+        cache->pending = calloc(cache->pending_size, sizeof(probe_cache_record));
+        cache->pending_used = calloc(cache->pending_size, sizeof(uint8_t));
+        if (!cache->pending || !cache->pending_used) {
+            free(cache->pending);
+            free(cache->pending_used);
+            cache->pending = old_pending;
+            cache->pending_used = old_pending_used;
+            cache->pending_size = old_size;
+            return 0;
+        }
+        cache->pending_count = 0;
+        for (i = 0; i < old_size; i++) {
+            if (old_pending_used[i])
+                *probe_cache_find_pending(cache, old_pending[i].path_hash, old_pending[i].stream_index, 1) = old_pending[i];
+        }
+        free(old_pending);
+        free(old_pending_used);
+    }
+
+    slot = probe_cache_find_pending(cache, record->path_hash, record->stream_index, 1);
+    *slot = *record;
+    return 1;
+}
+
+static int probe_cache_stat(const char * const filename, uint64_t * file_size, int64_t * file_mtime) {
+    struct stat st;
+
+    if (stat(filename, &st) != 0)
+        return 0;
+    *file_size = (uint64_t)st.st_size;
+    *file_mtime = (int64_t)st.st_mtime;
+    return 1;
+}
+
+static void probe_cache_unload(vgmstream_probe_cache * cache) {
+    if (cache->file_data) {
+#if !defined(_WIN32)
+        if (cache->file_mapped)
+            munmap(cache->file_data, cache->file_data_size);
+        else
+#endif
+            free(cache->file_data);
+    }
+    cache->file_data = NULL;
+    cache->file_data_size = 0;
+    cache->file_mapped = 0;
+    cache->records = NULL;
+    cache->record_count = 0;
+}
+
+static void probe_cache_load(vgmstream_probe_cache * cache) {
+    FILE * file;
+    off_t file_end;
+    size_t file_size;
+
+    file = fopen(cache->path, "rb");
+    if (!file)
+        return; /* new cache */
+
+    if (fseeko(file, 0, SEEK_END) != 0)
+        goto done;
+    file_end = ftello(file);
+    if (file_end < PROBE_CACHE_HEADER_SIZE)
+        goto done;
+    file_size = (size_t)file_end;
+
+#if !defined(_WIN32)
+    cache->file_data = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+    if (cache->file_data == MAP_FAILED) {
+        cache->file_data = NULL;
+    }
+    else {
+        cache->file_mapped = 1;
+    }
+#endif
+    if (!cache->file_data) {
+        cache->file_data = malloc(file_size);
+        if (!cache->file_data) goto done;
+        if (fseeko(file, 0, SEEK_SET) != 0 || fread(cache->file_data, 1, file_size, file) != file_size) {
+            probe_cache_unload(cache);
+            goto done;
+        }
+    }
+    cache->file_data_size = file_size;
+
+    /* validate header (native endianness, as the file is only meant for this machine) */
+    {
+        uint32_t * header = (uint32_t*)cache->file_data;
+        size_t record_count = header[3];
+
+        if (header[0] != PROBE_CACHE_ID || header[1] != PROBE_CACHE_VERSION || header[2] != probe_cache_fcns_hash()
+                || PROBE_CACHE_HEADER_SIZE + record_count * sizeof(probe_cache_record) > file_size) {
+            VGM_LOG("VGMSTREAM: ignored probe cache %s\n", cache->path);
+            probe_cache_unload(cache);
+            goto done;
+        }
+
+        cache->records = (const probe_cache_record*)(cache->file_data + PROBE_CACHE_HEADER_SIZE);
+        cache->record_count = record_count;
+    }
+
+done:
+    fclose(file);
+}
+
+vgmstream_probe_cache * open_vgmstream_probe_cache(const char * const path) {
+    vgmstream_probe_cache * cache;
+
+    cache = calloc(1, sizeof(vgmstream_probe_cache));
+    if (!cache) return NULL;
+
+    cache->path = malloc(strlen(path) + 1);
+    if (!cache->path) {
+        free(cache);
+        return NULL;
+    }
+    strcpy(cache->path, path);
+
+    probe_cache_load(cache);
+    return cache;
+}
+
+int flush_vgmstream_probe_cache(vgmstream_probe_cache * cache) {
+    char temp_path[PATH_LIMIT];
+    probe_cache_record * merged = NULL;
+    size_t merged_count = 0, i, j;
+    FILE * file = NULL;
+    uint32_t header[4];
+
+    if (!cache)
+        return 0;
+    if (!cache->pending_count)
+        return 1;
+
+    /* sorted pending results */
+    merged = malloc((cache->record_count + cache->pending_count) * sizeof(probe_cache_record));
+    if (!merged) goto fail;
+    for (i = 0; i < cache->pending_size; i++) {
+        if (cache->pending_used[i])
+            merged[merged_count++] = cache->pending[i];
+    }
+    qsort(merged, merged_count, sizeof(probe_cache_record), probe_cache_sort_cmp);
+
+    /* merge with old records (new ones replace old ones) */
+    if (snprintf(temp_path, sizeof(temp_path), "%s.tmp", cache->path) >= sizeof(temp_path))
+        goto fail;
+    file = fopen(temp_path, "wb");
+    if (!file) goto fail;
+
+    header[0] = PROBE_CACHE_ID;
+    header[1] = PROBE_CACHE_VERSION;
+    header[2] = probe_cache_fcns_hash();
+    header[3] = 0; /* updated below */
+    if (fwrite(header, sizeof(header), 1, file) != 1) goto fail;
+
+    i = 0; j = 0;
+    while (i < cache->record_count || j < merged_count) {
+        const probe_cache_record * record;
+        int cmp;
+
+        if (i == cache->record_count)
+            cmp = 1;
+        else if (j == merged_count)
+            cmp = -1;
+        else
+            cmp = probe_cache_compare(&cache->records[i], merged[j].path_hash, merged[j].stream_index);
+
+        if (cmp < 0) {
+            record = &cache->records[i++];
+        }
+        else {
+            if (cmp == 0) i++;
+            record = &merged[j++];
+        }
+
+        if (fwrite(record, sizeof(probe_cache_record), 1, file) != 1) goto fail;
+        header[3]++;
+    }
+
+    if (fseeko(file, 0, SEEK_SET) != 0) goto fail;
+    if (fwrite(header, sizeof(header), 1, file) != 1) goto fail;
+    if (fclose(file) != 0) {
+        file = NULL;
+        goto fail;
+    }
+    file = NULL;
+
+    /* replace and reload */
+    probe_cache_unload(cache);
+#ifdef _WIN32
+    remove(cache->path);
+#endif
+    if (rename(temp_path, cache->path) != 0) {
+        probe_cache_load(cache);
+        goto fail;
+    }
+
+    free(cache->pending);
+    free(cache->pending_used);
+    cache->pending = NULL;
+    cache->pending_used = NULL;
+    cache->pending_count = 0;
+    cache->pending_size = 0;
+    free(merged);
+
+    probe_cache_load(cache);
+    return 1;
+
+fail:
+    if (file) fclose(file);
+    free(merged);
+    return 0;
+}
+
+void close_vgmstream_probe_cache(vgmstream_probe_cache * cache) {
+    if (!cache)
+        return;
+
+    flush_vgmstream_probe_cache(cache);
+    probe_cache_unload(cache);
+    free(cache->pending);
+    free(cache->pending_used);
+    free(cache->path);
+    free(cache);
+}
+
+int query_vgmstream_probe_cache(vgmstream_probe_cache * cache, const char * const filename, int stream_index, vgmstream_probe_info * info) {
+    const probe_cache_record * record;
+    uint64_t file_size;
+    int64_t file_mtime;
+
+    if (!cache || !filename)
+        return 0;
+    if (!probe_cache_stat(filename, &file_size, &file_mtime))
+        return 0;
+
+    record = probe_cache_find(cache, probe_cache_hash_path(filename), stream_index);
+    if (!record || record->file_size != file_size || record->file_mtime != file_mtime)
+        return 0;
+
+    if (info) {
+        memset(info, 0, sizeof(vgmstream_probe_info));
+        info->supported = record->fcn_index >= 0;
+        info->meta_type = record->meta_type;
+        info->num_streams = record->num_streams;
+        info->num_samples = record->num_samples;
+        info->sample_rate = record->sample_rate;
+        info->channels = record->channels;
+        info->loop_flag = record->loop_flag;
+        info->loop_start_sample = record->loop_start_sample;
+        info->loop_end_sample = record->loop_end_sample;
+    }
+    return 1;
+}
+
+VGMSTREAM * init_vgmstream_cached(const char * const filename, int stream_index, vgmstream_probe_cache * cache) {
+    VGMSTREAM * vgmstream = NULL;
+    STREAMFILE * streamFile = NULL;
+    probe_cache_record record;
+    const probe_cache_record * found = NULL;
+    int fcn_index = -1;
+
+    if (!cache) {
+        streamFile = open_stdio_streamfile(filename);
+        if (!streamFile) return NULL;
+        streamFile->stream_index = stream_index;
+        vgmstream = init_vgmstream_from_STREAMFILE(streamFile);
+        close_streamfile(streamFile);
+        return vgmstream;
+    }
+
+    memset(&record, 0, sizeof(probe_cache_record));
+    if (!probe_cache_stat(filename, &record.file_size, &record.file_mtime))
+        return NULL;
+    record.path_hash = probe_cache_hash_path(filename);
+    record.stream_index = stream_index;
+
+    found = probe_cache_find(cache, record.path_hash, record.stream_index);
+    if (found && (found->file_size != record.file_size || found->file_mtime != record.file_mtime))
+        found = NULL; /* stale */
+
+    /* known unsupported file */
+    if (found && found->fcn_index < 0)
+        return NULL;
+
+    streamFile = open_stdio_streamfile(filename);
+    if (!streamFile) return NULL;
+    streamFile->stream_index = stream_index;
+
+    /* go straight to the function that worked before (dual stereo is only retried if it was found) */
+    if (found && found->fcn_index < probe_cache_fcns_size()) {
+        fcn_index = found->fcn_index;
+        vgmstream = init_vgmstream_function_index(streamFile, fcn_index, found->channels == 1);
+        if (vgmstream && vgmstream->channels == found->channels && vgmstream->num_samples == found->num_samples) {
+            close_streamfile(streamFile);
+            return vgmstream;
+        }
+
+        /* file changed in some way, redo */
+        close_vgmstream(vgmstream);
+        vgmstream = NULL;
+    }
+
+    vgmstream = init_vgmstream_internal(streamFile, &fcn_index, NULL);
+    close_streamfile(streamFile);
+
+    record.fcn_index = fcn_index;
+    if (vgmstream) {
+        record.meta_type = vgmstream->meta_type;
+        record.num_streams = vgmstream->num_streams;
+        record.num_samples = vgmstream->num_samples;
+        record.sample_rate = vgmstream->sample_rate;
+        record.channels = vgmstream->channels;
+        record.loop_flag = vgmstream->loop_flag;
+        record.loop_start_sample = vgmstream->loop_start_sample;
+        record.loop_end_sample = vgmstream->loop_end_sample;
+    }
+    probe_cache_add(cache, &record);
+
+    return vgmstream;
+}
@@ -723,6 +723,7 @@ typedef struct {
     int num_streams;        /* for multi-stream formats (0=not set/one stream, 1=one stream) */
     int stream_index;       /* selected stream (also 1-based) */
     char stream_name[STREAM_NAME_SIZE]; /* name of the current stream (info), if the file stores it and it's filled */
+    int info_only;          /* opened in metadata-only mode: codec state may be missing and render outputs silence */
 
     /* looping */
     int loop_flag;              /* is this stream looped? */
@@ -1165,6 +1166,10 @@ VGMSTREAM * init_vgmstream(const char * const filename);
 /* init with custom IO via streamfile */
 VGMSTREAM * init_vgmstream_from_STREAMFILE(STREAMFILE *streamFile);
 
+/* do format detection for info only (samples, loops, subsongs, etc). Codecs aren't set up so the
+ * VGMSTREAM can't be played (renders silence). Custom IO can set streamFile->info_only instead. */
+VGMSTREAM * init_vgmstream_info(const char * const filename);
+
 /* reset a VGMSTREAM to start of stream */
 void reset_vgmstream(VGMSTREAM * vgmstream);
 
@@ -1185,9 +1190,114 @@ void describe_vgmstream(VGMSTREAM * vgmstream, char * desc, int length);
  * stream. Compares files by absolute paths. */
 int get_vgmstream_average_bitrate(VGMSTREAM * vgmstream);
 
+/* Sum the I/O counters of all unique STREAMFILEs used by the stream's channels/codec
+ * (the largest backward seek is the max of all, and access/refill those of the largest refill). */
+void get_vgmstream_streamfile_stats(VGMSTREAM * vgmstream, streamfile_stats * stats);
+
+/* Detection profile: time and I/O used by each init function while detecting files,
+ * accumulated over all files opened with the same profile. */
+typedef struct {
+    const char * name;      /* init function */
+    int calls;              /* times it was tried */
+    int accepted;           /* times it returned a valid VGMSTREAM */
+    double seconds;         /* wall time */
+    size_t read_calls;      /* reads from the file being detected */
+    size_t read_bytes;      /* bytes requested by those reads */
+    size_t bytes_read;      /* bytes the file's backend read (if it counts them) */
+    int open_count;         /* files opened (channels, companion files, etc) */
+} vgmstream_probe_profile_entry;
+
+typedef struct {
+    int entry_count;
+    vgmstream_probe_profile_entry * entries; /* one per init function, in detection order */
+} vgmstream_probe_profile;
+
+vgmstream_probe_profile * allocate_vgmstream_probe_profile(void);
+void close_vgmstream_probe_profile(vgmstream_probe_profile * profile);
+
+/* init_vgmstream_from_STREAMFILE that also profiles detection */
+VGMSTREAM * init_vgmstream_from_STREAMFILE_profile(STREAMFILE *streamFile, vgmstream_probe_profile * profile);
+
+/* Opt-in persistent cache of detection results, keyed by path, size and modification time.
+ * Repeated opens go straight to the meta that worked before (or fail fast for unsupported files),
+ * and metadata can be queried without reading the file. Not thread-safe. */
+typedef struct vgmstream_probe_cache vgmstream_probe_cache;
+
+typedef struct {
+    int supported;          /* 0 if no meta accepted the file */
+    meta_t meta_type;
+    int num_streams;
+    int32_t num_samples;
+    int32_t sample_rate;
+    int channels;
+    int loop_flag;
+    int32_t loop_start_sample;
+    int32_t loop_end_sample;
+} vgmstream_probe_info;
+
+/* open (or create on flush) a cache file */
+vgmstream_probe_cache * open_vgmstream_probe_cache(const char * const path);
+
+/* write new results to the cache file, returns 0 on failure */
+int flush_vgmstream_probe_cache(vgmstream_probe_cache * cache);
+
+/* flush and free the cache */
+void close_vgmstream_probe_cache(vgmstream_probe_cache * cache);
+
+/* init_vgmstream that uses and updates the cache (which may be NULL) */
+VGMSTREAM * init_vgmstream_cached(const char * const filename, int stream_index, vgmstream_probe_cache * cache);
+
+/* get cached info without opening the file, returns 1 if found (check info->supported) */
+int query_vgmstream_probe_cache(vgmstream_probe_cache * cache, const char * const filename, int stream_index, vgmstream_probe_info * info);
+
+/* Subsong table: info of every subsong in a multi-stream file (banks, containers), from a single
+ * header parse when the format supports it (if the info needs the stream data, by opening each
+ * subsong from the parsed headers). Other formats are listed by opening each subsong in
+ * metadata-only mode with the meta that detected the file (no detection scan). */
+typedef struct {
+    int supported;          /* 0 if the subsong can't be opened (bad entry, codec not enabled, etc) */
+    off_t stream_offset;    /* start of the subsong's data (0 if unknown) */
+    size_t stream_size;     /* size of the subsong's data (0 if unknown) */
+    coding_t coding_type;
+    int channels;
+    int32_t sample_rate;
+    int32_t num_samples;
+    int loop_flag;
+    int32_t loop_start_sample;
+    int32_t loop_end_sample;
+    char stream_name[STREAM_NAME_SIZE];
+} vgmstream_subsong_info;
+
+typedef struct vgmstream_subsong_table {
+    meta_t meta_type;
+    int subsong_count;
+    vgmstream_subsong_info * subsongs; /* subsong N (1-based) is subsongs[N-1] */
+
+    /* internal */
+    int fcn_index;          /* init function that detected the file */
+    void * bank_data;       /* parsed header kept by formats that support tables */
+    VGMSTREAM * (*init_subsong)(STREAMFILE *streamFile, struct vgmstream_subsong_table * table, int subsong);
+    void (*free_bank_data)(void * bank_data);
+} vgmstream_subsong_table;
+
+/* get the table of subsongs in a file, or NULL if not supported */
+vgmstream_subsong_table * get_vgmstream_subsong_table(STREAMFILE *streamFile);
+
+/* open a subsong (1-based) from the table, without detecting or re-parsing the bank if possible */
+VGMSTREAM * init_vgmstream_from_subsong_table(STREAMFILE *streamFile, vgmstream_subsong_table * table, int subsong);
+
+void close_vgmstream_subsong_table(vgmstream_subsong_table * table);
+
+/* index an archive (AFS, CPK) so its entries can be opened in place with open_streamfile_archive_entry,
+ * or NULL if the file isn't a supported archive */
+streamfile_archive * open_streamfile_archive(STREAMFILE *streamFile);
+
 /* List of supported formats and elements in the list, for plugins that need to know. */
 const char ** vgmstream_get_formats(size_t * size);
 
+/* Index of a lowercase extension in the list above, or -1 if not supported. */
+int vgmstream_get_format_index(const char * ext);
+
 /* -------------------------------------------------------------------------*/
 /* vgmstream "private" API                                                  */
 /* -------------------------------------------------------------------------*/
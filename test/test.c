@@ -5,8 +5,14 @@
 #ifdef WIN32
 #include <io.h>
 #include <fcntl.h>
+#include <windows.h>
+#include <process.h>
 #else
 #include <unistd.h>
+#include <time.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
 #endif
 
 #ifndef STDOUT_FILENO
@@ -28,10 +34,13 @@ extern int optind, opterr, optopt;
 
 static void make_wav_header(uint8_t * buf, int32_t sample_count, int32_t sample_rate, int channels);
 static void make_smpl_chunk(uint8_t * buf, int32_t loop_start, int32_t loop_end);
+static void print_probe_profile(vgmstream_probe_profile * profile);
+static int scan_main(int argc, char ** argv, const char * listname, const char * outfilename, int thread_count);
 
 static void usage(const char * name) {
     fprintf(stderr,"vgmstream test decoder " VERSION " " __DATE__ "\n"
-          "Usage: %s [-o outfile.wav] [options] infile\n"
+          "Usage: %s [-o outfile.wav] [options] infile (- for stdin)\n"
+          "       %s -S [-o outfile.json] [-I listfile] [-j N] [file/dir ...]\n"
           "Options:\n"
           "    -o outfile.wav: name of output .wav file, default is dump.wav\n"
           "    -l loop count: loop count, default 2.0\n"
@@ -52,7 +61,30 @@ static void usage(const char * name) {
           "    -2 N: only output the Nth (first is 0) set of stereo channels\n"
           "    -F: don't fade after N loops and play the rest of the stream\n"
           "    -s N: select subtream N, if the format supports multiple streams\n"
-            ,name);
+          "    -T: print time and I/O used by each format while detecting the file\n"
+          "    -M: read the file through a memory mapping\n"
+          "    -R: read the file ahead on a background thread while decoding\n"
+          "    -n name: name of the stdin input (its extension is used for detection), default stdin.wav\n"
+          "    -a entry: decode an entry (name or number) of an archive infile (AFS, CPK) without extracting it\n"
+          "    -D: print I/O stats (reads, buffer hits/misses, seeks) of the stream's files after decoding\n"
+          "    -S: scan mode, print a JSON line per stream (all subsongs) of each file/dir (recursive, not following links to dirs inside)\n"
+          "    -I listfile: scan mode, also scan paths in listfile (one per line, - for stdin)\n"
+          "    -j N: scan mode, number of threads, default 4\n"
+            ,name,name);
+}
+
+static void print_streamfile_stats(const streamfile_stats * stats, size_t file_size) {
+    fprintf(stderr,"%lu reads (%lu hits, %lu misses), %lu seeks (max 0x%lx back), %lu bytes read",
+            (unsigned long)stats->reads, (unsigned long)stats->buffer_hits, (unsigned long)stats->buffer_misses,
+            (unsigned long)stats->seeks, (unsigned long)stats->max_backward_seek, (unsigned long)stats->bytes_read);
+    if (file_size)
+        fprintf(stderr," (%.2f%% of file)", stats->bytes_read*100.0/file_size);
+    fprintf(stderr,", %lu bytes copied, %d errors", (unsigned long)stats->bytes_copied, stats->error_count);
+    if (stats->access != STREAMFILE_ACCESS_UNKNOWN) {
+        const char * access_names[] = { "unknown", "sequential", "strided", "random" };
+        fprintf(stderr,", %s access (refill 0x%lx)", access_names[stats->access], (unsigned long)stats->refill_size);
+    }
+    fprintf(stderr,"\n");
 }
 
 int main(int argc, char ** argv) {
@@ -84,8 +116,18 @@ int main(int argc, char ** argv) {
     double fade_seconds = 10.0;
     double fade_delay_seconds = 0.0;
     int ignore_fade = 0;
-
-    while ((opt = getopt(argc, argv, "o:l:f:d:ipPcmxeLEFr:gb2:s:")) != -1) {
+    int print_profile = 0;
+    int use_mmap = 0;
+    int use_readahead = 0;
+    int print_iostats = 0;
+    char * pipe_name = "stdin.wav";
+    STREAMFILE * pipeFile = NULL;
+    char * archive_entry = NULL;
+    int scan_mode = 0;
+    char * scan_listname = NULL;
+    int scan_threads = 4;
+
+    while ((opt = getopt(argc, argv, "o:l:f:d:ipPcmxeLEFr:gb2:s:TMRDn:a:SI:j:")) != -1) {
         switch (opt) {
             case 'o':
                 outfilename = optarg;
@@ -145,6 +187,33 @@ int main(int argc, char ** argv) {
             case 's':
                 stream_index = atoi(optarg);
                 break;
+            case 'T':
+                print_profile = 1;
+                break;
+            case 'M':
+                use_mmap = 1;
+                break;
+            case 'R':
+                use_readahead = 1;
+                break;
+            case 'D':
+                print_iostats = 1;
+                break;
+            case 'n':
+                pipe_name = optarg;
+                break;
+            case 'a':
+                archive_entry = optarg;
+                break;
+            case 'S':
+                scan_mode = 1;
+                break;
+            case 'I':
+                scan_listname = optarg;
+                break;
+            case 'j':
+                scan_threads = atoi(optarg);
+                break;
             default:
                 usage(argv[0]);
                 return 1;
@@ -152,6 +221,14 @@ int main(int argc, char ** argv) {
         }
     }
 
+    if (scan_mode) {
+        if (optind == argc && !scan_listname) {
+            usage(argv[0]);
+            return 1;
+        }
+        return scan_main(argc - optind, argv + optind, scan_listname, outfilename, scan_threads);
+    }
+
     if (optind!=argc-1) {
         usage(argv[0]);
         return 1;
@@ -192,14 +269,74 @@ int main(int argc, char ** argv) {
     /* manually init streamfile to pass the stream index */
     {
         //s = init_vgmstream(infilename);
-        STREAMFILE *streamFile = open_stdio_streamfile(infilename);
+        STREAMFILE *streamFile;
+        if (!strcmp(infilename,"-")) {
+#ifdef WIN32
+            _setmode(fileno(stdin),_O_BINARY);
+#endif
+            streamFile = open_pipe_streamfile(stdin, pipe_name, 0, 0);
+            infilename = pipe_name;
+            if (streamFile) /* kept to report data lost at the end */
+                pipeFile = streamFile->open(streamFile, pipe_name, 0);
+        }
+        else {
+            streamFile = use_mmap ? open_mmap_streamfile(infilename) : open_stdio_streamfile(infilename);
+        }
         if (!streamFile) {
             fprintf(stderr,"file %s not found\n",infilename);
             return 1;
         }
 
+        if (archive_entry) {
+            STREAMFILE *entryFile = NULL;
+            streamfile_archive * archive = open_streamfile_archive(streamFile);
+            if (archive) {
+                int index = find_streamfile_archive_entry(archive, archive_entry);
+                char *end;
+                if (index < 0) {
+                    index = strtol(archive_entry, &end, 10);
+                    if (*end != '\0') index = -1;
+                }
+                entryFile = open_streamfile_archive_entry(archive, index);
+                if (!entryFile) {
+                    int i;
+                    fprintf(stderr,"entry %s not found, entries:\n",archive_entry);
+                    for (i = 0; i < archive->entry_count; i++)
+                        fprintf(stderr,"%i: %s (0x%lx bytes)\n",i,archive->entries[i].name,(unsigned long)archive->entries[i].size);
+                }
+                close_streamfile_archive(archive);
+            }
+            else {
+                fprintf(stderr,"%s isn't a supported archive\n",infilename);
+            }
+            close_streamfile(streamFile);
+            if (!entryFile)
+                return 1;
+            streamFile = entryFile;
+        }
+
+        /* channels re-open it by name, getting their own read-ahead buffers */
+        if (use_readahead) {
+            STREAMFILE *readaheadFile = open_readahead_streamfile(streamFile, 0x10000, 4);
+            if (!readaheadFile) {
+                fprintf(stderr,"failed to start read-ahead for %s\n",infilename);
+                close_streamfile(streamFile);
+                return 1;
+            }
+            streamFile = readaheadFile;
+        }
+
         streamFile->stream_index = stream_index;
-        vgmstream = init_vgmstream_from_STREAMFILE(streamFile);
+        streamFile->info_only = print_metaonly; /* won't be decoded */
+        if (print_profile) {
+            vgmstream_probe_profile * profile = allocate_vgmstream_probe_profile();
+            vgmstream = init_vgmstream_from_STREAMFILE_profile(streamFile, profile);
+            print_probe_profile(profile);
+            close_vgmstream_probe_profile(profile);
+        }
+        else {
+            vgmstream = init_vgmstream_from_STREAMFILE(streamFile);
+        }
         close_streamfile(streamFile);
 
         if (!vgmstream) {
@@ -386,31 +523,51 @@ int main(int argc, char ** argv) {
     fclose(outfile);
     outfile = NULL;
 
-#ifdef PROFILE_STREAMFILE
-    {
-        size_t total_bytes_read = 0;
+    /* a pipe can't go back to data it didn't keep (or may have ended early) */
+    if (pipeFile) {
+        streamfile_stats stats;
+        off_t lost_offset;
+        size_t lost_size;
+        int lost_count = get_pipe_streamfile_loss(pipeFile, &lost_offset, &lost_size);
+
+        if (lost_count > 0)
+            fprintf(stderr,"warning: %d reads from stdin went back to data no longer kept (from 0x%lx, 0x%lx bytes lost)\n",
+                    lost_count, (unsigned long)lost_offset, (unsigned long)lost_size);
+        get_vgmstream_streamfile_stats(vgmstream, &stats);
+        if (!lost_count && stats.error_count > 0)
+            fprintf(stderr,"warning: %d failed reads from stdin (input ended early or errors)\n", stats.error_count);
+        close_streamfile(pipeFile);
+        pipeFile = NULL;
+    }
+
+    if (print_iostats) {
+        streamfile_stats stats;
+
         for (i=0;i<vgmstream->channels;i++) {
-            size_t bytes_read = get_streamfile_bytes_read(vgmstream->ch[i].streamfile);
-            size_t file_size = get_streamfile_size(vgmstream->ch[i].streamfile);
-            int error_count = get_streamfile_error_count(vgmstream->ch[i].streamfile);
-            int already_reported = 0;
+            STREAMFILE * streamFile = vgmstream->ch[i].streamfile;
 
             /* see if we've reported this STREAMFILE already */
-            for (j=i-1;!already_reported && j>=0;j--) {
-                if (vgmstream->ch[j].streamfile == vgmstream->ch[i].streamfile) {
-                    already_reported=1;
-                }
+            for (j=i-1;j>=0;j--) {
+                if (vgmstream->ch[j].streamfile == streamFile)
+                    break;
+            }
+            if (!streamFile || j>=0) continue;
+
+            get_streamfile_stats(streamFile, &stats);
+            fprintf(stderr,"ch%d: ",i);
+            print_streamfile_stats(&stats, get_streamfile_size(streamFile));
+            {
+                size_t hits, waits, misses;
+                if (get_readahead_streamfile_stats(streamFile, &hits, &waits, &misses))
+                    fprintf(stderr,"ch%d: read-ahead %lu ready, %lu waited, %lu read in place\n",
+                            i, (unsigned long)hits, (unsigned long)waits, (unsigned long)misses);
             }
-
-            if (already_reported) continue;
-
-            total_bytes_read += bytes_read;
-            fprintf(stderr,"ch%d: %lf%% (%d bytes read, file is %d bytes) %d errors\n",i,
-                    bytes_read*100.0/file_size,bytes_read,file_size,error_count);
         }
-        fprintf(stderr,"total bytes read: %d\n",total_bytes_read);
+
+        get_vgmstream_streamfile_stats(vgmstream, &stats);
+        fprintf(stderr,"total: ");
+        print_streamfile_stats(&stats, 0);
     }
-#endif
 
     if (outfilename_reset) {
         outfile = fopen(outfilename_reset,"wb");
@@ -491,6 +648,45 @@ int main(int argc, char ** argv) {
 
 
 
+static int compare_profile_entries(const void * a, const void * b) {
+    const vgmstream_probe_profile_entry * ea = a;
+    const vgmstream_probe_profile_entry * eb = b;
+    if (ea->seconds != eb->seconds)
+        return ea->seconds < eb->seconds ? 1 : -1;
+    return (int)eb->read_calls - (int)ea->read_calls;
+}
+
+/* print detection profile, slowest formats first */
+static void print_probe_profile(vgmstream_probe_profile * profile) {
+    vgmstream_probe_profile_entry * entries;
+    double total_seconds = 0;
+    size_t total_reads = 0;
+    int i, tried = 0;
+
+    if (!profile) return;
+
+    entries = malloc(profile->entry_count * sizeof(vgmstream_probe_profile_entry));
+    if (!entries) return;
+    memcpy(entries, profile->entries, profile->entry_count * sizeof(vgmstream_probe_profile_entry));
+    qsort(entries, profile->entry_count, sizeof(vgmstream_probe_profile_entry), compare_profile_entries);
+
+    fprintf(stderr,"%-24s %10s %8s %10s %10s %6s %s\n", "format","usec","reads","bytes","io bytes","opens","");
+    for (i = 0; i < profile->entry_count; i++) {
+        const vgmstream_probe_profile_entry * entry = &entries[i];
+        if (!entry->calls)
+            continue;
+        fprintf(stderr,"%-24s %10.1f %8u %10u %10u %6i %s\n", entry->name, entry->seconds * 1000000.0,
+                (unsigned int)entry->read_calls, (unsigned int)entry->read_bytes, (unsigned int)entry->bytes_read,
+                entry->open_count, entry->accepted ? "(accepted)" : "");
+        total_seconds += entry->seconds;
+        total_reads += entry->read_calls;
+        tried++;
+    }
+    fprintf(stderr,"%i formats tried, %.1f usec, %u reads\n", tried, total_seconds * 1000000.0, (unsigned int)total_reads);
+
+    free(entries);
+}
+
 /**
  * make a header for PCM .wav
  * buffer must be 0x2c bytes
@@ -539,3 +735,479 @@ static void make_smpl_chunk(uint8_t * buf, int32_t loop_start, int32_t loop_end)
     put_32bitLE(buf+60, 0);
     put_32bitLE(buf+64, 0);
 }
+
+
+/* ************************************************************ */
+/* Scanner mode: probes files from dirs/lists on a pool of threads, and writes a JSON line per
+ * stream (every subsong of multi-stream files). Paths and output lines go through small bounded
+ * queues, so memory use doesn't depend on the number of files. */
+
+#define SCAN_PATH_QUEUE_SIZE    4096
+#define SCAN_LINE_QUEUE_SIZE    1024
+#define SCAN_LINE_MAX           (PATH_LIMIT*2 + STREAM_NAME_SIZE*2 + 1024)
+#define SCAN_THREADS_MAX        64
+
+/* counting semaphores for the queues (XP has no condition variables, and OS X no unnamed POSIX ones) */
+#ifdef WIN32
+typedef CRITICAL_SECTION scan_mutex_t;
+typedef HANDLE scan_sem_t;
+typedef HANDLE scan_thread_t;
+#define scan_mutex_init(m)      InitializeCriticalSection(m)
+#define scan_mutex_free(m)      DeleteCriticalSection(m)
+#define scan_mutex_lock(m)      EnterCriticalSection(m)
+#define scan_mutex_unlock(m)    LeaveCriticalSection(m)
+#define scan_sem_init(s,n)      ((*(s) = CreateSemaphore(NULL, n, 0x7FFFFFFF, NULL)) != NULL)
+#define scan_sem_free(s)        CloseHandle(*(s))
+#define scan_sem_wait(s)        WaitForSingleObject(*(s), INFINITE)
+#define scan_sem_post(s)        ReleaseSemaphore(*(s), 1, NULL)
+#else
+typedef pthread_mutex_t scan_mutex_t;
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int count;
+} scan_sem_t;
+typedef pthread_t scan_thread_t;
+#define scan_mutex_init(m)      pthread_mutex_init(m,NULL)
+#define scan_mutex_free(m)      pthread_mutex_destroy(m)
+#define scan_mutex_lock(m)      pthread_mutex_lock(m)
+#define scan_mutex_unlock(m)    pthread_mutex_unlock(m)
+
+static int scan_sem_init(scan_sem_t * s, int count) {
+    s->count = count;
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->cond, NULL);
+    return 1;
+}
+static void scan_sem_free(scan_sem_t * s) {
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->cond);
+}
+static void scan_sem_wait(scan_sem_t * s) {
+    pthread_mutex_lock(&s->lock);
+    while (s->count == 0)
+        pthread_cond_wait(&s->cond, &s->lock);
+    s->count--;
+    pthread_mutex_unlock(&s->lock);
+}
+static void scan_sem_post(scan_sem_t * s) {
+    pthread_mutex_lock(&s->lock);
+    s->count++;
+    pthread_cond_signal(&s->cond);
+    pthread_mutex_unlock(&s->lock);
+}
+#endif
+
+/* bounded FIFO of strings, push blocks when full and pop blocks when empty (until closed) */
+typedef struct {
+    char ** items;
+    int size;
+    int head;
+    int count;
+    scan_mutex_t lock;
+    scan_sem_t filled;      /* items to pop, +1 once closed */
+    scan_sem_t empty;       /* slots to push */
+} scan_queue;
+
+typedef struct {
+    scan_queue paths;
+    scan_queue lines;
+    FILE * outfile;
+
+    /* stats (under stats_lock) */
+    scan_mutex_t stats_lock;
+    long files;
+    long files_ok;
+    long streams;
+    long errors;
+} scan_state;
+
+static int scan_queue_init(scan_queue * q, int size) {
+    memset(q, 0, sizeof(scan_queue));
+    q->items = calloc(size, sizeof(char*));
+    if (!q->items) return 0;
+    q->size = size;
+    if (!scan_sem_init(&q->filled, 0)) {
+        free(q->items);
+        return 0;
+    }
+    if (!scan_sem_init(&q->empty, size)) {
+        scan_sem_free(&q->filled);
+        free(q->items);
+        return 0;
+    }
+    scan_mutex_init(&q->lock);
+    return 1;
+}
+
+static void scan_queue_free(scan_queue * q) {
+    while (q->count > 0) {
+        free(q->items[q->head]);
+        q->head = (q->head + 1) % q->size;
+        q->count--;
+    }
+    free(q->items);
+    scan_mutex_free(&q->lock);
+    scan_sem_free(&q->filled);
+    scan_sem_free(&q->empty);
+}
+
+/* takes ownership of item */
+static void scan_queue_push(scan_queue * q, char * item) {
+    scan_sem_wait(&q->empty);
+    scan_mutex_lock(&q->lock);
+    q->items[(q->head + q->count) % q->size] = item;
+    q->count++;
+    scan_mutex_unlock(&q->lock);
+    scan_sem_post(&q->filled);
+}
+
+/* returns NULL once closed and empty */
+static char * scan_queue_pop(scan_queue * q) {
+    char * item = NULL;
+
+    scan_sem_wait(&q->filled);
+    scan_mutex_lock(&q->lock);
+    if (q->count > 0) {
+        item = q->items[q->head];
+        q->head = (q->head + 1) % q->size;
+        q->count--;
+    }
+    scan_mutex_unlock(&q->lock);
+
+    if (item)
+        scan_sem_post(&q->empty);
+    else
+        scan_sem_post(&q->filled); /* closed: pass the wakeup on to the next waiting thread */
+    return item;
+}
+
+/* wakes up poppers once the queue is empty (no pushes are allowed after closing) */
+static void scan_queue_close(scan_queue * q) {
+    scan_sem_post(&q->filled);
+}
+
+static double scan_time(void) {
+#ifdef WIN32
+    return GetTickCount() / 1000.0;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+#endif
+}
+
+/* appends a JSON string (with quotes) */
+static void scan_json_string(char * line, size_t line_size, const char * str) {
+    size_t pos = strlen(line);
+    const unsigned char * s;
+
+    if (!str) str = "";
+    s = (const unsigned char *)str;
+    if (pos + 2 >= line_size) return;
+    line[pos++] = '"';
+    for (; *s != '\0' && pos + 8 < line_size; s++) {
+        if (*s == '"' || *s == '\\') {
+            line[pos++] = '\\';
+            line[pos++] = *s;
+        }
+        else if (*s < 0x20) {
+            pos += sprintf(line + pos, "\\u%04x", *s);
+        }
+        else {
+            line[pos++] = *s;
+        }
+    }
+    line[pos++] = '"';
+    line[pos] = '\0';
+}
+
+static void scan_json_key(char * line, size_t line_size, const char * key, const char * str) {
+    concatn(line_size, line, ",\"");
+    concatn(line_size, line, key);
+    concatn(line_size, line, "\":");
+    scan_json_string(line, line_size, str);
+}
+
+static char * scan_make_line(const char * filename, int subsong, int subsong_count, VGMSTREAM * vgmstream, const char * error) {
+    char * line;
+    char temp[256];
+    const char * description;
+
+    line = malloc(SCAN_LINE_MAX);
+    if (!line) return NULL;
+
+    strcpy(line, "{\"file\":");
+    scan_json_string(line, SCAN_LINE_MAX, filename);
+
+    if (!vgmstream) {
+        scan_json_key(line, SCAN_LINE_MAX, "error", error);
+        concatn(SCAN_LINE_MAX, line, "}\n");
+        return line;
+    }
+
+    snprintf(temp, sizeof(temp), ",\"subsong\":%i,\"subsongs\":%i", subsong, subsong_count);
+    concatn(SCAN_LINE_MAX, line, temp);
+
+    description = get_vgmstream_meta_description(vgmstream->meta_type);
+    scan_json_key(line, SCAN_LINE_MAX, "meta", description ? description : "unknown");
+    description = get_vgmstream_coding_description(vgmstream->coding_type);
+    scan_json_key(line, SCAN_LINE_MAX, "coding", description ? description : "unknown");
+    description = get_vgmstream_layout_description(vgmstream->layout_type);
+    scan_json_key(line, SCAN_LINE_MAX, "layout", description ? description : "unknown");
+
+    snprintf(temp, sizeof(temp), ",\"sample_rate\":%i,\"channels\":%i,\"num_samples\":%i",
+            vgmstream->sample_rate, vgmstream->channels, vgmstream->num_samples);
+    concatn(SCAN_LINE_MAX, line, temp);
+    if (vgmstream->loop_flag) {
+        snprintf(temp, sizeof(temp), ",\"loop_start\":%i,\"loop_end\":%i",
+                vgmstream->loop_start_sample, vgmstream->loop_end_sample);
+        concatn(SCAN_LINE_MAX, line, temp);
+    }
+    snprintf(temp, sizeof(temp), ",\"bitrate\":%i", get_vgmstream_average_bitrate(vgmstream));
+    concatn(SCAN_LINE_MAX, line, temp);
+
+    if (vgmstream->stream_name[0] != '\0')
+        scan_json_key(line, SCAN_LINE_MAX, "stream_name", vgmstream->stream_name);
+
+    concatn(SCAN_LINE_MAX, line, "}\n");
+    return line;
+}
+
+static void scan_file(scan_state * state, const char * filename) {
+    STREAMFILE * streamFile = NULL;
+    vgmstream_subsong_table * table = NULL;
+    char * line;
+    int i, streams = 0, errors = 0;
+
+    streamFile = open_stdio_streamfile(filename);
+    if (!streamFile) {
+        line = scan_make_line(filename, 0, 0, NULL, "can't open");
+        errors++;
+        goto done;
+    }
+    streamFile->info_only = 1;
+
+    table = get_vgmstream_subsong_table(streamFile);
+    if (!table) {
+        line = scan_make_line(filename, 0, 0, NULL, "unsupported");
+        errors++;
+        goto done;
+    }
+
+    for (i = 1; i <= table->subsong_count; i++) {
+        VGMSTREAM * vgmstream = init_vgmstream_from_subsong_table(streamFile, table, i);
+        if (!vgmstream) {
+            errors++;
+            continue;
+        }
+        line = scan_make_line(filename, i, table->subsong_count, vgmstream, NULL);
+        close_vgmstream(vgmstream);
+        if (line) scan_queue_push(&state->lines, line);
+        streams++;
+    }
+    line = NULL;
+
+done:
+    if (line) scan_queue_push(&state->lines, line);
+    close_vgmstream_subsong_table(table);
+    if (streamFile) close_streamfile(streamFile);
+
+    scan_mutex_lock(&state->stats_lock);
+    state->files++;
+    if (streams) state->files_ok++;
+    state->streams += streams;
+    state->errors += errors;
+    scan_mutex_unlock(&state->stats_lock);
+}
+
+#ifdef WIN32
+static unsigned __stdcall scan_worker(void * arg) {
+#else
+static void * scan_worker(void * arg) {
+#endif
+    scan_state * state = arg;
+    char * filename;
+
+    while ((filename = scan_queue_pop(&state->paths)) != NULL) {
+        scan_file(state, filename);
+        free(filename);
+    }
+    return 0;
+}
+
+#ifdef WIN32
+static unsigned __stdcall scan_writer(void * arg) {
+#else
+static void * scan_writer(void * arg) {
+#endif
+    scan_state * state = arg;
+    char * line;
+
+    while ((line = scan_queue_pop(&state->lines)) != NULL) {
+        fputs(line, state->outfile);
+        free(line);
+    }
+    fflush(state->outfile);
+    return 0;
+}
+
+static int scan_thread_start(scan_thread_t * thread, void * arg, int writer) {
+#ifdef WIN32
+    *thread = (HANDLE)_beginthreadex(NULL, 0, writer ? scan_writer : scan_worker, arg, 0, NULL);
+    return *thread != 0;
+#else
+    return pthread_create(thread, NULL, writer ? scan_writer : scan_worker, arg) == 0;
+#endif
+}
+
+static void scan_thread_join(scan_thread_t thread) {
+#ifdef WIN32
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+}
+
+static void scan_push_path(scan_state * state, const char * path) {
+    char * item = strdup(path);
+    if (item) scan_queue_push(&state->paths, item);
+}
+
+/* adds a file, or all files in a dir (recursively) */
+static void scan_add_path(scan_state * state, const char * path) {
+    char subpath[PATH_LIMIT];
+#ifdef WIN32
+    WIN32_FIND_DATAA data;
+    HANDLE handle;
+    DWORD attrs = GetFileAttributesA(path);
+
+    if (attrs == INVALID_FILE_ATTRIBUTES || !(attrs & FILE_ATTRIBUTE_DIRECTORY)) {
+        scan_push_path(state, path);
+        return;
+    }
+
+    snprintf(subpath, sizeof(subpath), "%s\\*", path);
+    handle = FindFirstFileA(subpath, &data);
+    if (handle == INVALID_HANDLE_VALUE) return;
+    do {
+        if (!strcmp(data.cFileName, ".") || !strcmp(data.cFileName, ".."))
+            continue;
+        /* don't follow links/junctions to dirs found inside, as they may loop */
+        if ((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) && (data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT))
+            continue;
+        snprintf(subpath, sizeof(subpath), "%s\\%s", path, data.cFileName);
+        scan_add_path(state, subpath);
+    } while (FindNextFileA(handle, &data));
+    FindClose(handle);
+#else
+    struct stat st;
+    DIR * dir;
+    struct dirent * dirent;
+
+    if (stat(path, &st) != 0 || !S_ISDIR(st.st_mode)) {
+        scan_push_path(state, path);
+        return;
+    }
+
+    dir = opendir(path);
+    if (!dir) return;
+    while ((dirent = readdir(dir)) != NULL) {
+        if (!strcmp(dirent->d_name, ".") || !strcmp(dirent->d_name, ".."))
+            continue;
+        snprintf(subpath, sizeof(subpath), "%s/%s", path, dirent->d_name);
+        /* don't follow links to dirs found inside, as they may loop */
+        if (lstat(subpath, &st) == 0 && S_ISLNK(st.st_mode) && stat(subpath, &st) == 0 && S_ISDIR(st.st_mode))
+            continue;
+        scan_add_path(state, subpath);
+    }
+    closedir(dir);
+#endif
+}
+
+/* adds paths from a text file with one path per line ("-" for stdin) */
+static void scan_add_list(scan_state * state, const char * listname) {
+    char path[PATH_LIMIT];
+    FILE * list = strcmp(listname, "-") == 0 ? stdin : fopen(listname, "r");
+
+    if (!list) {
+        fprintf(stderr,"failed to open list %s\n", listname);
+        return;
+    }
+    while (fgets(path, sizeof(path), list)) {
+        path[strcspn(path, "\r\n")] = '\0';
+        if (path[0] != '\0')
+            scan_add_path(state, path);
+    }
+    if (list != stdin)
+        fclose(list);
+}
+
+static int scan_main(int argc, char ** argv, const char * listname, const char * outfilename, int thread_count) {
+    scan_state state;
+    scan_thread_t workers[SCAN_THREADS_MAX];
+    scan_thread_t writer;
+    int i, worker_count = 0;
+    double start_time, elapsed;
+
+    if (thread_count < 1) thread_count = 1;
+    if (thread_count > SCAN_THREADS_MAX) thread_count = SCAN_THREADS_MAX;
+
+    memset(&state, 0, sizeof(scan_state));
+    if (!scan_queue_init(&state.paths, SCAN_PATH_QUEUE_SIZE)) return 1;
+    if (!scan_queue_init(&state.lines, SCAN_LINE_QUEUE_SIZE)) return 1;
+    scan_mutex_init(&state.stats_lock);
+
+    state.outfile = outfilename ? fopen(outfilename, "w") : stdout;
+    if (!state.outfile) {
+        fprintf(stderr,"failed to open %s for output\n", outfilename);
+        return 1;
+    }
+
+    /* companion files are probed per file, mostly from the same dirs */
+    set_streamfile_dir_cache(1);
+
+    start_time = scan_time();
+    if (!scan_thread_start(&writer, &state, 1)) {
+        fprintf(stderr,"failed to start threads\n");
+        return 1;
+    }
+    for (i = 0; i < thread_count; i++) {
+        if (!scan_thread_start(&workers[worker_count], &state, 0))
+            break;
+        worker_count++;
+    }
+    if (!worker_count) {
+        fprintf(stderr,"failed to start threads\n");
+        return 1;
+    }
+
+    /* feed paths (blocks while the queue is full) */
+    if (listname)
+        scan_add_list(&state, listname);
+    for (i = 0; i < argc; i++) {
+        scan_add_path(&state, argv[i]);
+    }
+
+    scan_queue_close(&state.paths);
+    for (i = 0; i < worker_count; i++) {
+        scan_thread_join(workers[i]);
+    }
+    scan_queue_close(&state.lines);
+    scan_thread_join(writer);
+
+    elapsed = scan_time() - start_time;
+    if (elapsed <= 0) elapsed = 0.000001;
+    fprintf(stderr,"scanned %li files (%li supported, %li errors), %li streams in %.2f seconds (%.1f files/s, %.1f streams/s) with %i threads\n",
+            state.files, state.files_ok, state.errors, state.streams, elapsed,
+            state.files / elapsed, state.streams / elapsed, worker_count);
+
+    set_streamfile_dir_cache(0);
+    if (state.outfile != stdout)
+        fclose(state.outfile);
+    scan_queue_free(&state.paths);
+    scan_queue_free(&state.lines);
+    scan_mutex_free(&state.stats_lock);
+    return 0;
+}
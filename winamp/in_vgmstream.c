@@ -281,7 +281,7 @@ static STREAMFILE *open_winamp_streamfile_by_wpath(const in_char *wpath) {
 }
 
 /* opens vgmstream for winamp */
-static VGMSTREAM* init_vgmstream_winamp(const in_char *fn, int stream_index) {
+static VGMSTREAM* init_vgmstream_winamp(const in_char *fn, int stream_index, int info_only) {
     VGMSTREAM * vgmstream = NULL;
 
     //return init_vgmstream(fn);
@@ -290,6 +290,7 @@ static VGMSTREAM* init_vgmstream_winamp(const in_char *fn, int stream_index) {
     STREAMFILE *streamFile = open_winamp_streamfile_by_wpath(fn); //open_stdio_streamfile(fn);
     if (streamFile) {
         streamFile->stream_index = stream_index;
+        streamFile->info_only = info_only; /* playlist info, won't be played */
         vgmstream = init_vgmstream_from_STREAMFILE(streamFile);
         close_streamfile(streamFile);
     }
@@ -607,7 +608,7 @@ int winamp_Play(const in_char *fn) {
     parse_fn_int(fn, wa_L("$s"), &stream_index);
 
     /* open the stream */
-    vgmstream = init_vgmstream_winamp(filename,stream_index);
+    vgmstream = init_vgmstream_winamp(filename,stream_index, 0);
     if (!vgmstream)
         return 1;
 
@@ -750,7 +751,7 @@ int winamp_InfoBox(const in_char *fn, HWND hwnd) {
         parse_fn_string(fn, NULL, filename,PATH_LIMIT);
         parse_fn_int(fn, wa_L("$s"), &stream_index);
 
-        infostream = init_vgmstream_winamp(filename, stream_index);
+        infostream = init_vgmstream_winamp(filename, stream_index, 1);
         if (!infostream)
             return 0;
 
@@ -791,7 +792,7 @@ void winamp_GetFileInfo(const in_char *fn, in_char *title, int *length_in_ms) {
         parse_fn_string(fn, NULL, filename,PATH_LIMIT);
         parse_fn_int(fn, wa_L("$s"), &stream_index);
 
-        infostream = init_vgmstream_winamp(filename, stream_index);
+        infostream = init_vgmstream_winamp(filename, stream_index, 1);
         if (!infostream) return;
 
         if (title) {